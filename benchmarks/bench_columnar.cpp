@@ -0,0 +1,170 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_columnar.h"
+#include "bench_common.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * \brief Количество строк колоночного представления
+ * */
+constexpr size_t columnar_rows = 1000000;
+
+/**
+ * \brief Поля по одному на тип хранения столбца: int32, int64, double
+ * */
+const db_fields_collection& columnar_fields() {
+  static const db_fields_collection fields = {
+      db_variable(1, "i32", db_variable_type::type_int,
+                  db_variable::db_variable_flags({{"can_be_null", true}})),
+      db_variable(2, "i64", db_variable_type::type_long,
+                  db_variable::db_variable_flags({{"can_be_null", true}})),
+      db_variable(3, "real", db_variable_type::type_real,
+                  db_variable::db_variable_flags({{"can_be_null", true}})),
+  };
+  return fields;
+}
+
+/**
+ * \brief Представление `columnar_rows` случайных строк со значениями
+ *   в [0, 1000), строится один раз: разбор строк дороже фильтров
+ * */
+DBColumnarView& columnar_view() {
+  static std::unique_ptr<DBColumnarView> view = []() {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> value(0, 999);
+    std::vector<DBColumnarView::row_values> rows(columnar_rows);
+    for (auto& row : rows) {
+      row.emplace(0, std::to_string(value(gen)));
+      row.emplace(1, std::to_string(int64_t(value(gen)) * 10000000000));
+      row.emplace(2, std::to_string(value(gen) * 0.5));
+    }
+    return std::make_unique<DBColumnarView>(columnar_fields(), rows);
+  }();
+  return *view;
+}
+
+/**
+ * \brief Дерево из одного условия равенства поля `i` значению `value`
+ * */
+std::shared_ptr<DBWhereClause<where_node_data>> eq_clause(
+    DBColumnarView::field_index i,
+    const std::string& value) {
+  return std::make_shared<DBWhereClause<where_node_data>>(
+      wns::node_eq(columnar_fields()[i], value));
+}
+
+/**
+ * \brief Фильтр диапазона, выбирающий примерно половину строк
+ * */
+template <class T>
+void bench_range(benchmark::State& state,
+                 DBColumnarView::field_index i,
+                 T lo,
+                 T hi) {
+  DBColumnarView& view = columnar_view();
+  db_selection selection;
+  bench::op_counters counters;
+  for (auto _ : state) {
+    view.SelectRange(i, lo, hi, &selection);
+    benchmark::DoNotOptimize(selection.words.data());
+  }
+  state.SetLabel(DBColumnarView::KernelName());
+  counters.Report(state, view.RowsCount());
+}
+
+/**
+ * \brief Фильтр равенства через дерево условий, выбирает около 0.1%
+ *   строк
+ * */
+void bench_eq(benchmark::State& state,
+              DBColumnarView::field_index i,
+              const std::string& value) {
+  DBColumnarView& view = columnar_view();
+  auto clause = eq_clause(i, value);
+  db_selection selection;
+  bench::op_counters counters;
+  for (auto _ : state) {
+    view.Select(clause, &selection);
+    benchmark::DoNotOptimize(selection.words.data());
+  }
+  state.SetLabel(DBColumnarView::KernelName());
+  counters.Report(state, view.RowsCount());
+}
+}  // namespace
+
+/* фильтры диапазона по столбцам int32, int64 и double */
+static void BM_ColumnarRangeInt32(benchmark::State& state) {
+  bench_range(state, 0, int64_t(250), int64_t(749));
+}
+BENCHMARK(BM_ColumnarRangeInt32);
+
+static void BM_ColumnarRangeInt64(benchmark::State& state) {
+  bench_range(state, 1, int64_t(2500000000000), int64_t(7490000000000));
+}
+BENCHMARK(BM_ColumnarRangeInt64);
+
+static void BM_ColumnarRangeReal(benchmark::State& state) {
+  bench_range(state, 2, 125.0, 374.5);
+}
+BENCHMARK(BM_ColumnarRangeReal);
+
+/* фильтры равенства по столбцам int32, int64 и double */
+static void BM_ColumnarEqInt32(benchmark::State& state) {
+  bench_eq(state, 0, "500");
+}
+BENCHMARK(BM_ColumnarEqInt32);
+
+static void BM_ColumnarEqInt64(benchmark::State& state) {
+  bench_eq(state, 1, "5000000000000");
+}
+BENCHMARK(BM_ColumnarEqInt64);
+
+static void BM_ColumnarEqReal(benchmark::State& state) {
+  bench_eq(state, 2, "250");
+}
+BENCHMARK(BM_ColumnarEqReal);
+
+/* пересечение и объединение битовых карт выборки */
+static void BM_ColumnarSelectionAnd(benchmark::State& state) {
+  DBColumnarView& view = columnar_view();
+  db_selection a, b;
+  view.SelectRange(0, int64_t(0), int64_t(499), &a);
+  view.SelectRange(1, int64_t(0), int64_t(4990000000000), &b);
+  // повтор операции не меняет карту, копия вне цикла
+  db_selection s = a;
+  bench::op_counters counters;
+  for (auto _ : state) {
+    s &= b;
+    benchmark::DoNotOptimize(s.words.data());
+  }
+  counters.Report(state, view.RowsCount());
+}
+BENCHMARK(BM_ColumnarSelectionAnd);
+
+static void BM_ColumnarSelectionOr(benchmark::State& state) {
+  DBColumnarView& view = columnar_view();
+  db_selection a, b;
+  view.SelectRange(0, int64_t(0), int64_t(499), &a);
+  view.SelectRange(1, int64_t(0), int64_t(4990000000000), &b);
+  // повтор операции не меняет карту, копия вне цикла
+  db_selection s = a;
+  bench::op_counters counters;
+  for (auto _ : state) {
+    s |= b;
+    benchmark::DoNotOptimize(s.words.data());
+  }
+  counters.Report(state, view.RowsCount());
+}
+BENCHMARK(BM_ColumnarSelectionOr);
@@ -0,0 +1,153 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "bench_common.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<size_t> allocations_count{0};
+}  // namespace
+
+/* счётчик выделений памяти: глобальные operator new/delete
+ *   программы бенчмарков */
+void* operator new(size_t size) {
+  allocations_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace bench {
+using namespace asp_db;
+
+size_t allocations() {
+  return allocations_count.load(std::memory_order_relaxed);
+}
+
+void op_counters::Report(benchmark::State& state, size_t items) const {
+  double allocs = static_cast<double>(allocations() - start_);
+  state.counters["allocs/op"] =
+      benchmark::Counter(allocs, benchmark::Counter::kAvgIterations);
+  state.counters["ops/s"] =
+      benchmark::Counter(static_cast<double>(state.iterations()),
+                         benchmark::Counter::kIsRate);
+  if (items)
+    state.SetItemsProcessed(state.iterations() * items);
+}
+
+/* render_connection */
+render_connection::render_connection(const IDBTables* tables)
+    : DBConnection(tables, db_parameters(), nullptr) {}
+
+std::shared_ptr<DBConnection> render_connection::CloneConnection() {
+  return std::make_shared<render_connection>(tables_);
+}
+mstatus_t render_connection::AddSavePoint(const db_save_point&) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::SetupConnection() {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::IsTableExists(db_table, bool*) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::GetTableFormat(db_table,
+                                            db_table_create_setup*) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::CheckTableFormat(const db_table_create_setup&) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::UpdateTable(const db_table_create_setup&) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::CreateTable(const db_table_create_setup&) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::DropTable(const db_table_drop_setup&) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::InsertRows(const db_query_insert_setup&,
+                                        id_container*) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::DeleteRows(const db_query_delete_setup&) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::SelectRows(const db_query_select_setup&,
+                                        db_query_select_result*) {
+  return STATUS_NOT;
+}
+mstatus_t render_connection::UpdateRows(const db_query_update_setup&) {
+  return STATUS_NOT;
+}
+std::stringstream render_connection::setupTableExistsString(db_table) {
+  return std::stringstream();
+}
+std::stringstream render_connection::setupGetColumnsInfoString(db_table) {
+  return std::stringstream();
+}
+std::string render_connection::db_variable_to_string(const db_variable&) {
+  return "";
+}
+
+/* данные */
+LibraryDBTables* tables() {
+  static LibraryDBTables ldb;
+  return &ldb;
+}
+
+std::vector<book> make_books(size_t count) {
+  std::vector<book> books(count);
+  for (size_t i = 0; i < count; ++i) {
+    book_construct(books[i], -1, (i % 2) ? lang_eng : lang_rus,
+                   "'Book title number " + std::to_string(i) + "'",
+                   1800 + static_cast<int>(i % 200),
+                   book::f_full & ~book::f_id);
+  }
+  return books;
+}
+
+std::unique_ptr<db_query_select_result> make_book_result(size_t count) {
+  auto setup = db_query_select_setup::Init(tables(), table_book, true);
+  std::unique_ptr<db_query_select_result> result(
+      new db_query_select_result(*setup));
+  auto id = result->IndexByFieldId(BOOK_ID);
+  auto title = result->IndexByFieldId(BOOK_TITLE);
+  auto year = result->IndexByFieldId(BOOK_PUB_YEAR);
+  auto lang = result->IndexByFieldId(BOOK_LANG);
+  result->values_vec.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto& row = result->values_vec[i];
+    row.emplace(id, std::to_string(i + 1));
+    row.emplace(title, "Book title number " + std::to_string(i));
+    row.emplace(year, std::to_string(1800 + i % 200));
+    row.emplace(lang, std::to_string((i % 2) ? lang_eng : lang_rus));
+  }
+  return result;
+}
+}  // namespace bench
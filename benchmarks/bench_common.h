@@ -0,0 +1,103 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * bench_common *
+ *   Общие функции бенчмарков: счётчик выделений памяти, соединение
+ * только для сборки строк запросов и генераторы данных
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__BENCH_COMMON_H_
+#define _DATABASE__BENCH_COMMON_H_
+
+#include "asp_db/db_connection.h"
+#include "asp_db/db_queries_setup_select.h"
+#include "library_tables.h"
+
+#include "benchmark/benchmark.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bench {
+/**
+ * \brief Количество вызовов operator new с начала работы программы
+ * */
+size_t allocations();
+
+/**
+ * \brief Счётчики бенчмарка: ops/s и allocs/op
+ *
+ * Создаётся перед циклом бенчмарка, Report вызывается после него
+ * */
+class op_counters {
+ public:
+  op_counters() : start_(allocations()) {}
+  /**
+   * \param items Количество элементов(строк, узлов) за одну операцию,
+   *   добавляет счётчик items_per_second
+   * */
+  void Report(benchmark::State& state, size_t items = 0) const;
+
+ private:
+  size_t start_;
+};
+
+/**
+ * \brief Соединение без подключения к СУБД, открывает функции сборки
+ *   строк запросов DBConnection
+ * */
+class render_connection : public asp_db::DBConnection {
+ public:
+  explicit render_connection(const asp_db::IDBTables* tables);
+
+  using DBConnection::setupInsertString;
+  using DBConnection::setupSelectString;
+
+  std::shared_ptr<DBConnection> CloneConnection() override;
+  mstatus_t AddSavePoint(const asp_db::db_save_point&) override;
+  void RollbackToSavePoint(const asp_db::db_save_point&) override {}
+  mstatus_t SetupConnection() override;
+  void CloseConnection() override {}
+  mstatus_t IsTableExists(asp_db::db_table, bool*) override;
+  mstatus_t GetTableFormat(asp_db::db_table,
+                           asp_db::db_table_create_setup*) override;
+  mstatus_t CheckTableFormat(const asp_db::db_table_create_setup&) override;
+  mstatus_t UpdateTable(const asp_db::db_table_create_setup&) override;
+  mstatus_t CreateTable(const asp_db::db_table_create_setup&) override;
+  mstatus_t DropTable(const asp_db::db_table_drop_setup&) override;
+  mstatus_t InsertRows(const asp_db::db_query_insert_setup&,
+                       asp_db::id_container*) override;
+  mstatus_t DeleteRows(const asp_db::db_query_delete_setup&) override;
+  mstatus_t SelectRows(const asp_db::db_query_select_setup&,
+                       asp_db::db_query_select_result*) override;
+  mstatus_t UpdateRows(const asp_db::db_query_update_setup&) override;
+
+ protected:
+  std::stringstream setupTableExistsString(asp_db::db_table) override;
+  std::stringstream setupGetColumnsInfoString(asp_db::db_table) override;
+  std::string db_variable_to_string(const asp_db::db_variable&) override;
+};
+
+/**
+ * \brief Пространство таблиц примера library
+ * */
+LibraryDBTables* tables();
+/**
+ * \brief Сгенерировать `count` строк book без идентификаторов
+ * */
+std::vector<book> make_books(size_t count);
+/**
+ * \brief Сгенерировать результат выборки из `count` строк book
+ * */
+std::unique_ptr<asp_db::db_query_select_result> make_book_result(
+    size_t count);
+}  // namespace bench
+
+#endif  // !_DATABASE__BENCH_COMMON_H_
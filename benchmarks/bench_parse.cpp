@@ -0,0 +1,66 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_append_functor.h"
+#include "asp_db/db_defines.h"
+#include "bench_common.h"
+
+#include <string>
+#include <vector>
+
+/* распаковка массива строк `n str n str` */
+static void BM_TranslateToVector(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  std::vector<std::string> src(count);
+  for (size_t i = 0; i < count; ++i)
+    src[i] = "value_" + std::to_string(i);
+  std::string packed = db_variable::TranslateFromVector(src.begin(), src.end());
+  bench::op_counters counters;
+  for (auto _ : state) {
+    std::vector<std::string> vec;
+    vector_wrapper n(vec);
+    db_variable::TranslateToVector(packed, AppendOp(n));
+    benchmark::DoNotOptimize(vec.data());
+  }
+  counters.Report(state, count);
+}
+BENCHMARK(BM_TranslateToVector)->RangeMultiplier(8)->Range(1, 4096);
+
+/* разбор массива postgres `{1,2,3}` в контейнер целых */
+static void BM_String2ContainerInt(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  std::string str = "{";
+  for (size_t i = 0; i < count; ++i)
+    str += std::to_string(i) + (i + 1 < count ? "," : "}");
+  bench::op_counters counters;
+  for (auto _ : state) {
+    std::vector<int> vec;
+    IDBTables::string2Container<std::vector<int>>(
+        str, &vec, [](const std::string& s) { return std::stoi(s); });
+    benchmark::DoNotOptimize(vec.data());
+  }
+  counters.Report(state, count);
+}
+BENCHMARK(BM_String2ContainerInt)->RangeMultiplier(8)->Range(1, 4096);
+
+/* разбор массива строк `{a,b,c}` */
+static void BM_String2ContainerString(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  std::string str = "{";
+  for (size_t i = 0; i < count; ++i)
+    str += "name_" + std::to_string(i) + (i + 1 < count ? "," : "}");
+  bench::op_counters counters;
+  for (auto _ : state) {
+    std::vector<std::string> vec;
+    IDBTables::string2Container(str, &vec);
+    benchmark::DoNotOptimize(vec.data());
+  }
+  counters.Report(state, count);
+}
+BENCHMARK(BM_String2ContainerString)->RangeMultiplier(8)->Range(1, 4096);
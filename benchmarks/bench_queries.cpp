@@ -0,0 +1,103 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_where.h"
+#include "bench_common.h"
+
+#include <string>
+#include <vector>
+
+/* сетап INSERT по вектору структур */
+static void BM_InitInsertSetup(benchmark::State& state) {
+  size_t rows = static_cast<size_t>(state.range(0));
+  auto books = bench::make_books(rows);
+  bench::op_counters counters;
+  for (auto _ : state) {
+    auto setup = bench::tables()->InitInsertSetup<book>(books);
+    benchmark::DoNotOptimize(setup.get());
+  }
+  counters.Report(state, rows);
+}
+BENCHMARK(BM_InitInsertSetup)->RangeMultiplier(10)->Range(1, 100000);
+
+/* строка INSERT запроса по сетапу */
+static void BM_SetupInsertString(benchmark::State& state) {
+  size_t rows = static_cast<size_t>(state.range(0));
+  bench::render_connection conn(bench::tables());
+  auto setup = bench::tables()->InitInsertSetup<book>(bench::make_books(rows));
+  bench::op_counters counters;
+  for (auto _ : state) {
+    auto sstr = conn.setupInsertString(*setup);
+    benchmark::DoNotOptimize(sstr);
+  }
+  counters.Report(state, rows);
+}
+BENCHMARK(BM_SetupInsertString)->RangeMultiplier(10)->Range(1, 100000);
+
+/* строка SELECT запроса с деревом из `range` условий, время реальное,
+ *   см. BM_WhereTreeGetString */
+static void BM_SetupSelectString(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  bench::render_connection conn(bench::tables());
+  WhereTreeConstructor<table_book> c(bench::tables());
+  WhereTree<table_book> wt(c);
+  wt.Init(c.Gt(BOOK_ID, 0));
+  for (size_t i = 1; i < count; ++i)
+    wt.AddOr(c.Eq(BOOK_ID, static_cast<int>(i)));
+  auto setup = db_query_select_setup::Init(wt);
+  bench::op_counters counters;
+  for (auto _ : state) {
+    auto sstr = conn.setupSelectString(*setup);
+    benchmark::DoNotOptimize(sstr);
+  }
+  counters.Report(state, count);
+}
+BENCHMARK(BM_SetupSelectString)
+    ->RangeMultiplier(10)
+    ->Range(1, 1000)
+    ->UseRealTime();
+
+/* разбор результата выборки в структуры */
+static void BM_SetSelectData(benchmark::State& state) {
+  size_t rows = static_cast<size_t>(state.range(0));
+  auto result = bench::make_book_result(rows);
+  const IDBTables* tables = bench::tables();
+  bench::op_counters counters;
+  for (auto _ : state) {
+    std::vector<book> out;
+    tables->SetSelectData(result.get(), &out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  counters.Report(state, rows);
+}
+BENCHMARK(BM_SetSelectData)->RangeMultiplier(10)->Range(1, 100000);
+
+/* сохранение и выборка через менеджер подключения, бэкенд в памяти:
+ *   стоимость слоёв менеджера, транзакций и отображения структур */
+static void BM_MemorySaveSelect(benchmark::State& state) {
+  size_t rows = static_cast<size_t>(state.range(0));
+  db_parameters parameters;
+  parameters.supplier = db_client::MEMORY;
+  parameters.name = "bench_memory";
+  DBConnectionManager dbm(bench::tables());
+  dbm.ResetConnectionParameters(parameters);
+  dbm.CreateTable(table_book);
+  auto books = bench::make_books(rows);
+  bench::op_counters counters;
+  for (auto _ : state) {
+    dbm.SaveVectorOfRows(books);
+    std::vector<book> out;
+    dbm.SelectAllRows(table_book, &out);
+    benchmark::DoNotOptimize(out.data());
+    dbm.DeleteAllRows(table_book);
+  }
+  counters.Report(state, rows);
+}
+BENCHMARK(BM_MemorySaveSelect)->RangeMultiplier(10)->Range(1, 10000);
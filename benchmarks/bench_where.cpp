@@ -0,0 +1,62 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_where.h"
+#include "bench_common.h"
+
+#include <string>
+
+namespace {
+/**
+ * \brief Собрать дерево из `count` условий `title = 'x' AND year > n`,
+ *   разнесённых операторами OR
+ * */
+WhereTree<table_book> make_tree(const WhereTreeConstructor<table_book>& c,
+                                size_t count) {
+  WhereTree<table_book> wt(c);
+  wt.Init(c.And(c.Eq(BOOK_TITLE, std::string("Book title number 0")),
+                c.Gt(BOOK_PUB_YEAR, 1800)));
+  for (size_t i = 1; i < count; ++i)
+    wt.AddOr(c.And(c.Eq(BOOK_TITLE, "Book title number " + std::to_string(i)),
+                   c.Gt(BOOK_PUB_YEAR, 1800 + static_cast<int>(i % 200))));
+  return wt;
+}
+}  // namespace
+
+/* сборка дерева условий */
+static void BM_WhereTreeBuild(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  WhereTreeConstructor<table_book> c(bench::tables());
+  bench::op_counters counters;
+  for (auto _ : state) {
+    auto wt = make_tree(c, count);
+    benchmark::DoNotOptimize(wt.GetWhereTree());
+  }
+  counters.Report(state, count);
+}
+BENCHMARK(BM_WhereTreeBuild)->RangeMultiplier(8)->Range(1, 4096);
+
+/* строка условия собранного дерева, узлы дерева собираются в
+ *   отдельных потоках(std::async), поэтому время - реальное */
+static void BM_WhereTreeGetString(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  WhereTreeConstructor<table_book> c(bench::tables());
+  auto wt = make_tree(c, count);
+  auto clause = wt.GetWhereTree();
+  bench::op_counters counters;
+  for (auto _ : state) {
+    auto str = clause->GetString();
+    benchmark::DoNotOptimize(str.data());
+  }
+  counters.Report(state, count);
+}
+BENCHMARK(BM_WhereTreeGetString)
+    ->RangeMultiplier(8)
+    ->Range(1, 512)
+    ->UseRealTime();
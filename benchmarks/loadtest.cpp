@@ -0,0 +1,419 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * loadtest *
+ *   Нагрузочный тест DBConnectionManager на локальном PostgreSQL со
+ * схемой примера library: пропускная способность и перцентили
+ * задержек по типам операций
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_where.h"
+#include "library_tables.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+typedef std::chrono::steady_clock load_clock;
+
+/**
+ * \brief Типы операций нагрузки
+ * */
+enum load_op {
+  /** \brief SaveSingleRow одной книги */
+  op_save = 0,
+  /** \brief SaveVectorOfRows пакета книг */
+  op_batch,
+  /** \brief SelectRows по первичному ключу */
+  op_select_key,
+  /** \brief SelectRows диапазона лет публикации */
+  op_select_scan,
+  /** \brief DeleteRows по первичному ключу ранее добавленной книги */
+  op_delete,
+  op_count
+};
+const std::array<const char*, op_count> op_names = {
+    "save", "batch", "select_key", "select_scan", "delete"};
+
+/**
+ * \brief Параметры запуска
+ * */
+struct load_parameters {
+  db_parameters db;
+  /** \brief Количество потоков */
+  size_t threads = 4;
+  /** \brief Длительность замера, с */
+  double duration = 10.0;
+  /** \brief Длительность прогрева, с */
+  double warmup = 1.0;
+  /** \brief Веса операций */
+  std::array<unsigned, op_count> mix = {20, 5, 50, 10, 15};
+  /** \brief Размер пакета op_batch */
+  size_t batch = 100;
+  /** \brief Количество книг, добавляемых перед замером */
+  size_t preload = 10000;
+  /** \brief Один DBConnectionManager на все потоки */
+  bool shared_manager = false;
+  /** \brief Удалить строки book и translation перед замером */
+  bool reset = false;
+  uint32_t seed = 42;
+};
+
+/**
+ * \brief Результаты потока
+ * */
+struct thread_result {
+  /** \brief Задержки операций, нс */
+  std::array<std::vector<uint64_t>, op_count> latency;
+  std::array<size_t, op_count> errors{};
+};
+
+void usage(const char* argv0) {
+  std::cout
+      << "usage: " << argv0 << " [options]\n"
+      << "  --host HOST          (127.0.0.1)\n"
+      << "  --port PORT          (54329)\n"
+      << "  --db NAME            (asp_db_load)\n"
+      << "  --user USER          (asp_db)\n"
+      << "  --password PASS      (asp_db)\n"
+      << "  --threads N          (4)\n"
+      << "  --duration SEC       (10)\n"
+      << "  --warmup SEC         (1)\n"
+      << "  --mix save=20,batch=5,select_key=50,select_scan=10,delete=15\n"
+      << "  --batch N            rows per batch save (100)\n"
+      << "  --preload N          rows saved before run (10000)\n"
+      << "  --shared-manager     one DBConnectionManager for all threads\n"
+      << "  --reset              delete all rows of book and translation\n"
+      << "                       before run, required if book is not empty\n"
+      << "  --seed N             (42)\n";
+}
+
+bool parse_mix(const std::string& str, std::array<unsigned, op_count>* mix) {
+  std::array<unsigned, op_count> result{};
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    auto eq = item.find('=');
+    if (eq == std::string::npos)
+      return false;
+    auto name = item.substr(0, eq);
+    auto it = std::find(op_names.begin(), op_names.end(), name);
+    if (it == op_names.end())
+      return false;
+    result[it - op_names.begin()] = std::stoul(item.substr(eq + 1));
+  }
+  *mix = result;
+  return true;
+}
+
+bool parse_args(int argc, char** argv, load_parameters* p) {
+  p->db.is_dry_run = false;
+  p->db.supplier = db_client::POSTGRESQL;
+  p->db.host = "127.0.0.1";
+  p->db.port = 54329;
+  p->db.name = "asp_db_load";
+  p->db.username = "asp_db";
+  p->db.password = "asp_db";
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--shared-manager") {
+      p->shared_manager = true;
+      continue;
+    }
+    if (arg == "--reset") {
+      p->reset = true;
+      continue;
+    }
+    if (arg == "--help" || i + 1 >= argc)
+      return false;
+    std::string v = argv[++i];
+    if (arg == "--host")
+      p->db.host = v;
+    else if (arg == "--port")
+      p->db.port = std::stoi(v);
+    else if (arg == "--db")
+      p->db.name = v;
+    else if (arg == "--user")
+      p->db.username = v;
+    else if (arg == "--password")
+      p->db.password = v;
+    else if (arg == "--threads")
+      p->threads = std::max<size_t>(1, std::stoul(v));
+    else if (arg == "--duration")
+      p->duration = std::stod(v);
+    else if (arg == "--warmup")
+      p->warmup = std::stod(v);
+    else if (arg == "--mix") {
+      if (!parse_mix(v, &p->mix))
+        return false;
+    } else if (arg == "--batch")
+      p->batch = std::max<size_t>(1, std::stoul(v));
+    else if (arg == "--preload")
+      p->preload = std::stoul(v);
+    else if (arg == "--seed")
+      p->seed = std::stoul(v);
+    else
+      return false;
+  }
+  return true;
+}
+
+/**
+ * \brief Книга с уникальным в рамках запуска названием
+ * */
+book make_book(const std::string& prefix, size_t n, std::mt19937& rng) {
+  book b;
+  book_construct(b, -1, (rng() % 2) ? lang_eng : lang_rus,
+                 prefix + std::to_string(n),
+                 1800 + static_cast<int>(rng() % 220),
+                 book::f_full & ~book::f_id);
+  return b;
+}
+
+/**
+ * \brief Поток нагрузки
+ * */
+class load_worker {
+ public:
+  load_worker(const load_parameters& p,
+              DBConnectionManager* dbm,
+              const std::vector<int>& keys,
+              size_t index)
+      : p_(p),
+        dbm_(dbm),
+        keys_(keys),
+        rng_(p.seed + static_cast<uint32_t>(index)),
+        pick_(p.mix.begin(), p.mix.end()),
+        prefix_("lt-" + std::to_string(p.seed) + "-" + std::to_string(index)
+                + "-") {}
+
+  void Run(load_clock::time_point start,
+           load_clock::time_point measure,
+           load_clock::time_point stop,
+           thread_result* result) {
+    std::this_thread::sleep_until(start);
+    for (auto now = start; now < stop; now = load_clock::now()) {
+      load_op op = static_cast<load_op>(pick_(rng_));
+      // удалять нечего - добавить строку
+      if (op == op_delete && own_ids_.empty())
+        op = op_save;
+      auto t0 = load_clock::now();
+      bool ok = exec(op);
+      auto t1 = load_clock::now();
+      if (t0 < measure)
+        continue;
+      if (ok)
+        result->latency[op].push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0)
+                .count());
+      else
+        ++result->errors[op];
+    }
+  }
+
+ private:
+  bool exec(load_op op) {
+    WhereTreeConstructor<table_book> c(&tables_);
+    switch (op) {
+      case op_save: {
+        int id = -1;
+        auto st = dbm_->SaveSingleRow(make_book(prefix_, n_++, rng_), &id);
+        if (id > 0)
+          own_ids_.push_back(id);
+        return is_status_ok(st);
+      }
+      case op_batch: {
+        std::vector<book> books;
+        books.reserve(p_.batch);
+        for (size_t i = 0; i < p_.batch; ++i)
+          books.push_back(make_book(prefix_, n_++, rng_));
+        id_container ids;
+        auto st = dbm_->SaveVectorOfRows(std::move(books), &ids);
+        own_ids_.insert(own_ids_.end(), ids.id_vec.begin(), ids.id_vec.end());
+        return is_status_ok(st);
+      }
+      case op_select_key: {
+        if (keys_.empty())
+          return false;
+        WhereTree<table_book> wt(c);
+        wt.Init(c.Eq(BOOK_ID, keys_[rng_() % keys_.size()]));
+        std::vector<book> res;
+        return is_status_ok(dbm_->SelectRows(wt, &res));
+      }
+      case op_select_scan: {
+        int from = 1800 + static_cast<int>(rng_() % 215);
+        WhereTree<table_book> wt(c);
+        wt.Init(c.And(c.Ge(BOOK_PUB_YEAR, from),
+                      c.Lt(BOOK_PUB_YEAR, from + 5)));
+        std::vector<book> res;
+        return is_status_ok(dbm_->SelectRows(wt, &res));
+      }
+      case op_delete: {
+        int id = own_ids_.back();
+        own_ids_.pop_back();
+        WhereTree<table_book> wt(c);
+        wt.Init(c.Eq(BOOK_ID, id));
+        return is_status_ok(dbm_->DeleteRows(wt));
+      }
+      default:
+        return false;
+    }
+  }
+
+ private:
+  const load_parameters& p_;
+  DBConnectionManager* dbm_;
+  const std::vector<int>& keys_;
+  LibraryDBTables tables_;
+  std::mt19937 rng_;
+  std::discrete_distribution<int> pick_;
+  std::string prefix_;
+  /** \brief Счётчик добавленных потоком книг */
+  size_t n_ = 0;
+  /** \brief Идентификаторы добавленных потоком книг */
+  std::vector<int> own_ids_;
+};
+
+/**
+ * \brief Подготовить таблицы и добавить книги для выборок по ключу
+ * \param keys Идентификаторы книг
+ * \return false, если таблицы не подготовлены
+ *
+ * \note Строки book и translation удаляются только с `--reset`, без
+ *   него подготовка непустой таблицы book завершается ошибкой, чтобы
+ *   замер не стёр данные рабочей БД
+ * */
+bool prepare(DBConnectionManager& dbm,
+             const load_parameters& p,
+             std::vector<int>* keys) {
+  for (auto t : {table_book, table_translation, table_author})
+    if (!dbm.IsTableExists(t) && !is_status_ok(dbm.CreateTable(t)))
+      return false;
+  if (p.reset) {
+    dbm.DeleteAllRows(table_translation);
+    dbm.DeleteAllRows(table_book);
+  } else {
+    std::vector<book> existing;
+    dbm.SelectAllRows(table_book, &existing);
+    if (!existing.empty()) {
+      std::cerr << "Таблица book не пуста(" << existing.size()
+                << " строк), для удаления строк перед замером - --reset\n";
+      return false;
+    }
+  }
+  std::mt19937 rng(p.seed);
+  const size_t chunk = 1000;
+  for (size_t n = 0; n < p.preload; n += chunk) {
+    std::vector<book> books;
+    for (size_t i = n; i < std::min(p.preload, n + chunk); ++i)
+      books.push_back(make_book("preload-", i, rng));
+    dbm.SaveVectorOfRows(std::move(books));
+  }
+  std::vector<book> all;
+  dbm.SelectAllRows(table_book, &all);
+  keys->reserve(all.size());
+  for (const auto& b : all)
+    keys->push_back(b.id);
+  return true;
+}
+
+/**
+ * \brief Перцентиль `q` отсортированного вектора задержек, мкс
+ * */
+double percentile(const std::vector<uint64_t>& sorted, double q) {
+  if (sorted.empty())
+    return 0.0;
+  size_t i = static_cast<size_t>(std::ceil(q * sorted.size()));
+  i = std::min(sorted.size() - 1, i ? i - 1 : 0);
+  return sorted[i] / 1000.0;
+}
+
+void report(const load_parameters& p, std::vector<thread_result>& results) {
+  std::printf("threads %zu, duration %.1f s, manager %s\n", p.threads,
+              p.duration, p.shared_manager ? "shared" : "per thread");
+  std::printf("%-12s %10s %7s %11s %10s %10s %10s %10s %10s\n", "op", "count",
+              "errors", "ops/s", "p50,us", "p95,us", "p99,us", "p999,us",
+              "max,us");
+  for (size_t op = 0; op < op_count; ++op) {
+    std::vector<uint64_t> all;
+    size_t errors = 0;
+    for (auto& r : results) {
+      all.insert(all.end(), r.latency[op].begin(), r.latency[op].end());
+      errors += r.errors[op];
+    }
+    if (all.empty() && !errors)
+      continue;
+    std::sort(all.begin(), all.end());
+    std::printf("%-12s %10zu %7zu %11.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                op_names[op], all.size(), errors, all.size() / p.duration,
+                percentile(all, 0.5), percentile(all, 0.95),
+                percentile(all, 0.99), percentile(all, 0.999),
+                all.empty() ? 0.0 : all.back() / 1000.0);
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  load_parameters p;
+  if (!parse_args(argc, argv, &p)) {
+    usage(argv[0]);
+    return 1;
+  }
+  LibraryDBTables tables;
+  DBConnectionManager dbm(&tables);
+  if (!is_status_aval(dbm.ResetConnectionParameters(p.db))) {
+    std::cerr << "Не удалось подключиться к БД: " << p.db.GetInfo() << "\n";
+    return 2;
+  }
+  std::vector<int> keys;
+  if (!prepare(dbm, p, &keys))
+    return 2;
+  if (keys.empty() && p.mix[op_select_key]) {
+    std::cerr << "Нет строк для выборки по ключу\n";
+    return 2;
+  }
+
+  std::vector<std::unique_ptr<DBConnectionManager>> managers;
+  std::vector<std::unique_ptr<load_worker>> workers;
+  for (size_t i = 0; i < p.threads; ++i) {
+    DBConnectionManager* m = &dbm;
+    if (!p.shared_manager) {
+      managers.emplace_back(new DBConnectionManager(&tables));
+      managers.back()->ResetConnectionParameters(p.db);
+      m = managers.back().get();
+    }
+    workers.emplace_back(new load_worker(p, m, keys, i));
+  }
+
+  std::vector<thread_result> results(p.threads);
+  auto start = load_clock::now() + std::chrono::milliseconds(100);
+  auto measure = start + std::chrono::duration_cast<load_clock::duration>(
+                             std::chrono::duration<double>(p.warmup));
+  auto stop = measure + std::chrono::duration_cast<load_clock::duration>(
+                            std::chrono::duration<double>(p.duration));
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < p.threads; ++i)
+    threads.emplace_back(&load_worker::Run, workers[i].get(), start, measure,
+                         stop, &results[i]);
+  for (auto& t : threads)
+    t.join();
+  report(p, results);
+  return 0;
+}
@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+# Запуск asp_db-loadtest на временном локальном экземпляре PostgreSQL
+#
+# usage: loadtest_pg.sh <path/to/asp_db-loadtest> [параметры loadtest]
+#        loadtest_pg.sh <path/to/asp_db-replay> --journal PATH [...]
+#
+# Переменные окружения:
+#   PG_BIN  - каталог initdb/pg_ctl, по умолчанию `pg_config --bindir`
+#   PG_PORT - порт экземпляра, по умолчанию 54329
+#   PG_FSYNC - fsync/synchronous_commit сервера, по умолчанию off
+#   PG_KEEP - не удалять каталог данных после замера
+set -euo pipefail
+
+if [ $# -lt 1 ]; then
+  sed -n '2,10p' "$0"
+  exit 1
+fi
+LOADTEST=$1
+shift
+
+PG_BIN=${PG_BIN:-$(pg_config --bindir)}
+PG_PORT=${PG_PORT:-54329}
+PG_FSYNC=${PG_FSYNC:-off}
+PG_DATA=$(mktemp -d -t asp_db_load.XXXXXX)
+
+cleanup() {
+  "$PG_BIN/pg_ctl" -D "$PG_DATA" -m fast stop >/dev/null 2>&1 || true
+  if [ -z "${PG_KEEP:-}" ]; then
+    rm -rf "$PG_DATA"
+  else
+    echo "data directory: $PG_DATA"
+  fi
+}
+trap cleanup EXIT
+
+"$PG_BIN/initdb" -D "$PG_DATA" -U postgres -A trust >/dev/null
+# без fsync замер не зависит от диска, для оценки стоимости
+#   фиксации транзакций PG_FSYNC=on
+cat >> "$PG_DATA/postgresql.conf" <<CONF
+listen_addresses = '127.0.0.1'
+port = $PG_PORT
+unix_socket_directories = '$PG_DATA'
+max_connections = 200
+shared_buffers = 256MB
+fsync = $PG_FSYNC
+synchronous_commit = $PG_FSYNC
+full_page_writes = off
+CONF
+"$PG_BIN/pg_ctl" -D "$PG_DATA" -l "$PG_DATA/server.log" -w start >/dev/null
+
+PSQL=("$PG_BIN/psql" -h 127.0.0.1 -p "$PG_PORT" -U postgres -q -v ON_ERROR_STOP=1)
+"${PSQL[@]}" -c "CREATE USER asp_db WITH PASSWORD 'asp_db';"
+"${PSQL[@]}" -c "CREATE DATABASE asp_db_load OWNER asp_db;"
+
+"$LOADTEST" --host 127.0.0.1 --port "$PG_PORT" --db asp_db_load \
+  --user asp_db --password asp_db "$@"
@@ -0,0 +1,302 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * replay *
+ *   Воспроизведение журнала запросов dry_run режима(DBJournalWriter)
+ * на локальном PostgreSQL с исходной или ускоренной скоростью:
+ * задержки запросов и отставание от расписания журнала
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_connection_postgre.h"
+#include "asp_db/db_journal.h"
+
+#include <pqxx/pqxx>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asp_db;
+
+namespace {
+typedef std::chrono::steady_clock replay_clock;
+
+/**
+ * \brief Параметры запуска
+ * */
+struct replay_parameters {
+  db_parameters db;
+  std::string journal;
+  /** \brief Ускорение относительно журнала, 0 - без пауз */
+  double speed = 1.0;
+  /** \brief Количество одновременных подключений */
+  size_t concurrency = 4;
+};
+
+/**
+ * \brief Запросы одного подключения журнала
+ *
+ * Подключение менеджера живёт одну транзакцию, поэтому запросы
+ *   подключения выполняются подряд на одном подключении PostgreSQL
+ * */
+struct replay_session {
+  uint32_t connection_id = 0;
+  std::vector<db_journal_record> records;
+};
+
+/**
+ * \brief Результаты потока
+ * */
+struct thread_result {
+  /** \brief Задержки запросов, нс */
+  std::vector<uint64_t> latency;
+  /** \brief Отставание начала запроса от расписания, нс */
+  std::vector<uint64_t> lag;
+  size_t errors = 0;
+  size_t skipped = 0;
+};
+
+void usage(const char* argv0) {
+  std::cout
+      << "usage: " << argv0 << " --journal PATH [options]\n"
+      << "  --host HOST          (127.0.0.1)\n"
+      << "  --port PORT          (54329)\n"
+      << "  --db NAME            (asp_db_load)\n"
+      << "  --user USER          (asp_db)\n"
+      << "  --password PASS      (asp_db)\n"
+      << "  --speed X            replay speed factor, 0 - no pauses (1)\n"
+      << "  --concurrency N      simultaneous connections (4)\n";
+}
+
+bool parse_args(int argc, char** argv, replay_parameters* p) {
+  p->db.is_dry_run = false;
+  p->db.supplier = db_client::POSTGRESQL;
+  p->db.host = "127.0.0.1";
+  p->db.port = 54329;
+  p->db.name = "asp_db_load";
+  p->db.username = "asp_db";
+  p->db.password = "asp_db";
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || i + 1 >= argc)
+      return false;
+    std::string v = argv[++i];
+    if (arg == "--journal")
+      p->journal = v;
+    else if (arg == "--host")
+      p->db.host = v;
+    else if (arg == "--port")
+      p->db.port = std::stoi(v);
+    else if (arg == "--db")
+      p->db.name = v;
+    else if (arg == "--user")
+      p->db.username = v;
+    else if (arg == "--password")
+      p->db.password = v;
+    else if (arg == "--speed")
+      p->speed = std::max(0.0, std::stod(v));
+    else if (arg == "--concurrency")
+      p->concurrency = std::max<size_t>(1, std::stoul(v));
+    else
+      return false;
+  }
+  return !p->journal.empty();
+}
+
+/**
+ * \brief Прочитать журнал и разбить на сессии в порядке их начала
+ * */
+bool load_sessions(const std::string& path,
+                   std::vector<replay_session>* sessions,
+                   size_t* records) {
+  DBJournalReader reader(path);
+  if (!reader.IsOpen()) {
+    std::cerr << "Не удалось открыть журнал: " << path << "\n";
+    return false;
+  }
+  std::map<uint32_t, size_t> index;
+  db_journal_record record;
+  *records = 0;
+  while (reader.Next(&record)) {
+    auto it = index.find(record.connection_id);
+    if (it == index.end()) {
+      it = index.emplace(record.connection_id, sessions->size()).first;
+      sessions->emplace_back();
+      sessions->back().connection_id = record.connection_id;
+    }
+    (*sessions)[it->second].records.push_back(std::move(record));
+    ++*records;
+  }
+  if (reader.IsCorrupted())
+    std::cerr << "Журнал повреждён, воспроизводятся первые " << *records
+              << " запросов\n";
+  return true;
+}
+
+/**
+ * \brief Поток воспроизведения: берёт сессии по порядку и выполняет их
+ *   запросы по расписанию журнала
+ * */
+class replay_worker {
+ public:
+  replay_worker(const replay_parameters& p,
+                const std::vector<replay_session>& sessions,
+                std::atomic<size_t>* next)
+      : p_(p), sessions_(sessions), next_(next) {}
+
+  void Run(replay_clock::time_point start, thread_result* result) {
+    std::unique_ptr<pqxx::connection> connection;
+    for (size_t i = next_->fetch_add(1); i < sessions_.size();
+         i = next_->fetch_add(1)) {
+      const auto& records = sessions_[i].records;
+      for (size_t r = 0; r < records.size(); ++r) {
+        auto due = start + scheduled(records[r].time_us);
+        if (p_.speed > 0.0)
+          std::this_thread::sleep_until(due);
+        auto t0 = replay_clock::now();
+        try {
+          if (!connection)
+            connection.reset(new pqxx::connection(
+                DBConnectionPostgre::ConnectionString(p_.db)));
+          pqxx::nontransaction work(*connection);
+          work.exec(records[r].sql);
+        } catch (const pqxx::broken_connection&) {
+          // переподключение в следующей сессии
+          connection.reset();
+          ++result->errors;
+          result->skipped += records.size() - r - 1;
+          break;
+        } catch (const std::exception&) {
+          // транзакция сессии прервана - остальные запросы бессмысленны
+          ++result->errors;
+          result->skipped += skip(connection.get(), records.size() - r - 1);
+          break;
+        }
+        auto t1 = replay_clock::now();
+        result->latency.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0)
+                .count());
+        if (p_.speed > 0.0)
+          result->lag.push_back(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(t0 - due)
+                  .count());
+      }
+    }
+  }
+
+ private:
+  replay_clock::duration scheduled(uint64_t time_us) const {
+    if (p_.speed <= 0.0)
+      return replay_clock::duration::zero();
+    return std::chrono::duration_cast<replay_clock::duration>(
+        std::chrono::duration<double, std::micro>(time_us / p_.speed));
+  }
+
+  /**
+   * \brief Откатить прерванную транзакцию сессии
+   * \return Количество пропущенных запросов
+   * */
+  static size_t skip(pqxx::connection* connection, size_t rest) {
+    if (connection) {
+      try {
+        pqxx::nontransaction work(*connection);
+        work.exec("rollback;");
+      } catch (const std::exception&) {
+      }
+    }
+    return rest;
+  }
+
+ private:
+  const replay_parameters& p_;
+  const std::vector<replay_session>& sessions_;
+  std::atomic<size_t>* next_;
+};
+
+/**
+ * \brief Перцентиль `q` отсортированного вектора, мкс
+ * */
+double percentile(const std::vector<uint64_t>& sorted, double q) {
+  if (sorted.empty())
+    return 0.0;
+  size_t i = static_cast<size_t>(std::ceil(q * sorted.size()));
+  i = std::min(sorted.size() - 1, i ? i - 1 : 0);
+  return sorted[i] / 1000.0;
+}
+
+void report_row(const char* name, std::vector<uint64_t>& values) {
+  std::sort(values.begin(), values.end());
+  std::printf("%-8s %10zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+              values.size(), percentile(values, 0.5), percentile(values, 0.95),
+              percentile(values, 0.99), percentile(values, 0.999),
+              values.empty() ? 0.0 : values.back() / 1000.0);
+}
+
+void report(const replay_parameters& p,
+            std::vector<thread_result>& results,
+            size_t sessions,
+            double elapsed) {
+  std::vector<uint64_t> latency, lag;
+  size_t errors = 0, skipped = 0;
+  for (auto& r : results) {
+    latency.insert(latency.end(), r.latency.begin(), r.latency.end());
+    lag.insert(lag.end(), r.lag.begin(), r.lag.end());
+    errors += r.errors;
+    skipped += r.skipped;
+  }
+  std::printf("sessions %zu, concurrency %zu, speed %.2f, elapsed %.2f s\n",
+              sessions, p.concurrency, p.speed, elapsed);
+  std::printf("statements %zu (%.1f/s), errors %zu, skipped %zu\n",
+              latency.size(), latency.size() / elapsed, errors, skipped);
+  std::printf("%-8s %10s %10s %10s %10s %10s %10s\n", "", "count", "p50,us",
+              "p95,us", "p99,us", "p999,us", "max,us");
+  report_row("latency", latency);
+  if (p.speed > 0.0)
+    report_row("lag", lag);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  replay_parameters p;
+  if (!parse_args(argc, argv, &p)) {
+    usage(argv[0]);
+    return 1;
+  }
+  std::vector<replay_session> sessions;
+  size_t records = 0;
+  if (!load_sessions(p.journal, &sessions, &records))
+    return 2;
+  std::printf("journal %s: %zu statements, %zu sessions\n", p.journal.c_str(),
+              records, sessions.size());
+
+  std::atomic<size_t> next{0};
+  std::vector<std::unique_ptr<replay_worker>> workers;
+  for (size_t i = 0; i < p.concurrency; ++i)
+    workers.emplace_back(new replay_worker(p, sessions, &next));
+  std::vector<thread_result> results(p.concurrency);
+  auto start = replay_clock::now() + std::chrono::milliseconds(100);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < p.concurrency; ++i)
+    threads.emplace_back(&replay_worker::Run, workers[i].get(), start,
+                         &results[i]);
+  for (auto& t : threads)
+    t.join();
+  double elapsed =
+      std::chrono::duration<double>(replay_clock::now() - start).count();
+  report(p, results, sessions.size(), elapsed);
+  return 0;
+}
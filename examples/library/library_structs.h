@@ -20,6 +20,10 @@
 
 #include <stdint.h>
 
+/* после стандартных заголовков: макросы `field`, `reference` и т.п.
+ *   не должны попасть в их определения */
+#include "asp_db/db_meta.h"
+
 /* примерные типы данных */
 typedef int32_t row_id;
 /** \brief Язык, как пример enum */
@@ -40,8 +44,13 @@ enum language_t {
 
 /**
  * \brief Вот например книжка
+ *
+ * Поля размечены макросами asp_db/db_meta.h, по разметке генератор
+ *   tools/macrogen собирает реализацию LibraryDBTables
+ *   (опция LIBRARY_GENERATED_TABLES)
  * */
-struct book {
+struct ASP_TABLE book {
+  table_code(table_book)
   /**
    * \brief Флаги инициализированных полей
    * */
@@ -54,13 +63,16 @@ struct book {
   };
   inline bool IsFlagSet(initialized_flags f) const { return f & initialized; }
   /** \brief Номер в таблице БД */
-  row_id id;
+  field(row_id, id, type(autoinc), id(BOOK_ID), flag(f_id));
   /** \brief Есть у неё название */
-  std::string title;
+  field(std::string, title, NOT_NULL, id(BOOK_TITLE), flag(f_title));
   /** \brief Год публикации позволит разглядеть спрятанное */
-  int first_pub_year;
+  field(int, first_pub_year, NOT_NULL, id(BOOK_PUB_YEAR), flag(f_pub_year));
   /** \brief Язык оригинала */
-  language_t lang;
+  field(language_t, lang, type(int), NOT_NULL, id(BOOK_LANG), flag(f_lang));
+
+  primary_key(id)
+  unique_complex(title, first_pub_year)
 
   int32_t initialized = 0;
 };
@@ -74,7 +86,8 @@ inline std::ostream& operator<<(std::ostream& stream, const book& b) {
 }
 
 /** \brief Перевод */
-struct translation {
+struct ASP_TABLE translation {
+  table_code(table_translation)
   /** \brief Флаги инициализированных полей */
   enum initialized_flags {
     f_book_p = 0x01,
@@ -85,18 +98,37 @@ struct translation {
     f_full = 0x1f
   };
   inline bool IsFlagSet(initialized_flags f) const { return f & initialized; }
-  row_id id;
+  field(row_id, id, type(autoinc), id(TRANS_ID), flag(f_id));
   /** \brief Книги */
-  std::pair<row_id, book*> book_p;
-  language_t lang;
-  std::string translated_name;
-  std::string translators;
+  field_fkey(row_id,
+             book_p,
+             book,
+             type(int),
+             NOT_NULL,
+             id(TRANS_BOOK_ID),
+             flag(f_book_p));
+  field(language_t, lang, type(int), NOT_NULL, id(TRANS_LANG), flag(f_lang));
+  field(std::string,
+        translated_name,
+        NOT_NULL,
+        id(TRANS_TRANS_TITLE),
+        flag(f_tr_name));
+  field(std::string,
+        translators,
+        NOT_NULL,
+        id(TRANS_TRANSLATORS),
+        flag(f_translators));
+
+  primary_key(id)
+  unique_complex(book_p, lang, translated_name)
+  reference(book_p, book(id), CASCADE, CASCADE)
 
   int32_t initialized = 0;
 };
 
 /** \brief Писатель */
-struct author {
+struct ASP_TABLE author {
+  table_code(table_author)
   enum initialized_flags {
     f_name = 0x01,
     f_b_year = 0x02,
@@ -106,17 +138,22 @@ struct author {
     f_full = 0x1f
   };
   inline bool IsFlagSet(initialized_flags f) const { return f & initialized; }
-  row_id id;
+  field(row_id, id, type(autoinc), id(AUTHOR_ID), flag(f_id));
   /** \brief Имя */
-  std::string name;
-  int born_year;
-  int died_year;
+  field(std::string, name, NOT_NULL, id(AUTHOR_NAME), flag(f_name));
+  field(int, born_year, id(AUTHOR_BORN_YEAR), flag(f_b_year));
+  field(int, died_year, id(AUTHOR_DIED_YEAR), flag(f_d_year));
   /** \brief Имена книг */
-  std::vector<std::string> books;
+  field(std::vector<std::string>, books, id(AUTHOR_BOOKS), flag(f_books));
+
+  primary_key(id)
+  unique_complex(name, born_year, died_year)
 
   int32_t initialized = 0;
 };
 
+#include "asp_db/db_meta_undef.h"
+
 template <class T>
 std::string insertValue2str(const T& s) {
   return std::to_string(s);
@@ -8,6 +8,7 @@
  */
 #include "library_tables.h"
 #include "asp_db/db_connection_manager.h"
+#include "asp_db/db_table_descriptor.h"
 
 #include <map>
 #include <memory>
@@ -29,21 +30,16 @@ std::map<db_table, std::string> str_tables = {
  */
 /** \brief Сетап таблицы БД хранения данных о модели
  * \note В семантике PostgreSQL */
-const db_fields_collection book_fields = {
-    db_variable(TABLE_FIELD_PAIR(BOOK_ID),
-                db_variable_type::type_autoinc,
-                db_variable::db_variable_flags(
-                    {{"is_primary_key", true}, {"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(BOOK_TITLE),
-                db_variable_type::type_text,
-                db_variable::db_variable_flags({{"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(BOOK_PUB_YEAR),
-                db_variable_type::type_int,
-                db_variable::db_variable_flags({{"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(BOOK_LANG),
-                db_variable_type::type_int,
-                db_variable::db_variable_flags({{"can_be_null", false}})),
-};
+constexpr db_table_schema book_schema({
+    {TABLE_FIELD_PAIR(BOOK_ID), db_variable_type::type_autoinc,
+     ff_primary_key | ff_not_null},
+    {TABLE_FIELD_PAIR(BOOK_TITLE), db_variable_type::type_text, ff_not_null},
+    {TABLE_FIELD_PAIR(BOOK_PUB_YEAR), db_variable_type::type_int, ff_not_null},
+    {TABLE_FIELD_PAIR(BOOK_LANG), db_variable_type::type_int, ff_not_null},
+});
+static_assert(book_schema.IndexOf(BOOK_LANG) == 3);
+const db_fields_collection book_fields = book_schema.MakeCollection();
+static const db_fields_index book_index = book_schema.Index();
 static const db_table_create_setup::uniques_container book_uniques = {
     {TABLE_FIELD_NAME(BOOK_TITLE), TABLE_FIELD_NAME(BOOK_PUB_YEAR)}};
 static const db_table_create_setup book_create_setup(table_book,
@@ -54,26 +50,21 @@ static const db_table_create_setup book_create_setup(table_book,
 /*
  * TRANSLATIONS
  */
-const db_fields_collection translation_fields{
-    db_variable(TABLE_FIELD_PAIR(TRANS_ID),
-                db_variable_type::type_autoinc,
-                db_variable::db_variable_flags(
-                    {{"is_primary_key", true}, {"can_be_null", false}})),
+constexpr db_table_schema translation_schema({
+    {TABLE_FIELD_PAIR(TRANS_ID), db_variable_type::type_autoinc,
+     ff_primary_key | ff_not_null},
     // reference to book(fk)
-    db_variable(TABLE_FIELD_PAIR(TRANS_BOOK_ID),
-                db_variable_type::type_int,
-                db_variable::db_variable_flags(
-                    {{"is_reference ", true}, {"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(TRANS_LANG),
-                db_variable_type::type_int,
-                db_variable::db_variable_flags({{"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(TRANS_TRANS_TITLE),
-                db_variable_type::type_text,
-                db_variable::db_variable_flags({{"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(TRANS_TRANSLATORS),
-                db_variable_type::type_text,
-                db_variable::db_variable_flags({{"can_be_null", false}})),
-};
+    {TABLE_FIELD_PAIR(TRANS_BOOK_ID), db_variable_type::type_int,
+     ff_reference | ff_not_null},
+    {TABLE_FIELD_PAIR(TRANS_LANG), db_variable_type::type_int, ff_not_null},
+    {TABLE_FIELD_PAIR(TRANS_TRANS_TITLE), db_variable_type::type_text,
+     ff_not_null},
+    {TABLE_FIELD_PAIR(TRANS_TRANSLATORS), db_variable_type::type_text,
+     ff_not_null},
+});
+const db_fields_collection translation_fields =
+    translation_schema.MakeCollection();
+static const db_fields_index translation_index = translation_schema.Index();
 static const db_table_create_setup::uniques_container tr_uniques = {
     {{TABLE_FIELD_NAME(TRANS_BOOK_ID), TABLE_FIELD_NAME(TRANS_LANG),
       TABLE_FIELD_NAME(TRANS_TRANS_TITLE)}}};
@@ -93,25 +84,16 @@ static const db_table_create_setup translation_create_setup(
 /*
  * AUTHORS
  */
-const db_fields_collection author_fields = {
-    db_variable(TABLE_FIELD_PAIR(AUTHOR_ID),
-                db_variable_type::type_autoinc,
-                db_variable::db_variable_flags(
-                    {{"is_primary_key", true}, {"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(AUTHOR_NAME),
-                db_variable_type::type_text,
-                db_variable::db_variable_flags({{"can_be_null", false}})),
-    db_variable(TABLE_FIELD_PAIR(AUTHOR_BORN_YEAR),
-                db_variable_type::type_int,
-                {}),
-    db_variable(TABLE_FIELD_PAIR(AUTHOR_DIED_YEAR),
-                db_variable_type::type_int,
-                {}),
-    db_variable(TABLE_FIELD_PAIR(AUTHOR_BOOKS),
-                db_variable_type::type_text,
-                db_variable::db_variable_flags({{"is_array", false}}),
-                0),
-};
+constexpr db_table_schema author_schema({
+    {TABLE_FIELD_PAIR(AUTHOR_ID), db_variable_type::type_autoinc,
+     ff_primary_key | ff_not_null},
+    {TABLE_FIELD_PAIR(AUTHOR_NAME), db_variable_type::type_text, ff_not_null},
+    {TABLE_FIELD_PAIR(AUTHOR_BORN_YEAR), db_variable_type::type_int},
+    {TABLE_FIELD_PAIR(AUTHOR_DIED_YEAR), db_variable_type::type_int},
+    {TABLE_FIELD_PAIR(AUTHOR_BOOKS), db_variable_type::type_text, ff_none, 0},
+});
+const db_fields_collection author_fields = author_schema.MakeCollection();
+static const db_fields_index author_index = author_schema.Index();
 static const db_table_create_setup::uniques_container aut_uniques = {
     {{TABLE_FIELD_NAME(AUTHOR_NAME), TABLE_FIELD_NAME(AUTHOR_BORN_YEAR),
       TABLE_FIELD_NAME(AUTHOR_DIED_YEAR)}}};
@@ -119,6 +101,132 @@ static const db_table_create_setup author_create_setup(table_author,
                                                        author_fields,
                                                        aut_uniques,
                                                        nullptr);
+
+/*
+ * Дескрипторы таблиц: функции записи и чтения полей структур
+ *   по столбцам таблиц
+ */
+static const db_table_descriptor<book> book_descriptor(
+    book_fields,
+    {{BOOK_ID, book::f_id,
+      [](book& b, const std::string& s) { db_string_to_int(s, &b.id); },
+      [](const book& b, std::string* s) {
+        db_int_to_string(b.id, s);
+        return b.id > 0;
+      }},
+     {BOOK_TITLE, book::f_title,
+      [](book& b, const std::string& s) { b.title = s; },
+      [](const book& b, std::string* s) {
+        *s = b.title;
+        return true;
+      },
+      [](book& b, std::string* s) {
+        *s = std::move(b.title);
+        return true;
+      }},
+     {BOOK_PUB_YEAR, book::f_pub_year,
+      [](book& b, const std::string& s) {
+        db_string_to_int(s, &b.first_pub_year);
+      },
+      [](const book& b, std::string* s) {
+        db_int_to_string(b.first_pub_year, s);
+        return true;
+      }},
+     {BOOK_LANG, book::f_lang,
+      [](book& b, const std::string& s) { db_string_to_int(s, &b.lang); },
+      [](const book& b, std::string* s) {
+        db_int_to_string(b.lang, s);
+        return true;
+      }}});
+static const db_table_descriptor<translation> translation_descriptor(
+    translation_fields,
+    {{TRANS_ID, translation::f_id,
+      [](translation& tr, const std::string& s) {
+        db_string_to_int(s, &tr.id);
+      },
+      [](const translation& tr, std::string* s) {
+        db_int_to_string(tr.id, s);
+        return tr.id > 0;
+      }},
+     {TRANS_BOOK_ID, translation::f_book_p,
+      [](translation& tr, const std::string& s) {
+        db_string_to_int(s, &tr.book_p.first);
+      },
+      [](const translation& tr, std::string* s) {
+        db_int_to_string(tr.book_p.first, s);
+        return tr.book_p.first > 0;
+      }},
+     {TRANS_LANG, translation::f_lang,
+      [](translation& tr, const std::string& s) {
+        db_string_to_int(s, &tr.lang);
+      },
+      [](const translation& tr, std::string* s) {
+        db_int_to_string(tr.lang, s);
+        return true;
+      }},
+     {TRANS_TRANS_TITLE, translation::f_tr_name,
+      [](translation& tr, const std::string& s) { tr.translated_name = s; },
+      [](const translation& tr, std::string* s) {
+        *s = tr.translated_name;
+        return true;
+      },
+      [](translation& tr, std::string* s) {
+        *s = std::move(tr.translated_name);
+        return true;
+      }},
+     {TRANS_TRANSLATORS, translation::f_translators,
+      [](translation& tr, const std::string& s) { tr.translators = s; },
+      [](const translation& tr, std::string* s) {
+        *s = tr.translators;
+        return true;
+      },
+      [](translation& tr, std::string* s) {
+        *s = std::move(tr.translators);
+        return true;
+      }}});
+static const db_table_descriptor<author> author_descriptor(
+    author_fields,
+    {{AUTHOR_ID, author::f_id,
+      [](author& a, const std::string& s) { db_string_to_int(s, &a.id); },
+      [](const author& a, std::string* s) {
+        db_int_to_string(a.id, s);
+        return a.id > 0;
+      }},
+     {AUTHOR_NAME, author::f_name,
+      [](author& a, const std::string& s) { a.name = s; },
+      [](const author& a, std::string* s) {
+        *s = a.name;
+        return true;
+      },
+      [](author& a, std::string* s) {
+        *s = std::move(a.name);
+        return true;
+      }},
+     {AUTHOR_BORN_YEAR, author::f_b_year,
+      [](author& a, const std::string& s) {
+        db_string_to_int(s, &a.born_year);
+      },
+      [](const author& a, std::string* s) {
+        db_int_to_string(a.born_year, s);
+        return true;
+      }},
+     {AUTHOR_DIED_YEAR, author::f_d_year,
+      [](author& a, const std::string& s) {
+        db_string_to_int(s, &a.died_year);
+      },
+      [](const author& a, std::string* s) {
+        db_int_to_string(a.died_year, s);
+        return true;
+      }},
+     {AUTHOR_BOOKS, author::f_books,
+      [](author& a, const std::string& s) {
+        IDBTables::string2Container(s, &a.books);
+      },
+      [](const author& a, std::string* s) {
+        // todo: replace TranslateFromVector with field2str
+        *s = db_variable::TranslateFromVector(a.books.begin(), a.books.end());
+        return !a.books.empty();
+      }}});
 }  // namespace table_fields_setup
 
 namespace ns_tfs = table_fields_setup;
@@ -147,6 +255,20 @@ const db_fields_collection* LibraryDBTables::GetFieldsCollection(
   }
   return result;
 }
+const db_fields_index* LibraryDBTables::GetFieldsIndex(db_table t) const {
+  switch (t) {
+    case table_book:
+      return &ns_tfs::book_index;
+    case table_translation:
+      return &ns_tfs::translation_index;
+    case table_author:
+      return &ns_tfs::author_index;
+    case table_undefined:
+    default:
+      break;
+  }
+  return nullptr;
+}
 db_table LibraryDBTables::StrToTableCode(const std::string& tname) const {
   for (const auto& x : ns_tfs::str_tables)
     if (x.second == tname)
@@ -225,16 +347,7 @@ db_table IDBTables::GetTableCode<author>() const {
 template <>
 void IDBTables::setInsertValues<book>(db_query_insert_setup* src,
                                       const book& select_data) const {
-  /* insert all data */
-  db_query_basesetup::row_values values;
-  db_query_basesetup::field_index i;
-  if (select_data.id > 0)
-    insert_macro(book::f_id, BOOK_ID, std::to_string(select_data.id));
-  insert_macro(book::f_title, BOOK_TITLE, select_data.title);
-  insert_macro(book::f_pub_year, BOOK_PUB_YEAR,
-               std::to_string(select_data.first_pub_year));
-  insert_macro(book::f_lang, BOOK_LANG, std::to_string(select_data.lang));
-  src->values_vec.emplace_back(values);
+  ns_tfs::book_descriptor.SetInsertValues(src, select_data);
 }
 /** \brief Собрать вектор 'values' значений столбцов БД,
  *   по переданным строкам translation */
@@ -242,41 +355,31 @@ template <>
 void IDBTables::setInsertValues<translation>(
     db_query_insert_setup* src,
     const translation& select_data) const {
-  db_query_basesetup::row_values values;
-  db_query_basesetup::field_index i;
-  if (select_data.id > 0)
-    insert_macro(translation::f_id, TRANS_ID, std::to_string(select_data.id));
-  if (select_data.book_p.first > 0)
-    insert_macro(translation::f_book_p, TRANS_BOOK_ID,
-                 std::to_string(select_data.book_p.first));
-  insert_macro(translation::f_lang, TRANS_LANG,
-               std::to_string(select_data.lang));
-  insert_macro(translation::f_tr_name, TRANS_TRANS_TITLE,
-               select_data.translated_name);
-  insert_macro(translation::f_translators, TRANS_TRANSLATORS,
-               select_data.translators);
-  src->values_vec.emplace_back(values);
+  ns_tfs::translation_descriptor.SetInsertValues(src, select_data);
 }
 /** \brief Собрать вектор 'values' значений столбцов БД,
  *   по переданным строкам author */
 template <>
 void IDBTables::setInsertValues<author>(db_query_insert_setup* src,
                                         const author& select_data) const {
-  db_query_basesetup::row_values values;
-  db_query_basesetup::field_index i;
-  if (select_data.id > 0)
-    insert_macro(author::f_id, AUTHOR_ID, std::to_string(select_data.id));
-  insert_macro(author::f_name, AUTHOR_NAME, select_data.name);
-  insert_macro(author::f_b_year, AUTHOR_BORN_YEAR,
-               std::to_string(select_data.born_year));
-  insert_macro(author::f_d_year, AUTHOR_DIED_YEAR,
-               std::to_string(select_data.died_year));
-  if (select_data.books.size())
-    // todo: replace TranslateFromVector with field2str
-    insert_macro(author::f_books, AUTHOR_BOOKS,
-                 db_variable::TranslateFromVector(select_data.books.begin(),
-                                                  select_data.books.end()));
-  src->values_vec.emplace_back(values);
+  ns_tfs::author_descriptor.SetInsertValues(src, select_data);
+}
+
+/* moveInsertValues */
+template <>
+void IDBTables::moveInsertValues<book>(db_query_insert_setup* src,
+                                       book& insert_data) const {
+  ns_tfs::book_descriptor.MoveInsertValues(src, insert_data);
+}
+template <>
+void IDBTables::moveInsertValues<translation>(db_query_insert_setup* src,
+                                              translation& insert_data) const {
+  ns_tfs::translation_descriptor.MoveInsertValues(src, insert_data);
+}
+template <>
+void IDBTables::moveInsertValues<author>(db_query_insert_setup* src,
+                                         author& insert_data) const {
+  ns_tfs::author_descriptor.MoveInsertValues(src, insert_data);
 }
 
 std::string setInsertValue_author_book(const author& select_data) {
@@ -292,24 +395,7 @@ std::string setInsertValue_author_book(const author& select_data) {
 template <>
 void IDBTables::SetSelectData<book>(db_query_select_result* src,
                                     std::vector<book>* out_vec) const {
-  for (auto& row : src->values_vec) {
-    book b;
-    for (auto& col : row) {
-      if (src->isFieldName(TABLE_FIELD_NAME(BOOK_ID), src->fields[col.first])) {
-        b.id = std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(BOOK_TITLE),
-                                  src->fields[col.first])) {
-        b.title = col.second.c_str();
-      } else if (src->isFieldName(TABLE_FIELD_NAME(BOOK_PUB_YEAR),
-                                  src->fields[col.first])) {
-        b.first_pub_year = std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(BOOK_LANG),
-                                  src->fields[col.first])) {
-        b.lang = (language_t)std::atoi(col.second.c_str());
-      }
-    }
-    out_vec->push_back(std::move(b));
-  }
+  ns_tfs::book_descriptor.SetSelectData(*src, out_vec);
 }
 /** \brief Записать в out_vec строки translation из данных values_vec,
  *   полученных из БД */
@@ -317,54 +403,12 @@ template <>
 void IDBTables::SetSelectData<translation>(
     db_query_select_result* src,
     std::vector<translation>* out_vec) const {
-  for (auto& row : src->values_vec) {
-    translation tr;
-    for (auto& col : row) {
-      if (src->isFieldName(TABLE_FIELD_NAME(TRANS_ID),
-                           src->fields[col.first])) {
-        tr.id = std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(TRANS_BOOK_ID),
-                                  src->fields[col.first])) {
-        tr.book_p.first = std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(TRANS_LANG),
-                                  src->fields[col.first])) {
-        tr.lang = (language_t)std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(TRANS_TRANS_TITLE),
-                                  src->fields[col.first])) {
-        tr.translated_name = col.second.c_str();
-      } else if (src->isFieldName(TABLE_FIELD_NAME(TRANS_TRANSLATORS),
-                                  src->fields[col.first])) {
-        tr.translators = col.second.c_str();
-      }
-    }
-    out_vec->push_back(std::move(tr));
-  }
+  ns_tfs::translation_descriptor.SetSelectData(*src, out_vec);
 }
 /** \brief Записать в out_vec строки author из данных values_vec,
  *   полученных из БД */
 template <>
 void IDBTables::SetSelectData<author>(db_query_select_result* src,
                                       std::vector<author>* out_vec) const {
-  for (auto& row : src->values_vec) {
-    author a;
-    for (auto& col : row) {
-      if (src->isFieldName(TABLE_FIELD_NAME(AUTHOR_ID),
-                           src->fields[col.first])) {
-        a.id = std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(AUTHOR_NAME),
-                                  src->fields[col.first])) {
-        a.name = col.second.c_str();
-      } else if (src->isFieldName(TABLE_FIELD_NAME(AUTHOR_BORN_YEAR),
-                                  src->fields[col.first])) {
-        a.born_year = std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(AUTHOR_DIED_YEAR),
-                                  src->fields[col.first])) {
-        a.died_year = std::atoi(col.second.c_str());
-      } else if (src->isFieldName(TABLE_FIELD_NAME(AUTHOR_BOOKS),
-                                  src->fields[col.first])) {
-        string2Container(col.second, &a.books);
-      }
-    }
-    out_vec->push_back(std::move(a));
-  }
+  ns_tfs::author_descriptor.SetSelectData(*src, out_vec);
 }
@@ -89,11 +89,17 @@ enum library_db_tables {
   table_author = AUTHOR_TABLE >> 16
 };
 
+#if defined(LIBRARY_GENERATED_TABLES)
+/* реализация library_tables_gen.h/.cpp сгенерирована tools/macrogen
+ *   по разметке library_structs.h */
+#include "library_tables_gen.h"
+#else
 /** \brief Перегруженные функции api БД */
 class LibraryDBTables final : public IDBTables {
   std::string GetTablesNamespace() const override { return "LibraryDBTables"; }
   std::string GetTableName(db_table t) const override;
   const db_fields_collection* GetFieldsCollection(db_table t) const override;
+  const db_fields_index* GetFieldsIndex(db_table t) const override;
   db_table StrToTableCode(const std::string& tname) const override;
   std::string GetIdColumnName(db_table dt) const override;
   const db_table_create_setup& CreateSetupByCode(db_table dt) const override;
@@ -133,6 +139,18 @@ template <>
 void IDBTables::setInsertValues<author>(db_query_insert_setup* src,
                                         const author& select_data) const;
 
+/* moveInsertValues */
+/** \brief Собрать 'values' по строкам book, переместив их строки */
+template <>
+void IDBTables::moveInsertValues<book>(db_query_insert_setup* src,
+                                       book& insert_data) const;
+template <>
+void IDBTables::moveInsertValues<translation>(db_query_insert_setup* src,
+                                              translation& insert_data) const;
+template <>
+void IDBTables::moveInsertValues<author>(db_query_insert_setup* src,
+                                         author& insert_data) const;
+
 /* SetSelectData */
 /** \brief Записать в out_vec строки book из данных values_vec,
  *   полученных из БД
@@ -151,5 +169,6 @@ void IDBTables::SetSelectData<translation>(
 template <>
 void IDBTables::SetSelectData<author>(db_query_select_result* src,
                                       std::vector<author>* out_vec) const;
+#endif  // LIBRARY_GENERATED_TABLES
 
 #endif  // !EXAMPLES__LIBRARY_TABLES_H
@@ -0,0 +1,393 @@
+/**
+ * asp_db - db api of the project 'asp_therm'
+ * ===================================================================
+ * * library_tables_gen.cpp *
+ *   Сгенерировано asp_db-macrogen по 'library_structs.h', не редактировать
+ * вручную - изменения будут перезаписаны генератором
+ * ===================================================================
+ */
+#include "library_tables.h"
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_table_descriptor.h"
+#include "asp_db/db_table_schema.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+using namespace asp_db;
+
+namespace {
+
+/*
+ * book
+ */
+constexpr db_table_schema book_schema({
+    {TABLE_FIELD_PAIR(BOOK_ID), db_variable_type::type_autoinc,
+     ff_primary_key | ff_not_null},
+    {TABLE_FIELD_PAIR(BOOK_TITLE), db_variable_type::type_text,
+     ff_not_null},
+    {TABLE_FIELD_PAIR(BOOK_PUB_YEAR), db_variable_type::type_int,
+     ff_not_null},
+    {TABLE_FIELD_PAIR(BOOK_LANG), db_variable_type::type_int,
+     ff_not_null},
+});
+const db_fields_collection book_fields = book_schema.MakeCollection();
+const db_fields_index book_index = book_schema.Index();
+const db_table_create_setup::uniques_container book_uniques = {
+    db_table_create_setup::unique_constrain{
+        TABLE_FIELD_NAME(BOOK_TITLE),
+        TABLE_FIELD_NAME(BOOK_PUB_YEAR)},};
+const std::shared_ptr<db_ref_collection> book_references = nullptr;
+const db_table_create_setup book_create_setup(table_book,
+    book_fields,
+    book_uniques,
+    book_references);
+const db_table_descriptor<book> book_descriptor(
+    book_fields,
+    {{BOOK_ID, book::f_id,
+      [](book& t, const std::string& s) {
+        db_string_to_int(s, &t.id);
+      },
+      [](const book& t, std::string* s) {
+        db_int_to_string(t.id, s);
+        return t.id > 0;
+      }},
+     {BOOK_TITLE, book::f_title,
+      [](book& t, const std::string& s) {
+        t.title = s;
+      },
+      [](const book& t, std::string* s) {
+        *s = t.title;
+        return true;
+      },
+      [](book& t, std::string* s) {
+        *s = std::move(t.title);
+        return true;
+      }},
+     {BOOK_PUB_YEAR, book::f_pub_year,
+      [](book& t, const std::string& s) {
+        db_string_to_int(s, &t.first_pub_year);
+      },
+      [](const book& t, std::string* s) {
+        db_int_to_string(t.first_pub_year, s);
+        return true;
+      }},
+     {BOOK_LANG, book::f_lang,
+      [](book& t, const std::string& s) {
+        db_string_to_int(s, &t.lang);
+      },
+      [](const book& t, std::string* s) {
+        db_int_to_string(t.lang, s);
+        return true;
+      }}});
+
+/*
+ * translation
+ */
+constexpr db_table_schema translation_schema({
+    {TABLE_FIELD_PAIR(TRANS_ID), db_variable_type::type_autoinc,
+     ff_primary_key | ff_not_null},
+    {TABLE_FIELD_PAIR(TRANS_BOOK_ID), db_variable_type::type_int,
+     ff_reference | ff_not_null},
+    {TABLE_FIELD_PAIR(TRANS_LANG), db_variable_type::type_int,
+     ff_not_null},
+    {TABLE_FIELD_PAIR(TRANS_TRANS_TITLE), db_variable_type::type_text,
+     ff_not_null},
+    {TABLE_FIELD_PAIR(TRANS_TRANSLATORS), db_variable_type::type_text,
+     ff_not_null},
+});
+const db_fields_collection translation_fields = translation_schema.MakeCollection();
+const db_fields_index translation_index = translation_schema.Index();
+const db_table_create_setup::uniques_container translation_uniques = {
+    db_table_create_setup::unique_constrain{
+        TABLE_FIELD_NAME(TRANS_BOOK_ID),
+        TABLE_FIELD_NAME(TRANS_LANG),
+        TABLE_FIELD_NAME(TRANS_TRANS_TITLE)},};
+const std::shared_ptr<db_ref_collection> translation_references(
+    new db_ref_collection{
+        db_reference(TABLE_FIELD_NAME(TRANS_BOOK_ID),
+                     table_book,
+                     TABLE_FIELD_NAME(BOOK_ID),
+                     true,
+                     db_reference_act::ref_act_cascade,
+                     db_reference_act::ref_act_cascade)});
+const db_table_create_setup translation_create_setup(table_translation,
+    translation_fields,
+    translation_uniques,
+    translation_references);
+const db_table_descriptor<translation> translation_descriptor(
+    translation_fields,
+    {{TRANS_ID, translation::f_id,
+      [](translation& t, const std::string& s) {
+        db_string_to_int(s, &t.id);
+      },
+      [](const translation& t, std::string* s) {
+        db_int_to_string(t.id, s);
+        return t.id > 0;
+      }},
+     {TRANS_BOOK_ID, translation::f_book_p,
+      [](translation& t, const std::string& s) {
+        db_string_to_int(s, &t.book_p.first);
+      },
+      [](const translation& t, std::string* s) {
+        db_int_to_string(t.book_p.first, s);
+        return t.book_p.first > 0;
+      }},
+     {TRANS_LANG, translation::f_lang,
+      [](translation& t, const std::string& s) {
+        db_string_to_int(s, &t.lang);
+      },
+      [](const translation& t, std::string* s) {
+        db_int_to_string(t.lang, s);
+        return true;
+      }},
+     {TRANS_TRANS_TITLE, translation::f_tr_name,
+      [](translation& t, const std::string& s) {
+        t.translated_name = s;
+      },
+      [](const translation& t, std::string* s) {
+        *s = t.translated_name;
+        return true;
+      },
+      [](translation& t, std::string* s) {
+        *s = std::move(t.translated_name);
+        return true;
+      }},
+     {TRANS_TRANSLATORS, translation::f_translators,
+      [](translation& t, const std::string& s) {
+        t.translators = s;
+      },
+      [](const translation& t, std::string* s) {
+        *s = t.translators;
+        return true;
+      },
+      [](translation& t, std::string* s) {
+        *s = std::move(t.translators);
+        return true;
+      }}});
+
+/*
+ * author
+ */
+constexpr db_table_schema author_schema({
+    {TABLE_FIELD_PAIR(AUTHOR_ID), db_variable_type::type_autoinc,
+     ff_primary_key | ff_not_null},
+    {TABLE_FIELD_PAIR(AUTHOR_NAME), db_variable_type::type_text,
+     ff_not_null},
+    {TABLE_FIELD_PAIR(AUTHOR_BORN_YEAR), db_variable_type::type_int,
+     ff_none},
+    {TABLE_FIELD_PAIR(AUTHOR_DIED_YEAR), db_variable_type::type_int,
+     ff_none},
+    {TABLE_FIELD_PAIR(AUTHOR_BOOKS), db_variable_type::type_text,
+     ff_none, 0},
+});
+const db_fields_collection author_fields = author_schema.MakeCollection();
+const db_fields_index author_index = author_schema.Index();
+const db_table_create_setup::uniques_container author_uniques = {
+    db_table_create_setup::unique_constrain{
+        TABLE_FIELD_NAME(AUTHOR_NAME),
+        TABLE_FIELD_NAME(AUTHOR_BORN_YEAR),
+        TABLE_FIELD_NAME(AUTHOR_DIED_YEAR)},};
+const std::shared_ptr<db_ref_collection> author_references = nullptr;
+const db_table_create_setup author_create_setup(table_author,
+    author_fields,
+    author_uniques,
+    author_references);
+const db_table_descriptor<author> author_descriptor(
+    author_fields,
+    {{AUTHOR_ID, author::f_id,
+      [](author& t, const std::string& s) {
+        db_string_to_int(s, &t.id);
+      },
+      [](const author& t, std::string* s) {
+        db_int_to_string(t.id, s);
+        return t.id > 0;
+      }},
+     {AUTHOR_NAME, author::f_name,
+      [](author& t, const std::string& s) {
+        t.name = s;
+      },
+      [](const author& t, std::string* s) {
+        *s = t.name;
+        return true;
+      },
+      [](author& t, std::string* s) {
+        *s = std::move(t.name);
+        return true;
+      }},
+     {AUTHOR_BORN_YEAR, author::f_b_year,
+      [](author& t, const std::string& s) {
+        db_string_to_int(s, &t.born_year);
+      },
+      [](const author& t, std::string* s) {
+        db_int_to_string(t.born_year, s);
+        return true;
+      }},
+     {AUTHOR_DIED_YEAR, author::f_d_year,
+      [](author& t, const std::string& s) {
+        db_string_to_int(s, &t.died_year);
+      },
+      [](const author& t, std::string* s) {
+        db_int_to_string(t.died_year, s);
+        return true;
+      }},
+     {AUTHOR_BOOKS, author::f_books,
+      [](author& t, const std::string& s) {
+        t.books.clear();
+        IDBTables::string2Container(s, &t.books);
+      },
+      [](const author& t, std::string* s) {
+        *s = db_variable::TranslateFromVector(t.books.begin(), t.books.end());
+        return !t.books.empty();
+      }}});
+}  // namespace
+
+std::string LibraryDBTables::GetTableName(db_table t) const {
+  switch (t) {
+    case table_book:
+      return "book";
+    case table_translation:
+      return "translation";
+    case table_author:
+      return "author";
+    default:
+      break;
+  }
+  return "";
+}
+const db_fields_collection* LibraryDBTables::GetFieldsCollection(db_table t) const {
+  switch (t) {
+    case table_book:
+      return &book_fields;
+    case table_translation:
+      return &translation_fields;
+    case table_author:
+      return &author_fields;
+    default:
+      throw DBException(ERROR_DB_TABLE_EXISTS, "Неизвестный код таблицы");
+  }
+}
+const db_fields_index* LibraryDBTables::GetFieldsIndex(db_table t) const {
+  switch (t) {
+    case table_book:
+      return &book_index;
+    case table_translation:
+      return &translation_index;
+    case table_author:
+      return &author_index;
+    default:
+      break;
+  }
+  return nullptr;
+}
+db_table LibraryDBTables::StrToTableCode(const std::string& tname) const {
+  if (tname == "book")
+    return table_book;
+  if (tname == "translation")
+    return table_translation;
+  if (tname == "author")
+    return table_author;
+  return UNDEFINED_TABLE;
+}
+std::string LibraryDBTables::GetIdColumnName(db_table dt) const {
+  switch (dt) {
+    case table_book:
+      return TABLE_FIELD_NAME(BOOK_ID);
+    case table_translation:
+      return TABLE_FIELD_NAME(TRANS_ID);
+    case table_author:
+      return TABLE_FIELD_NAME(AUTHOR_ID);
+    default:
+      break;
+  }
+  return "";
+}
+const db_table_create_setup& LibraryDBTables::CreateSetupByCode(db_table dt) const {
+  switch (dt) {
+    case table_book:
+      return book_create_setup;
+    case table_translation:
+      return translation_create_setup;
+    case table_author:
+      return author_create_setup;
+    default:
+      throw DBException(ERROR_DB_TABLE_EXISTS, "Неизвестный код таблицы");
+  }
+}
+
+namespace asp_db {
+/* book */
+template <>
+std::string IDBTables::GetTableName<book>() const {
+  return "book";
+}
+template <>
+db_table IDBTables::GetTableCode<book>() const {
+  return table_book;
+}
+template <>
+void IDBTables::setInsertValues<book>(db_query_insert_setup* src,
+                                      const book& select_data) const {
+  book_descriptor.SetInsertValues(src, select_data);
+}
+template <>
+void IDBTables::moveInsertValues<book>(db_query_insert_setup* src,
+                                       book& insert_data) const {
+  book_descriptor.MoveInsertValues(src, insert_data);
+}
+template <>
+void IDBTables::SetSelectData<book>(db_query_select_result* src,
+                                    std::vector<book>* out_vec) const {
+  book_descriptor.SetSelectData(*src, out_vec);
+}
+/* translation */
+template <>
+std::string IDBTables::GetTableName<translation>() const {
+  return "translation";
+}
+template <>
+db_table IDBTables::GetTableCode<translation>() const {
+  return table_translation;
+}
+template <>
+void IDBTables::setInsertValues<translation>(db_query_insert_setup* src,
+                                             const translation& select_data) const {
+  translation_descriptor.SetInsertValues(src, select_data);
+}
+template <>
+void IDBTables::moveInsertValues<translation>(db_query_insert_setup* src,
+                                              translation& insert_data) const {
+  translation_descriptor.MoveInsertValues(src, insert_data);
+}
+template <>
+void IDBTables::SetSelectData<translation>(db_query_select_result* src,
+                                           std::vector<translation>* out_vec) const {
+  translation_descriptor.SetSelectData(*src, out_vec);
+}
+/* author */
+template <>
+std::string IDBTables::GetTableName<author>() const {
+  return "author";
+}
+template <>
+db_table IDBTables::GetTableCode<author>() const {
+  return table_author;
+}
+template <>
+void IDBTables::setInsertValues<author>(db_query_insert_setup* src,
+                                        const author& select_data) const {
+  author_descriptor.SetInsertValues(src, select_data);
+}
+template <>
+void IDBTables::moveInsertValues<author>(db_query_insert_setup* src,
+                                         author& insert_data) const {
+  author_descriptor.MoveInsertValues(src, insert_data);
+}
+template <>
+void IDBTables::SetSelectData<author>(db_query_select_result* src,
+                                      std::vector<author>* out_vec) const {
+  author_descriptor.SetSelectData(*src, out_vec);
+}
+}  // namespace asp_db
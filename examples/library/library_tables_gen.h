@@ -0,0 +1,78 @@
+/**
+ * asp_db - db api of the project 'asp_therm'
+ * ===================================================================
+ * * library_tables_gen *
+ *   Сгенерировано asp_db-macrogen по 'library_structs.h', не редактировать
+ * вручную - изменения будут перезаписаны генератором
+ * ===================================================================
+ */
+#ifndef ASP_DB_MACROGEN__LIBRARY_TABLES_GEN_H
+#define ASP_DB_MACROGEN__LIBRARY_TABLES_GEN_H
+
+#include "asp_db/db_tables.h"
+#include "library_structs.h"
+
+#include <string>
+#include <vector>
+
+/** \brief Реализация IDBTables для таблиц library_structs.h */
+class LibraryDBTables final : public asp_db::IDBTables {
+ public:
+  std::string GetTablesNamespace() const override { return "LibraryDBTables"; }
+  std::string GetTableName(asp_db::db_table t) const override;
+  const asp_db::db_fields_collection* GetFieldsCollection(
+      asp_db::db_table t) const override;
+  const asp_db::db_fields_index* GetFieldsIndex(
+      asp_db::db_table t) const override;
+  asp_db::db_table StrToTableCode(const std::string& tname) const override;
+  std::string GetIdColumnName(asp_db::db_table dt) const override;
+  const asp_db::db_table_create_setup& CreateSetupByCode(
+      asp_db::db_table dt) const override;
+};
+
+namespace asp_db {
+/* book */
+template <>
+std::string IDBTables::GetTableName<book>() const;
+template <>
+db_table IDBTables::GetTableCode<book>() const;
+template <>
+void IDBTables::setInsertValues<book>(db_query_insert_setup* src,
+                                      const book& select_data) const;
+template <>
+void IDBTables::moveInsertValues<book>(db_query_insert_setup* src,
+                                       book& insert_data) const;
+template <>
+void IDBTables::SetSelectData<book>(db_query_select_result* src,
+                                    std::vector<book>* out_vec) const;
+/* translation */
+template <>
+std::string IDBTables::GetTableName<translation>() const;
+template <>
+db_table IDBTables::GetTableCode<translation>() const;
+template <>
+void IDBTables::setInsertValues<translation>(db_query_insert_setup* src,
+                                             const translation& select_data) const;
+template <>
+void IDBTables::moveInsertValues<translation>(db_query_insert_setup* src,
+                                              translation& insert_data) const;
+template <>
+void IDBTables::SetSelectData<translation>(db_query_select_result* src,
+                                           std::vector<translation>* out_vec) const;
+/* author */
+template <>
+std::string IDBTables::GetTableName<author>() const;
+template <>
+db_table IDBTables::GetTableCode<author>() const;
+template <>
+void IDBTables::setInsertValues<author>(db_query_insert_setup* src,
+                                        const author& select_data) const;
+template <>
+void IDBTables::moveInsertValues<author>(db_query_insert_setup* src,
+                                         author& insert_data) const;
+template <>
+void IDBTables::SetSelectData<author>(db_query_select_result* src,
+                                      std::vector<author>* out_vec) const;
+}  // namespace asp_db
+
+#endif  // !ASP_DB_MACROGEN__LIBRARY_TABLES_GEN_H
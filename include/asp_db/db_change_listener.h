@@ -0,0 +1,163 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_change_listener *
+ *   Подписка на уведомления СУБД об изменении данных таблиц
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_CHANGE_LISTENER_H_
+#define _DATABASE__DB_CHANGE_LISTENER_H_
+
+#include "asp_db/db_defines.h"
+
+#include "asp_utils/Base.h"
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asp_db {
+class IDBTables;
+
+/**
+ * \brief Событие изменения данных таблицы
+ * */
+struct db_table_change {
+  /**
+   * \brief Код изменённой таблицы
+   * */
+  db_table table;
+  /**
+   * \brief Операция изменения: INSERT, UPDATE, DELETE или TRUNCATE.
+   *   После восстановления подключения слушателя - RECONNECT:
+   *   уведомления за время разрыва потеряны, данные таблицы надо
+   *   перечитать целиком
+   * */
+  std::string operation;
+};
+/**
+ * \brief Функция обработки события изменения таблицы
+ * \note Вызывается из потока слушателя
+ * */
+typedef std::function<void(const db_table_change&)> db_change_callback;
+
+/**
+ * \brief Получить имя канала уведомлений таблицы
+ * \param table_name Имя таблицы в БД
+ * */
+std::string db_change_channel(const std::string& table_name);
+
+/**
+ * \brief Базовый класс слушателя уведомлений об изменении таблиц
+ *
+ * Реализация СУБД держит отдельное подключение, получает
+ *   уведомления и раздаёт их подписчикам через `dispatch`.
+ *   Состояние прослушивания меняется потоком слушателя, читать его
+ *   следует через GetListenStatus, а не GetStatus
+ * */
+class DBChangeListener : public BaseObject {
+ public:
+  explicit DBChangeListener(const IDBTables* tables);
+  virtual ~DBChangeListener() = default;
+
+  /**
+   * \brief Начать прослушивание уведомлений таблиц `tables`
+   * */
+  virtual mstatus_t Start(const std::vector<db_table>& tables) = 0;
+  /**
+   * \brief Прекратить прослушивание, закрыть подключение
+   * */
+  virtual void Stop() = 0;
+
+  /**
+   * \brief Подписаться на изменения таблицы
+   * \param table Код таблицы
+   * \param callback Функция обработки события
+   *
+   * \return Идентификатор подписки
+   * */
+  size_t Subscribe(db_table table, db_change_callback callback);
+  /**
+   * \brief Отменить подписку с идентификатором `id`
+   *
+   * После возврата обработчик подписки не вызывается и не исполняется:
+   *   метод ждёт завершения уже начатого вызова. Из обработчика(потока
+   *   слушателя) метод не ждёт, текущий вызов завершится после него
+   * */
+  void Unsubscribe(size_t id);
+  /**
+   * \brief Состояние прослушивания: STATUS_OK - уведомления
+   *   принимаются, STATUS_HAVE_ERROR - подключение потеряно
+   *   и восстанавливается
+   * */
+  mstatus_t GetListenStatus() const { return listen_status_.load(); }
+
+ protected:
+  /**
+   * \brief Передать событие подписчикам таблицы
+   * */
+  void dispatch(const db_table_change& change);
+
+ protected:
+  /**
+   * \brief Указатель на интерфейс таблиц
+   * */
+  const IDBTables* tables_;
+  /**
+   * \brief Состояние прослушивания, пишется потоком слушателя
+   * */
+  std::atomic<mstatus_t> listen_status_{STATUS_DEFAULT};
+
+ private:
+  /**
+   * \brief Подписка на изменения таблицы
+   * */
+  struct subscription {
+    db_table table;
+    db_change_callback callback;
+    /**
+     * \brief Число исполняемых вызовов обработчика, под
+     *   `subscribers_lock_`
+     * */
+    size_t in_flight = 0;
+    /**
+     * \brief Подписка отменена, новые вызовы не начинаются
+     * */
+    bool removed = false;
+  };
+
+ private:
+  std::mutex subscribers_lock_;
+  /**
+   * \brief Завершение вызова обработчика, ждёт Unsubscribe
+   * */
+  std::condition_variable subscribers_cv_;
+  /**
+   * \brief Подписчики по идентификатору подписки
+   * */
+  std::map<size_t, std::shared_ptr<subscription>> subscribers_;
+  /**
+   * \brief Поток, раздающий события, под `subscribers_lock_`
+   * */
+  std::thread::id dispatch_thread_;
+  /**
+   * \brief Идентификатор следующей подписки
+   * */
+  size_t next_id_ = 1;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_CHANGE_LISTENER_H_
@@ -0,0 +1,68 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_CHANGE_LISTENER_MEMORY_H_
+#define _DATABASE__DB_CHANGE_LISTENER_MEMORY_H_
+
+#include "asp_db/db_change_listener.h"
+#include "asp_db/db_connection_memory.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Слушатель изменений таблиц в памяти
+ *
+ * Аналог LISTEN/NOTIFY для DBConnectionMemory: подключения передают
+ *   изменения наблюдателям хранилища при фиксации транзакции,
+ *   слушатель раздаёт их подписчикам из своего потока. Слушатель
+ *   видит изменения всех подключений к БД с тем же именем, в том
+ *   числе других менеджеров
+ * */
+class DBChangeListenerMemory final : public DBChangeListener {
+ public:
+  DBChangeListenerMemory(const IDBTables* tables,
+                         const db_parameters& parameters);
+  ~DBChangeListenerMemory() override;
+
+  mstatus_t Start(const std::vector<db_table>& tables) override;
+  void Stop() override;
+
+ private:
+  /**
+   * \brief Цикл раздачи изменений, исполняется в потоке слушателя
+   * */
+  void listenLoop();
+
+ private:
+  /**
+   * \brief Подключение к прослушиваемой БД, держит её хранилище
+   * */
+  std::unique_ptr<DBConnectionMemory> connection_;
+  /**
+   * \brief Идентификатор наблюдателя хранилища, 0 - не запущен
+   * */
+  size_t watcher_id_ = 0;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  /**
+   * \brief Изменения, ожидающие раздачи, под `lock_`
+   * */
+  std::deque<db_table_change> queue_;
+  bool running_ = false;
+  std::thread thread_;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_CHANGE_LISTENER_MEMORY_H_
@@ -0,0 +1,113 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_CHANGE_LISTENER_POSTGRESQL_H_
+#define _DATABASE__DB_CHANGE_LISTENER_POSTGRESQL_H_
+
+#include "asp_db/db_change_listener.h"
+#include "asp_db/db_connection.h"
+
+#include <pqxx/pqxx>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Слушатель LISTEN/NOTIFY уведомлений postgresql
+ *
+ * Держит отдельное подключение к БД, на котором выполнены LISTEN
+ *   для каналов таблиц, и поток ожидания уведомлений. Уведомления
+ *   отправляются триггерами: Start устанавливает их на уже
+ *   существующие таблицы, ещё не созданные таблицы получают триггер
+ *   при создании с флагом db_table_create_setup::notify_on_change.
+ *
+ * При ошибке ожидания поток переподключается с растущей задержкой
+ *   и после восстановления раздаёт подписчикам событие RECONNECT
+ * */
+class DBChangeListenerPostgre final : public DBChangeListener {
+ public:
+  DBChangeListenerPostgre(const IDBTables* tables,
+                          const db_parameters& parameters);
+  ~DBChangeListenerPostgre() override;
+
+  mstatus_t Start(const std::vector<db_table>& tables) override;
+  void Stop() override;
+
+ private:
+  /**
+   * \brief Получатель уведомлений канала одной таблицы
+   * */
+  class table_receiver : public pqxx::notification_receiver {
+   public:
+    table_receiver(DBChangeListenerPostgre* owner,
+                   pqxx::connection& connection,
+                   db_table table,
+                   const std::string& channel);
+
+    void operator()(const std::string& payload, int backend_pid) override;
+
+   private:
+    DBChangeListenerPostgre* owner_;
+    db_table table_;
+  };
+
+ private:
+  /**
+   * \brief Открыть подключение и выполнить LISTEN для каналов таблиц
+   * \param install_triggers Установить триггеры на существующие таблицы
+   * \param error Текст ошибки подключения
+   * */
+  bool connect(bool install_triggers, std::string* error);
+  /**
+   * \brief Закрыть подключение слушателя
+   * */
+  void disconnect();
+  /**
+   * \brief Подождать `delay`, прерываясь при остановке слушателя
+   * */
+  void sleepFor(std::chrono::milliseconds delay);
+  /**
+   * \brief Цикл ожидания уведомлений, исполняется в потоке слушателя
+   * */
+  void listenLoop();
+
+ private:
+  /**
+   * \brief Параметры подключения к БД
+   * */
+  db_parameters parameters_;
+  /**
+   * \brief Выделенное подключение для LISTEN
+   * */
+  std::unique_ptr<pqxx::connection> connection_ = nullptr;
+  /**
+   * \brief Получатели уведомлений таблиц
+   * */
+  std::vector<std::unique_ptr<table_receiver>> receivers_;
+  /**
+   * \brief Прослушиваемые таблицы
+   * */
+  std::vector<db_table> tables_list_;
+  /**
+   * \brief Поток ожидания уведомлений
+   * */
+  std::thread thread_;
+  /**
+   * \brief Флаг работы потока
+   * */
+  std::atomic<bool> running_ = false;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_CHANGE_LISTENER_POSTGRESQL_H_
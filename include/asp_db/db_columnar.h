@@ -0,0 +1,219 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_columnar *
+ *   Колоночное представление числовых результатов выборки и
+ *   векторизованная фильтрация по нему
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_COLUMNAR_H_
+#define _DATABASE__DB_COLUMNAR_H_
+
+#include "asp_db/db_defines.h"
+#include "asp_db/db_expression.h"
+#include "asp_db/db_queries_setup.h"
+#include "asp_db/db_queries_setup_select.h"
+
+#include "asp_utils/Base.h"
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Битовая карта выбранных строк: бит `i` - строка `i`
+ *
+ * Биты за пределами `rows` всегда сброшены
+ * */
+struct db_selection {
+  db_selection() = default;
+  /**
+   * \param rows Количество строк
+   * \param value Начальное значение битов
+   * */
+  explicit db_selection(size_t rows, bool value = false);
+
+  /**
+   * \brief Количество строк
+   * */
+  inline size_t Size() const { return rows; }
+  /**
+   * \brief Количество выбранных строк
+   * */
+  size_t Count() const;
+  /**
+   * \brief Строка `i` выбрана
+   * */
+  inline bool Test(size_t i) const {
+    return (words[i >> 6] >> (i & 63)) & 1;
+  }
+  /**
+   * \brief Выбрать строку `i`
+   * */
+  inline void Set(size_t i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+  /**
+   * \brief Индексы выбранных строк по возрастанию
+   * */
+  std::vector<size_t> Indexes() const;
+
+  /**
+   * \brief Пересечение выборок, размеры должны совпадать
+   * */
+  db_selection& operator&=(const db_selection& r);
+  /**
+   * \brief Объединение выборок, размеры должны совпадать
+   * */
+  db_selection& operator|=(const db_selection& r);
+  /**
+   * \brief Инвертировать выборку
+   * */
+  void Invert();
+
+ public:
+  /**
+   * \brief Биты выборки, по 64 строки в слове
+   * */
+  std::vector<uint64_t> words;
+  /**
+   * \brief Количество строк
+   * */
+  size_t rows = 0;
+
+ private:
+  /**
+   * \brief Сбросить биты за пределами `rows`
+   * */
+  void clearTail();
+};
+
+/**
+ * \brief Числовой столбец результата выборки
+ * */
+struct db_numeric_column {
+  /**
+   * \brief Тип хранения значений столбца
+   * */
+  enum class storage_t {
+    /// type_autoinc, type_short, type_int
+    st_int32 = 0,
+    /// type_long
+    st_int64,
+    /// type_real
+    st_real
+  };
+
+ public:
+  storage_t storage = storage_t::st_int32;
+  /**
+   * \brief Значения столбца, заполнен один вектор по `storage`.
+   *   Для NULL значений хранится 0
+   * */
+  std::vector<int32_t> i32;
+  std::vector<int64_t> i64;
+  std::vector<double> real;
+  /**
+   * \brief Карта не NULL значений
+   * */
+  db_selection valid;
+};
+
+/**
+ * \brief Колоночное представление числовых столбцов результата выборки
+ *
+ * При построении числовые столбцы(type_autoinc, type_short, type_int,
+ *   type_long, type_real) разбираются из строк результата в
+ *   непрерывные массивы, по которым фильтры диапазонов и равенства
+ *   вычисляются векторизованно(AVX2 или SSE2, иначе скалярно), по 64
+ *   строки на слово битовой карты выборки. Составные условия деревьев
+ *   where собираются из карт операциями AND/OR.
+ *
+ * \note Условия по нечисловым столбцам, `like` и `raw` узлы здесь не
+ *   вычисляются - для них см. DBWhereEvaluator
+ * */
+class DBColumnarView : public BaseObject {
+ public:
+  typedef db_query_basesetup::field_index field_index;
+  typedef db_query_basesetup::row_values row_values;
+
+ public:
+  /**
+   * \param fields Коллекция полей таблицы, копируется
+   * \param rows Строки результата выборки
+   * */
+  DBColumnarView(const db_fields_collection& fields,
+                 const std::vector<row_values>& rows);
+  explicit DBColumnarView(const db_query_select_result& result);
+
+  /**
+   * \brief Количество строк
+   * */
+  inline size_t RowsCount() const { return rows_count_; }
+  /**
+   * \brief Числовой столбец поля с индексом `i`
+   * \return nullptr если поле не числовое
+   * */
+  const db_numeric_column* GetColumn(field_index i) const;
+
+  /**
+   * \brief Выбрать строки со значением поля `i` в диапазоне [lo, hi]
+   * \note NULL значения не выбираются
+   * */
+  mstatus_t SelectRange(field_index i,
+                        int64_t lo,
+                        int64_t hi,
+                        db_selection* out);
+  mstatus_t SelectRange(field_index i, double lo, double hi, db_selection* out);
+  /**
+   * \brief Выбрать строки, удовлетворяющие дереву условий
+   * \param clause Дерево условий, nullptr - все строки
+   * */
+  mstatus_t Select(
+      const std::shared_ptr<DBWhereClause<where_node_data>>& clause,
+      db_selection* out);
+
+  /**
+   * \brief Имя используемого набора инструкций: avx2, sse2 или scalar
+   * */
+  static const char* KernelName();
+
+ private:
+  void init(const std::vector<row_values>& rows);
+  /**
+   * \brief Собрать карту выборки для поддерева условий
+   * */
+  db_selection selectNode(const expression_node<where_node_data>* node);
+  /**
+   * \brief Собрать карту выборки для оператора сравнения
+   * */
+  db_selection selectLeaf(const expression_node<where_node_data>* node);
+  /**
+   * \brief Найти индекс числового столбца по имени поля
+   * */
+  field_index columnByName(const std::string& fname) const;
+
+ private:
+  /**
+   * \brief Копия коллекции полей таблицы: представление не зависит
+   *   от времени жизни коллекции, переданной в конструктор
+   * */
+  db_fields_collection fields_;
+  /**
+   * \brief Числовые столбцы по индексу поля, nullptr для нечисловых
+   * */
+  std::vector<std::unique_ptr<db_numeric_column>> columns_;
+  /**
+   * \brief Количество строк
+   * */
+  size_t rows_count_ = 0;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_COLUMNAR_H_
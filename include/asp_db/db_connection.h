@@ -16,6 +16,7 @@
 #define _DATABASE__DB_CONNECTION_H_
 
 #include "asp_db/db_defines.h"
+#include "asp_db/db_log.h"
 #include "asp_db/db_queries_setup.h"
 #include "asp_db/db_queries_setup_select.h"
 #include "asp_db/db_tables.h"
@@ -24,16 +25,17 @@
 #include "asp_utils/Common.h"
 #include "asp_utils/Logging.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
 
-#ifndef IS_DEBUG_MODE
-#define IS_DEBUG_MODE false
-#endif  // !IS_DEBUG_MODE
-
 namespace asp_db {
+class DBDryRunSink;
+class DBJournalWriter;
+struct db_fault_config;
+
 /**
  * \brief Структура параметров подключения
  * */
@@ -69,6 +71,32 @@ struct db_parameters {
    * выводить получившееся запросы в stdout(или логировать)
    * */
   bool is_dry_run;
+  /**
+   * \brief Файл для запросов dry_run режима. Если задан, сообщения
+   *   пишутся в него асинхронно(DBDryRunSink), а не в логгер
+   * */
+  std::string dry_run_file;
+  /**
+   * \brief Файл двоичного журнала запросов dry_run режима(DBJournalWriter)
+   *   для воспроизведения утилитой `asp_db-replay`
+   * */
+  std::string dry_run_journal;
+  /**
+   * \brief Конфигурация внесения задержек и ошибок, если задана -
+   *   подключение оборачивается в DBConnectionFaults
+   * */
+  std::shared_ptr<const db_fault_config> faults;
+  /**
+   * \brief Порог журнала медленных запросов, нулевое значение
+   *   отключает журнал
+   * */
+  std::chrono::microseconds slow_query_threshold{0};
+  /**
+   * \brief Снимать план медленного запроса(EXPLAIN) на отдельном
+   *   подключении, не чаще одного раза за `slow_query_explain_interval`
+   * */
+  bool slow_query_explain = false;
+  std::chrono::milliseconds slow_query_explain_interval{1000};
 
  public:
   db_parameters();
@@ -111,6 +139,16 @@ class DBConnection : public BaseObject {
    * \brief Установка соединения
    * */
   virtual mstatus_t SetupConnection() = 0;
+  /**
+   * \brief Следующая транзакция только читает данные
+   *
+   * Задаётся до SetupConnection. Подключение может не открывать
+   *   явную транзакцию(PostgreSQL, SQLite) или открыть транзакцию
+   *   только для чтения(Firebird). Точки сохранения для таких
+   *   транзакций не добавляются
+   * */
+  void SetReadOnly(bool read_only);
+  bool IsReadOnly() const;
   /**
    * \brief Закрытие соединения
    */
@@ -160,6 +198,8 @@ class DBConnection : public BaseObject {
   virtual mstatus_t UpdateRows(const db_query_update_setup& update_data) = 0;
 
   bool IsOpen() const;
+  /** \brief Сообщение последней ошибки подключения */
+  std::string GetErrorMessage() const;
 
  protected:
   /**
@@ -239,6 +279,14 @@ class DBConnection : public BaseObject {
    * \brief Собрать строку первичного ключа
    * */
   virtual std::string db_primarykey_to_string(const db_complex_pk& pk);
+  /**
+   * \brief Собрать начало INSERT запроса `INSERT INTO table (a, b)`
+   *   по столбцам пакета сетапа
+   * \return Номера столбцов пакета, добавленных в запрос. Столбцы
+   *   без значений во всех строках пропускаются
+   * */
+  std::vector<size_t> setupInsertColumns(const db_query_insert_setup& fields,
+                                         std::string* fnames);
   /**
    * \brief Подключение к БД сымитировано
    * */
@@ -250,6 +298,20 @@ class DBConnection : public BaseObject {
   void passToLogger(io_loglvl ll,
                     const std::string& logger,
                     const std::string& msg);
+  /**
+   * \brief Дождаться записи сообщений dry_run режима в файл
+   * */
+  void flushDryRun();
+  /**
+   * \brief Записать запрос dry_run режима в журнал, если он задан
+   * */
+  void journalStatement(const std::string& sql);
+  /**
+   * \brief Записать в журнал начало(`begin`) или завершение транзакции,
+   *   завершение без начала(закрытие неоткрытого подключения)
+   *   не записывается
+   * */
+  void journalTransaction(const std::string& sql, bool begin);
 
  protected:
   /**
@@ -264,10 +326,26 @@ class DBConnection : public BaseObject {
    * \brief Указатель на логгер операций бд
    * */
   PrivateLogging* logger_ = nullptr;
+  /**
+   * \brief Асинхронный сток dry_run сообщений, общий для копий
+   *   подключения
+   * */
+  std::shared_ptr<DBDryRunSink> dry_run_sink_;
+  /**
+   * \brief Журнал запросов dry_run режима, общий для копий
+   *   подключения, и номер подключения в нём
+   * */
+  std::shared_ptr<DBJournalWriter> journal_;
+  uint32_t journal_connection_ = 0;
+  bool journal_transaction_ = false;
   /**
    * \brief Флаг подключения к бд
    * */
   bool is_connected_ = false;
+  /**
+   * \brief Транзакция только для чтения
+   * */
+  bool is_read_only_ = false;
 };
 }  // namespace asp_db
 
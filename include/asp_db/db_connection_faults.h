@@ -0,0 +1,233 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_CONNECTION_FAULTS_H_
+#define _DATABASE__DB_CONNECTION_FAULTS_H_
+
+#include "asp_db/db_connection.h"
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace asp_db {
+/**
+ * \brief Операции подключения, для которых задаются правила
+ *   внесения задержек и ошибок
+ * */
+enum class db_fault_op : uint32_t {
+  setup_connection = 0,
+  close_connection,
+  add_save_point,
+  rollback_to_save_point,
+  is_table_exists,
+  get_table_format,
+  check_table_format,
+  update_table,
+  create_table,
+  drop_table,
+  insert_rows,
+  delete_rows,
+  select_rows,
+  update_rows,
+  /// количество операций, не операция
+  count
+};
+
+/**
+ * \brief Распределение вносимой задержки
+ * */
+enum class db_latency_dist : uint32_t {
+  /// задержки нет
+  none = 0,
+  /// постоянная задержка `base`
+  fixed,
+  /// равномерно в [base, base + spread]
+  uniform,
+  /// base + экспоненциальная со средним `spread`
+  exponential
+};
+
+/**
+ * \brief Правило внесения задержек и ошибок для операции
+ * */
+struct db_fault_rule {
+  /**
+   * \brief Распределение задержки перед выполнением операции
+   * */
+  db_latency_dist dist = db_latency_dist::none;
+  std::chrono::microseconds base{0};
+  std::chrono::microseconds spread{0};
+  /**
+   * \brief Вероятность дополнительной задержки `tail_latency`,
+   *   для хвоста распределения(p99 и т.п.)
+   * */
+  double tail_probability = 0.0;
+  std::chrono::microseconds tail_latency{0};
+  /**
+   * \brief Вероятность ошибки операции. Операция с ошибкой
+   *   до оборачиваемого подключения не доходит
+   * */
+  double error_probability = 0.0;
+  /**
+   * \brief Код ошибки, 0 - ERROR_DB_CONNECTION для SetupConnection
+   *   и ERROR_DB_OPERATION для остальных операций
+   * */
+  merror_t error = 0;
+};
+
+/**
+ * \brief Конфигурация внесения задержек и ошибок
+ * */
+struct db_fault_config {
+  /**
+   * \brief Зерно генератора. Копия подключения получает зерно
+   *   `seed + номер копии`, так что при одном порядке создания
+   *   копий последовательность задержек и ошибок повторяется
+   * */
+  uint64_t seed = 0;
+  /**
+   * \brief Правила по операциям, индекс - db_fault_op
+   * */
+  std::array<db_fault_rule, static_cast<size_t>(db_fault_op::count)> rules;
+
+ public:
+  /**
+   * \brief Правило операции `op`
+   * */
+  db_fault_rule& Rule(db_fault_op op);
+  const db_fault_rule& Rule(db_fault_op op) const;
+  /**
+   * \brief Установить правило `rule` для всех операций
+   * */
+  void SetAll(const db_fault_rule& rule);
+};
+
+/**
+ * \brief Счётчики внесённых задержек и ошибок, общие для
+ *   подключения и его копий
+ * */
+struct db_fault_stats {
+  /** \brief Операций через подключение */
+  std::atomic<uint64_t> operations{0};
+  /** \brief Внесено ошибок */
+  std::atomic<uint64_t> errors{0};
+  /** \brief Суммарная внесённая задержка, мкс */
+  std::atomic<uint64_t> latency_us{0};
+};
+
+/**
+ * \brief Декоратор подключения, вносящий задержки и ошибки в операции
+ *   оборачиваемого подключения
+ *
+ * Используется для воспроизводимой проверки поведения
+ *   DBConnectionManager на медленной и нестабильной БД(размеры пулов,
+ *   таймауты, повторы). Задаётся полем db_parameters::faults, тогда
+ *   DBConnectionManager оборачивает им подключение любого клиента,
+ *   в том числе в режиме dry_run.
+ *
+ * Задержка вносится перед выполнением операции, ошибка - вместо её
+ *   выполнения. CloseConnection и RollbackToSavePoint ошибок не
+ *   возвращают, для них вносится только задержка.
+ *
+ * \note Случайные величины считаются по битам std::mt19937_64 без
+ *   std::*_distribution, чтобы последовательность не зависела от
+ *   стандартной библиотеки
+ * */
+class DBConnectionFaults final : public DBConnection {
+  ADD_TEST_CLASS(DBConnectionFaultsProxy)
+
+ public:
+  /**
+   * \brief Обернуть подключение `connection`
+   * \param connection Оборачиваемое подключение
+   * \param config Конфигурация задержек и ошибок
+   * */
+  DBConnectionFaults(std::shared_ptr<DBConnection> connection,
+                     const db_fault_config& config,
+                     const IDBTables* tables,
+                     const db_parameters& parameters,
+                     PrivateLogging* logger = nullptr);
+
+  std::shared_ptr<DBConnection> CloneConnection() override;
+
+  mstatus_t AddSavePoint(const db_save_point& sp) override;
+  void RollbackToSavePoint(const db_save_point& sp) override;
+
+  mstatus_t SetupConnection() override;
+  void CloseConnection() override;
+
+  mstatus_t IsTableExists(db_table t, bool* is_exists) override;
+  mstatus_t GetTableFormat(db_table t, db_table_create_setup* fields) override;
+  mstatus_t CheckTableFormat(const db_table_create_setup& fields) override;
+  mstatus_t UpdateTable(const db_table_create_setup& fields) override;
+  mstatus_t CreateTable(const db_table_create_setup& fields) override;
+  mstatus_t DropTable(const db_table_drop_setup& drop) override;
+
+  mstatus_t InsertRows(const db_query_insert_setup& insert_data,
+                       id_container* id_vec) override;
+  mstatus_t DeleteRows(const db_query_delete_setup& delete_data) override;
+  mstatus_t SelectRows(const db_query_select_setup& select_data,
+                       db_query_select_result* result_data) override;
+  mstatus_t UpdateRows(const db_query_update_setup& update_data) override;
+
+  /**
+   * \brief Счётчики подключения и его копий
+   * */
+  const db_fault_stats& GetStats() const;
+
+ private:
+  /**
+   * \brief Общее состояние подключения и его копий
+   * */
+  struct shared_state {
+    db_fault_config config;
+    db_fault_stats stats;
+    /** \brief Количество созданных копий */
+    std::atomic<uint64_t> clones{0};
+  };
+
+ private:
+  DBConnectionFaults(const DBConnectionFaults& r,
+                     std::shared_ptr<DBConnection> connection);
+
+  /**
+   * \brief Внести задержку операции `op` и разыграть ошибку
+   * \return true, если операцию надо выполнить
+   * */
+  bool inject(db_fault_op op);
+  /**
+   * \brief Перенести статус и ошибку оборачиваемого подключения
+   * */
+  mstatus_t forward(mstatus_t st);
+  /**
+   * \brief Равномерно распределённая величина в [0, 1)
+   * */
+  double uniform();
+
+  std::stringstream setupTableExistsString(db_table t) override;
+  std::stringstream setupGetColumnsInfoString(db_table t) override;
+
+  std::string db_variable_to_string(const db_variable& dv) override;
+
+ private:
+  std::shared_ptr<shared_state> state_;
+  std::shared_ptr<DBConnection> connection_;
+  std::mt19937_64 rng_;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_CONNECTION_FAULTS_H_
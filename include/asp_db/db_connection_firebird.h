@@ -11,6 +11,7 @@
 #define _DATABASE__DB_CONNECTION_FIREBIRD_H_
 
 #include "asp_db/db_connection.h"
+#include "asp_db/db_query_stats.h"
 
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
@@ -129,13 +130,15 @@ class DBConnectionFireBird final : public DBConnection {
     sstr.seekg(0, std::ios::end);
     auto sstr_len = sstr.tellg();
     if (firebird_work.IsAvailable() && sstr_len) {
+      DBQueryStats::Statement stat(DBQueryStats::Global());
       try {
         // execute query
         // todo: почему не возвращает статус?
         std::invoke(exec_m, *this, sstr, res);
-        if (IS_DEBUG_MODE)
-          Logging::Append(io_loglvl::debug_logs,
-                          "Debug mode: \n\tЗапрос БД: " + sstr.str() + "\n\t");
+        // результат firebird пока не разбирается, учитывается
+        //   только текст запроса
+        stat.Finish(sstr.str(), 0, 0);
+        DB_LOG_DEBUG("Debug mode: \n\tЗапрос БД: ", sstr.str(), "\n\t");
 
       } catch (const FbException& e) {
         status_ = STATUS_HAVE_ERROR;
@@ -159,6 +162,7 @@ class DBConnectionFireBird final : public DBConnection {
         if (sstr_len) {
           passToLogger(io_loglvl::info_logs, FIREBIRD_DRYRUN_LOGGER,
                        "dry_run: " + sstr.str());
+          journalStatement(sstr.str());
         } else {
           passToLogger(io_loglvl::info_logs, FIREBIRD_DRYRUN_LOGGER,
                        "dry_run: 'empty query!'");
@@ -13,12 +13,18 @@
 #ifndef _DATABASE__DB_CONNECTION_MANAGER_H_
 #define _DATABASE__DB_CONNECTION_MANAGER_H_
 
+#include "asp_db/db_change_listener.h"
 #include "asp_db/db_connection.h"
 #include "asp_db/db_defines.h"
+#include "asp_db/db_group_commit.h"
+#include "asp_db/db_metrics.h"
 #include "asp_db/db_queries_setup.h"
 #include "asp_db/db_queries_setup_select.h"
 #include "asp_db/db_query.h"
+#include "asp_db/db_query_cache.h"
 #include "asp_db/db_tables.h"
+#include "asp_db/db_trace.h"
+#include "asp_db/db_write_behind.h"
 
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
@@ -26,7 +32,11 @@
 #include "asp_utils/ThreadWrap.h"
 
 #include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace asp_db {
@@ -143,9 +153,20 @@ class DBConnectionManager : public BaseObject {
   mstatus_t CreateTable(db_table dt);
 
   /* insert operations */
-  /** \brief Сохранить в БД строку */
+  /**
+   * \brief Сохранить в БД строку
+   * \note При включенном групповом добавлении строка может быть
+   *   добавлена одной транзакцией со строками других потоков,
+   *   см. EnableGroupCommit
+   * */
   template <class TableI>
   mstatus_t SaveSingleRow(TableI& ti, int* id_p = nullptr);
+  /**
+   * \brief Сохранить в БД строку, переместив её данные в сетап
+   *   добавления
+   * */
+  template <class TableI>
+  mstatus_t SaveSingleRow(TableI&& ti, int* id_p = nullptr);
   /**
    * \brief Сохранить в БД вектор строк.
    * \todo replace with generic container
@@ -153,6 +174,21 @@ class DBConnectionManager : public BaseObject {
   template <class TableI>
   mstatus_t SaveVectorOfRows(const std::vector<TableI>& tis,
                              id_container* id_vec_p = nullptr);
+  /**
+   * \brief Сохранить в БД вектор строк, переместив их данные
+   *   в сетап добавления
+   * */
+  template <class TableI>
+  mstatus_t SaveVectorOfRows(std::vector<TableI>&& tis,
+                             id_container* id_vec_p = nullptr);
+  /**
+   * \brief Сохранить в БД строки диапазона [first, last), для
+   *   std::move_iterator данные строк перемещаются
+   * */
+  template <class ForwardIt>
+  mstatus_t SaveVectorOfRows(ForwardIt first,
+                             ForwardIt last,
+                             id_container* id_vec_p = nullptr);
   /**
    * \brief Сохранить в БД строки ещё не добавленные.
    * \todo replace with generic container
@@ -232,6 +268,119 @@ class DBConnectionManager : public BaseObject {
    * */
   mstatus_t UpdateTableFormat(db_table dt);
 
+  /* query cache */
+  /**
+   * \brief Включить кэш результатов выборки
+   *
+   * Результаты SELECT запросов сохраняются в кэш по ключу из таблицы,
+   *   строки WHERE условий и набора полей. Операции добавления и
+   *   удаления строк и создания таблицы, проходящие через менеджер,
+   *   инвалидируют записи таблицы. Включать и отключать кэш можно
+   *   во время работы других потоков: выборка, начатая со старым
+   *   кэшем, завершается с ним.
+   * \note Изменения данных в обход менеджера кэш не отслеживает
+   * */
+  void EnableQueryCache(const db_query_cache_parameters& parameters);
+  /**
+   * \brief Отключить кэш результатов выборки
+   * */
+  void DisableQueryCache();
+  /**
+   * \brief Удалить из кэша результаты выборок таблицы `table`
+   * */
+  void InvalidateQueryCache(db_table table);
+
+  /* group commit */
+  /**
+   * \brief Включить групповое добавление строк SaveSingleRow
+   *
+   * Одновременные добавления одиночных строк одной таблицы из разных
+   *   потоков собираются в течение окна `parameters.window`(или до
+   *   `parameters.max_rows` строк) и добавляются одним запросом в
+   *   одной транзакции. Задержка добавления строки ограничена окном
+   * \note Включать и отключать до начала работы потоков с менеджером
+   * */
+  void EnableGroupCommit(const db_group_commit_parameters& parameters);
+  /**
+   * \brief Отключить групповое добавление строк
+   * */
+  void DisableGroupCommit();
+  /**
+   * \brief Групповое добавление строк, nullptr если отключено
+   * */
+  const DBGroupCommit* GetGroupCommit() const;
+
+  /* write-behind */
+  /**
+   * \brief Включить отложенное добавление строк EnqueueSave
+   *
+   * Строки ставятся в очередь своей таблицы и добавляются фоновым
+   *   потоком пакетами через SaveVectorOfRows, результат пакета
+   *   передаётся `parameters.on_batch`
+   * \note Включать и отключать до начала работы потоков с менеджером
+   * */
+  void EnableWriteBehind(const db_write_behind_parameters& parameters);
+  /**
+   * \brief Отключить отложенное добавление, дописав строки очередей
+   * */
+  void DisableWriteBehind();
+  /**
+   * \brief Дождаться добавления строк, поставленных в очередь
+   *   до вызова
+   * */
+  void FlushWriteBehind();
+  /**
+   * \brief Отложенное добавление строк, nullptr если отключено
+   * */
+  const DBWriteBehind* GetWriteBehind() const;
+  /**
+   * \brief Поставить строку в очередь отложенного добавления
+   *
+   * Возвращает управление не дожидаясь добавления строки, кроме
+   *   переполнения очередей
+   * \return STATUS_NOT если отложенное добавление не включено
+   * */
+  template <class TableI>
+  mstatus_t EnqueueSave(TableI ti);
+
+  /* change notifications */
+  /**
+   * \brief Запустить слушатель уведомлений об изменении таблиц `tables`
+   *
+   * Слушатель держит отдельное подключение к БД. Если включён кэш
+   *   выборки, его записи инвалидируются по уведомлениям, в том числе
+   *   об изменениях сделанных в обход менеджера.
+   * \note Для postgresql триггеры уведомлений устанавливаются на
+   *   существующие таблицы `tables` при запуске и на новые при
+   *   создании, см. db_table_create_setup::notify_on_change. Для БД
+   *   в памяти уведомления отправляются при фиксации транзакции
+   * */
+  mstatus_t StartChangeListener(const std::vector<db_table>& tables);
+  /**
+   * \brief Остановить слушатель уведомлений
+   * */
+  void StopChangeListener();
+  /**
+   * \brief Подписаться на изменения таблицы `table`
+   * \note Обработчик вызывается из потока слушателя
+   *
+   * \return Идентификатор подписки или 0, если слушатель не запущен
+   * */
+  size_t SubscribeTableChanges(db_table table, db_change_callback callback);
+  /**
+   * \brief Отменить подписку на изменения таблицы
+   * \note Ждёт завершения исполняемого обработчика подписки, см.
+   *   DBChangeListener::Unsubscribe
+   * */
+  void UnsubscribeTableChanges(size_t id);
+  /**
+   * \brief Замеры DBMetrics в текстовом формате Prometheus
+   *   с именами таблиц
+   * \note Замеры общие для всех менеджеров процесса, включаются
+   *   DBMetrics::SetEnabled
+   * */
+  std::string GetMetricsPrometheus() const;
+
  private:
   class DBConnectionCreator;
   typedef DBConnectionManager::DBConnectionCreator ConnectionCreator;
@@ -240,14 +389,30 @@ class DBConnectionManager : public BaseObject {
   template <class TableI>
   mstatus_t selectRowsImp(std::shared_ptr<db_query_select_setup>& dss,
                           std::vector<TableI>* res) {
+    DBMetrics::Scope metrics(db_metric_op::select_rows, dss->table);
     db_query_select_result result(*dss);
+    auto cache = queryCache();
+    // поколение до выборки: изменение таблицы во время выборки
+    //   не даст сохранить её результат
+    const uint64_t generation = (cache) ? cache->Generation(dss->table) : 0;
+    if (cache && cache->Get(*dss, &result)) {
+      DBMetrics::Timer timer(db_metric_stage::set_select_data);
+      DBTrace::Span span(db_trace_category::manager, "SetSelectData");
+      tables_->SetSelectData(&result, res);
+      return STATUS_OK;
+    }
     auto st = exec_wrap<const db_query_select_setup&, db_query_select_result,
                         void (DBConnectionManager::*)(
                             Transaction*, const db_query_select_setup&,
                             db_query_select_result*)>(
-        *dss, &result, &DBConnectionManager::selectRows, nullptr);
-    if (is_status_ok(st))
+        *dss, &result, &DBConnectionManager::selectRows, nullptr, true);
+    if (is_status_ok(st)) {
+      if (cache)
+        cache->Put(*dss, result, generation);
+      DBMetrics::Timer timer(db_metric_stage::set_select_data);
+      DBTrace::Span span(db_trace_category::manager, "SetSelectData");
       tables_->SetSelectData(&result, res);
+    }
     return st;
   }
   /**
@@ -256,7 +421,21 @@ class DBConnectionManager : public BaseObject {
   template <class TableI>
   mstatus_t saveRowsImp(const db_query_insert_setup& dis,
                         id_container* id_vec_p);
+  /**
+   * \brief Добавить строку сетапа dis, записать её id в id_p
+   * */
+  template <class TableI>
+  mstatus_t saveSingleRow(db_query_insert_setup* dis, int* id_p);
+  /**
+   * \brief Добавить строку через групповое добавление
+   * */
+  template <class TableI, class RowT>
+  mstatus_t groupSaveSingleRow(RowT&& row, int* id_p);
   mstatus_t deleteRowsImp(const std::shared_ptr<db_query_delete_setup>& dds);
+  /**
+   * \brief Текущий кэш результатов выборки, nullptr если отключен
+   * */
+  std::shared_ptr<DBQueryCache> queryCache() const;
   /**
    * \brief Обёртка над функционалом сбора и выполнения транзакции:
    *   подключение, создание точки сохранения
@@ -265,6 +444,9 @@ class DBConnectionManager : public BaseObject {
    * \param SetupQueryF setup_m метод на добавление
    *   специализированного запроса(Query) к транзакции
    * \param sp_ptr указатель на сетап точки сохранения
+   * \param read_only транзакция только читает данные: подключение
+   *   может не оборачивать её в begin/commit, см.
+   *   DBConnection::SetReadOnly
    *
    * \todo Слишком много шаблонных параметров получается,
    *   не очень красиво смотрится
@@ -273,7 +455,8 @@ class DBConnectionManager : public BaseObject {
   mstatus_t exec_wrap(DataT data,
                       OutT* res,
                       SetupQueryF setup_m,
-                      db_save_point* sp_ptr);
+                      db_save_point* sp_ptr,
+                      bool read_only = false);
   /**
    * \brief Проинициализировать соединение с БД
    * */
@@ -321,6 +504,34 @@ class DBConnectionManager : public BaseObject {
    * \note Мэйби контейнер??? Хотя лучше несколько менеджеров держать
    * */
   std::unique_ptr<DBConnection> db_connection_;
+  /**
+   * \brief Кэш результатов выборки, nullptr если кэш отключен
+   * */
+  std::shared_ptr<DBQueryCache> query_cache_ = nullptr;
+  /**
+   * \brief Блокировка замены `query_cache_`
+   * */
+  mutable std::mutex query_cache_lock_;
+  /**
+   * \brief Групповое добавление строк, nullptr если отключено
+   * */
+  std::unique_ptr<DBGroupCommit> group_commit_ = nullptr;
+  /**
+   * \brief Слушатель уведомлений об изменении таблиц
+   * \note Объявлен после кэша - останавливается раньше его удаления.
+   *   Отписка держит копию указателя вне `change_listener_lock_`
+   * */
+  std::shared_ptr<DBChangeListener> change_listener_ = nullptr;
+  /**
+   * \brief Блокировка замены `change_listener_` и подписок
+   * */
+  std::mutex change_listener_lock_;
+  /**
+   * \brief Отложенное добавление строк, nullptr если отключено
+   * \note Объявлено последним - дописывает очереди через
+   *   подключение менеджера до его удаления
+   * */
+  std::unique_ptr<DBWriteBehind> write_behind_ = nullptr;
 };
 
 /**
@@ -350,6 +561,18 @@ class DBConnectionManager::DBConnectionCreator {
    * \return Указатель на реализацию подключения или nullptr
    * */
   std::shared_ptr<DBConnection> cloneConnection(DBConnection* orig) const;
+  /**
+   * \brief Создать слушатель уведомлений об изменении таблиц
+   * \param tables Указатель на класс реализующий
+   *   операции с таблицами БД
+   * \param parameters Параметры подключения
+   *
+   * \return Указатель на слушатель или nullptr, если СУБД
+   *   уведомления не поддерживает
+   * */
+  std::unique_ptr<DBChangeListener> initChangeListener(
+      const IDBTables* tables,
+      const db_parameters& parameters) const;
 
  private:
   /**
@@ -361,33 +584,83 @@ class DBConnectionManager::DBConnectionCreator {
 /* template methods of DBConnectionManager */
 template <class TableI>
 mstatus_t DBConnectionManager::SaveSingleRow(TableI& ti, int* id_p) {
+  typedef std::remove_const_t<TableI> table_t;
+  if (group_commit_)
+    return groupSaveSingleRow<table_t>(static_cast<const table_t&>(ti), id_p);
   std::unique_ptr<db_query_insert_setup> dis(
-      tables_->InitInsertSetup<TableI>({ti}));
+      tables_->InitInsertSetup<table_t>(&ti, &ti + 1));
+  return saveSingleRow<table_t>(dis.get(), id_p);
+}
+template <class TableI>
+mstatus_t DBConnectionManager::SaveSingleRow(TableI&& ti, int* id_p) {
+  // для lvalue выбирается перегрузка `TableI&`
+  static_assert(!std::is_reference<TableI>::value);
+  if (group_commit_)
+    return groupSaveSingleRow<TableI>(std::move(ti), id_p);
+  std::unique_ptr<db_query_insert_setup> dis(tables_->InitInsertSetup<TableI>(
+      std::make_move_iterator(&ti), std::make_move_iterator(&ti + 1)));
+  return saveSingleRow<TableI>(dis.get(), id_p);
+}
+template <class TableI>
+mstatus_t DBConnectionManager::saveSingleRow(db_query_insert_setup* dis,
+                                             int* id_p) {
   id_container id_vec;
   mstatus_t st = STATUS_NOT;
-  if (dis.get() != nullptr) {
+  if (dis != nullptr) {
     st = saveRowsImp<TableI>(*dis, &id_vec);
   } else {
-    Logging::Append(io_loglvl::warn_logs,
-                    "Ошибка добавления набора строк в SaveSingleRow \n"
-                    "к БД - не инициализирован сетап добавляемыхх данных");
+    DB_LOG_WARN("Ошибка добавления набора строк в SaveSingleRow \n"
+                "к БД - не инициализирован сетап добавляемыхх данных");
   }
   if (id_vec.id_vec.size() && id_p)
     *id_p = id_vec.id_vec[0];
   return st;
 }
+template <class TableI, class RowT>
+mstatus_t DBConnectionManager::groupSaveSingleRow(RowT&& row, int* id_p) {
+  return group_commit_->Save(
+      tables_->GetTableCode<TableI>(), std::forward<RowT>(row), id_p,
+      [this](auto first, auto last, id_container* ids) {
+        return SaveVectorOfRows(first, last, ids);
+      });
+}
+template <class TableI>
+mstatus_t DBConnectionManager::EnqueueSave(TableI ti) {
+  if (!write_behind_) {
+    DB_LOG_WARN("EnqueueSave: отложенное добавление строк не включено");
+    return STATUS_NOT;
+  }
+  write_behind_->Enqueue(
+      tables_->GetTableCode<TableI>(), std::move(ti),
+      [this](std::vector<TableI>&& rows, id_container* ids) {
+        return SaveVectorOfRows(std::move(rows), ids);
+      });
+  return STATUS_OK;
+}
 template <class TableI>
 mstatus_t DBConnectionManager::SaveVectorOfRows(const std::vector<TableI>& tis,
                                                 id_container* id_vec_p) {
+  return SaveVectorOfRows(tis.begin(), tis.end(), id_vec_p);
+}
+template <class TableI>
+mstatus_t DBConnectionManager::SaveVectorOfRows(std::vector<TableI>&& tis,
+                                                id_container* id_vec_p) {
+  return SaveVectorOfRows(std::make_move_iterator(tis.begin()),
+                          std::make_move_iterator(tis.end()), id_vec_p);
+}
+template <class ForwardIt>
+mstatus_t DBConnectionManager::SaveVectorOfRows(ForwardIt first,
+                                                ForwardIt last,
+                                                id_container* id_vec_p) {
+  typedef typename std::iterator_traits<ForwardIt>::value_type TableI;
   std::unique_ptr<db_query_insert_setup> dis(
-      tables_->InitInsertSetup<TableI>(tis));
+      tables_->InitInsertSetup<TableI>(first, last));
   mstatus_t st = STATUS_NOT;
   if (dis.get() != nullptr) {
     st = saveRowsImp<TableI>(*dis, id_vec_p);
   } else {
-    Logging::Append(io_loglvl::warn_logs,
-                    "Ошибка добавления набора строк в SaveVectorOfRows \n"
-                    "к БД - не инициализирован сетап добавляемыхх данных");
+    DB_LOG_WARN("Ошибка добавления набора строк в SaveVectorOfRows \n"
+                "к БД - не инициализирован сетап добавляемыхх данных");
   }
   return st;
 }
@@ -403,9 +676,8 @@ mstatus_t DBConnectionManager::SaveNotExistsRows(
     dis->SetOnExistAct(on_exists);
     st = saveRowsImp<TableI>(*dis, id_vec_p);
   } else {
-    Logging::Append(io_loglvl::warn_logs,
-                    "Ошибка добавления набора строк в SaveNotExistsRows"
-                    "к БД - не инициализирован сетап добавляемыхх данных");
+    DB_LOG_WARN("Ошибка добавления набора строк в SaveNotExistsRows"
+                "к БД - не инициализирован сетап добавляемыхх данных");
   }
   return st;
 }
@@ -413,29 +685,41 @@ mstatus_t DBConnectionManager::SaveNotExistsRows(
 template <class TableI>
 mstatus_t DBConnectionManager::saveRowsImp(const db_query_insert_setup& dis,
                                            id_container* id_vec_p) {
+  DBMetrics::Scope metrics(db_metric_op::insert_rows, dis.table);
   db_save_point sp("save_" + tables_->GetTableName<TableI>());
-  return exec_wrap<const db_query_insert_setup&, id_container,
-                   void (DBConnectionManager::*)(Transaction*,
-                                                 const db_query_insert_setup&,
-                                                 id_container*)>(
-      dis, id_vec_p, &DBConnectionManager::saveRows, &sp);
+  auto st = exec_wrap<const db_query_insert_setup&, id_container,
+                      void (DBConnectionManager::*)(
+                          Transaction*, const db_query_insert_setup&,
+                          id_container*)>(dis, id_vec_p,
+                                          &DBConnectionManager::saveRows, &sp);
+  InvalidateQueryCache(dis.table);
+  return st;
 }
 
 template <class DataT, class OutT, class SetupQueryF>
 mstatus_t DBConnectionManager::exec_wrap(DataT data,
                                          OutT* res,
                                          SetupQueryF setup_m,
-                                         db_save_point* sp_ptr) {
+                                         db_save_point* sp_ptr,
+                                         bool read_only) {
   if (status_ == STATUS_DEFAULT)
     status_ = CheckConnection();
   mstatus_t trans_st = STATUS_NOT;
+  DBMetrics::Timer total(db_metric_stage::total);
+  DBTrace::Span total_span(db_trace_category::manager, "Transaction");
   if (db_connection_ && is_status_aval(status_)) {
+    DBMetrics::Timer clone(db_metric_stage::clone_connection);
+    DBTrace::Span clone_span(db_trace_category::manager, "CloneConnection");
     auto c = DBConnectionCreator().cloneConnection(db_connection_.get());
+    clone.Finish(c.get() != nullptr);
+    clone_span.Finish();
     if (c.get()) {
       Transaction tr(c.get());
-      tr.AddQuery(QuerySmartPtr(new DBQuerySetupConnection(c.get())));
-      // добавить точку сохранения, если есть необходимость
-      if (sp_ptr)
+      tr.AddQuery(
+          QuerySmartPtr(new DBQuerySetupConnection(c.get(), read_only)));
+      // добавить точку сохранения, если есть необходимость,
+      //   чтение откатывать нечего
+      if (sp_ptr && !read_only)
         tr.AddQuery(QuerySmartPtr(new DBQueryAddSavePoint(c.get(), *sp_ptr)));
       // добавить специализированные запросы
       std::invoke(setup_m, *this, &tr, data, res);
@@ -458,6 +742,7 @@ mstatus_t DBConnectionManager::exec_wrap(DataT data,
                         + parameters_.GetInfo());
     status_ = trans_st = STATUS_HAVE_ERROR;
   }
+  total.Finish(is_status_ok(trans_st));
   return trans_st;
 }
 }  // namespace asp_db
@@ -0,0 +1,156 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_CONNECTION_MEMORY_H_
+#define _DATABASE__DB_CONNECTION_MEMORY_H_
+
+#include "asp_db/db_change_listener.h"
+#include "asp_db/db_connection.h"
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+#include "asp_utils/Logging.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace asp_db {
+namespace memory_impl {
+struct memory_storage;
+struct memory_table;
+struct undo_log;
+}  // namespace memory_impl
+
+/**
+ * \brief Реализация DBConnection над таблицами в памяти процесса
+ *
+ * Таблицы хранятся в хранилище, общем для всех подключений с одним
+ *   именем БД(db_parameters::name): копии подключения, созданные
+ *   CloneConnection, и подключения разных менеджеров видят одни и те
+ *   же данные. Хранилище живёт, пока живо хотя бы одно подключение
+ *   к нему.
+ *
+ * Условия where вычисляются DBWhereEvaluator, без сборки строк
+ *   запросов. Поддерживаются:
+ *   - автоинкремент(type_autoinc) и значения по умолчанию;
+ *   - ограничения NOT NULL, первичный ключ и уникальные комплексы,
+ *     с учётом insert_on_exists_act;
+ *   - транзакции: изменения записываются в журнал отката подключения,
+ *     RollbackToSavePoint откатывает их до точки сохранения,
+ *     CloseConnection фиксирует;
+ *   - уведомления наблюдателей хранилища об изменении таблиц при
+ *     фиксации транзакции, см. AddChangeWatcher.
+ *
+ * \note Изоляции транзакций нет: изменения видны другим подключениям
+ *   сразу(read uncommitted). Внешние ключи не проверяются, флаг
+ *   is_dry_run игнорируется
+ * */
+class DBConnectionMemory final : public DBConnection {
+  ADD_TEST_CLASS(DBConnectionMemoryProxy)
+
+ public:
+  DBConnectionMemory(const IDBTables* tables,
+                     const db_parameters& parameters,
+                     PrivateLogging* logger = nullptr);
+
+  ~DBConnectionMemory() override;
+
+  std::shared_ptr<DBConnection> CloneConnection() override;
+
+  mstatus_t AddSavePoint(const db_save_point& sp) override;
+  void RollbackToSavePoint(const db_save_point& sp) override;
+
+  mstatus_t SetupConnection() override;
+  void CloseConnection() override;
+
+  mstatus_t IsTableExists(db_table t, bool* is_exists) override;
+  mstatus_t GetTableFormat(db_table t, db_table_create_setup* fields) override;
+  mstatus_t CheckTableFormat(const db_table_create_setup& fields) override;
+  mstatus_t UpdateTable(const db_table_create_setup& fields) override;
+  mstatus_t CreateTable(const db_table_create_setup& fields) override;
+  mstatus_t DropTable(const db_table_drop_setup& drop) override;
+
+  mstatus_t InsertRows(const db_query_insert_setup& insert_data,
+                       id_container* id_vec) override;
+  mstatus_t DeleteRows(const db_query_delete_setup& delete_data) override;
+  mstatus_t SelectRows(const db_query_select_setup& select_data,
+                       db_query_select_result* result_data) override;
+  mstatus_t UpdateRows(const db_query_update_setup& update_data) override;
+
+  /**
+   * \brief Количество строк таблицы `t` в хранилище
+   * \return Количество строк или 0, если таблицы нет
+   * */
+  size_t RowsCount(db_table t) const;
+  /**
+   * \brief Добавить наблюдателя изменений таблиц, зафиксированных
+   *   любым подключением к хранилищу этой БД
+   * \return Идентификатор наблюдателя
+   *
+   * При фиксации транзакции наблюдатель получает по одному изменению
+   *   на таблицу и операцию(INSERT, UPDATE, DELETE).
+   * \note Наблюдатель вызывается в потоке фиксирующего подключения под
+   *   блокировкой наблюдателей хранилища: он должен быстро возвращаться
+   *   и не обращаться к БД
+   * */
+  size_t AddChangeWatcher(db_change_callback watcher);
+  /**
+   * \brief Удалить наблюдателя `id`, после возврата он не вызывается
+   * */
+  void RemoveChangeWatcher(size_t id);
+
+ private:
+  DBConnectionMemory(const DBConnectionMemory& r);
+  DBConnectionMemory& operator=(const DBConnectionMemory& r) = delete;
+
+  /**
+   * \brief Проверить, что подключение открыто, иначе установить ошибку
+   * */
+  bool checkConnected();
+  /**
+   * \brief Установить ошибку операции и вернуть статус
+   * */
+  mstatus_t setError(merror_t error, const std::string& msg);
+  /**
+   * \brief Найти таблицу в хранилище
+   * \note Вызывается под блокировкой хранилища
+   * */
+  memory_impl::memory_table* findTable(db_table t) const;
+  /**
+   * \brief Откатить изменения журнала до отметки `mark`
+   * \note Вызывается под эксклюзивной блокировкой хранилища
+   * */
+  void rollbackTo(size_t mark);
+  /**
+   * \brief Передать изменения зафиксированной транзакции наблюдателям
+   *   хранилища, по одному на таблицу и операцию
+   * */
+  void notifyChanges();
+
+  std::stringstream setupTableExistsString(db_table t) override;
+  std::stringstream setupGetColumnsInfoString(db_table t) override;
+
+  std::string db_variable_to_string(const db_variable& dv) override;
+
+ private:
+  /**
+   * \brief Общее хранилище таблиц БД
+   * */
+  std::shared_ptr<memory_impl::memory_storage> storage_;
+  /**
+   * \brief Журнал отката текущей транзакции
+   * */
+  std::unique_ptr<memory_impl::undo_log> undo_;
+};
+
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_CONNECTION_MEMORY_H_
@@ -11,6 +11,8 @@
 #define _DATABASE__DB_CONNECTION_POSTGRESQL_H_
 
 #include "asp_db/db_connection.h"
+#include "asp_db/db_metrics.h"
+#include "asp_db/db_query_stats.h"
 
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
@@ -18,10 +20,12 @@
 
 #include <pqxx/pqxx>
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 #define POSTGRE_DRYRUN_LOGGER "postgre_logger"
 #define POSTGRE_DRYRUN_LOGFILE "postgre_logs"
@@ -84,6 +88,15 @@ class DBConnectionPostgre final : public DBConnection {
    *   к формату 'hh:mm'
    * */
   static std::string PostgreTimeToTime(const std::string& ptime);
+  /**
+   * \brief Собрать строку подключения к БД по параметрам `parameters`
+   * */
+  static std::string ConnectionString(const db_parameters& parameters);
+  /**
+   * \brief Собрать строку установки триггера NOTIFY для таблицы
+   *   `table_name`, повторная установка заменяет триггер
+   * */
+  static std::string NotifyTriggerString(const std::string& table_name);
 
  private:
   DBConnectionPostgre(const DBConnectionPostgre& r);
@@ -108,17 +121,35 @@ class DBConnectionPostgre final : public DBConnection {
                       ExecF exec_m) {
     // setup content of query(call some function 'setup*String' from
     //   list of function below)
+    DBMetrics::Timer build(db_metric_stage::statement_build);
     std::stringstream sstr = std::invoke(setup_m, *this, data);
     sstr.seekg(0, std::ios::end);
     auto sstr_len = sstr.tellg();
+    build.Finish(sstr_len > 0);
     if (pqxx_work.IsAvailable() && sstr_len) {
+      DBMetrics::Timer server(db_metric_stage::server_exec);
+      DBQueryStats::Statement stat(DBQueryStats::Global());
+      const bool slow_log = parameters_.slow_query_threshold.count() > 0;
+      std::chrono::steady_clock::time_point start;
+      if (slow_log)
+        start = std::chrono::steady_clock::now();
       try {
         // execute query
         std::invoke(exec_m, *this, sstr, res);
-        if (IS_DEBUG_MODE)
-          Logging::Append(io_loglvl::debug_logs,
-                          "Debug mode: \n\tЗапрос БД: " + sstr.str() + "\n\t");
+        if (stat.IsActive()) {
+          auto volume = resultVolume(res);
+          stat.Finish(sstr.str(), volume.first, volume.second);
+        }
+        if (slow_log) {
+          auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - start);
+          if (elapsed >= parameters_.slow_query_threshold)
+            logSlowQuery(sstr.str(), elapsed, resultVolume(res).first,
+                         queryTable(data));
+        }
+        DB_LOG_DEBUG("Debug mode: \n\tЗапрос БД: ", sstr.str(), "\n\t");
       } catch (const pqxx::undefined_table& e) {
+        server.Finish(false);
         status_ = STATUS_HAVE_ERROR;
         error_.SetError(ERROR_DB_TABLE_EXISTS,
                         "Exception text: " + std::string(e.what()) +
@@ -127,11 +158,13 @@ class DBConnectionPostgre final : public DBConnection {
         // исключение пробрасывается при ошибке создания строки
         //   например если строка с таким комплексом уникальных
         //   значений уже существует
+        server.Finish(false);
         status_ = STATUS_HAVE_ERROR;
         error_.SetError(ERROR_DB_SQL_QUERY,
                         "Exception text: " + std::string(e.what()) +
                             "\n Query: " + e.query());
       } catch (const std::exception& e) {
+        server.Finish(false);
         status_ = STATUS_HAVE_ERROR;
         error_.SetError(ERROR_DB_CONNECTION,
                         "Подключение к БД: exception. Запрос:\n" + sstr.str() +
@@ -144,6 +177,7 @@ class DBConnectionPostgre final : public DBConnection {
         if (sstr_len) {
           passToLogger(io_loglvl::info_logs, POSTGRE_DRYRUN_LOGGER,
                        "dry_run: " + sstr.str());
+          journalStatement(sstr.str());
         } else {
           passToLogger(io_loglvl::info_logs, POSTGRE_DRYRUN_LOGGER,
                        "dry_run: 'empty query!'");
@@ -157,6 +191,49 @@ class DBConnectionPostgre final : public DBConnection {
     return status_;
   }
 
+  /**
+   * \brief Количество строк и байт значений результата запроса
+   *   для статистики DBQueryStats
+   * */
+  template <class OutT>
+  static std::pair<uint64_t, uint64_t> resultVolume(const OutT* res) {
+    uint64_t bytes = 0;
+    if constexpr (std::is_same_v<OutT, pqxx::result>) {
+      for (const auto& row : *res)
+        for (const auto& field : row)
+          bytes += field.size();
+      return {res->size(), bytes};
+    }
+    return {0, bytes};
+  }
+
+  template <class DataT, class = void>
+  struct has_table_member : std::false_type {};
+  template <class DataT>
+  struct has_table_member<DataT, std::void_t<decltype(DataT::table)>>
+      : std::true_type {};
+  /**
+   * \brief Таблица запроса для журнала медленных запросов
+   * */
+  template <class DataT>
+  static db_table queryTable(const DataT& data) {
+    if constexpr (std::is_same_v<DataT, db_table>) {
+      return data;
+    } else if constexpr (has_table_member<DataT>::value) {
+      return data.table;
+    } else {
+      return UNDEFINED_TABLE;
+    }
+  }
+  /**
+   * \brief Записать в журнал медленный запрос и, если включено,
+   *   запросить его план на отдельном подключении
+   * */
+  void logSlowQuery(const std::string& query,
+                    std::chrono::microseconds elapsed,
+                    uint64_t rows,
+                    db_table table);
+
   /* функции собирающие строку запроса */
   /** \brief Собрать строку подключения к БД */
   std::string setupConnectionString();
@@ -167,6 +244,12 @@ class DBConnectionPostgre final : public DBConnection {
   std::stringstream setupGetConstrainsString(db_table t);
   /** \brief Собрать строку получения внешних ключей */
   std::stringstream setupGetForeignKeys(db_table t);
+  /**
+   * \brief Дополнить строку создания таблицы установкой триггера
+   *   уведомлений об изменении данных, если он запрошен сетапом
+   * */
+  std::stringstream setupCreateTableString(
+      const db_table_create_setup& fields) override;
   std::stringstream setupInsertString(
       const db_query_insert_setup& fields) override;
   std::stringstream setupDeleteString(
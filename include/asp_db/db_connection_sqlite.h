@@ -0,0 +1,212 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_CONNECTION_SQLITE_H_
+#define _DATABASE__DB_CONNECTION_SQLITE_H_
+
+#include "asp_db/db_connection.h"
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+#include "asp_utils/Logging.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define SQLITE_DRYRUN_LOGGER "sqlite_logger"
+#define SQLITE_DRYRUN_LOGFILE "sqlite_logs"
+
+struct sqlite3_stmt;
+
+namespace asp_db {
+namespace sqlite_impl {
+class sqlite_handle;
+class handle_pool;
+}  // namespace sqlite_impl
+
+/**
+ * \brief Реализация DBConnection для встроенной БД SQLite
+ *
+ * Имя БД(db_parameters::name) - путь к файлу базы, параметры
+ *   сервера(host, port, username, password) не используются.
+ *
+ * Особенности:
+ *   - база открывается в режиме WAL(synchronous = NORMAL), внешние
+ *     ключи включены;
+ *   - открытые дескрипторы базы переиспользуются копиями подключения
+ *     (CloneConnection) через общий пул, вместе с кэшем
+ *     подготовленных запросов дескриптора;
+ *   - значения передаются в запросы параметрами подготовленных
+ *     запросов, в том числе значения условий where, так что текст
+ *     запроса не зависит от значений и берётся из кэша;
+ *   - вставка insert_on_exists_act::do_update - `ON CONFLICT(...)
+ *     DO UPDATE`(SQLite >= 3.24): не переданные столбцы
+ *     и rowid строки сохраняются;
+ *   - SetupConnection открывает транзакцию, CloseConnection
+ *     фиксирует её: строки INSERT операции добавляются одним
+ *     подготовленным запросом в рамках транзакции;
+ *   - типы db_variable_type отображаются на классы хранения SQLite:
+ *     INTEGER, REAL, TEXT, BLOB. Поле автоинкремента становится
+ *     `INTEGER PRIMARY KEY AUTOINCREMENT`, сложный первичный ключ
+ *     с ним - уникальным комплексом.
+ *
+ * \note Путь ":memory:" открывает отдельную базу для каждого
+ *   дескриптора, для таблиц в памяти см. DBConnectionMemory
+ * */
+class DBConnectionSQLite final : public DBConnection {
+  ADD_TEST_CLASS(DBConnectionSQLiteProxy)
+
+ public:
+  DBConnectionSQLite(const IDBTables* tables,
+                     const db_parameters& parameters,
+                     PrivateLogging* logger = nullptr);
+
+  ~DBConnectionSQLite() override;
+
+  std::shared_ptr<DBConnection> CloneConnection() override;
+
+  mstatus_t AddSavePoint(const db_save_point& sp) override;
+  void RollbackToSavePoint(const db_save_point& sp) override;
+
+  mstatus_t SetupConnection() override;
+  void CloseConnection() override;
+
+  mstatus_t IsTableExists(db_table t, bool* is_exists) override;
+  mstatus_t GetTableFormat(db_table t, db_table_create_setup* fields) override;
+  mstatus_t CheckTableFormat(const db_table_create_setup& fields) override;
+  mstatus_t UpdateTable(const db_table_create_setup& fields) override;
+  mstatus_t CreateTable(const db_table_create_setup& fields) override;
+  mstatus_t DropTable(const db_table_drop_setup& drop) override;
+
+  mstatus_t InsertRows(const db_query_insert_setup& insert_data,
+                       id_container* id_vec) override;
+  mstatus_t DeleteRows(const db_query_delete_setup& delete_data) override;
+  mstatus_t SelectRows(const db_query_select_setup& select_data,
+                       db_query_select_result* result_data) override;
+  mstatus_t UpdateRows(const db_query_update_setup& update_data) override;
+
+  /**
+   * \brief Класс хранения SQLite для типа поля
+   * */
+  static std::string StorageClass(const db_variable& var);
+
+ private:
+  DBConnectionSQLite(const DBConnectionSQLite& r);
+  DBConnectionSQLite& operator=(const DBConnectionSQLite& r) = delete;
+
+  /**
+   * \brief Значение параметра подготовленного запроса
+   * */
+  struct bind_value {
+    db_variable_type type;
+    bool is_array;
+    std::string_view value;
+  };
+  /**
+   * \brief Значение условия where: тип поля и значение
+   * */
+  typedef std::pair<db_variable_type, std::string> where_value;
+
+  /**
+   * \brief Проверить режим dry_run: запрос `sql` только логируется
+   * \return true для dry_run
+   * */
+  bool dryRun(const std::string& sql);
+  /**
+   * \brief Проверить, что подключение открыто, иначе установить ошибку
+   * */
+  bool checkConnected();
+  /**
+   * \brief Выполнить запрос без параметров и результата
+   * */
+  mstatus_t execSql(const std::string& sql);
+  /**
+   * \brief Получить подготовленный запрос из кэша дескриптора
+   * \return Указатель на запрос или nullptr с установленной ошибкой
+   * */
+  sqlite3_stmt* prepare(const std::string& sql);
+  /**
+   * \brief Привязать параметры `binds` к запросу начиная с `first`
+   * */
+  bool bindValues(sqlite3_stmt* stmt,
+                  const std::vector<bind_value>& binds,
+                  int first = 1);
+  /**
+   * \brief Выполнить подготовленный запрос без результата
+   * */
+  mstatus_t stepDone(sqlite3_stmt* stmt, const std::string& sql);
+  /**
+   * \brief Установить ошибку SQLite запроса `sql`
+   * */
+  mstatus_t setSqliteError(merror_t error, const std::string& sql);
+  /**
+   * \brief Выполнить запрос и собрать текстовые значения всех
+   *   столбцов результата, NULL - пустая строка
+   * */
+  mstatus_t queryRows(const std::string& sql,
+                      std::vector<std::vector<std::string>>* rows);
+
+  /**
+   * \brief Собрать строку where условия с параметрами `?`
+   *   по дереву условий сетапа, пустую если условий нет
+   * \return false при ошибке разбора дерева, ошибка установлена
+   * */
+  bool setupWhere(const db_query_select_setup& fields,
+                  std::string* sql,
+                  std::vector<where_value>* values);
+  /**
+   * \brief Добавить к строке where условия узел дерева `node`
+   * \return false при ошибке разбора узла
+   * */
+  bool whereNodeString(const expression_node<where_node_data>* node,
+                       bool braced,
+                       std::string* sql,
+                       std::vector<where_value>* values);
+  /**
+   * \brief Собрать строку INSERT запроса для столбцов пакета `cols`
+   * */
+  std::string setupInsert(const db_query_insert_setup& fields,
+                          const std::vector<size_t>& cols);
+  /**
+   * \brief Собрать условие `ON CONFLICT(...) DO UPDATE` для вставки
+   *   столбцов `names` таблицы `t`
+   * \return Пустую строку, если ни первичный ключ, ни уникальный
+   *   комплекс не покрыты переданными столбцами
+   * */
+  std::string setupUpsert(db_table t, const std::vector<std::string>& names);
+
+  std::stringstream setupTableExistsString(db_table t) override;
+  std::stringstream setupGetColumnsInfoString(db_table t) override;
+  /**
+   * \brief Собрать строку создания таблицы: поле автоинкремента
+   *   объявляется первичным ключом при описании столбца
+   * */
+  std::stringstream setupCreateTableString(
+      const db_table_create_setup& fields) override;
+
+  std::string db_variable_to_string(const db_variable& dv) override;
+
+ private:
+  /**
+   * \brief Пул открытых дескрипторов базы, общий для копий
+   *   подключения
+   * */
+  std::shared_ptr<sqlite_impl::handle_pool> pool_;
+  /**
+   * \brief Дескриптор базы открытого подключения
+   * */
+  std::unique_ptr<sqlite_impl::sqlite_handle> handle_;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_CONNECTION_SQLITE_H_
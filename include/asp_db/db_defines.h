@@ -87,7 +87,11 @@ enum class db_client : uint32_t {
   /// реализация в db_connection_postgre.cpp
   POSTGRESQL = 1,
   /// реализация в db_connection_firebird.cpp
-  FIREBIRD = 2
+  FIREBIRD = 2,
+  /// реализация в db_connection_memory.cpp, таблицы в памяти процесса
+  MEMORY = 3,
+  /// реализация в db_connection_sqlite.cpp, встроенная БД в файле
+  SQLITE = 4
 };
 /**
  * \brief Получить имя клиента БД по идентификатору
@@ -0,0 +1,133 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_DRY_RUN_SINK_H_
+#define _DATABASE__DB_DRY_RUN_SINK_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <stdint.h>
+
+namespace asp_db {
+/**
+ * \brief Асинхронная запись сообщений dry_run режима в файл
+ *
+ * Подключения пишут сообщения в очередь без блокировок(MPSC список
+ *   Вьюкова), фоновый поток собирает их в пакеты до `batch_size` байт
+ *   и записывает пакет одним вызовом `fwrite` без буферизации stdio.
+ *   Объём сообщений в очереди ограничен `max_pending`: при
+ *   переполнении пишущий поток ждёт записи пакета. Flush ставит в
+ *   очередь метку и ждёт, пока поток записи дойдёт до неё.
+ *
+ * Сообщения одного потока записываются в порядке добавления, каждое
+ *   отдельной строкой.
+ * */
+class DBDryRunSink {
+ public:
+  /**
+   * \brief Общий для подключений сток файла `path`, файл
+   *   перезаписывается при создании стока
+   * \return nullptr, если файл не открывается
+   * */
+  static std::shared_ptr<DBDryRunSink> Open(
+      const std::string& path,
+      size_t max_pending = default_max_pending);
+
+  explicit DBDryRunSink(std::FILE* file,
+                        size_t max_pending = default_max_pending);
+  ~DBDryRunSink();
+  DBDryRunSink(const DBDryRunSink&) = delete;
+  DBDryRunSink& operator=(const DBDryRunSink&) = delete;
+
+  /**
+   * \brief Добавить сообщение в очередь записи
+   * */
+  void Append(std::string msg);
+  /**
+   * \brief Дождаться записи всех сообщений, добавленных вызывающим
+   *   потоком до вызова
+   * */
+  void Flush();
+  /**
+   * \brief Записано байт
+   * */
+  uint64_t Written() const;
+  /**
+   * \brief Количество вызовов записи в файл
+   * */
+  uint64_t Writes() const;
+
+ public:
+  static constexpr size_t default_max_pending = 8 * 1024 * 1024;
+  static constexpr size_t batch_size = 64 * 1024;
+
+ private:
+  /**
+   * \brief Метка Flush: поток записи дошёл до неё и записал
+   *   сообщения перед ней
+   * */
+  struct flush_barrier {
+    std::atomic<bool> reached{false};
+  };
+  struct node {
+    std::atomic<node*> next{nullptr};
+    std::string msg;
+    /** \brief Узел метки Flush вместо сообщения */
+    std::shared_ptr<flush_barrier> barrier;
+  };
+
+ private:
+  void run();
+  /**
+   * \brief Занять в очереди место под `size` байт, при переполнении
+   *   дождаться записи пакета
+   * \return Байт в очереди до занятия
+   * */
+  size_t reserve(size_t size);
+  /**
+   * \brief Добавить узел в конец очереди
+   * */
+  void push(node* n);
+  /**
+   * \brief Забрать сообщения из очереди в `batch`, записывая
+   *   заполненные пакеты и снимая метки Flush
+   * */
+  void drain(std::string* batch);
+  void write(std::string* batch);
+
+ private:
+  std::FILE* file_;
+  const size_t max_pending_;
+  /** \brief Последний добавленный узел, в него пишут продюсеры */
+  std::atomic<node*> head_;
+  /** \brief Заглушка перед первым незабранным узлом */
+  node* tail_;
+  /** \brief Байт в очереди и в незаписанном пакете */
+  std::atomic<size_t> pending_{0};
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> writes_{0};
+  std::atomic<bool> flush_requested_{false};
+  std::atomic<bool> stop_{false};
+
+  std::mutex lock_;
+  /** \brief Пробуждение потока записи */
+  std::condition_variable wake_cv_;
+  /** \brief Ожидание записи: Flush и переполнение очереди */
+  std::condition_variable done_cv_;
+  std::thread worker_;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_DRY_RUN_SINK_H_
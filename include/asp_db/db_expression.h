@@ -548,6 +548,10 @@ class DBWhereClause {
     }
     return "";
   }
+  /**
+   * \brief Получить корень дерева условий
+   * */
+  std::shared_ptr<expression_node<T>> GetRoot() const { return root; }
 
  protected:
   /**
@@ -0,0 +1,199 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_group_commit *
+ *   Объединение одновременных добавлений одиночных строк таблицы
+ *   в одну транзакцию
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_GROUP_COMMIT_H_
+#define _DATABASE__DB_GROUP_COMMIT_H_
+
+#include "asp_db/db_defines.h"
+#include "asp_db/db_queries_setup.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace asp_db {
+/**
+ * \brief Параметры группового добавления строк
+ * */
+struct db_group_commit_parameters {
+  /**
+   * \brief Время ожидания строк других потоков первым потоком группы
+   * */
+  std::chrono::microseconds window{1000};
+  /**
+   * \brief Максимум строк группы, заполненная группа добавляется
+   *   не дожидаясь окончания окна
+   * */
+  size_t max_rows = 64;
+};
+
+/**
+ * \brief Групповое добавление одиночных строк
+ *
+ * Первый поток, добавляющий строку таблицы, становится лидером
+ *   группы: он ждёт строки других потоков той же таблицы в течение
+ *   `window` или до `max_rows` строк, затем добавляет всю группу
+ *   одним запросом в одной транзакции. Остальные потоки ждут
+ *   завершения транзакции лидера и получают id своей строки и статус.
+ *   Если групповое добавление не удалось, лидер добавляет строки
+ *   по одной, чтобы ошибка одной строки не отменяла остальные
+ * */
+class DBGroupCommit {
+ public:
+  explicit DBGroupCommit(const db_group_commit_parameters& parameters);
+
+  /**
+   * \brief Добавить строку `row` таблицы `table` в группу
+   * \param id_p Указатель на id добавленной строки, может быть nullptr
+   * \param commit Функция добавления строк диапазона
+   *   `mstatus_t(It first, It last, id_container* ids)`, вызывается
+   *   в потоке лидера группы
+   *
+   * \return Статус добавления строки
+   * */
+  template <class TableI, class CommitF>
+  mstatus_t Save(db_table table, TableI&& row, int* id_p, CommitF commit);
+
+  /**
+   * \brief Количество групп, добавленных одной транзакцией
+   * */
+  uint64_t Groups() const;
+  /**
+   * \brief Количество строк, прошедших через группы
+   * */
+  uint64_t Rows() const;
+  /**
+   * \brief Параметры группового добавления
+   * */
+  const db_group_commit_parameters& GetParameters() const {
+    return parameters_;
+  }
+
+ private:
+  /**
+   * \brief Группа строк одной таблицы
+   * */
+  struct group {
+    virtual ~group() = default;
+    /**
+     * \brief Ожидание закрытия группы лидером и её добавления
+     *   остальными потоками
+     * */
+    std::condition_variable cv;
+    /** \brief Группа больше не принимает строки */
+    bool closed = false;
+    /** \brief Строки группы добавлены, результаты заполнены */
+    bool done = false;
+    std::vector<mstatus_t> statuses;
+    std::vector<int> ids;
+  };
+  template <class TableI>
+  struct rows_group : public group {
+    std::vector<TableI> rows;
+  };
+
+ private:
+  /**
+   * \brief Закрыть группу для новых строк, вызывается под
+   *   захваченным мьютексом
+   * */
+  void close(db_table table, group* g);
+  /**
+   * \brief Добавить строки группы, вызывается лидером без блокировки
+   * */
+  template <class TableI, class CommitF>
+  void commit(rows_group<TableI>* g, CommitF& commit_f);
+
+ private:
+  const db_group_commit_parameters parameters_;
+  std::mutex lock_;
+  /**
+   * \brief Открытые группы, принимающие строки
+   * */
+  std::map<db_table, std::shared_ptr<group>> open_;
+  std::atomic<uint64_t> groups_{0};
+  std::atomic<uint64_t> rows_{0};
+};
+
+template <class TableI, class CommitF>
+mstatus_t DBGroupCommit::Save(db_table table,
+                              TableI&& row,
+                              int* id_p,
+                              CommitF commit_f) {
+  typedef std::decay_t<TableI> table_t;
+  typedef rows_group<table_t> group_t;
+  std::unique_lock<std::mutex> lock(lock_);
+  auto& slot = open_[table];
+  const bool leader = !slot;
+  if (leader)
+    slot = std::make_shared<group_t>();
+  // код таблицы однозначно определяет структуру строки
+  auto g = std::static_pointer_cast<group_t>(slot);
+  const size_t index = g->rows.size();
+  g->rows.push_back(std::forward<TableI>(row));
+  if (g->rows.size() >= parameters_.max_rows)
+    close(table, g.get());
+  if (leader) {
+    g->cv.wait_for(lock, parameters_.window, [&g]() { return g->closed; });
+    if (!g->closed)
+      close(table, g.get());
+    // группа закрыта, строки и результаты меняет только лидер
+    lock.unlock();
+    commit(g.get(), commit_f);
+    lock.lock();
+    g->done = true;
+    g->cv.notify_all();
+  } else {
+    g->cv.wait(lock, [&g]() { return g->done; });
+  }
+  if (id_p && index < g->ids.size())
+    *id_p = g->ids[index];
+  return g->statuses[index];
+}
+
+template <class TableI, class CommitF>
+void DBGroupCommit::commit(rows_group<TableI>* g, CommitF& commit_f) {
+  const size_t count = g->rows.size();
+  id_container ids;
+  mstatus_t st = commit_f(g->rows.cbegin(), g->rows.cend(), &ids);
+  groups_.fetch_add(1, std::memory_order_relaxed);
+  rows_.fetch_add(count, std::memory_order_relaxed);
+  g->statuses.assign(count, st);
+  if (is_status_ok(st)) {
+    if (ids.id_vec.size() == count)
+      g->ids = std::move(ids.id_vec);
+    return;
+  }
+  if (count == 1)
+    return;
+  // ошибка одной строки отменила транзакцию группы - по одной
+  g->ids.assign(count, -1);
+  for (size_t i = 0; i < count; ++i) {
+    id_container one;
+    auto it = g->rows.cbegin() + i;
+    g->statuses[i] = commit_f(it, it + 1, &one);
+    if (one.id_vec.size() == 1)
+      g->ids[i] = one.id_vec[0];
+  }
+}
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_GROUP_COMMIT_H_
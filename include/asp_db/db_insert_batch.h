@@ -0,0 +1,167 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_insert_batch *
+ *   Колоночное хранилище строк INSERT запроса
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_INSERT_BATCH_H_
+#define _DATABASE__DB_INSERT_BATCH_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Пакет строк INSERT запроса в колоночном виде
+ *
+ * Набор столбцов задаётся один раз на пакет, значения каждого
+ *   столбца хранятся подряд в байтовой арене столбца, концы значений -
+ *   в векторе смещений. Отсутствующие значения отмечены в битовой
+ *   карте столбца(бит `r` - строка `r`), при сборке запроса вместо
+ *   них подставляется DEFAULT. Строка добавляется последовательными
+ *   вызовами Append/AppendNull по порядку столбцов и завершается
+ *   CommitRow, после Reserve добавление строк не выделяет память
+ *   пока значения укладываются в оценку размера арены.
+ *
+ * \code
+ * db_insert_batch batch;
+ * batch.SetColumns({1, 2});
+ * batch.Append("Hobbit");
+ * batch.Append("1937");
+ * batch.CommitRow();
+ * \endcode
+ * */
+class db_insert_batch {
+ public:
+  typedef size_t field_index;
+  /** \brief Строка пакета: индекс столбца -> значение */
+  typedef std::map<field_index, std::string> row_values;
+
+ public:
+  /**
+   * \brief Задать набор столбцов пакета по индексам коллекции полей
+   * \return false если в пакете уже есть значения
+   * */
+  bool SetColumns(const std::vector<field_index>& columns);
+  /**
+   * \brief Набор столбцов задан
+   * */
+  inline bool HasColumns() const { return has_columns_; }
+  /**
+   * \brief Количество столбцов
+   * */
+  inline size_t ColumnsSize() const { return columns_.size(); }
+  /**
+   * \brief Индекс в коллекции полей столбца `col`
+   * */
+  inline field_index ColumnIndex(size_t col) const {
+    return columns_[col].index;
+  }
+  /**
+   * \brief Количество завершённых строк
+   * */
+  inline size_t RowsSize() const { return rows_; }
+  inline bool Empty() const { return rows_ == 0; }
+  /**
+   * \brief Зарезервировать память под `rows` строк, размер арен
+   *   оценивается по первой строке пакета
+   * */
+  void Reserve(size_t rows);
+
+  /**
+   * \brief Добавить значение следующего столбца текущей строки
+   * \note Значение хранится как есть, в том виде, в котором его
+   *   отдаёт функция получения поля таблицы: без кавычек SQL
+   * */
+  void Append(std::string_view value);
+  /**
+   * \brief Отметить значение следующего столбца текущей строки
+   *   отсутствующим
+   * */
+  void AppendNull();
+  /**
+   * \brief Завершить текущую строку, незаполненные столбцы строки
+   *   отмечаются отсутствующими
+   * */
+  void CommitRow();
+  /**
+   * \brief Буфер для сборки значения перед Append, ёмкость буфера
+   *   сохраняется между строками
+   * */
+  inline std::string* Buffer() { return &buffer_; }
+  /**
+   * \brief Удалить строки, сохранив набор столбцов и выделенную память
+   * */
+  void Clear();
+
+  /**
+   * \brief Значение столбца `col` строки `row`
+   * */
+  inline std::string_view Value(size_t row, size_t col) const {
+    const column& c = columns_[col];
+    size_t begin = row ? c.ends[row - 1] : 0;
+    return std::string_view(c.arena.data() + begin, c.ends[row] - begin);
+  }
+  /**
+   * \brief Значение столбца `col` строки `row` отсутствует
+   * */
+  inline bool IsNull(size_t row, size_t col) const {
+    return (columns_[col].nulls[row >> 6] >> (row & 63)) & 1;
+  }
+  /**
+   * \brief Во всех строках пакета значение столбца `col` отсутствует,
+   *   такой столбец не добавляется в запрос
+   * */
+  inline bool AllNull(size_t col) const {
+    return columns_[col].null_count == rows_;
+  }
+  /**
+   * \brief Собрать строку `row` в виде row_values, отсутствующие
+   *   значения пропускаются
+   * */
+  row_values Row(size_t row) const;
+
+ private:
+  /**
+   * \brief Столбец пакета
+   * */
+  struct column {
+    /** \brief Индекс в коллекции полей */
+    field_index index;
+    /** \brief Значения столбца подряд */
+    std::string arena;
+    /** \brief Смещения концов значений в арене, по строкам */
+    std::vector<size_t> ends;
+    /** \brief Битовая карта отсутствующих значений */
+    std::vector<uint64_t> nulls;
+    /** \brief Количество отсутствующих значений */
+    size_t null_count = 0;
+  };
+
+ private:
+  void append(std::string_view value, bool is_null);
+
+ private:
+  std::vector<column> columns_;
+  /** \brief Буфер сборки значения, см. Buffer */
+  std::string buffer_;
+  /** \brief Количество завершённых строк */
+  size_t rows_ = 0;
+  /** \brief Следующий заполняемый столбец текущей строки */
+  size_t cell_ = 0;
+  /** \brief Зарезервированное количество строк */
+  size_t reserved_ = 0;
+  bool has_columns_ = false;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_INSERT_BATCH_H_
@@ -0,0 +1,113 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_JOURNAL_H_
+#define _DATABASE__DB_JOURNAL_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <stdint.h>
+
+namespace asp_db {
+/**
+ * \brief Запись журнала запросов
+ * */
+struct db_journal_record {
+  /** \brief Время от открытия журнала, мкс */
+  uint64_t time_us = 0;
+  /** \brief Номер подключения(копии DBConnection) */
+  uint32_t connection_id = 0;
+  /** \brief Текст запроса */
+  std::string sql;
+};
+
+/**
+ * \brief Запись двоичного журнала запросов dry_run режима
+ *
+ * Формат файла: заголовок `ASPDBJ01`, затем записи из трёх чисел
+ *   varint(LEB128) - приращение времени с предыдущей записи в мкс,
+ *   номер подключения, длина запроса - и байтов запроса. Журнал
+ *   воспроизводится на PostgreSQL утилитой `asp_db-replay`.
+ * */
+class DBJournalWriter {
+ public:
+  /**
+   * \brief Общий для подключений журнал файла `path`, файл
+   *   перезаписывается при создании журнала
+   * \return nullptr, если файл не открывается
+   * */
+  static std::shared_ptr<DBJournalWriter> Open(const std::string& path);
+
+  explicit DBJournalWriter(std::FILE* file);
+  ~DBJournalWriter();
+  DBJournalWriter(const DBJournalWriter&) = delete;
+  DBJournalWriter& operator=(const DBJournalWriter&) = delete;
+
+  /**
+   * \brief Номер нового подключения
+   * */
+  uint32_t NextConnectionId();
+  /**
+   * \brief Записать запрос подключения `connection_id`
+   * */
+  void Append(uint32_t connection_id, const std::string& sql);
+  /**
+   * \brief Сбросить буфер записи в файл
+   * */
+  void Flush();
+
+ private:
+  std::FILE* file_;
+  std::mutex lock_;
+  std::chrono::steady_clock::time_point start_;
+  uint64_t last_us_ = 0;
+  std::atomic<uint32_t> connections_{0};
+};
+
+/**
+ * \brief Чтение двоичного журнала запросов
+ * */
+class DBJournalReader {
+ public:
+  explicit DBJournalReader(const std::string& path);
+  ~DBJournalReader();
+  DBJournalReader(const DBJournalReader&) = delete;
+  DBJournalReader& operator=(const DBJournalReader&) = delete;
+
+  /**
+   * \brief Файл открыт и заголовок журнала верный
+   * */
+  bool IsOpen() const;
+  /**
+   * \brief Прочитать следующую запись
+   * \return false в конце журнала или на повреждённой записи
+   * */
+  bool Next(db_journal_record* record);
+  /**
+   * \brief Чтение остановлено на повреждённой или неполной записи
+   * */
+  bool IsCorrupted() const;
+
+ private:
+  bool readVarint(uint64_t* value);
+
+ private:
+  std::FILE* file_ = nullptr;
+  uint64_t time_us_ = 0;
+  bool is_open_ = false;
+  bool is_corrupted_ = false;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_JOURNAL_H_
@@ -0,0 +1,99 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_LOG_H_
+#define _DATABASE__DB_LOG_H_
+
+#include "asp_db/db_defines.h"
+
+#include "asp_utils/Logging.h"
+
+#include <sstream>
+#include <string>
+
+/* Уровни логирования времени компиляции */
+#define ASP_DB_LOG_LEVEL_NONE 0
+#define ASP_DB_LOG_LEVEL_ERR 1
+#define ASP_DB_LOG_LEVEL_WARN 2
+#define ASP_DB_LOG_LEVEL_INFO 3
+#define ASP_DB_LOG_LEVEL_DEBUG 4
+
+#ifndef IS_DEBUG_MODE
+#define IS_DEBUG_MODE false
+#endif  // !IS_DEBUG_MODE
+
+/**
+ * \brief Максимальный уровень сообщений, попадающих в лог. Сообщения
+ *   выше уровня вырезаются при компиляции вместе с их форматированием
+ * */
+#ifndef ASP_DB_LOG_LEVEL
+#if IS_DEBUG_MODE || defined(BYCMAKE_DEBUG)
+#define ASP_DB_LOG_LEVEL ASP_DB_LOG_LEVEL_DEBUG
+#else
+#define ASP_DB_LOG_LEVEL ASP_DB_LOG_LEVEL_INFO
+#endif  // IS_DEBUG_MODE || BYCMAKE_DEBUG
+#endif  // !ASP_DB_LOG_LEVEL
+
+namespace asp_db {
+/**
+ * \brief Сообщения уровня `level` попадают в лог
+ * */
+constexpr bool db_log_enabled(io_loglvl level) {
+  switch (level) {
+    case io_loglvl::err_logs:
+      return ASP_DB_LOG_LEVEL >= ASP_DB_LOG_LEVEL_ERR;
+    case io_loglvl::warn_logs:
+      return ASP_DB_LOG_LEVEL >= ASP_DB_LOG_LEVEL_WARN;
+    case io_loglvl::info_logs:
+      return ASP_DB_LOG_LEVEL >= ASP_DB_LOG_LEVEL_INFO;
+    case io_loglvl::debug_logs:
+      return ASP_DB_LOG_LEVEL >= ASP_DB_LOG_LEVEL_DEBUG;
+    default:
+      return false;
+  }
+}
+
+/**
+ * \brief Собрать сообщение из частей
+ * */
+template <class... Args>
+std::string db_log_format(const Args&... args) {
+  std::ostringstream sstr;
+  (sstr << ... << args);
+  return sstr.str();
+}
+}  // namespace asp_db
+
+/**
+ * \brief Записать сообщение уровня `level` из частей `...`
+ *
+ * Части сообщения вычисляются и собираются только если уровень
+ *   не вырезан при компиляции:
+ *   DB_LOG_DEBUG("Запрос БД: ", sstr.str());
+ * */
+#define DB_LOG(level, ...)                                        \
+  do {                                                            \
+    if constexpr (asp_db::db_log_enabled(level))                  \
+      Logging::Append(level, asp_db::db_log_format(__VA_ARGS__)); \
+  } while (0)
+/**
+ * \brief Записать сообщение об ошибке с кодом `error`
+ * */
+#define DB_LOG_ERROR(error, ...)                                  \
+  do {                                                            \
+    if constexpr (asp_db::db_log_enabled(io_loglvl::err_logs))    \
+      Logging::Append(error, asp_db::db_log_format(__VA_ARGS__)); \
+  } while (0)
+
+#define DB_LOG_ERR(...) DB_LOG(io_loglvl::err_logs, __VA_ARGS__)
+#define DB_LOG_WARN(...) DB_LOG(io_loglvl::warn_logs, __VA_ARGS__)
+#define DB_LOG_INFO(...) DB_LOG(io_loglvl::info_logs, __VA_ARGS__)
+#define DB_LOG_DEBUG(...) DB_LOG(io_loglvl::debug_logs, __VA_ARGS__)
+
+#endif  // !_DATABASE__DB_LOG_H_
@@ -0,0 +1,70 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_meta *
+ *   Макросы разметки структур данных, по которым генератор
+ * tools/macrogen собирает реализацию IDBTables
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+/*
+ * Заголовок не защищён от повторного подключения намеренно: после
+ *   объявления размеченных структур макросы удаляются подключением
+ *   "asp_db/db_meta_undef.h", чтобы короткие имена `field`, `reference`
+ *   не конфликтовали с идентификаторами других библиотек.
+ *
+ * Пример разметки:
+ * \code
+ * #include "asp_db/db_meta.h"
+ *
+ * struct ASP_TABLE book {
+ *   table_code(table_book)
+ *   field(row_id, id, type(autoinc), id(BOOK_ID), flag(f_id));
+ *   field(std::string, title, NOT_NULL, id(BOOK_TITLE), flag(f_title));
+ *   primary_key(id)
+ *   unique_complex(title)
+ *   int32_t initialized = 0;
+ * };
+ * struct ASP_TABLE translation {
+ *   field(row_id, id, type(autoinc));
+ *   field_fkey(row_id, book_p, book, type(int), NOT_NULL);
+ *   primary_key(id)
+ *   reference(book_p, book(id), CASCADE, CASCADE)
+ * };
+ *
+ * #include "asp_db/db_meta_undef.h"
+ * \endcode
+ *
+ * Опции полей:
+ *   - NOT_NULL, ARRAY, CAN_BE_NEGATIVE, HAS_DEFAULT - флаги столбца;
+ *   - type(autoinc|uuid|bool|short|int|long|real|date|time|char_array|
+ *     text|blob) - тип столбца, если не выводится из типа поля;
+ *   - id(MACRO) - идентификатор столбца, имя столбца - MACRO_NAME.
+ *     Без опции генератор определяет `<TABLE>_<FIELD>` и его имя;
+ *   - flag(f) - флаг `initialized` структуры для поля;
+ *   - len(n) - длина массива.
+ * */
+#include <utility>
+
+/** \brief Пометка структуры таблицы: `struct ASP_TABLE name {...}` */
+#define ASP_TABLE
+/** \brief Поле `x` типа `t` с опциями столбца */
+#define field(t, x, ...) t x
+/** \brief Внешний ключ `x`: идентификатор типа `t` и указатель на
+ *   строку таблицы `ref` */
+#define field_fkey(t, x, ref, ...) std::pair<t, ref*> x
+/** \brief Функции преобразования поля `x` в строку и обратно:
+ *   `std::string to_str_f(const T&)`,
+ *   `void from_str_f(const std::string&, T*)` */
+#define str_functions(x, to_str_f, from_str_f)
+/** \brief Код таблицы, по умолчанию генерируется `table_<name>` */
+#define table_code(x)
+#define primary_key(x)
+#define unique_complex(...)
+/** \brief reference(field, table(column), on_update, on_delete),
+ *   действия: NO_ACTION, SET_NULL, CASCADE, RESTRICT */
+#define reference(x, ...)
@@ -0,0 +1,20 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_meta_undef *
+ *   Удаление макросов разметки db_meta.h
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#undef ASP_TABLE
+#undef field
+#undef field_fkey
+#undef str_functions
+#undef table_code
+#undef primary_key
+#undef unique_complex
+#undef reference
@@ -0,0 +1,234 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_METRICS_H_
+#define _DATABASE__DB_METRICS_H_
+
+#include "asp_db/db_defines.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace asp_db {
+class IDBTables;
+
+/**
+ * \brief Операция DBConnectionManager, к которой относится замер
+ * */
+enum class db_metric_op : uint32_t {
+  /// вне операций менеджера
+  none = 0,
+  is_table_exists,
+  create_table,
+  get_table_format,
+  update_table_format,
+  insert_rows,
+  select_rows,
+  delete_rows,
+  /// количество операций, не операция
+  count
+};
+
+/**
+ * \brief Этап выполнения операции
+ * */
+enum class db_metric_stage : uint32_t {
+  /// вся операция: exec_wrap менеджера
+  total = 0,
+  /// копирование подключения
+  clone_connection,
+  /// запрос SetupConnection транзакции
+  connect,
+  /// запрос AddSavePoint транзакции
+  save_point,
+  /// запрос операции транзакции
+  execute,
+  /// запрос CloseConnection транзакции
+  close_connection,
+  /// откат выполненных запросов транзакции
+  rollback,
+  /// сборка текста запроса в бэкенде
+  statement_build,
+  /// выполнение запроса сервером
+  server_exec,
+  /// разбор результата запроса в бэкенде
+  result_decode,
+  /// IDBTables::SetSelectData
+  set_select_data,
+  /// количество этапов, не этап
+  count
+};
+
+/**
+ * \brief Имя операции для вывода
+ * */
+const char* db_metric_op_to_string(db_metric_op op);
+/**
+ * \brief Имя этапа для вывода
+ * */
+const char* db_metric_stage_to_string(db_metric_stage stage);
+
+/**
+ * \brief Ключ замера: операция, этап, таблица
+ * */
+struct db_metric_key {
+  db_metric_op op;
+  db_metric_stage stage;
+  db_table table;
+
+ public:
+  bool operator<(const db_metric_key& r) const;
+};
+
+/**
+ * \brief Снимок гистограммы длительностей этапа
+ *
+ * Логарифмически-линейные корзины(как в HdrHistogram): значения
+ *   до 16нс - по корзине на наносекунду, дальше каждый интервал
+ *   [2^e, 2^(e+1)) делится на 16 корзин, относительная погрешность
+ *   не больше 1/16
+ * */
+struct db_metric_histogram {
+  /** \brief Количество корзин */
+  static constexpr size_t buckets_count = 720;
+
+  std::vector<uint64_t> buckets;
+  /** \brief Количество замеров */
+  uint64_t count = 0;
+  /** \brief Сумма длительностей, нс */
+  uint64_t sum_ns = 0;
+  /** \brief Максимальная длительность, нс */
+  uint64_t max_ns = 0;
+  /** \brief Количество этапов, завершённых с ошибкой */
+  uint64_t errors = 0;
+
+ public:
+  /**
+   * \brief Номер корзины для длительности `ns`
+   * */
+  static size_t BucketIndex(uint64_t ns);
+  /**
+   * \brief Верхняя граница значений корзины `index`, нс
+   * */
+  static uint64_t BucketUpperBound(size_t index);
+  /**
+   * \brief Квантиль `q` из [0, 1], верхняя граница корзины, нс
+   * */
+  uint64_t Percentile(double q) const;
+};
+
+/**
+ * \brief Снимок всех замеров
+ * */
+struct db_metrics_snapshot {
+  std::map<db_metric_key, db_metric_histogram> values;
+
+ public:
+  /**
+   * \brief Вывести снимок в текстовом формате Prometheus
+   * \param tables Интерфейс таблиц для имён таблиц, для nullptr
+   *   выводятся коды таблиц
+   * */
+  std::string ToPrometheus(const IDBTables* tables = nullptr) const;
+};
+
+/**
+ * \brief Замеры длительностей этапов операций с БД
+ *
+ * Гистограммы и счётчики ведутся по ключу db_metric_key отдельно для
+ *   каждого потока: запись замера - атомарные добавления в
+ *   гистограмму потока без блокировок, мьютекс потока берётся только
+ *   при появлении нового ключа и при снятии снимка. Операцию и таблицу
+ *   замеров задаёт DBMetrics::Scope текущего потока, этапы замеряет
+ *   DBMetrics::Timer.
+ *
+ * По умолчанию замеры отключены, Timer тогда не обращается к часам.
+ *
+ * Гистограммы завершившегося потока суммируются в общие гистограммы
+ *   реестра, и память под них освобождается, поэтому расход памяти
+ *   не растёт с количеством созданных потоков
+ * */
+class DBMetrics {
+ public:
+  /**
+   * \brief Операция и таблица замеров текущего потока на время
+   *   жизни объекта
+   * */
+  class Scope {
+   public:
+    Scope(db_metric_op op, db_table table);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    db_metric_op prev_op_;
+    db_table prev_table_;
+  };
+
+  /**
+   * \brief Замер этапа от создания объекта до Finish или удаления
+   * */
+  class Timer {
+   public:
+    explicit Timer(db_metric_stage stage);
+    ~Timer();
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    /**
+     * \brief Завершить замер
+     * \param ok false, если этап завершился ошибкой
+     * */
+    void Finish(bool ok = true);
+
+   private:
+    std::chrono::steady_clock::time_point start_;
+    db_metric_stage stage_;
+    bool active_;
+  };
+
+ public:
+  /**
+   * \brief Включить или отключить замеры
+   * */
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled();
+  /**
+   * \brief Записать длительность этапа для операции и таблицы
+   *   текущего потока
+   * */
+  static void Record(db_metric_stage stage, uint64_t ns, bool ok = true);
+  /**
+   * \brief Записать длительность этапа для ключа `key`
+   * */
+  static void Record(const db_metric_key& key, uint64_t ns, bool ok = true);
+  /**
+   * \brief Снять снимок замеров всех потоков
+   * */
+  static db_metrics_snapshot Snapshot();
+  /**
+   * \brief Количество наборов гистограмм живых потоков, записавших
+   *   хотя бы один замер
+   * */
+  static size_t ThreadsCount();
+  /**
+   * \brief Обнулить замеры всех потоков
+   * \note Замер, записываемый одновременно с обнулением, может
+   *   быть учтён частично
+   * */
+  static void Reset();
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_METRICS_H_
@@ -0,0 +1,326 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_mirror_table *
+ *   Зеркало таблицы БД в памяти процесса
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_MIRROR_TABLE_H_
+#define _DATABASE__DB_MIRROR_TABLE_H_
+
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_where.h"
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Зеркало таблицы БД в памяти
+ *
+ * Держит полную копию строк таблицы в векторе `std::vector<TableI>`
+ *   и хэш-индекс по первичному ключу. Точечные выборки по ключу
+ *   обслуживаются из памяти без обращения к СУБД.
+ *
+ * Обновление зеркала:
+ *   - полная перезагрузка Load;
+ *   - инкрементальное Refresh, если задан водяной знак - монотонно
+ *     растущий столбец(id, время обновления): выбираются строки со
+ *     значением больше последнего загруженного;
+ *   - по уведомлениям об изменении таблицы(см. SubscribeChanges).
+ *
+ * \tparam table Идентификатор таблицы
+ * \tparam TableI Структура, реализующая таблицу данных
+ * \tparam KeyT Тип первичного ключа
+ * \tparam WatermarkT Тип водяного знака: целое для id, строка для
+ *   времени обновления в формате ISO 8601(type_date, type_time),
+ *   сравнение строк которого совпадает с хронологическим
+ * */
+template <db_table table,
+          class TableI,
+          class KeyT = int64_t,
+          class WatermarkT = int64_t>
+class DBMirrorTable {
+ public:
+  /**
+   * \brief Функция получения первичного ключа строки
+   * */
+  typedef std::function<KeyT(const TableI&)> key_function;
+  /**
+   * \brief Функция получения значения водяного знака строки
+   * */
+  typedef std::function<WatermarkT(const TableI&)> watermark_function;
+
+ public:
+  /**
+   * \param dbm Указатель на менеджер подключения
+   * \param tables Указатель на пространство таблиц, нужен для сборки
+   *   условий инкрементальной выборки
+   * \param key_f Функция получения первичного ключа строки
+   * */
+  DBMirrorTable(DBConnectionManager* dbm,
+                IDBTables* tables,
+                key_function key_f)
+      : dbm_(dbm), tables_(tables), key_f_(std::move(key_f)) {}
+  /**
+   * \brief Отписаться от уведомлений, дождавшись исполняемого
+   *   обработчика: он обращается к зеркалу через `this`
+   * */
+  ~DBMirrorTable() { UnsubscribeChanges(); }
+
+  DBMirrorTable(const DBMirrorTable&) = delete;
+  DBMirrorTable& operator=(const DBMirrorTable&) = delete;
+
+  /**
+   * \brief Задать столбец водяного знака для инкрементального обновления
+   * \param field_id Идентификатор столбца
+   * \param wm_f Функция получения значения водяного знака строки
+   * \param tracks_updates Значение столбца растёт и при обновлении
+   *   строки(время обновления), а не только при добавлении(id)
+   * */
+  void SetWatermark(db_variable_id field_id,
+                    watermark_function wm_f,
+                    bool tracks_updates = false) {
+    std::unique_lock<std::shared_mutex> lock(lock_);
+    watermark_field_ = field_id;
+    watermark_f_ = std::move(wm_f);
+    watermark_tracks_updates_ = tracks_updates;
+    // значение прежнего столбца не годится, следующий Refresh
+    //   перезагрузит зеркало
+    watermark_.reset();
+    loaded_ = false;
+  }
+
+  /**
+   * \brief Полностью перезагрузить зеркало из БД
+   * */
+  mstatus_t Load() {
+    // функции могут смениться SetWatermark, копируем под блокировкой
+    key_function key_f;
+    watermark_function watermark_f;
+    {
+      std::shared_lock<std::shared_mutex> lock(lock_);
+      key_f = key_f_;
+      watermark_f = watermark_f_;
+    }
+    std::vector<TableI> rows;
+    mstatus_t st = dbm_->SelectAllRows(table, &rows);
+    if (is_status_ok(st)) {
+      std::unordered_map<KeyT, size_t> index;
+      index.reserve(rows.size());
+      std::optional<WatermarkT> watermark;
+      for (size_t i = 0; i < rows.size(); ++i) {
+        index[key_f(rows[i])] = i;
+        if (watermark_f) {
+          WatermarkT wm = watermark_f(rows[i]);
+          if (!watermark || *watermark < wm)
+            watermark = std::move(wm);
+        }
+      }
+      std::unique_lock<std::shared_mutex> lock(lock_);
+      rows_ = std::move(rows);
+      index_ = std::move(index);
+      watermark_ = watermark;
+      loaded_ = true;
+    }
+    return st;
+  }
+  /**
+   * \brief Догрузить в зеркало строки с водяным знаком больше
+   *   последнего загруженного
+   *
+   * Если водяной знак не задан, зеркало ещё не загружено или
+   *   пусто, выполняется полная перезагрузка
+   * \note Удалённые строки инкрементальным обновлением не обнаруживаются
+   * */
+  mstatus_t Refresh() {
+    db_variable_id field_id = 0;
+    std::optional<WatermarkT> watermark;
+    {
+      std::shared_lock<std::shared_mutex> lock(lock_);
+      if (loaded_ && watermark_f_) {
+        field_id = watermark_field_;
+        watermark = watermark_;
+      }
+    }
+    if (!field_id || !watermark)
+      return Load();
+    WhereTreeConstructor<table> c(tables_);
+    WhereTree<table> wt(c);
+    wt.Init(c.Gt(field_id, *watermark));
+    std::vector<TableI> rows;
+    mstatus_t st = dbm_->SelectRows(wt, &rows);
+    if (is_status_ok(st) && !rows.empty()) {
+      std::unique_lock<std::shared_mutex> lock(lock_);
+      for (auto& row : rows)
+        upsert(std::move(row));
+    }
+    return st;
+  }
+
+  /**
+   * \brief Подписаться на уведомления об изменении таблицы
+   *
+   * INSERT уведомления догружаются через Refresh, прочие операции -
+   *   через Refresh только если водяной знак отслеживает обновления,
+   *   иначе зеркало перезагружается целиком.
+   * \note Слушатель уведомлений должен быть запущен менеджером
+   *   (DBConnectionManager::StartChangeListener), обновление
+   *   выполняется в потоке слушателя
+   *
+   * \return true если подписка оформлена
+   * */
+  bool SubscribeChanges() {
+    UnsubscribeChanges();
+    subscription_id_ = dbm_->SubscribeTableChanges(
+        table, [this](const db_table_change& change) { onChange(change); });
+    return subscription_id_ != 0;
+  }
+  /**
+   * \brief Отменить подписку на уведомления об изменении таблицы
+   * \note Ждёт завершения обновления по уведомлению, если оно уже
+   *   исполняется в потоке слушателя
+   * */
+  void UnsubscribeChanges() {
+    if (subscription_id_) {
+      dbm_->UnsubscribeTableChanges(subscription_id_);
+      subscription_id_ = 0;
+    }
+  }
+
+  /**
+   * \brief Найти строку по первичному ключу
+   * */
+  std::optional<TableI> Find(const KeyT& key) const {
+    std::shared_lock<std::shared_mutex> lock(lock_);
+    auto it = index_.find(key);
+    return (it != index_.end()) ? std::optional<TableI>(rows_[it->second])
+                                : std::nullopt;
+  }
+  /**
+   * \brief Вызвать `f` для каждой строки зеркала
+   * \note Функция вызывается под захваченным на чтение мьютексом,
+   *   обращения к зеркалу на запись из неё недопустимы
+   * */
+  template <class F>
+  void ForEach(F f) const {
+    std::shared_lock<std::shared_mutex> lock(lock_);
+    for (const auto& row : rows_)
+      f(row);
+  }
+  /**
+   * \brief Количество строк зеркала
+   * */
+  size_t Size() const {
+    std::shared_lock<std::shared_mutex> lock(lock_);
+    return rows_.size();
+  }
+  /**
+   * \brief Последнее загруженное значение водяного знака, пусто если
+   *   водяной знак не задан или строк нет
+   * */
+  std::optional<WatermarkT> GetWatermark() const {
+    std::shared_lock<std::shared_mutex> lock(lock_);
+    return watermark_;
+  }
+
+ private:
+  /**
+   * \brief Добавить или заменить строку, вызывается под захваченным
+   *   на запись мьютексом
+   * */
+  void upsert(TableI&& row) {
+    if (watermark_f_) {
+      WatermarkT wm = watermark_f_(row);
+      if (!watermark_ || *watermark_ < wm)
+        watermark_ = std::move(wm);
+    }
+    KeyT key = key_f_(row);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      rows_[it->second] = std::move(row);
+    } else {
+      index_.emplace(key, rows_.size());
+      rows_.emplace_back(std::move(row));
+    }
+  }
+  /**
+   * \brief Обработать уведомление об изменении таблицы
+   * */
+  void onChange(const db_table_change& change) {
+    bool incremental = false;
+    {
+      std::shared_lock<std::shared_mutex> lock(lock_);
+      incremental = change.operation == "INSERT" ||
+                    (change.operation == "UPDATE" && watermark_tracks_updates_);
+    }
+    mstatus_t st = (incremental) ? Refresh() : Load();
+    if (!is_status_ok(st))
+      Logging::Append(io_loglvl::warn_logs,
+                      "Ошибка обновления зеркала таблицы по уведомлению: "
+                          + change.operation);
+  }
+
+ private:
+  mutable std::shared_mutex lock_;
+  /**
+   * \brief Указатель на менеджер подключения
+   * */
+  DBConnectionManager* dbm_;
+  /**
+   * \brief Указатель на пространство таблиц
+   * */
+  IDBTables* tables_;
+  /**
+   * \brief Функция получения первичного ключа
+   * */
+  key_function key_f_;
+  /**
+   * \brief Строки таблицы
+   * */
+  std::vector<TableI> rows_;
+  /**
+   * \brief Индекс строк по первичному ключу - позиция в `rows_`
+   * */
+  std::unordered_map<KeyT, size_t> index_;
+  /**
+   * \brief Идентификатор столбца водяного знака
+   * */
+  db_variable_id watermark_field_ = 0;
+  /**
+   * \brief Функция получения водяного знака строки
+   * */
+  watermark_function watermark_f_;
+  /**
+   * \brief Водяной знак отслеживает обновления строк
+   * */
+  bool watermark_tracks_updates_ = false;
+  /**
+   * \brief Последнее загруженное значение водяного знака
+   * */
+  std::optional<WatermarkT> watermark_;
+  /**
+   * \brief Зеркало загружено
+   * */
+  bool loaded_ = false;
+  /**
+   * \brief Идентификатор подписки на уведомления, 0 - подписки нет
+   * */
+  size_t subscription_id_ = 0;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_MIRROR_TABLE_H_
@@ -16,6 +16,7 @@
 
 #include "asp_db/db_defines.h"
 #include "asp_db/db_expression.h"
+#include "asp_db/db_insert_batch.h"
 
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
@@ -28,6 +29,7 @@
 
 namespace asp_db {
 class IDBTables;
+class db_fields_index;
 /**
  * \brief Сетап для добавления точки сохранения
  * */
@@ -111,6 +113,9 @@ struct db_table_create_setup {
   uniques_container unique_constrains;
   /** \brief Набор внешних ссылок */
   std::shared_ptr<db_ref_collection> ref_strings = nullptr;
+  /** \brief Установить триггер уведомлений об изменении данных
+   *   таблицы(LISTEN/NOTIFY для postgresql), см. DBChangeListener */
+  bool notify_on_change = false;
 
  private:
   /** \brief Собрать поле 'pk_string' */
@@ -156,6 +161,9 @@ struct db_query_basesetup {
   /** \brief Ссылка на коллекцию полей(столбцов)
    *   таблицы в БД для таблицы 'table' */
   const db_fields_collection& fields;
+  /** \brief Индекс полей коллекции `fields`, если есть,
+   *   см. IDBTables::GetFieldsIndex */
+  const db_fields_index* fields_index = nullptr;
 };
 
 /**
@@ -183,10 +191,20 @@ struct db_query_insert_setup : public db_query_basesetup {
    * */
   template <class DataInfo>
   static bool haveConflict(const std::vector<DataInfo>& select_data) {
-    if (!select_data.empty()) {
-      auto initialized = (*select_data.begin()).initialized;
-      for (auto it = select_data.begin() + 1; it != select_data.end(); ++it)
-        if (initialized != (*it).initialized)
+    return haveConflict(select_data.begin(), select_data.end());
+  }
+  /**
+   * \brief Проверить соответствие значений полей initialized для
+   *   элементов диапазона [first, last)
+   * \note Элементы только читаются, диапазон может состоять из
+   *   std::move_iterator
+   * */
+  template <class ForwardIt>
+  static bool haveConflict(ForwardIt first, ForwardIt last) {
+    if (first != last) {
+      auto initialized = (*first).initialized;
+      for (++first; first != last; ++first)
+        if (initialized != (*first).initialized)
           return true;
     }
     return false;
@@ -196,7 +214,7 @@ struct db_query_insert_setup : public db_query_basesetup {
   virtual ~db_query_insert_setup() = default;
 
   inline void SetOnExistAct(on_exists_act act) { on_exists = act; }
-  inline size_t RowsSize() const { return values_vec.size(); }
+  inline size_t RowsSize() const { return batch.RowsSize(); }
   /**
    * \brief Функция собирающая обычное дерево условий `a` = 'A',
    *   разнесённых операторами AND
@@ -205,9 +223,9 @@ struct db_query_insert_setup : public db_query_basesetup {
 
  public:
   /**
-   * \brief Набор значений для операций INSERT|SELECT|DELETE
+   * \brief Значения строк INSERT операции по столбцам
    * */
-  std::vector<row_values> values_vec;
+  db_insert_batch batch;
   /**
    * \brief Флаг действия с insert данными, если они уже
    *   присутствуют в таблице
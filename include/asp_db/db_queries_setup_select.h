@@ -41,8 +41,10 @@ struct db_query_select_setup : public db_query_basesetup {
     if (tables == nullptr)
       throw idbtables_exception<table>(
           "Объект WhereTree не содержит информации о пространстве таблиц");
-    return std::shared_ptr<db_query_select_setup>(new db_query_select_setup(
+    std::shared_ptr<db_query_select_setup> setup(new db_query_select_setup(
         table, *tables->GetFieldsCollection(table), wt.GetWhereTree(), false));
+    setup->fields_index = tables->GetFieldsIndex(table);
+    return setup;
   }
   /**
    * \brief Статический конструктор для select запросов всех данных
@@ -50,8 +52,10 @@ struct db_query_select_setup : public db_query_basesetup {
   static std::shared_ptr<db_query_select_setup> Init(const IDBTables* tables,
                                                      db_table table,
                                                      bool act2all) {
-    return std::shared_ptr<db_query_select_setup>(new db_query_select_setup(
+    std::shared_ptr<db_query_select_setup> setup(new db_query_select_setup(
         table, *tables->GetFieldsCollection(table), nullptr, act2all));
+    setup->fields_index = tables->GetFieldsIndex(table);
+    return setup;
   }
 
   virtual ~db_query_select_setup() = default;
@@ -62,6 +66,14 @@ struct db_query_select_setup : public db_query_basesetup {
    *   не проинициализировано(если оно пустое, то вернёт пустую строку)
    * */
   std::optional<std::string> GetWhereString() const;
+  /**
+   * \brief Получить дерево условий where
+   *
+   * \return Указатель на дерево или nullptr, если условия не заданы
+   * */
+  const std::shared_ptr<DBWhereClause<where_node_data>>& GetWhereTree() const {
+    return where_;
+  }
 
   /**
    * \brief Установлен ли флаг применения ко всем данным
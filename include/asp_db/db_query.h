@@ -11,6 +11,7 @@
 #define _DATABASE__DB_QUERY_H_
 
 #include "asp_db/db_defines.h"
+#include "asp_db/db_metrics.h"
 #include "asp_db/db_queries_setup.h"
 #include "asp_db/db_queries_setup_select.h"
 
@@ -39,6 +40,10 @@ class DBQuery {
   virtual mstatus_t Execute();
   virtual void unExecute();
   virtual ~DBQuery();
+  /** \brief Краткое название запроса */
+  std::string GetInfo();
+  /** \brief Этап транзакции для замеров DBMetrics */
+  virtual db_metric_stage MetricStage() const;
 
  protected:
   DBQuery(DBConnection* db_ptr);
@@ -63,13 +68,21 @@ typedef std::vector<QuerySmartPtr> QueryContainer;
  * */
 class DBQuerySetupConnection : public DBQuery {
  public:
-  DBQuerySetupConnection(DBConnection* db_ptr);
+  /**
+   * \param read_only транзакция только для чтения,
+   *   см. DBConnection::SetReadOnly
+   * */
+  DBQuerySetupConnection(DBConnection* db_ptr, bool read_only = false);
   /** \brief отключиться от бд */
   void unExecute() override;
+  db_metric_stage MetricStage() const override;
 
  protected:
   mstatus_t exec() override;
   std::string q_info() override;
+
+ private:
+  bool read_only_;
 };
 
 /**
@@ -79,6 +92,7 @@ class DBQueryCloseConnection : public DBQuery {
  public:
   DBQueryCloseConnection(DBConnection* db_ptr);
   mstatus_t Execute() override;
+  db_metric_stage MetricStage() const override;
 
  protected:
   mstatus_t exec() override;
@@ -93,6 +107,7 @@ class DBQueryAddSavePoint : public DBQuery {
   DBQueryAddSavePoint(DBConnection* ptr, const db_save_point& sp);
   /** \brief Rollback к этой точке сохранения */
   void unExecute() override;
+  db_metric_stage MetricStage() const override;
 
  protected:
   mstatus_t exec() override;
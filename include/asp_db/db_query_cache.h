@@ -0,0 +1,181 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_query_cache *
+ *   Кэш результатов SELECT запросов менеджера подключений
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_QUERY_CACHE_H_
+#define _DATABASE__DB_QUERY_CACHE_H_
+
+#include "asp_db/db_defines.h"
+#include "asp_db/db_queries_setup_select.h"
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Параметры кэша результатов выборки
+ * */
+struct db_query_cache_parameters {
+  /**
+   * \brief Бюджет памяти кэша в байтах
+   * */
+  size_t memory_budget = 16 * 1024 * 1024;
+  /**
+   * \brief Время жизни записи кэша
+   * */
+  std::chrono::milliseconds ttl = std::chrono::seconds(60);
+};
+
+/**
+ * \brief Кэш результатов SELECT запросов
+ *
+ * Ключ записи собирается из кода таблицы, отрендеренной строки WHERE
+ *   условий и набора выбираемых полей. Вытеснение записей - LRU в
+ *   пределах бюджета памяти, устаревшие по TTL записи удаляются при
+ *   обращении к ним. Любая модифицирующая операция над таблицей
+ *   должна инвалидировать все записи этой таблицы
+ * */
+class DBQueryCache {
+ public:
+  typedef std::chrono::steady_clock clock;
+  typedef std::vector<db_query_basesetup::row_values> rows_container;
+
+ public:
+  explicit DBQueryCache(const db_query_cache_parameters& parameters);
+
+  /**
+   * \brief Собрать ключ записи кэша для сетапа выборки
+   * */
+  static std::string MakeKey(const db_query_select_setup& setup);
+
+  /**
+   * \brief Найти результат выборки в кэше
+   * \param setup Сетап выборки
+   * \param result Указатель на структуру результата, в неё копируются
+   *   закэшированные строки
+   *
+   * \return true если актуальная запись найдена
+   * */
+  bool Get(const db_query_select_setup& setup, db_query_select_result* result);
+  /**
+   * \brief Поколение записей таблицы `table`, читается до выполнения
+   *   выборки и передаётся в Put
+   * */
+  uint64_t Generation(db_table table) const;
+  /**
+   * \brief Сохранить результат выборки в кэш
+   *
+   * Результат не сохраняется, если его размер превышает бюджет кэша
+   *   или таблица была инвалидирована после чтения поколения
+   *   `generation`: иначе выборка, выполненная до изменения таблицы,
+   *   вернула бы в кэш устаревшие строки
+   * */
+  void Put(const db_query_select_setup& setup,
+           const db_query_select_result& result,
+           uint64_t generation);
+  /**
+   * \brief Удалить все записи таблицы `table` и сменить её поколение
+   * */
+  void InvalidateTable(db_table table);
+  /**
+   * \brief Очистить кэш
+   * */
+  void Clear();
+
+  /**
+   * \brief Количество записей кэша
+   * */
+  size_t Size() const;
+  /**
+   * \brief Оценка занимаемой записями кэша памяти
+   * */
+  size_t MemoryUsage() const;
+  /**
+   * \brief Параметры кэша
+   * */
+  const db_query_cache_parameters& GetParameters() const {
+    return parameters_;
+  }
+
+ private:
+  /**
+   * \brief Запись кэша
+   * */
+  struct cache_entry {
+    /**
+     * \brief Ключ записи
+     * */
+    std::string key;
+    /**
+     * \brief Код таблицы
+     * */
+    db_table table;
+    /**
+     * \brief Строки результата выборки
+     * */
+    rows_container rows;
+    /**
+     * \brief Оценка занимаемой памяти
+     * */
+    size_t size;
+    /**
+     * \brief Время устаревания записи
+     * */
+    clock::time_point expire;
+  };
+  typedef std::list<cache_entry> lru_list;
+
+ private:
+  /**
+   * \brief Оценить размер строк результата
+   * */
+  static size_t rowsSize(const rows_container& rows);
+  /**
+   * \brief Удалить запись, вызывается под захваченным мьютексом
+   * */
+  void erase(lru_list::iterator it);
+  /**
+   * \brief Вытеснить давно используемые записи до попадания в бюджет
+   *   памяти, вызывается под захваченным мьютексом
+   * */
+  void evict(size_t required);
+
+ private:
+  mutable std::mutex lock_;
+  /**
+   * \brief Параметры кэша
+   * */
+  const db_query_cache_parameters parameters_;
+  /**
+   * \brief Записи кэша, в начале списка - последние использованные
+   * */
+  lru_list entries_;
+  /**
+   * \brief Индекс записей по ключу
+   * */
+  std::unordered_map<std::string, lru_list::iterator> index_;
+  /**
+   * \brief Суммарная оценка памяти записей
+   * */
+  size_t memory_usage_ = 0;
+  /**
+   * \brief Поколения таблиц, увеличиваются при инвалидации
+   * */
+  std::unordered_map<db_table, uint64_t> generations_;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_QUERY_CACHE_H_
@@ -0,0 +1,171 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_QUERY_STATS_H_
+#define _DATABASE__DB_QUERY_STATS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stdint.h>
+
+namespace asp_db {
+/**
+ * \brief Нормализовать текст запроса: литералы строк и чисел
+ *   заменяются на `?`, списки литералов `?, ?, ?` сворачиваются
+ *   в `?`, одинаковые подряд группы `(...), (...)` - в одну,
+ *   пробельные символы - в один пробел
+ *
+ * Запросы, собранные одним setup*String с разными значениями,
+ *   в том числе INSERT с разным числом строк, дают одинаковый текст
+ * */
+std::string db_query_normalize(const std::string& sql);
+/**
+ * \brief Отпечаток нормализованного текста запроса(FNV-1a)
+ * */
+uint64_t db_query_fingerprint(const std::string& normalized);
+
+/**
+ * \brief Статистика запросов одного отпечатка
+ * */
+struct db_query_stat {
+  /** \brief Отпечаток */
+  uint64_t fingerprint = 0;
+  /** \brief Нормализованный текст запроса */
+  std::string query;
+  /** \brief Количество выполнений */
+  uint64_t calls = 0;
+  /** \brief Суммарная, минимальная и максимальная длительность, нс */
+  uint64_t total_ns = 0;
+  uint64_t min_ns = 0;
+  uint64_t max_ns = 0;
+  /** \brief Строк результата */
+  uint64_t rows = 0;
+  /** \brief Байт передано: текст запроса и значения результата */
+  uint64_t bytes = 0;
+
+ public:
+  uint64_t MeanNs() const;
+};
+
+/**
+ * \brief Порядок отчёта статистики запросов
+ * */
+enum class db_query_stats_order : uint32_t {
+  total_time = 0,
+  mean_time,
+  max_time,
+  calls,
+  rows,
+  bytes
+};
+
+/**
+ * \brief Статистика выполненных запросов по отпечаткам, аналог
+ *   pg_stat_statements на стороне клиента
+ *
+ * Хранилище разбито на сегменты со своими мьютексами, размер
+ *   ограничен: при переполнении сегмента вытесняется отпечаток
+ *   с наименьшим числом выполнений. Бэкенды(postgres, firebird)
+ *   записывают выполненные запросы в DBQueryStats::Global(), если
+ *   статистика включена.
+ * */
+class DBQueryStats {
+ public:
+  /**
+   * \brief Замер одного запроса: время берётся при создании, только
+   *   если статистика включена
+   * */
+  class Statement {
+   public:
+    explicit Statement(DBQueryStats& stats);
+    /**
+     * \brief Запрос замеряется: объём результата стоит считать
+     * */
+    bool IsActive() const;
+    /**
+     * \brief Записать выполненный запрос
+     * \param sql Текст запроса
+     * \param rows Строк результата
+     * \param bytes Байт результата, к ним добавляется длина `sql`
+     * */
+    void Finish(const std::string& sql, uint64_t rows, uint64_t bytes);
+
+   private:
+    DBQueryStats& stats_;
+    std::chrono::steady_clock::time_point start_;
+    bool active_;
+  };
+
+ public:
+  /**
+   * \param capacity Максимальное количество отпечатков
+   * */
+  explicit DBQueryStats(size_t capacity = default_capacity);
+
+  /**
+   * \brief Общая статистика бэкендов процесса
+   * */
+  static DBQueryStats& Global();
+
+  void SetEnabled(bool enabled);
+  bool IsEnabled() const;
+  /**
+   * \brief Записать выполнение запроса `sql`
+   * */
+  void Record(const std::string& sql,
+              uint64_t ns,
+              uint64_t rows,
+              uint64_t bytes);
+  /**
+   * \brief `n` самых дорогих отпечатков в порядке `order`
+   * */
+  std::vector<db_query_stat> Top(
+      size_t n,
+      db_query_stats_order order = db_query_stats_order::total_time) const;
+  /**
+   * \brief Текстовый отчёт по `n` самым дорогим отпечаткам
+   * */
+  std::string Report(
+      size_t n,
+      db_query_stats_order order = db_query_stats_order::total_time) const;
+  /**
+   * \brief Количество отпечатков
+   * */
+  size_t Size() const;
+  /**
+   * \brief Количество вытесненных отпечатков
+   * */
+  uint64_t Evicted() const;
+  void Reset();
+
+ public:
+  static constexpr size_t default_capacity = 1024;
+
+ private:
+  static constexpr size_t shards_count = 16;
+  struct shard {
+    mutable std::mutex lock;
+    std::unordered_map<uint64_t, db_query_stat> values;
+  };
+
+ private:
+  std::array<shard, shards_count> shards_;
+  size_t shard_capacity_;
+  std::atomic<bool> enabled_{false};
+  std::atomic<uint64_t> evicted_{0};
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_QUERY_STATS_H_
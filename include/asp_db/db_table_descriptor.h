@@ -0,0 +1,327 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_table_descriptor *
+ *   Дескриптор отображения полей структуры таблицы на столбцы БД
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_TABLE_DESCRIPTOR_H_
+#define _DATABASE__DB_TABLE_DESCRIPTOR_H_
+
+#include "asp_db/db_defines.h"
+#include "asp_db/db_queries_setup.h"
+#include "asp_db/db_queries_setup_select.h"
+
+#include <charconv>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Записать целое значение(или enum) в строку `s`
+ *
+ * Число форматируется std::to_chars в буфер на стеке, строка `s`
+ *   переиспользует свою память, а короткие числа умещаются в
+ *   небольшой строке без выделения памяти
+ * */
+template <class T>
+void db_int_to_string(T v, std::string* s) {
+  char buf[24];
+  auto r = std::to_chars(buf, buf + sizeof(buf), static_cast<long long>(v));
+  s->assign(buf, r.ptr);
+}
+/**
+ * \brief Разобрать целое значение(или enum) из строки без копирования
+ * */
+template <class T>
+void db_string_to_int(const std::string& s, T* v) {
+  long long x = 0;
+  std::from_chars(s.data(), s.data() + s.size(), x);
+  *v = static_cast<T>(x);
+}
+
+/**
+ * \brief Есть ли у структуры TableI поле флагов `initialized`
+ * */
+template <class TableI, class = void>
+struct db_has_initialized : std::false_type {};
+template <class TableI>
+struct db_has_initialized<TableI,
+                          std::void_t<decltype(TableI::initialized)>>
+    : std::true_type {};
+
+/**
+ * \brief Связь столбца таблицы БД с полем структуры TableI
+ * \tparam TableI Структура, реализующая таблицу данных
+ * */
+template <class TableI>
+struct db_column_binding {
+  /**
+   * \brief Функция записи строкового значения столбца в поле структуры
+   * */
+  typedef void (*setter_t)(TableI&, const std::string&);
+  /**
+   * \brief Функция получения строкового значения поля структуры
+   * \return false если значение не задано и в INSERT не добавляется
+   * */
+  typedef bool (*getter_t)(const TableI&, std::string*);
+  /**
+   * \brief Функция получения строкового значения поля, которая может
+   *   переместить данные поля структуры(например строку)
+   * */
+  typedef bool (*taker_t)(TableI&, std::string*);
+
+ public:
+  /**
+   * \brief Идентификатор столбца
+   * */
+  db_variable_id fid;
+  /**
+   * \brief Флаг поля `TableI::initialized`, 0 - поле добавляется
+   *   в INSERT всегда
+   * */
+  int32_t flag;
+  setter_t set;
+  getter_t get;
+  /**
+   * \brief Для добавления перемещением, если не задана - используется
+   *   `get`
+   * */
+  taker_t take = nullptr;
+};
+
+/**
+ * \brief Дескриптор таблицы: функции записи и чтения полей структуры
+ *   TableI по индексу столбца в коллекции полей таблицы
+ *
+ * Таблица функций по индексу столбца собирается один раз при создании
+ *   дескриптора, так что разбор результатов выборки - прямой вызов
+ *   функции на ячейку вместо сравнения имён столбцов, и тот же набор
+ *   функций собирает значения для INSERT.
+ *
+ * Пример использования в реализации IDBTables:
+ * \code
+ * static const db_table_descriptor<book> book_descriptor(book_fields, {
+ *     {BOOK_ID, book::f_id,
+ *      [](book& b, const std::string& s) { db_string_to_int(s, &b.id); },
+ *      [](const book& b, std::string* s) {
+ *        db_int_to_string(b.id, s);
+ *        return b.id > 0;
+ *      }},
+ *     {BOOK_TITLE, book::f_title,
+ *      [](book& b, const std::string& s) { b.title = s; },
+ *      [](const book& b, std::string* s) {
+ *        *s = b.title;
+ *        return true;
+ *      },
+ *      [](book& b, std::string* s) {
+ *        *s = std::move(b.title);
+ *        return true;
+ *      }},
+ *     ...});
+ *
+ * template <>
+ * void IDBTables::SetSelectData<book>(db_query_select_result* src,
+ *                                     std::vector<book>* out_vec) const {
+ *   book_descriptor.SetSelectData(*src, out_vec);
+ * }
+ * \endcode
+ *
+ * \tparam TableI Структура, реализующая таблицу данных. Если у неё
+ *   есть поле флагов `initialized`, в INSERT добавляются только
+ *   отмеченные флагами поля
+ * */
+template <class TableI>
+class db_table_descriptor {
+ public:
+  typedef db_query_basesetup::field_index field_index;
+  typedef db_query_basesetup::row_values row_values;
+  typedef db_column_binding<TableI> binding;
+
+ public:
+  /**
+   * \param fields Коллекция полей таблицы
+   * \param bindings Связи столбцов с полями структуры, столбцы
+   *   отсутствующие в `fields` пропускаются
+   * */
+  db_table_descriptor(const db_fields_collection& fields,
+                      std::initializer_list<binding> bindings)
+      : fields_(&fields), bindings_(bindings) {
+    setters_ = makeSetters(fields);
+    positions_.assign(fields.size(), db_query_basesetup::field_index_end);
+    for (size_t i = 0; i < bindings_.size(); ++i) {
+      indexes_.push_back(findIndex(fields, bindings_[i].fid));
+      if (indexes_[i] != db_query_basesetup::field_index_end)
+        positions_[indexes_[i]] = i;
+    }
+  }
+
+  /**
+   * \brief Записать значения строки результата выборки в структуру
+   * */
+  void SetRow(const row_values& row, TableI* out) const {
+    setRow(setters_, row, out);
+  }
+  /**
+   * \brief Заполнить out_vec строками результата выборки
+   * */
+  void SetSelectData(const db_query_select_result& src,
+                     std::vector<TableI>* out_vec) const {
+    // индексы результата относятся к коллекции полей сетапа,
+    //   для другой коллекции таблица функций собирается заново
+    std::vector<typename binding::setter_t> other;
+    if (&src.fields != fields_)
+      other = makeSetters(src.fields);
+    const auto& setters = (&src.fields == fields_) ? setters_ : other;
+    out_vec->reserve(out_vec->size() + src.values_vec.size());
+    for (const auto& row : src.values_vec) {
+      TableI t;
+      setRow(setters, row, &t);
+      out_vec->push_back(std::move(t));
+    }
+  }
+  /**
+   * \brief Собрать строковые значения инициализированных полей
+   *   структуры по индексам столбцов
+   * */
+  row_values ToRow(const TableI& data) const {
+    row_values values;
+    toRow(data, &values, [](const binding& b, const TableI& d, std::string* s) {
+      return b.get(d, s);
+    });
+    return values;
+  }
+  /**
+   * \brief Добавить значения структуры строкой пакета сетапа
+   *   INSERT запроса
+   * */
+  void SetInsertValues(db_query_insert_setup* src, const TableI& data) const {
+    appendRow(data, &src->batch,
+              [](const binding& b, const TableI& d, std::string* s) {
+                return b.get(d, s);
+              });
+  }
+  /**
+   * \brief Добавить значения структуры строкой пакета сетапа
+   *   INSERT запроса, перемещая данные полей со связями `take`
+   * \note После вызова перемещённые поля `data` в допустимом, но
+   *   неопределённом состоянии
+   * */
+  void MoveInsertValues(db_query_insert_setup* src, TableI& data) const {
+    appendRow(data, &src->batch,
+              [](const binding& b, TableI& d, std::string* s) {
+                return b.take ? b.take(d, s) : b.get(d, s);
+              });
+  }
+
+ private:
+  /**
+   * \brief Индекс столбца `fid` в коллекции полей
+   * */
+  static field_index findIndex(const db_fields_collection& fields,
+                               db_variable_id fid) {
+    for (size_t i = 0; i < fields.size(); ++i)
+      if (fields[i].fid == fid)
+        return i;
+    return db_query_basesetup::field_index_end;
+  }
+  /**
+   * \brief Собрать таблицу функций записи по индексу столбца
+   * */
+  std::vector<typename binding::setter_t> makeSetters(
+      const db_fields_collection& fields) const {
+    std::vector<typename binding::setter_t> setters(fields.size(), nullptr);
+    for (const auto& b : bindings_) {
+      field_index i = findIndex(fields, b.fid);
+      if (i != db_query_basesetup::field_index_end)
+        setters[i] = b.set;
+    }
+    return setters;
+  }
+  /**
+   * \brief Значение связи `i` инициализировано в `data`
+   * */
+  bool isInitialized(size_t i, const TableI& data) const {
+    const binding& b = bindings_[i];
+    if (indexes_[i] == db_query_basesetup::field_index_end || !b.get)
+      return false;
+    if constexpr (db_has_initialized<TableI>::value) {
+      if (b.flag && !(data.initialized & b.flag))
+        return false;
+    }
+    return true;
+  }
+  template <class DataT, class GetF>
+  void toRow(DataT& data, row_values* values, GetF get) const {
+    std::string value;
+    for (size_t i = 0; i < bindings_.size(); ++i)
+      if (isInitialized(i, data) && get(bindings_[i], data, &value))
+        values->emplace_hint(values->end(), indexes_[i], std::move(value));
+  }
+  /**
+   * \brief Добавить строку `data` к пакету. Набор столбцов пакета -
+   *   инициализированные поля первой строки, для остальных строк он
+   *   совпадает, см. db_query_insert_setup::haveConflict
+   * */
+  template <class DataT, class GetF>
+  void appendRow(DataT& data, db_insert_batch* batch, GetF get) const {
+    if (!batch->HasColumns()) {
+      std::vector<field_index> columns;
+      for (size_t i = 0; i < bindings_.size(); ++i)
+        if (isInitialized(i, data))
+          columns.push_back(indexes_[i]);
+      batch->SetColumns(columns);
+    }
+    std::string* value = batch->Buffer();
+    for (size_t col = 0; col < batch->ColumnsSize(); ++col) {
+      field_index i = batch->ColumnIndex(col);
+      value->clear();
+      if (i < positions_.size()
+          && positions_[i] != db_query_basesetup::field_index_end
+          && get(bindings_[positions_[i]], data, value))
+        batch->Append(*value);
+      else
+        batch->AppendNull();
+    }
+    batch->CommitRow();
+  }
+  static void setRow(const std::vector<typename binding::setter_t>& setters,
+                     const row_values& row,
+                     TableI* out) {
+    for (const auto& col : row)
+      if (col.first < setters.size() && setters[col.first])
+        setters[col.first](*out, col.second);
+  }
+
+ private:
+  /**
+   * \brief Коллекция полей таблицы
+   * */
+  const db_fields_collection* fields_;
+  /**
+   * \brief Связи столбцов с полями структуры
+   * */
+  std::vector<binding> bindings_;
+  /**
+   * \brief Функции записи по индексу столбца
+   * */
+  std::vector<typename binding::setter_t> setters_;
+  /**
+   * \brief Индексы столбцов связей `bindings_`
+   * */
+  std::vector<field_index> indexes_;
+  /**
+   * \brief Позиции связей по индексу столбца
+   * */
+  std::vector<size_t> positions_;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_TABLE_DESCRIPTOR_H_
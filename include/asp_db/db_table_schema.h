@@ -0,0 +1,213 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_table_schema *
+ *   Схема таблицы времени компиляции и индекс её полей
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_TABLE_SCHEMA_H_
+#define _DATABASE__DB_TABLE_SCHEMA_H_
+
+#include "asp_db/db_defines.h"
+
+#include <array>
+#include <stdexcept>
+
+#include <stdint.h>
+
+namespace asp_db {
+/**
+ * \brief Флаги поля схемы таблицы, см. db_variable::db_variable_flags
+ * */
+enum db_field_flag : uint32_t {
+  ff_none = 0x00,
+  ff_primary_key = 0x01,
+  ff_reference = 0x02,
+  /// в отличие от db_variable_flags по умолчанию поле может быть NULL
+  ff_not_null = 0x04,
+  ff_can_be_negative = 0x08,
+  ff_array = 0x10,
+  ff_has_default = 0x20
+};
+
+/**
+ * \brief Описание поля схемы таблицы
+ * */
+struct db_field_schema {
+  db_variable_id fid;
+  const char* fname;
+  db_variable_type type;
+  /**
+   * \brief Набор флагов db_field_flag
+   * */
+  uint32_t flags = ff_none;
+  /**
+   * \brief Для массивов - количество элементов
+   * */
+  int len = 1;
+
+ public:
+  /**
+   * \brief Собрать описание поля для коллекции полей таблицы
+   * */
+  db_variable ToVariable() const;
+};
+
+/**
+ * \brief Ячейка хэш-таблицы индекса полей, `fid == 0` - ячейка пуста
+ * */
+struct db_field_slot {
+  db_variable_id fid = 0;
+  uint32_t index = 0;
+};
+
+/**
+ * \brief Хэш идентификатора поля
+ * */
+constexpr size_t db_field_hash(db_variable_id fid) {
+  return static_cast<size_t>((uint64_t(fid) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+/**
+ * \brief Индекс полей таблицы: идентификатор поля -> позиция в
+ *   коллекции полей
+ *
+ * Представление хэш-таблицы с открытой адресацией схемы
+ *   db_table_schema, не владеет данными
+ * */
+class db_fields_index {
+ public:
+  static constexpr size_t npos = size_t(-1);
+
+ public:
+  constexpr db_fields_index(const db_field_slot* slots, size_t mask)
+      : slots_(slots), mask_(mask) {}
+
+  /**
+   * \brief Позиция поля `fid` в коллекции полей
+   * \return npos если поля нет
+   * */
+  constexpr size_t IndexOf(db_variable_id fid) const {
+    for (size_t i = db_field_hash(fid) & mask_;; i = (i + 1) & mask_) {
+      if (slots_[i].fid == fid)
+        return slots_[i].index;
+      if (slots_[i].fid == 0)
+        return npos;
+    }
+  }
+
+ private:
+  const db_field_slot* slots_;
+  size_t mask_;
+};
+
+/**
+ * \brief Схема таблицы времени компиляции
+ *
+ * Хранит описания полей и хэш-таблицу `fid -> позиция поля`,
+ *   заполняемую при constexpr построении схемы, так что разрешение
+ *   идентификатора поля не требует перебора коллекции полей:
+ * \code
+ * constexpr db_table_schema book_schema({
+ *     {TABLE_FIELD_PAIR(BOOK_ID), db_variable_type::type_autoinc,
+ *      ff_primary_key | ff_not_null},
+ *     {TABLE_FIELD_PAIR(BOOK_TITLE), db_variable_type::type_text,
+ *      ff_not_null}});
+ * static_assert(book_schema.IndexOf(BOOK_TITLE) == 1);
+ * \endcode
+ *
+ * Для реализаций IDBTables схема собирает коллекцию полей
+ *   (MakeCollection) и индекс для IDBTables::GetFieldsIndex
+ *
+ * \tparam N Количество полей
+ * */
+template <size_t N>
+class db_table_schema {
+ public:
+  /**
+   * \brief Размер хэш-таблицы - степень двойки не меньше 2N
+   * */
+  static constexpr size_t capacity = [] {
+    size_t c = 2;
+    while (c < 2 * N)
+      c <<= 1;
+    return c;
+  }();
+
+ public:
+  /**
+   * \throw std::logic_error Для повторяющихся и нулевых идентификаторов
+   *   полей, при constexpr построении - ошибка компиляции
+   * */
+  constexpr explicit db_table_schema(const db_field_schema (&fields)[N])
+      : fields_{}, slots_{} {
+    for (size_t i = 0; i < N; ++i) {
+      fields_[i] = fields[i];
+      if (fields[i].fid == 0)
+        throw std::logic_error("Нулевой идентификатор поля схемы таблицы");
+      size_t s = db_field_hash(fields[i].fid) & (capacity - 1);
+      for (; slots_[s].fid != 0; s = (s + 1) & (capacity - 1))
+        if (slots_[s].fid == fields[i].fid)
+          throw std::logic_error("Повторный идентификатор поля схемы");
+      slots_[s].fid = fields[i].fid;
+      slots_[s].index = static_cast<uint32_t>(i);
+    }
+  }
+
+  /**
+   * \brief Количество полей
+   * */
+  constexpr size_t Size() const { return N; }
+  /**
+   * \brief Описание поля в позиции `i`
+   * */
+  constexpr const db_field_schema& operator[](size_t i) const {
+    return fields_[i];
+  }
+  /**
+   * \brief Позиция поля `fid`, db_fields_index::npos если поля нет
+   * */
+  constexpr size_t IndexOf(db_variable_id fid) const {
+    return Index().IndexOf(fid);
+  }
+  /**
+   * \brief Индекс полей схемы
+   * \note Индекс ссылается на схему и действителен пока она существует
+   * */
+  constexpr db_fields_index Index() const {
+    return db_fields_index(slots_.data(), capacity - 1);
+  }
+  /**
+   * \brief Собрать коллекцию полей в порядке схемы
+   * */
+  db_fields_collection MakeCollection() const {
+    db_fields_collection fields;
+    fields.reserve(N);
+    for (const auto& f : fields_)
+      fields.push_back(f.ToVariable());
+    return fields;
+  }
+
+ private:
+  std::array<db_field_schema, N> fields_;
+  std::array<db_field_slot, capacity> slots_;
+};
+
+inline db_variable db_field_schema::ToVariable() const {
+  db_variable::db_variable_flags f;
+  f.is_primary_key = flags & ff_primary_key;
+  f.is_reference = flags & ff_reference;
+  f.can_be_null = !(flags & ff_not_null);
+  f.can_be_negative = flags & ff_can_be_negative;
+  f.is_array = flags & ff_array;
+  f.has_default = flags & ff_has_default;
+  return db_variable(fid, fname, type, f, len);
+}
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_TABLE_SCHEMA_H_
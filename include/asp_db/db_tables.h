@@ -16,11 +16,14 @@
 
 #include "asp_db/db_defines.h"
 #include "asp_db/db_queries_setup.h"
+#include "asp_db/db_table_schema.h"
 
 #include <algorithm>
 #include <exception>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 /* macro */
@@ -141,6 +144,19 @@ class IDBTables {
    * \return Ссылка на сетап создания таблицы dt
    * */
   virtual const db_table_create_setup& CreateSetupByCode(db_table dt) const = 0;
+  /**
+   * \brief Получить индекс полей таблицы по её id
+   * \param t Идентификатор таблицы
+   *
+   * \return Указатель на индекс `fid -> позиция поля` в коллекции
+   *   GetFieldsCollection(t) или nullptr, если индекса нет и поля
+   *   ищутся перебором коллекции
+   *
+   * \note Индекс собирается по схеме таблицы, см. db_table_schema
+   * */
+  virtual const db_fields_index* GetFieldsIndex(db_table /*t*/) const {
+    return nullptr;
+  }
 
   /**
    * \brief Шаблон функции получения имени таблицы по типу.
@@ -189,6 +205,28 @@ class IDBTables {
   template <class TableI>
   std::unique_ptr<db_query_insert_setup> InitInsertSetup(
       const std::vector<TableI>& insert_data) const;
+  /**
+   * \brief Собрать сетап INSERT операции, перемещая данные
+   *   добавляемых структур(строки и т.п.) в сетап
+   * \param insert_data Добавляемые структуры, после вызова
+   *   перемещённые поля в неопределённом состоянии
+   * */
+  template <class TableI>
+  std::unique_ptr<db_query_insert_setup> InitInsertSetup(
+      std::vector<TableI>&& insert_data) const;
+  /**
+   * \brief Собрать сетап INSERT операции для диапазона
+   *   структур [first, last) без копирования их в вектор
+   *
+   * Для диапазона std::move_iterator данные структур перемещаются:
+   * \code
+   * tables->InitInsertSetup<book>(std::make_move_iterator(v.begin()),
+   *                               std::make_move_iterator(v.end()));
+   * \endcode
+   * */
+  template <class TableI, class ForwardIt>
+  std::unique_ptr<db_query_insert_setup> InitInsertSetup(ForwardIt first,
+                                                         ForwardIt last) const;
   /**
    * \brief Заполнить контейнер out_vec данными select структуры src
    * \param src Указатель на структуру результатов SELECT команды
@@ -208,10 +246,31 @@ class IDBTables {
   template <class TableI>
   std::shared_ptr<DBWhereClause<where_node_data>> InitInsertTree(
       const TableI& where) const {
-    auto is = InitInsertSetup<TableI>({where});
+    auto is = InitInsertSetup<TableI>(&where, &where + 1);
     return (is.get() != nullptr) ? is->InitInsertTree() : nullptr;
   }
 
+  /**
+   * \brief Разбить строковое представление массива данных
+   * \param str Ссылка на строковое представление
+   * \param cont Указатель на контейнер выходных данных
+   * \param str2type Функциональный объект конвертации строкового
+   *   представления значения к значению оригинального типа.
+   *   На вход принимает ссылку на строку, выдаёт обект требуемого
+   *   типа.
+   *
+   * \return Код(статус) результата выполнения
+   *
+   * \note Сделал ориентированно на Postgre, не знаю унифицирован
+   *   ли формат возврата массива в SQL
+   * */
+  template <class Container>
+  static mstatus_t string2Container(
+      const std::string& str,
+      Container* cont,
+      std::function<typename Container::value_type(const std::string&)>
+          str2type = [](const std::string& s) { return s; });
+
  protected:
   /**
    * \brief Шаблонная функция сбора сетапа добавления по структуре таблицы БД
@@ -225,6 +284,17 @@ class IDBTables {
   void setInsertValues(db_query_insert_setup* src, const T& select_data) const {
     assert(0 && "not implemented function");
   }
+  /**
+   * \brief Собрать сетап добавления, перемещая данные структуры
+   *
+   * По умолчанию копирует данные через setInsertValues, специализации
+   *   могут перемещать строки полей,
+   *   см. db_table_descriptor::MoveInsertValues
+   * */
+  template <class T>
+  void moveInsertValues(db_query_insert_setup* src, T& insert_data) const {
+    setInsertValues<T>(src, insert_data);
+  }
   /**
    * \brief Инициализировать сетап добавления в БД
    * \param t Идентификатор таблицы
@@ -238,26 +308,6 @@ class IDBTables {
       Table t,
       db_query_insert_setup* src,
       const std::vector<DataInfo>& insert_data);
-  /**
-   * \brief Разбить строковое представление массива данных
-   * \param str Ссылка на строковое представление
-   * \param cont Указатель на контейнер выходных данных
-   * \param str2type Функциональный объект конвертации строкового
-   *   представления значения к значению оригинального типа.
-   *   На вход принимает ссылку на строку, выдаёт обект требуемого
-   *   типа.
-   *
-   * \return Код(статус) результата выполнения
-   *
-   * \note Сделал ориентированно на Postgre, не знаю унифицирован
-   *   ли формат возврата массива в SQL
-   * */
-  template <class Container>
-  mstatus_t string2Container(
-      const std::string& str,
-      Container* cont,
-      std::function<typename Container::value_type(const std::string&)>
-          str2type = [](const std::string& s) { return s; }) const;
 };
 
 /* templates */
@@ -276,6 +326,13 @@ template <db_table table>
 const db_variable& IDBTables::GetFieldById(db_variable_id id) {
   const db_fields_collection* fc = GetFieldsCollection(table);
   if (fc) {
+    if (const db_fields_index* index = GetFieldsIndex(table)) {
+      size_t i = index->IndexOf(id);
+      if (i < fc->size())
+        return (*fc)[i];
+      throw idbtables_exception<table>(
+          this, id, "IDBTables не найдено поле с id " + std::to_string(id));
+    }
     const auto field = std::find_if(
         fc->begin(), fc->end(), [id](const auto& it) { return it.fid == id;
         });
@@ -292,14 +349,37 @@ const db_variable& IDBTables::GetFieldById(db_variable_id id) {
 template <class TableI>
 std::unique_ptr<db_query_insert_setup> IDBTables::InitInsertSetup(
     const std::vector<TableI>& insert_data) const {
-  if (db_query_insert_setup::haveConflict(insert_data))
+  return InitInsertSetup<TableI>(insert_data.begin(), insert_data.end());
+}
+
+template <class TableI>
+std::unique_ptr<db_query_insert_setup> IDBTables::InitInsertSetup(
+    std::vector<TableI>&& insert_data) const {
+  return InitInsertSetup<TableI>(std::make_move_iterator(insert_data.begin()),
+                                 std::make_move_iterator(insert_data.end()));
+}
+
+template <class TableI, class ForwardIt>
+std::unique_ptr<db_query_insert_setup> IDBTables::InitInsertSetup(
+    ForwardIt first,
+    ForwardIt last) const {
+  if (db_query_insert_setup::haveConflict(first, last))
     return nullptr;
   db_table table = GetTableCode<TableI>();
   std::unique_ptr<db_query_insert_setup> ins_setup(
       new db_query_insert_setup(table, *GetFieldsCollection(table)));
-  if (ins_setup)
-    for (auto& x : insert_data)
-      setInsertValues<TableI>(ins_setup.get(), x);
+  if (ins_setup) {
+    ins_setup->fields_index = GetFieldsIndex(table);
+    ins_setup->batch.Reserve(std::distance(first, last));
+    for (; first != last; ++first) {
+      if constexpr (std::is_rvalue_reference<decltype(*first)>::value) {
+        TableI&& x = *first;
+        moveInsertValues<TableI>(ins_setup.get(), x);
+      } else {
+        setInsertValues<TableI>(ins_setup.get(), *first);
+      }
+    }
+  }
   return ins_setup;
 }
 
@@ -322,13 +402,14 @@ template <class Container>
 mstatus_t IDBTables::string2Container(
     const std::string& str,
     Container* cont,
-    std::function<typename Container::value_type(const std::string&)> str2type)
-    const {
+    std::function<typename Container::value_type(const std::string&)>
+        str2type) {
   std::string estr = str;
   estr.erase(std::remove(estr.begin(), estr.end(), '{'), estr.end());
   estr.erase(std::remove(estr.begin(), estr.end(), '}'), estr.end());
   mstatus_t st = STATUS_DEFAULT;
-  if (!std::is_same<std::string, typename Container::value_type>::value) {
+  if constexpr (!std::is_same<std::string,
+                               typename Container::value_type>::value) {
     // тип значений контейнера не строковый, нужна конвертация
     std::vector<std::string> tmp;
     split_str(estr, &tmp, ',');
@@ -0,0 +1,134 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_TRACE_H_
+#define _DATABASE__DB_TRACE_H_
+
+#include "asp_db/db_defines.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace asp_db {
+/**
+ * \brief Категория интервала трассировки
+ * */
+enum class db_trace_category : uint32_t {
+  /** \brief Операция DBConnectionManager */
+  manager = 0,
+  /** \brief DBQuery::Execute */
+  query,
+  /** \brief DBQuery::unExecute при откате транзакции */
+  rollback,
+  count
+};
+const char* db_trace_category_to_string(db_trace_category category);
+
+/**
+ * \brief Интервал трассировки
+ * */
+struct db_trace_event {
+  /** \brief Максимальная длина имени, длинные имена обрезаются */
+  static constexpr size_t name_size = 31;
+
+  std::string name;
+  db_trace_category category = db_trace_category::manager;
+  /** \brief Начало интервала от включения трассировки, нс */
+  uint64_t start_ns = 0;
+  uint64_t duration_ns = 0;
+  /** \brief Номер потока, в порядке первой записи */
+  uint32_t tid = 0;
+};
+
+/**
+ * \brief Трассировка выполнения транзакций в формате Chrome trace event
+ *
+ * Интервалы пишутся в кольцевой буфер своего потока без блокировок:
+ *   каждая ячейка защищена счётчиком версии(seqlock), поэтому снятие
+ *   событий из другого потока не останавливает запись, а ячейку,
+ *   перезаписанную во время чтения, пропускает. При переполнении
+ *   буфера теряются самые старые интервалы потока. Буфер
+ *   завершившегося потока после Collect или Reset переходит к
+ *   следующему новому потоку, поэтому количество буферов ограничено
+ *   числом потоков, трассируемых между снятиями.
+ *
+ * Transaction пишет интервалы DBQuery::Execute и unExecute,
+ *   DBConnectionManager - интервалы транзакции, клонирования
+ *   подключения и разбора результата выборки. Результат открывается
+ *   в chrome://tracing или Perfetto.
+ *
+ * По умолчанию трассировка отключена, Span тогда не обращается к часам.
+ * */
+class DBTrace {
+ public:
+  /**
+   * \brief Интервал от создания объекта до Finish или удаления
+   * */
+  class Span {
+   public:
+    Span(db_trace_category category, const char* name);
+    Span(db_trace_category category, const std::string& name);
+    ~Span();
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    void Finish();
+
+   private:
+    std::chrono::steady_clock::time_point start_;
+    db_trace_category category_;
+    char name_[db_trace_event::name_size + 1];
+    bool active_;
+  };
+
+ public:
+  /**
+   * \brief Включить или отключить трассировку, при включении
+   *   отсчёт времени событий начинается заново
+   * */
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled();
+  /**
+   * \brief Записать интервал в буфер текущего потока
+   * */
+  static void Record(db_trace_category category,
+                     const char* name,
+                     std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point finish);
+  /**
+   * \brief Снять интервалы всех потоков, упорядоченные по началу
+   * */
+  static std::vector<db_trace_event> Collect();
+  /**
+   * \brief Интервалы всех потоков в формате JSON Chrome trace event
+   * */
+  static std::string ToChromeJson();
+  /**
+   * \brief Записать ToChromeJson в файл `path`
+   * */
+  static mstatus_t WriteChromeJson(const std::string& path);
+  /**
+   * \brief Отбросить записанные интервалы
+   * */
+  static void Reset();
+  /**
+   * \brief Количество выделенных кольцевых буферов потоков
+   * */
+  static size_t RingsCount();
+
+ public:
+  /** \brief Ёмкость кольцевого буфера потока */
+  static constexpr size_t ring_capacity = 4096;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_TRACE_H_
@@ -157,17 +157,14 @@ class WhereTreeConstructor {
     return node_bind(field_id, val, wns::node_lt);
   }
   /**
-   * \brief Шаблон функции собирающей узлы `Like` операций для where
+   * \brief Функция собирающая узлы `Like` операций для where
    *   условий.
    *
-   * \tparam Tval Тип данных
-   *
    * \param field_id Идентификатор обновляемого поля
    * \param val Значение
    *
    * \note Функция должна быть доступна только для символьных полей и значений
    * */
-  template <class Tval>
   wns::node_ptr Like(db_variable_id field_id,
                      const char* val,
                      bool inverse = false) const;
@@ -287,7 +284,6 @@ class WhereTreeConstructor {
 
 /* templates */
 template <db_table table>
-template <class Tval>
 wns::node_ptr WhereTreeConstructor<table>::Like(db_variable_id field_id,
                                                 const char* val,
                                                 bool inverse) const {
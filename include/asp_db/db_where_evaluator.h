@@ -0,0 +1,238 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_where_evaluator *
+ *   Вычисление деревьев where условий на стороне клиента
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_WHERE_EVALUATOR_H_
+#define _DATABASE__DB_WHERE_EVALUATOR_H_
+
+#include "asp_db/db_defines.h"
+#include "asp_db/db_expression.h"
+#include "asp_db/db_queries_setup.h"
+
+#include "asp_utils/Base.h"
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asp_db {
+/**
+ * \brief Результат вычисления условия в тернарной логике SQL
+ * */
+enum class db_tribool {
+  tb_false = 0,
+  tb_true = 1,
+  /// сравнение с NULL
+  tb_unknown = 2
+};
+
+/**
+ * \brief Предикат, скомпилированный из дерева where условий
+ *
+ * При компиляции имена полей разрешаются в индексы коллекции полей
+ *   таблицы, значения условий разбираются по типам полей, так что при
+ *   вычислении для строки разбираются только значения самой строки.
+ *   Поддерживаются операторы eq, ne, lt, le, gt, ge, like, between, is
+ *   и логические and/or, сравнение с отсутствующим значением(NULL)
+ *   даёт tb_unknown.
+ *
+ * Предикат применим к строкам результатов выборки(row_values), к
+ *   строкам TableI через функцию приведения к row_values, и к любым
+ *   другим хранилищам через функтор доступа к значению по индексу
+ *   поля(EvaluateWith).
+ *
+ * \note Узлы `raw` вычислить нельзя, для деревьев с ними компиляция
+ *   завершается ошибкой
+ * */
+class DBWhereEvaluator : public BaseObject {
+ public:
+  typedef db_query_basesetup::field_index field_index;
+  typedef db_query_basesetup::row_values row_values;
+
+ public:
+  /**
+   * \brief Скомпилировать дерево условий
+   * \param fields Коллекция полей таблицы, ссылка не сохраняется
+   * \param clause Дерево условий, nullptr - условие выполняется
+   *   для всех строк
+   * */
+  DBWhereEvaluator(
+      const db_fields_collection& fields,
+      const std::shared_ptr<DBWhereClause<where_node_data>>& clause);
+
+  /**
+   * \brief Дерево условий скомпилировано
+   * */
+  bool IsValid() const { return is_status_ok(status_); }
+
+  /**
+   * \brief Вычислить условие для строки
+   * */
+  db_tribool Evaluate(const row_values& row) const {
+    return EvaluateWith([&row](field_index i) -> const std::string* {
+      auto it = row.find(i);
+      return (it != row.end()) ? &it->second : nullptr;
+    });
+  }
+  /**
+   * \brief Вычислить условие с функтором доступа к значениям
+   * \param get Функтор `const std::string *(field_index)`, возвращает
+   *   указатель на строковое значение поля или nullptr для NULL
+   * */
+  template <class GetF>
+  db_tribool EvaluateWith(const GetF& get) const {
+    if (!IsValid())
+      return db_tribool::tb_unknown;
+    return (nodes_.empty()) ? db_tribool::tb_true : eval(0, get);
+  }
+  /**
+   * \brief Строка удовлетворяет условию
+   * */
+  bool operator()(const row_values& row) const {
+    return Evaluate(row) == db_tribool::tb_true;
+  }
+
+  /**
+   * \brief Отфильтровать строки, удовлетворяющие условию
+   * */
+  std::vector<row_values> Filter(const std::vector<row_values>& rows) const;
+  /**
+   * \brief Отфильтровать строки TableI, удовлетворяющие условию
+   * \param rows Вектор строк
+   * \param to_row Функция приведения TableI к row_values
+   *
+   * \note Строки приводятся к строковым значениям намеренно: IDBTables
+   *   описывает поля TableI только через setInsertValues/SetSelectData,
+   *   а типизированного доступа к полю по индексу нет. Без лишних
+   *   копий - EvaluateWith с функтором над своим хранилищем
+   * */
+  template <class TableI, class ToRowF>
+  std::vector<TableI> Filter(const std::vector<TableI>& rows,
+                             ToRowF to_row) const {
+    std::vector<TableI> result;
+    for (const auto& row : rows)
+      if (Evaluate(to_row(row)) == db_tribool::tb_true)
+        result.push_back(row);
+    return result;
+  }
+
+ public:
+  /**
+   * \brief Сравнить по шаблону SQL LIKE: `%` - любая подстрока,
+   *   `_` - любой символ
+   * */
+  static bool LikeMatch(const std::string& str, const std::string& pattern);
+
+ private:
+  /**
+   * \brief Категория сравнения значений поля
+   * */
+  enum class value_kind {
+    vk_integer = 0,
+    vk_real,
+    vk_bool,
+    /// даты - лексикографически, разделители '/' и '-' равнозначны
+    vk_date,
+    /// строки и время - лексикографически
+    vk_text
+  };
+  /**
+   * \brief Разобранное значение условия
+   * */
+  struct compiled_value {
+    int64_t i = 0;
+    double d = 0.0;
+    std::string s;
+  };
+  /**
+   * \brief Узел скомпилированного дерева
+   * */
+  struct compiled_node {
+    db_operator_wrapper op = db_operator_wrapper(db_operator_t::op_empty);
+    /**
+     * \brief Индексы подузлов в `nodes_` для and/or
+     * */
+    int left = -1;
+    int right = -1;
+    /**
+     * \brief Индекс поля для операторов сравнения
+     * */
+    field_index field = 0;
+    value_kind kind = value_kind::vk_text;
+    /**
+     * \brief Значение условия, для between - нижняя граница
+     * */
+    compiled_value lo;
+    /**
+     * \brief Верхняя граница between
+     * */
+    compiled_value hi;
+  };
+
+ private:
+  /**
+   * \brief Скомпилировать поддерево, вернуть индекс узла в `nodes_`
+   * \param fields Коллекция полей таблицы, нужна только при компиляции
+   * */
+  int compile(const db_fields_collection& fields,
+              const expression_node<where_node_data>* node);
+  /**
+   * \brief Разобрать значение условия
+   * */
+  static compiled_value parseValue(value_kind kind, const std::string& str);
+  /**
+   * \brief Код ошибки разбора значения строки при сравнении
+   * */
+  static constexpr int compare_failed = 2;
+  /**
+   * \brief Сравнить значение строки с разобранным значением
+   * \return -1, 0, 1 или compare_failed, если значение строки
+   *   не разбирается
+   * */
+  static int compare(value_kind kind,
+                     const std::string& value,
+                     const compiled_value& cv);
+  /**
+   * \brief Вычислить оператор сравнения для значения поля
+   * */
+  db_tribool evalLeaf(const compiled_node& node,
+                      const std::string* value) const;
+
+  template <class GetF>
+  db_tribool eval(int i, const GetF& get) const {
+    const compiled_node& node = nodes_[i];
+    if (node.op.op == db_operator_t::op_and) {
+      db_tribool l = eval(node.left, get);
+      if (l == db_tribool::tb_false)
+        return l;
+      db_tribool r = eval(node.right, get);
+      return (r == db_tribool::tb_true) ? l : r;
+    } else if (node.op.op == db_operator_t::op_or) {
+      db_tribool l = eval(node.left, get);
+      if (l == db_tribool::tb_true)
+        return l;
+      db_tribool r = eval(node.right, get);
+      return (r == db_tribool::tb_false) ? l : r;
+    }
+    return evalLeaf(node, get(node.field));
+  }
+
+ private:
+  /**
+   * \brief Узлы скомпилированного дерева, корень - первый элемент
+   * */
+  std::vector<compiled_node> nodes_;
+};
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_WHERE_EVALUATOR_H_
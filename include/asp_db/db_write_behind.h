@@ -0,0 +1,339 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ * ===================================================================
+ * * db_write_behind *
+ *   Отложенное добавление строк: очередь строк таблиц и фоновая
+ *   запись пакетами
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef _DATABASE__DB_WRITE_BEHIND_H_
+#define _DATABASE__DB_WRITE_BEHIND_H_
+
+#include "asp_db/db_defines.h"
+#include "asp_db/db_queries_setup.h"
+#include "asp_db/db_tables.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace asp_db {
+/**
+ * \brief Результат записи пакета строк
+ * */
+struct db_write_behind_batch {
+  db_table table = UNDEFINED_TABLE;
+  /** \brief Количество строк пакета */
+  size_t rows = 0;
+  mstatus_t status = STATUS_DEFAULT;
+  /** \brief id добавленных строк */
+  std::vector<int> ids;
+};
+/**
+ * \brief Обработчик записанного пакета, вызывается из потока записи
+ * */
+typedef std::function<void(const db_write_behind_batch&)>
+    db_write_behind_callback;
+
+/**
+ * \brief Параметры отложенного добавления строк
+ * */
+struct db_write_behind_parameters {
+  /**
+   * \brief Максимум строк в одном пакете, набранный пакет
+   *   записывается не дожидаясь периода записи
+   * */
+  size_t batch_rows = 512;
+  /**
+   * \brief Период записи неполных пакетов
+   * */
+  std::chrono::milliseconds flush_interval{100};
+  /**
+   * \brief Ограничение строк в очередях и в записываемых пакетах,
+   *   при переполнении добавляющий поток ждёт записи пакета
+   * */
+  size_t max_pending = 64 * 1024;
+  /**
+   * \brief Обработчик записанных пакетов, в том числе ошибок
+   * */
+  db_write_behind_callback on_batch = nullptr;
+};
+
+/**
+ * \brief Отложенное добавление строк
+ *
+ * Для каждой таблицы своя очередь строк без блокировок(MPSC список
+ *   Вьюкова). Фоновый поток забирает строки пакетами до `batch_rows`
+ *   и добавляет пакет функцией очереди(SaveVectorOfRows менеджера)
+ *   при наборе пакета или раз в `flush_interval`. Результат пакета
+ *   передаётся обработчику `on_batch`, ошибки пакетов логируются.
+ *
+ * Строки одного потока добавляются в порядке постановки в очередь.
+ *   При удалении объекта оставшиеся строки записываются
+ * */
+class DBWriteBehind {
+ public:
+  explicit DBWriteBehind(const db_write_behind_parameters& parameters);
+  ~DBWriteBehind();
+  DBWriteBehind(const DBWriteBehind&) = delete;
+  DBWriteBehind& operator=(const DBWriteBehind&) = delete;
+
+  /**
+   * \brief Поставить строку `row` таблицы `table` в очередь
+   * \param commit Функция добавления строк
+   *   `mstatus_t(std::vector<TableI>&& rows, id_container* ids)`,
+   *   запоминается при создании очереди таблицы
+   * */
+  template <class TableI, class CommitF>
+  void Enqueue(db_table table, TableI&& row, CommitF commit);
+  /**
+   * \brief Дождаться записи всех строк, поставленных в очередь
+   *   до вызова
+   *
+   * В каждую очередь добавляется метка, поток записи отмечает её
+   *   после записи всех строк очереди перед ней. Строки, добавленные
+   *   другими потоками после вызова, ожидание не продлевают
+   *   и не сокращают
+   * */
+  void Flush();
+
+  /**
+   * \brief Строк поставлено в очередь
+   * */
+  uint64_t Enqueued() const;
+  /**
+   * \brief Строк обработано, в том числе с ошибкой
+   * */
+  uint64_t Completed() const;
+  /**
+   * \brief Строк в пакетах, завершившихся ошибкой
+   * */
+  uint64_t Failed() const;
+  /**
+   * \brief Количество записанных пакетов
+   * */
+  uint64_t Batches() const;
+  /**
+   * \brief Параметры отложенного добавления
+   * */
+  const db_write_behind_parameters& GetParameters() const {
+    return parameters_;
+  }
+
+ private:
+  /**
+   * \brief Метка Flush: число очередей, ещё не дошедших до метки
+   * */
+  struct flush_barrier {
+    std::atomic<size_t> remaining{0};
+  };
+  /**
+   * \brief Очередь строк таблицы
+   * */
+  struct table_queue {
+    explicit table_queue(db_table table) : table(table) {}
+    virtual ~table_queue() = default;
+    /**
+     * \brief Забрать до `max_rows` строк и добавить их в БД,
+     *   вызывается только потоком записи. Строки пакета не
+     *   переходят через метку Flush, метка в начале очереди
+     *   снимается без записи строк(batch->rows == 0)
+     * \return false если очередь пуста
+     * */
+    virtual bool flush(size_t max_rows, db_write_behind_batch* batch) = 0;
+    /**
+     * \brief Добавить в очередь метку Flush
+     * */
+    virtual void pushBarrier(std::shared_ptr<flush_barrier> barrier) = 0;
+
+    const db_table table;
+    /** \brief Строк в очереди */
+    std::atomic<size_t> size{0};
+  };
+  template <class TableI>
+  class typed_queue;
+  /**
+   * \brief Неизменяемый список очередей, публикуется целиком при
+   *   добавлении очереди
+   * */
+  struct queue_list {
+    std::vector<table_queue*> queues;
+  };
+
+ private:
+  /**
+   * \brief Найти очередь таблицы без блокировки
+   * */
+  table_queue* findQueue(db_table table) const;
+  /**
+   * \brief Добавить очередь, если её ещё нет
+   * \return Очередь таблицы `queue->table`
+   * */
+  table_queue* addQueue(std::unique_ptr<table_queue> queue);
+  /**
+   * \brief Занять место под строку, при переполнении ждать записи
+   *   пакета
+   * */
+  void reserve();
+  /**
+   * \brief Учесть добавленную в очередь `queue` строку, разбудить
+   *   поток записи при наборе пакета
+   * */
+  void pushed(table_queue* queue);
+  void run();
+  /**
+   * \brief Записать все строки очередей пакетами
+   * */
+  void flushQueues();
+
+ private:
+  const db_write_behind_parameters parameters_;
+  std::atomic<const queue_list*> queues_;
+  /** \brief Очереди и все опубликованные списки, под `queues_lock_` */
+  std::mutex queues_lock_;
+  std::vector<std::unique_ptr<table_queue>> owned_queues_;
+  std::vector<std::unique_ptr<queue_list>> lists_;
+
+  /** \brief Строк в очередях и в записываемом пакете */
+  std::atomic<size_t> pending_{0};
+  std::atomic<uint64_t> enqueued_{0};
+  std::atomic<uint64_t> completed_{0};
+  std::atomic<uint64_t> failed_{0};
+  std::atomic<uint64_t> batches_{0};
+  std::atomic<bool> flush_requested_{false};
+  std::atomic<bool> stop_{false};
+
+  std::mutex lock_;
+  /** \brief Пробуждение потока записи */
+  std::condition_variable wake_cv_;
+  /** \brief Ожидание записи: Flush и переполнение очередей */
+  std::condition_variable done_cv_;
+  std::thread worker_;
+};
+
+/**
+ * \brief Очередь строк структуры TableI
+ * */
+template <class TableI>
+class DBWriteBehind::typed_queue : public DBWriteBehind::table_queue {
+ public:
+  typedef std::function<mstatus_t(std::vector<TableI>&&, id_container*)>
+      commit_function;
+
+ public:
+  typed_queue(db_table table, commit_function commit)
+      : table_queue(table),
+        commit_(std::move(commit)),
+        head_(new node),
+        tail_(head_.load(std::memory_order_relaxed)) {}
+  ~typed_queue() override {
+    node* n = tail_;
+    while (n) {
+      node* next = n->next.load(std::memory_order_relaxed);
+      delete n;
+      n = next;
+    }
+  }
+
+  void Push(TableI&& row) {
+    node* n = new node;
+    n->row.emplace(std::move(row));
+    push(n);
+  }
+
+  void pushBarrier(std::shared_ptr<flush_barrier> barrier) override {
+    node* n = new node;
+    n->barrier = std::move(barrier);
+    push(n);
+  }
+
+  bool flush(size_t max_rows, db_write_behind_batch* batch) override {
+    std::vector<TableI> rows;
+    node* next = tail_->next.load(std::memory_order_acquire);
+    if (next && next->barrier) {
+      // все строки перед меткой уже записаны
+      next->barrier->remaining.fetch_sub(1, std::memory_order_acq_rel);
+      pop(next);
+      batch->table = table;
+      batch->rows = 0;
+      return true;
+    }
+    while (next && !next->barrier && rows.size() < max_rows) {
+      rows.push_back(std::move(*next->row));
+      pop(next);
+      next = tail_->next.load(std::memory_order_acquire);
+    }
+    if (rows.empty())
+      return false;
+    size.fetch_sub(rows.size(), std::memory_order_relaxed);
+    id_container ids;
+    batch->table = table;
+    batch->rows = rows.size();
+    batch->status = commit_(std::move(rows), &ids);
+    batch->ids = std::move(ids.id_vec);
+    return true;
+  }
+
+ private:
+  struct node {
+    std::atomic<node*> next{nullptr};
+    std::optional<TableI> row;
+    /** \brief Метка Flush вместо строки */
+    std::shared_ptr<flush_barrier> barrier;
+  };
+
+ private:
+  void push(node* n) {
+    node* prev = head_.exchange(n, std::memory_order_acq_rel);
+    prev->next.store(n, std::memory_order_release);
+  }
+  /**
+   * \brief Забранный узел `next` становится заглушкой, его строка
+   *   и метка больше не нужны
+   * */
+  void pop(node* next) {
+    next->row.reset();
+    next->barrier.reset();
+    delete tail_;
+    tail_ = next;
+  }
+
+ private:
+  commit_function commit_;
+  /** \brief Последний добавленный узел, в него пишут продюсеры */
+  std::atomic<node*> head_;
+  /** \brief Заглушка перед первым незабранным узлом */
+  node* tail_;
+};
+
+template <class TableI, class CommitF>
+void DBWriteBehind::Enqueue(db_table table, TableI&& row, CommitF commit) {
+  typedef std::decay_t<TableI> table_t;
+  table_queue* queue = findQueue(table);
+  if (!queue)
+    queue = addQueue(std::make_unique<typed_queue<table_t>>(
+        table, typename typed_queue<table_t>::commit_function(
+                   std::move(commit))));
+  reserve();
+  table_t value(std::forward<TableI>(row));
+  // код таблицы однозначно определяет структуру строки
+  static_cast<typed_queue<table_t>*>(queue)->Push(std::move(value));
+  pushed(queue);
+}
+}  // namespace asp_db
+
+#endif  // !_DATABASE__DB_WRITE_BEHIND_H_
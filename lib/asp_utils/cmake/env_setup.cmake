@@ -0,0 +1,5 @@
+function(add_system_defines target)
+  target_compile_definitions(${target} PRIVATE OS_UNIX)
+endfunction()
+function(copy_compile_commands target)
+endfunction()
@@ -0,0 +1,14 @@
+#pragma once
+#include "asp_utils/ErrorWrap.h"
+class BaseObject {
+ public:
+  BaseObject(mstatus_t s) : status_(s) {}
+  virtual ~BaseObject() = default;
+  merror_t GetError() const { return error_.GetErrorCode(); }
+  mstatus_t GetStatus() const { return status_; }
+  void LogError() { error_.LogIt(); }
+  ErrorWrap GetErrorWrap() const { return error_; }
+ protected:
+  ErrorWrap error_;
+  mstatus_t status_;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <vector>
+#include <sstream>
+#define ADD_TEST_CLASS(x) friend class x;
+namespace asp_utils {}
+typedef int32_t mstatus_t;
+typedef uint32_t merror_t;
+#define STATUS_DEFAULT 0x00
+#define STATUS_OK 0x01
+#define STATUS_NOT 0x02
+#define STATUS_HAVE_ERROR 0x03
+#define ERROR_SUCCESS_T 0x0000
+#define ERROR_GENERAL_T 0x0001
+#define ERROR_STR_PARSE_ST 0x0002
+#define ERROR_PAIR_DEFAULT(x) x, x##_MSG
+#define STRING_DEBUG_INFO (std::string(__FILE__) + ":" + std::to_string(__LINE__))
+inline bool is_status_ok(mstatus_t s) { return s == STATUS_OK; }
+inline bool is_status_aval(mstatus_t s) { return s == STATUS_OK || s == STATUS_DEFAULT; }
+inline std::string trim_str(const std::string& s) {
+  size_t b = s.find_first_not_of(" \t\n\r"); if (b == std::string::npos) return "";
+  size_t e = s.find_last_not_of(" \t\n\r"); return s.substr(b, e - b + 1);
+}
+template <class C>
+inline void split_str(const std::string& s, C* out, char d) {
+  std::stringstream ss(s); std::string t; while (std::getline(ss, t, d)) out->push_back(trim_str(t));
+}
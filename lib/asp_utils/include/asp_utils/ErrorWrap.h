@@ -0,0 +1,15 @@
+#pragma once
+#include "asp_utils/Common.h"
+#include "asp_utils/Logging.h"
+class ErrorWrap {
+ public:
+  ErrorWrap() = default;
+  ErrorWrap(merror_t e, const std::string& m = "") : e_(e), m_(m) {}
+  merror_t SetError(merror_t e, const std::string& m = "") { e_ = e; m_ = m; return e_; }
+  merror_t GetErrorCode() const { return e_; }
+  std::string GetMessage() const { return m_; }
+  void Reset() { e_ = 0; m_.clear(); }
+  merror_t LogIt(io_loglvl = io_loglvl::err_logs);
+ private:
+  merror_t e_ = 0; std::string m_;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include "asp_utils/Common.h"
+#include <string>
+enum class io_loglvl { no_log = 0, err_logs, warn_logs, info_logs, debug_logs };
+#define DEFAULT_MAXLEN_LOGFILE 1024
+#define DEFAULT_FLUSH_RATE 10
+struct logging_cfg {
+  logging_cfg(const std::string& n, io_loglvl l, const std::string& f, size_t m, size_t fr, bool o)
+      : name(n), lvl(l), file(f), maxlen(m), flush(fr), online(o) {}
+  std::string name; io_loglvl lvl; std::string file; size_t maxlen, flush; bool online;
+};
+class Logging {
+ public:
+  static mstatus_t InitDefault();
+  static void Append(io_loglvl, const std::string&);
+  static void Append(const std::string&);
+  static void Append(merror_t, const std::string&);
+};
+class PrivateLogging {
+ public:
+  bool IsRegistered(const logging_cfg&) const;
+  mstatus_t Register(const logging_cfg&);
+  void Append(io_loglvl, const std::string& logger, const std::string& msg);
+};
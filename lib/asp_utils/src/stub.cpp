@@ -0,0 +1,10 @@
+#include "asp_utils/Base.h"
+#include <cstdio>
+mstatus_t Logging::InitDefault() { return STATUS_OK; }
+void Logging::Append(io_loglvl, const std::string&) {}
+void Logging::Append(const std::string&) {}
+bool PrivateLogging::IsRegistered(const logging_cfg&) const { return true; }
+mstatus_t PrivateLogging::Register(const logging_cfg&) { return STATUS_OK; }
+void PrivateLogging::Append(io_loglvl, const std::string&, const std::string&) {}
+merror_t ErrorWrap::LogIt(io_loglvl) { return e_; }
+void Logging::Append(merror_t, const std::string&) {}
@@ -0,0 +1,78 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_change_listener.h"
+
+#include "asp_utils/Logging.h"
+
+namespace asp_db {
+std::string db_change_channel(const std::string& table_name) {
+  return "asp_db_" + table_name;
+}
+
+DBChangeListener::DBChangeListener(const IDBTables* tables)
+    : BaseObject(STATUS_DEFAULT), tables_(tables) {}
+
+size_t DBChangeListener::Subscribe(db_table table,
+                                   db_change_callback callback) {
+  std::lock_guard<std::mutex> lock(subscribers_lock_);
+  size_t id = next_id_++;
+  auto s = std::make_shared<subscription>();
+  s->table = table;
+  s->callback = std::move(callback);
+  subscribers_.emplace(id, std::move(s));
+  return id;
+}
+
+void DBChangeListener::Unsubscribe(size_t id) {
+  std::unique_lock<std::mutex> lock(subscribers_lock_);
+  auto it = subscribers_.find(id);
+  if (it == subscribers_.end())
+    return;
+  std::shared_ptr<subscription> s = std::move(it->second);
+  subscribers_.erase(it);
+  s->removed = true;
+  // из обработчика ждать нельзя: он сам исполняемый вызов
+  if (dispatch_thread_ == std::this_thread::get_id())
+    return;
+  subscribers_cv_.wait(lock, [&s]() { return s->in_flight == 0; });
+}
+
+void DBChangeListener::dispatch(const db_table_change& change) {
+  // обработчики вызываются вне захваченного мьютекса, чтобы
+  //   подписчик мог отписаться из обработчика
+  std::vector<std::shared_ptr<subscription>> matched;
+  {
+    std::lock_guard<std::mutex> lock(subscribers_lock_);
+    dispatch_thread_ = std::this_thread::get_id();
+    for (const auto& s : subscribers_)
+      if (s.second->table == change.table)
+        matched.push_back(s.second);
+  }
+  for (auto& s : matched) {
+    {
+      // подписка могла быть отменена предыдущим обработчиком
+      std::lock_guard<std::mutex> lock(subscribers_lock_);
+      if (s->removed)
+        continue;
+      ++s->in_flight;
+    }
+    try {
+      s->callback(change);
+    } catch (const std::exception& e) {
+      Logging::Append(io_loglvl::err_logs,
+                      "Исключение в обработчике изменения таблицы: "
+                          + std::string(e.what()));
+    }
+    std::lock_guard<std::mutex> lock(subscribers_lock_);
+    if (--s->in_flight == 0)
+      subscribers_cv_.notify_all();
+  }
+}
+}  // namespace asp_db
@@ -0,0 +1,77 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_change_listener_memory.h"
+
+#include <set>
+
+namespace asp_db {
+DBChangeListenerMemory::DBChangeListenerMemory(
+    const IDBTables* tables,
+    const db_parameters& parameters)
+    : DBChangeListener(tables),
+      connection_(new DBConnectionMemory(tables, parameters)) {}
+
+DBChangeListenerMemory::~DBChangeListenerMemory() {
+  Stop();
+}
+
+mstatus_t DBChangeListenerMemory::Start(const std::vector<db_table>& tables) {
+  Stop();
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    running_ = true;
+  }
+  thread_ = std::thread(&DBChangeListenerMemory::listenLoop, this);
+  std::set<db_table> listened(tables.begin(), tables.end());
+  // наблюдатель вызывается в потоке фиксирующего подключения, поэтому
+  //   только ставит изменение в очередь
+  watcher_id_ = connection_->AddChangeWatcher(
+      [this, listened](const db_table_change& change) {
+        if (listened.count(change.table) == 0)
+          return;
+        std::lock_guard<std::mutex> lock(lock_);
+        queue_.push_back(change);
+        cv_.notify_one();
+      });
+  listen_status_ = STATUS_OK;
+  return status_ = STATUS_OK;
+}
+
+void DBChangeListenerMemory::Stop() {
+  if (watcher_id_) {
+    connection_->RemoveChangeWatcher(watcher_id_);
+    watcher_id_ = 0;
+  }
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    running_ = false;
+    queue_.clear();
+  }
+  cv_.notify_one();
+  if (thread_.joinable())
+    thread_.join();
+  listen_status_ = STATUS_DEFAULT;
+}
+
+void DBChangeListenerMemory::listenLoop() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    cv_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+    if (!running_)
+      break;
+    db_table_change change = std::move(queue_.front());
+    queue_.pop_front();
+    // обработчики вызываются без блокировки очереди
+    lock.unlock();
+    dispatch(change);
+    lock.lock();
+  }
+}
+}  // namespace asp_db
@@ -0,0 +1,168 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_change_listener_postgre.h"
+
+#include "asp_db/db_connection_postgre.h"
+#include "asp_db/db_tables.h"
+
+#include "asp_utils/Logging.h"
+
+#include <algorithm>
+
+namespace asp_db {
+/**
+ * \brief Интервал опроса флага остановки потока слушателя, мкс
+ * */
+static constexpr long listen_poll_usec = 200000;
+/**
+ * \brief Задержки переподключения слушателя: начальная и предельная
+ * */
+static constexpr std::chrono::milliseconds reconnect_delay_min{100};
+static constexpr std::chrono::milliseconds reconnect_delay_max{10000};
+
+DBChangeListenerPostgre::table_receiver::table_receiver(
+    DBChangeListenerPostgre* owner,
+    pqxx::connection& connection,
+    db_table table,
+    const std::string& channel)
+    : pqxx::notification_receiver(connection, channel),
+      owner_(owner),
+      table_(table) {}
+
+void DBChangeListenerPostgre::table_receiver::operator()(
+    const std::string& payload,
+    int) {
+  owner_->dispatch(db_table_change{table_, payload});
+}
+
+DBChangeListenerPostgre::DBChangeListenerPostgre(
+    const IDBTables* tables,
+    const db_parameters& parameters)
+    : DBChangeListener(tables), parameters_(parameters) {}
+
+DBChangeListenerPostgre::~DBChangeListenerPostgre() {
+  Stop();
+}
+
+mstatus_t DBChangeListenerPostgre::Start(const std::vector<db_table>& tables) {
+  Stop();
+  if (parameters_.is_dry_run) {
+    error_.SetError(ERROR_DB_CONNECTION,
+                    "Прослушивание уведомлений недоступно в режиме dry_run");
+    return status_ = STATUS_HAVE_ERROR;
+  }
+  tables_list_ = tables;
+  std::string error;
+  if (!connect(true, &error)) {
+    error_.SetError(ERROR_DB_CONNECTION,
+                    "Подключение слушателя уведомлений БД: exception: "
+                        + error);
+    listen_status_ = STATUS_HAVE_ERROR;
+    return status_ = STATUS_HAVE_ERROR;
+  }
+  listen_status_ = STATUS_OK;
+  running_ = true;
+  thread_ = std::thread(&DBChangeListenerPostgre::listenLoop, this);
+  return status_ = STATUS_OK;
+}
+
+void DBChangeListenerPostgre::Stop() {
+  running_ = false;
+  if (thread_.joinable())
+    thread_.join();
+  disconnect();
+}
+
+bool DBChangeListenerPostgre::connect(bool install_triggers,
+                                      std::string* error) {
+  try {
+    connection_ = std::make_unique<pqxx::connection>(
+        DBConnectionPostgre::ConnectionString(parameters_));
+    if (install_triggers) {
+      // триггеры таблиц, созданных до запуска слушателя или без
+      //   флага notify_on_change
+      pqxx::work tr(*connection_);
+      for (const auto table : tables_list_) {
+        std::string name = tables_->GetTableName(table);
+        auto exists =
+            tr.exec("SELECT to_regclass(" + tr.quote(name) + ") IS NOT NULL;");
+        if (!exists.empty() && exists[0][0].as<bool>())
+          tr.exec(DBConnectionPostgre::NotifyTriggerString(name));
+      }
+      tr.commit();
+    }
+    for (const auto table : tables_list_) {
+      receivers_.emplace_back(std::make_unique<table_receiver>(
+          this, *connection_, table,
+          db_change_channel(tables_->GetTableName(table))));
+    }
+  } catch (const std::exception& e) {
+    disconnect();
+    *error = e.what();
+    return false;
+  }
+  return true;
+}
+
+void DBChangeListenerPostgre::disconnect() {
+  receivers_.clear();
+  if (connection_) {
+#if defined(OS_WINDOWS)
+    connection_->close();
+#elif defined(OS_UNIX)
+    connection_->disconnect();
+#endif  // OS_
+    connection_ = nullptr;
+  }
+}
+
+void DBChangeListenerPostgre::sleepFor(std::chrono::milliseconds delay) {
+  const auto step = std::chrono::milliseconds(listen_poll_usec / 1000);
+  auto until = std::chrono::steady_clock::now() + delay;
+  while (running_ && std::chrono::steady_clock::now() < until)
+    std::this_thread::sleep_for(std::min<std::chrono::milliseconds>(
+        step, std::chrono::duration_cast<std::chrono::milliseconds>(
+                  until - std::chrono::steady_clock::now())));
+}
+
+void DBChangeListenerPostgre::listenLoop() {
+  auto delay = reconnect_delay_min;
+  while (running_) {
+    if (!connection_) {
+      std::string error;
+      if (!connect(false, &error)) {
+        Logging::Append(io_loglvl::debug_logs,
+                        "Переподключение слушателя уведомлений БД: " + error);
+        sleepFor(delay);
+        delay = std::min(delay * 2, reconnect_delay_max);
+        continue;
+      }
+      delay = reconnect_delay_min;
+      listen_status_ = STATUS_OK;
+      Logging::Append(io_loglvl::info_logs,
+                      "Слушатель уведомлений БД переподключен");
+      // уведомления за время разрыва потеряны
+      for (const auto table : tables_list_)
+        dispatch(db_table_change{table, "RECONNECT"});
+      continue;
+    }
+    try {
+      // обработчики получателей вызываются внутри await_notification
+      connection_->await_notification(0, listen_poll_usec);
+    } catch (const std::exception& e) {
+      Logging::Append(io_loglvl::err_logs,
+                      "Ошибка ожидания уведомлений БД, переподключение: "
+                          + std::string(e.what()));
+      listen_status_ = STATUS_HAVE_ERROR;
+      disconnect();
+    }
+  }
+}
+}  // namespace asp_db
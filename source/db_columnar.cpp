@@ -0,0 +1,526 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_columnar.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define DB_COLUMNAR_SSE2
+#endif  // __SSE2__ || _M_X64
+
+#if defined(__AVX2__) || defined(DB_COLUMNAR_SSE2)
+#include <immintrin.h>
+#endif  // __AVX2__ || DB_COLUMNAR_SSE2
+
+namespace asp_db {
+namespace {
+bool parse_integer(const std::string& str, int64_t* out) {
+  const char* end = str.data() + str.size();
+  auto res = std::from_chars(str.data(), end, *out);
+  return res.ec == std::errc() && res.ptr == end;
+}
+bool parse_real(const std::string& str, double* out) {
+  if (str.empty())
+    return false;
+  char* end = nullptr;
+  *out = std::strtod(str.c_str(), &end);
+  return end == str.c_str() + str.size();
+}
+inline int bit_count(uint64_t w) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(w);
+#else
+  int count = 0;
+  for (; w; w &= w - 1)
+    ++count;
+  return count;
+#endif  // __GNUC__
+}
+inline int lowest_bit(uint64_t w) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(w);
+#else
+  int i = 0;
+  for (; !(w & 1); w >>= 1)
+    ++i;
+  return i;
+#endif  // __GNUC__
+}
+
+/* Ядра фильтра диапазона [lo, hi]: маска 64 строк, начиная с `p` */
+template <class T>
+inline uint64_t range_tail(const T* p, size_t count, T lo, T hi) {
+  uint64_t mask = 0;
+  for (size_t j = 0; j < count; ++j)
+    mask |= uint64_t(p[j] >= lo && p[j] <= hi) << j;
+  return mask;
+}
+
+inline uint64_t range_block(const int32_t* p, int32_t lo, int32_t hi) {
+#if defined(__AVX2__)
+  const __m256i vlo = _mm256_set1_epi32(lo);
+  const __m256i vhi = _mm256_set1_epi32(hi);
+  uint64_t mask = 0;
+  for (int j = 0; j < 64; j += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j));
+    __m256i miss = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x),
+                                   _mm256_cmpgt_epi32(x, vhi));
+    uint64_t bits = _mm256_movemask_ps(_mm256_castsi256_ps(miss));
+    mask |= (~bits & 0xff) << j;
+  }
+  return mask;
+#elif defined(DB_COLUMNAR_SSE2)
+  const __m128i vlo = _mm_set1_epi32(lo);
+  const __m128i vhi = _mm_set1_epi32(hi);
+  uint64_t mask = 0;
+  for (int j = 0; j < 64; j += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j));
+    __m128i miss =
+        _mm_or_si128(_mm_cmpgt_epi32(vlo, x), _mm_cmpgt_epi32(x, vhi));
+    uint64_t bits = _mm_movemask_ps(_mm_castsi128_ps(miss));
+    mask |= (~bits & 0xf) << j;
+  }
+  return mask;
+#else
+  return range_tail(p, 64, lo, hi);
+#endif  // __AVX2__
+}
+
+inline uint64_t range_block(const int64_t* p, int64_t lo, int64_t hi) {
+#if defined(__AVX2__)
+  const __m256i vlo = _mm256_set1_epi64x(lo);
+  const __m256i vhi = _mm256_set1_epi64x(hi);
+  uint64_t mask = 0;
+  for (int j = 0; j < 64; j += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j));
+    __m256i miss = _mm256_or_si256(_mm256_cmpgt_epi64(vlo, x),
+                                   _mm256_cmpgt_epi64(x, vhi));
+    uint64_t bits = _mm256_movemask_pd(_mm256_castsi256_pd(miss));
+    mask |= (~bits & 0xf) << j;
+  }
+  return mask;
+#else
+  // в SSE2 нет сравнения 64-битных целых
+  return range_tail(p, 64, lo, hi);
+#endif  // __AVX2__
+}
+
+inline uint64_t range_block(const double* p, double lo, double hi) {
+#if defined(__AVX2__)
+  const __m256d vlo = _mm256_set1_pd(lo);
+  const __m256d vhi = _mm256_set1_pd(hi);
+  uint64_t mask = 0;
+  for (int j = 0; j < 64; j += 4) {
+    __m256d x = _mm256_loadu_pd(p + j);
+    __m256d hit = _mm256_and_pd(_mm256_cmp_pd(x, vlo, _CMP_GE_OQ),
+                                _mm256_cmp_pd(x, vhi, _CMP_LE_OQ));
+    mask |= uint64_t(_mm256_movemask_pd(hit)) << j;
+  }
+  return mask;
+#elif defined(DB_COLUMNAR_SSE2)
+  const __m128d vlo = _mm_set1_pd(lo);
+  const __m128d vhi = _mm_set1_pd(hi);
+  uint64_t mask = 0;
+  for (int j = 0; j < 64; j += 2) {
+    __m128d x = _mm_loadu_pd(p + j);
+    __m128d hit = _mm_and_pd(_mm_cmpge_pd(x, vlo), _mm_cmple_pd(x, vhi));
+    mask |= uint64_t(_mm_movemask_pd(hit)) << j;
+  }
+  return mask;
+#else
+  return range_tail(p, 64, lo, hi);
+#endif  // __AVX2__
+}
+
+/**
+ * \brief Заполнить карту выборки значений из диапазона [lo, hi]
+ * */
+template <class T>
+db_selection scan_range(const std::vector<T>& data, T lo, T hi) {
+  db_selection result(data.size());
+  const T* p = data.data();
+  size_t full = data.size() / 64;
+  for (size_t w = 0; w < full; ++w)
+    result.words[w] = range_block(p + w * 64, lo, hi);
+  if (data.size() % 64)
+    result.words[full] = range_tail(p + full * 64, data.size() % 64, lo, hi);
+  return result;
+}
+
+/**
+ * \brief Привести целочисленные границы к типу столбца
+ * \return false если диапазон пуст
+ * */
+template <class T>
+bool clamp_bounds(int64_t lo, int64_t hi, T* tlo, T* thi) {
+  lo = std::max<int64_t>(lo, std::numeric_limits<T>::min());
+  hi = std::min<int64_t>(hi, std::numeric_limits<T>::max());
+  *tlo = static_cast<T>(lo);
+  *thi = static_cast<T>(hi);
+  return lo <= hi;
+}
+
+/**
+ * \brief Границы [lo, hi] оператора сравнения со значением `v`
+ * \return false если диапазон пуст
+ * */
+template <class T>
+bool operator_bounds(db_operator_t op, T v, T* lo, T* hi) {
+  const T min = std::numeric_limits<T>::lowest();
+  const T max = std::numeric_limits<T>::max();
+  *lo = min;
+  *hi = max;
+  switch (op) {
+    case db_operator_t::op_eq:
+    case db_operator_t::op_ne:
+      *lo = *hi = v;
+      break;
+    case db_operator_t::op_lt:
+      if (v == min)
+        return false;
+      if constexpr (std::is_integral<T>::value)
+        *hi = v - 1;
+      else
+        *hi = std::nextafter(v, min);
+      break;
+    case db_operator_t::op_le:
+      *hi = v;
+      break;
+    case db_operator_t::op_gt:
+      if (v == max)
+        return false;
+      if constexpr (std::is_integral<T>::value)
+        *lo = v + 1;
+      else
+        *lo = std::nextafter(v, max);
+      break;
+    case db_operator_t::op_ge:
+      *lo = v;
+      break;
+    default:
+      throw db_variable_exception("Оператор не поддерживается колоночным "
+                                  "фильтром");
+  }
+  return true;
+}
+}  // namespace
+
+/* db_selection */
+db_selection::db_selection(size_t rows, bool value)
+    : words((rows + 63) / 64, value ? ~uint64_t(0) : 0), rows(rows) {
+  clearTail();
+}
+
+size_t db_selection::Count() const {
+  size_t count = 0;
+  for (auto w : words)
+    count += bit_count(w);
+  return count;
+}
+
+std::vector<size_t> db_selection::Indexes() const {
+  std::vector<size_t> result;
+  result.reserve(Count());
+  for (size_t i = 0; i < words.size(); ++i) {
+    uint64_t w = words[i];
+    while (w) {
+      result.push_back(i * 64 + lowest_bit(w));
+      w &= w - 1;
+    }
+  }
+  return result;
+}
+
+db_selection& db_selection::operator&=(const db_selection& r) {
+  for (size_t i = 0; i < words.size() && i < r.words.size(); ++i)
+    words[i] &= r.words[i];
+  return *this;
+}
+
+db_selection& db_selection::operator|=(const db_selection& r) {
+  for (size_t i = 0; i < words.size() && i < r.words.size(); ++i)
+    words[i] |= r.words[i];
+  return *this;
+}
+
+void db_selection::Invert() {
+  for (auto& w : words)
+    w = ~w;
+  clearTail();
+}
+
+void db_selection::clearTail() {
+  if (rows % 64)
+    words.back() &= (uint64_t(1) << (rows % 64)) - 1;
+}
+
+/* DBColumnarView */
+DBColumnarView::DBColumnarView(const db_fields_collection& fields,
+                               const std::vector<row_values>& rows)
+    : BaseObject(STATUS_DEFAULT), fields_(fields) {
+  init(rows);
+}
+
+DBColumnarView::DBColumnarView(const db_query_select_result& result)
+    : BaseObject(STATUS_DEFAULT), fields_(result.fields) {
+  init(result.values_vec);
+}
+
+const db_numeric_column* DBColumnarView::GetColumn(field_index i) const {
+  return (i < columns_.size()) ? columns_[i].get() : nullptr;
+}
+
+mstatus_t DBColumnarView::SelectRange(field_index i,
+                                      int64_t lo,
+                                      int64_t hi,
+                                      db_selection* out) {
+  const db_numeric_column* col = GetColumn(i);
+  if (col == nullptr) {
+    error_.SetError(ERROR_DB_VARIABLE, "Поле не является числовым");
+    return STATUS_HAVE_ERROR;
+  }
+  if (col->storage == db_numeric_column::storage_t::st_real)
+    return SelectRange(i, double(lo), double(hi), out);
+  *out = db_selection(rows_count_);
+  if (col->storage == db_numeric_column::storage_t::st_int32) {
+    int32_t tlo, thi;
+    if (clamp_bounds(lo, hi, &tlo, &thi))
+      *out = scan_range(col->i32, tlo, thi);
+  } else if (lo <= hi) {
+    *out = scan_range(col->i64, lo, hi);
+  }
+  *out &= col->valid;
+  return STATUS_OK;
+}
+
+mstatus_t DBColumnarView::SelectRange(field_index i,
+                                      double lo,
+                                      double hi,
+                                      db_selection* out) {
+  const db_numeric_column* col = GetColumn(i);
+  if (col == nullptr) {
+    error_.SetError(ERROR_DB_VARIABLE, "Поле не является числовым");
+    return STATUS_HAVE_ERROR;
+  }
+  if (col->storage != db_numeric_column::storage_t::st_real) {
+    // целочисленный столбец: [ceil(lo), floor(hi)] с насыщением
+    const double limit = 9.2e18;
+    lo = std::ceil(std::max(lo, -limit));
+    hi = std::floor(std::min(hi, limit));
+    if (std::isnan(lo) || std::isnan(hi) || lo > hi) {
+      *out = db_selection(rows_count_);
+      return STATUS_OK;
+    }
+    return SelectRange(i, int64_t(lo), int64_t(hi), out);
+  }
+  *out = scan_range(col->real, lo, hi);
+  *out &= col->valid;
+  return STATUS_OK;
+}
+
+mstatus_t DBColumnarView::Select(
+    const std::shared_ptr<DBWhereClause<where_node_data>>& clause,
+    db_selection* out) {
+  auto root = (clause) ? clause->GetRoot() : nullptr;
+  if (!root) {
+    *out = db_selection(rows_count_, true);
+    return STATUS_OK;
+  }
+  try {
+    *out = selectNode(root.get());
+  } catch (const std::exception& e) {
+    error_.SetError(ERROR_DB_OPERATION,
+                    "Ошибка колоночной фильтрации: " + std::string(e.what()));
+    return STATUS_HAVE_ERROR;
+  }
+  return STATUS_OK;
+}
+
+const char* DBColumnarView::KernelName() {
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(DB_COLUMNAR_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif  // __AVX2__
+}
+
+void DBColumnarView::init(const std::vector<row_values>& rows) {
+  rows_count_ = rows.size();
+  columns_.resize(fields_.size());
+  try {
+    for (size_t f = 0; f < fields_.size(); ++f) {
+      std::unique_ptr<db_numeric_column> col(new db_numeric_column);
+      switch (fields_[f].type) {
+        case db_variable_type::type_autoinc:
+        case db_variable_type::type_short:
+        case db_variable_type::type_int:
+          col->storage = db_numeric_column::storage_t::st_int32;
+          col->i32.resize(rows_count_, 0);
+          break;
+        case db_variable_type::type_long:
+          col->storage = db_numeric_column::storage_t::st_int64;
+          col->i64.resize(rows_count_, 0);
+          break;
+        case db_variable_type::type_real:
+          col->storage = db_numeric_column::storage_t::st_real;
+          col->real.resize(rows_count_, 0.0);
+          break;
+        default:
+          continue;
+      }
+      col->valid = db_selection(rows_count_);
+      columns_[f] = std::move(col);
+    }
+    for (size_t r = 0; r < rows.size(); ++r) {
+      for (const auto& value : rows[r]) {
+        if (value.first >= columns_.size() || !columns_[value.first])
+          continue;
+        db_numeric_column& col = *columns_[value.first];
+        bool ok = false;
+        if (col.storage == db_numeric_column::storage_t::st_real) {
+          ok = parse_real(value.second, &col.real[r]);
+        } else {
+          int64_t i = 0;
+          ok = parse_integer(value.second, &i);
+          if (col.storage == db_numeric_column::storage_t::st_int64) {
+            col.i64[r] = i;
+          } else {
+            ok = ok && i >= std::numeric_limits<int32_t>::min() &&
+                 i <= std::numeric_limits<int32_t>::max();
+            col.i32[r] = static_cast<int32_t>(i);
+          }
+        }
+        if (!ok)
+          throw db_variable_exception("Ошибка разбора числового значения '"
+                                      + value.second + "' поля "
+                                      + fields_[value.first].fname);
+        col.valid.Set(r);
+      }
+    }
+    status_ = STATUS_OK;
+  } catch (const std::exception& e) {
+    columns_.clear();
+    rows_count_ = 0;
+    error_.SetError(ERROR_DB_OPERATION,
+                    "Построение колоночного представления: "
+                        + std::string(e.what()));
+    status_ = STATUS_HAVE_ERROR;
+  }
+}
+
+db_selection DBColumnarView::selectNode(
+    const expression_node<where_node_data>* node) {
+  if (node == nullptr || !node->field_data.IsOperator())
+    throw db_variable_exception("Узел дерева условий не является оператором");
+  auto op = node->field_data.GetOperatorWrapper().op;
+  if (op == db_operator_t::op_and) {
+    db_selection result = selectNode(node->GetLeft().get());
+    result &= selectNode(node->GetRight().get());
+    return result;
+  } else if (op == db_operator_t::op_or) {
+    db_selection result = selectNode(node->GetLeft().get());
+    result |= selectNode(node->GetRight().get());
+    return result;
+  }
+  return selectLeaf(node);
+}
+
+db_selection DBColumnarView::selectLeaf(
+    const expression_node<where_node_data>* node) {
+  auto fnode = node->GetLeft();
+  auto vnode = node->GetRight();
+  if (!fnode || !fnode->field_data.IsFieldName() || !vnode)
+    throw db_variable_exception("Невычислимый узел дерева условий");
+  field_index fi = columnByName(fnode->field_data.GetTablePair().second);
+  const db_numeric_column& col = *columns_[fi];
+  auto opw = node->field_data.GetOperatorWrapper();
+  db_selection result;
+  auto select = [this, fi, &result](auto lo, auto hi) {
+    if (!is_status_ok(SelectRange(fi, lo, hi, &result)))
+      throw db_variable_exception("Ошибка фильтра диапазона");
+  };
+  auto parse = [&col](const std::string& str, int64_t* i, double* d) {
+    bool ok = (col.storage == db_numeric_column::storage_t::st_real)
+                  ? parse_real(str, d)
+                  : parse_integer(str, i);
+    if (!ok)
+      throw db_variable_exception("Ошибка разбора значения условия: " + str);
+  };
+  bool is_real = col.storage == db_numeric_column::storage_t::st_real;
+  bool inverse = false;
+  int64_t ilo = 0, ihi = 0;
+  double dlo = 0.0, dhi = 0.0;
+  switch (opw.op) {
+    case db_operator_t::op_is: {
+      std::string what = trim_str(vnode->field_data.GetTablePair().second);
+      std::transform(what.begin(), what.end(), what.begin(), ::toupper);
+      if (what == "NULL") {
+        result = col.valid;
+        result.Invert();
+      } else if (what == "NOT NULL") {
+        result = col.valid;
+      } else {
+        throw db_variable_exception("Оператор IS " + what
+                                    + " не поддерживается колоночным "
+                                      "фильтром");
+      }
+      return result;
+    }
+    case db_operator_t::op_between:
+      if (!vnode->GetLeft() || !vnode->GetRight())
+        throw db_variable_exception("Не заданы границы оператора BETWEEN");
+      parse(vnode->GetLeft()->field_data.GetTablePair().second, &ilo, &dlo);
+      parse(vnode->GetRight()->field_data.GetTablePair().second, &ihi, &dhi);
+      inverse = opw.inverse;
+      break;
+    default: {
+      if (!vnode->field_data.IsValue())
+        throw db_variable_exception("Невычислимое значение дерева условий");
+      int64_t iv = 0;
+      double dv = 0.0;
+      parse(vnode->field_data.GetTablePair().second, &iv, &dv);
+      bool not_empty = (is_real) ? operator_bounds(opw.op, dv, &dlo, &dhi)
+                                 : operator_bounds(opw.op, iv, &ilo, &ihi);
+      if (!not_empty)
+        return db_selection(rows_count_);
+      inverse = opw.op == db_operator_t::op_ne;
+    }
+  }
+  if (is_real)
+    select(dlo, dhi);
+  else
+    select(ilo, ihi);
+  if (inverse) {
+    // NOT диапазона, NULL значения условию не удовлетворяют
+    result.Invert();
+    result &= col.valid;
+  }
+  return result;
+}
+
+DBColumnarView::field_index DBColumnarView::columnByName(
+    const std::string& fname) const {
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].fname == fname) {
+      if (i < columns_.size() && columns_[i])
+        return i;
+      throw db_variable_exception("Поле '" + fname + "' не является числовым");
+    }
+  }
+  throw db_variable_exception("Поле '" + fname
+                              + "' не найдено в коллекции полей таблицы");
+}
+}  // namespace asp_db
@@ -10,6 +10,8 @@
 #include "asp_db/db_connection.h"
 
 #include "asp_db/db_connection_manager.h"
+#include "asp_db/db_dry_run_sink.h"
+#include "asp_db/db_journal.h"
 
 #include <map>
 #include <sstream>
@@ -26,7 +28,11 @@ std::string db_parameters::GetInfo() const {
     return info += "dummy connection\n";
   return info + db_client_to_string(supplier) + "\n\tname: " + name
          + "\n\tusername: " + username + "\n\thost: " + host + ":"
-         + std::to_string(port) + "\n";
+         + std::to_string(port) + "\n" + (faults ? "\tfaults: on\n" : "")
+         + ((slow_query_threshold.count() > 0)
+                ? "\tslow query: "
+                      + std::to_string(slow_query_threshold.count()) + " us\n"
+                : "");
 }
 
 DBConnection::db_field_info::db_field_info(const std::string& name,
@@ -46,13 +52,22 @@ DBConnection::DBConnection(const IDBTables* tables,
     throw DBException(ERROR_DB_CONNECTION,
                       "Попытка инициализовать DBConnection пустым "
                       "указатедем на функционал таблиц");
+  if (parameters_.is_dry_run && !parameters_.dry_run_file.empty())
+    dry_run_sink_ = DBDryRunSink::Open(parameters_.dry_run_file);
+  if (parameters_.is_dry_run && !parameters_.dry_run_journal.empty())
+    journal_ = DBJournalWriter::Open(parameters_.dry_run_journal);
+  if (journal_)
+    journal_connection_ = journal_->NextConnectionId();
 }
 
 DBConnection::DBConnection(const DBConnection& r)
     : BaseObject(STATUS_DEFAULT),
       parameters_(r.parameters_),
       tables_(r.tables_),
-      logger_(r.logger_) {}
+      logger_(r.logger_),
+      dry_run_sink_(r.dry_run_sink_),
+      journal_(r.journal_),
+      journal_connection_(journal_ ? journal_->NextConnectionId() : 0) {}
 
 DBConnection& DBConnection::operator=(const DBConnection& r) {
   if (&r != this) {
@@ -60,10 +75,15 @@ DBConnection& DBConnection::operator=(const DBConnection& r) {
     parameters_ = db_parameters(r.parameters_);
     tables_ = r.tables_;
     logger_ = r.logger_;
+    dry_run_sink_ = r.dry_run_sink_;
+    journal_ = r.journal_;
+    journal_connection_ = journal_ ? journal_->NextConnectionId() : 0;
+    journal_transaction_ = false;
     // установить дефолтные значения
     error_.Reset();
     status_ = STATUS_DEFAULT;
     is_connected_ = false;
+    is_read_only_ = false;
   }
   return *this;
 }
@@ -74,6 +94,18 @@ bool DBConnection::IsOpen() const {
   return is_connected_;
 }
 
+std::string DBConnection::GetErrorMessage() const {
+  return error_.GetMessage();
+}
+
+void DBConnection::SetReadOnly(bool read_only) {
+  is_read_only_ = read_only;
+}
+
+bool DBConnection::IsReadOnly() const {
+  return is_read_only_;
+}
+
 /* setup quries text */
 std::stringstream DBConnection::setupAddSavePointString(
     const db_save_point& sp) {
@@ -131,32 +163,58 @@ std::stringstream DBConnection::setupDropTableString(
        << db_reference::GetReferenceActString(drop.act) << ";";
   return sstr;
 }
-std::stringstream DBConnection::setupInsertString(
-    const db_query_insert_setup& fields) {
-  if (fields.values_vec.empty()) {
+std::vector<size_t> DBConnection::setupInsertColumns(
+    const db_query_insert_setup& fields,
+    std::string* fnames) {
+  const db_insert_batch& batch = fields.batch;
+  std::vector<size_t> cols;
+  if (batch.Empty()) {
     error_.SetError(ERROR_DB_VARIABLE, "Нет данных для INSERT операции");
-    return std::stringstream();
+    return cols;
   }
-  std::string fnames =
-      "INSERT INTO " + tables_->GetTableName(fields.table) + " (";
-  std::string values = "VALUES (";
-  for (const auto& row : fields.values_vec) {
-    for (const auto& x : row) {
-      if (x.first >= 0 && x.first < fields.fields.size()) {
-        fnames += std::string(fields.fields[x.first].fname) + ", ";
-        values += x.second + ", ";
-      } else {
-        Logging::Append(io_loglvl::debug_logs,
-                        "Ошибка индекса операции INSERT.\n"
-                        "\tДля таблицы "
-                            + tables_->GetTableName(fields.table));
+  cols.reserve(batch.ColumnsSize());
+  *fnames = "INSERT INTO " + tables_->GetTableName(fields.table) + " (";
+  for (size_t col = 0; col < batch.ColumnsSize(); ++col) {
+    auto i = batch.ColumnIndex(col);
+    if (i < fields.fields.size()) {
+      if (!batch.AllNull(col)) {
+        *fnames += std::string(fields.fields[i].fname) + ", ";
+        cols.push_back(col);
       }
+    } else {
+      DB_LOG_DEBUG("Ошибка индекса операции INSERT.\n\tДля таблицы ",
+                   tables_->GetTableName(fields.table));
     }
   }
-  fnames.replace(fnames.size() - 2, fnames.size() - 1, ")");
-  values.replace(values.size() - 2, values.size() - 1, ")");
+  if (cols.empty()) {
+    error_.SetError(ERROR_DB_VARIABLE, "INSERT операция для пустых строк");
+    return cols;
+  }
+  fnames->replace(fnames->size() - 2, 2, ")");
+  return cols;
+}
+std::stringstream DBConnection::setupInsertString(
+    const db_query_insert_setup& fields) {
+  std::string fnames;
+  auto cols = setupInsertColumns(fields, &fnames);
+  if (cols.empty())
+    return std::stringstream();
+  const db_insert_batch& batch = fields.batch;
   std::stringstream sstr;
-  sstr << fnames << " " << values << " RETURNING ID;";
+  sstr << fnames << " VALUES ";
+  for (size_t row = 0; row < batch.RowsSize(); ++row) {
+    sstr << (row ? ", (" : "(");
+    for (size_t k = 0; k < cols.size(); ++k) {
+      if (k)
+        sstr << ", ";
+      if (batch.IsNull(row, cols[k]))
+        sstr << "DEFAULT";
+      else
+        sstr << batch.Value(row, cols[k]);
+    }
+    sstr << ")";
+  }
+  sstr << " RETURNING ID;";
   return sstr;
 }
 std::stringstream DBConnection::setupDeleteString(
@@ -256,7 +314,9 @@ bool DBConnection::isDryRun() {
 void DBConnection::passToLogger(io_loglvl ll,
                                 const std::string& logger,
                                 const std::string& msg) {
-  if (logger_) {
+  if (dry_run_sink_) {
+    dry_run_sink_->Append(msg);
+  } else if (logger_) {
     // зарегистрирован специальный логгер
     logger_->Append(ll, logger, msg);
   } else {
@@ -264,4 +324,22 @@ void DBConnection::passToLogger(io_loglvl ll,
     Logging::Append(ll, msg);
   }
 }
+
+void DBConnection::flushDryRun() {
+  if (dry_run_sink_)
+    dry_run_sink_->Flush();
+  if (journal_)
+    journal_->Flush();
+}
+
+void DBConnection::journalStatement(const std::string& sql) {
+  if (journal_)
+    journal_->Append(journal_connection_, sql);
+}
+
+void DBConnection::journalTransaction(const std::string& sql, bool begin) {
+  if (begin || journal_transaction_)
+    journalStatement(sql);
+  journal_transaction_ = begin;
+}
 }  // namespace asp_db
@@ -0,0 +1,247 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_connection_faults.h"
+
+#include <cmath>
+#include <thread>
+
+namespace asp_db {
+/* db_fault_config */
+db_fault_rule& db_fault_config::Rule(db_fault_op op) {
+  return rules[static_cast<size_t>(op)];
+}
+
+const db_fault_rule& db_fault_config::Rule(db_fault_op op) const {
+  return rules[static_cast<size_t>(op)];
+}
+
+void db_fault_config::SetAll(const db_fault_rule& rule) {
+  rules.fill(rule);
+}
+
+/* DBConnectionFaults */
+DBConnectionFaults::DBConnectionFaults(
+    std::shared_ptr<DBConnection> connection,
+    const db_fault_config& config,
+    const IDBTables* tables,
+    const db_parameters& parameters,
+    PrivateLogging* logger)
+    : DBConnection(tables, parameters, logger),
+      state_(std::make_shared<shared_state>()),
+      connection_(connection),
+      rng_(config.seed) {
+  state_->config = config;
+  if (!connection_) {
+    error_.SetError(ERROR_DB_CONNECTION,
+                    "Не задано оборачиваемое подключение");
+    status_ = STATUS_HAVE_ERROR;
+  }
+}
+
+DBConnectionFaults::DBConnectionFaults(
+    const DBConnectionFaults& r,
+    std::shared_ptr<DBConnection> connection)
+    : DBConnection(r),
+      state_(r.state_),
+      connection_(connection),
+      rng_(r.state_->config.seed + (++r.state_->clones)) {
+  is_connected_ = false;
+}
+
+std::shared_ptr<DBConnection> DBConnectionFaults::CloneConnection() {
+  auto connection = (connection_) ? connection_->CloneConnection() : nullptr;
+  if (!connection)
+    return nullptr;
+  return std::shared_ptr<DBConnectionFaults>(
+      new DBConnectionFaults(*this, connection));
+}
+
+mstatus_t DBConnectionFaults::AddSavePoint(const db_save_point& sp) {
+  if (!inject(db_fault_op::add_save_point))
+    return status_;
+  return forward(connection_->AddSavePoint(sp));
+}
+
+void DBConnectionFaults::RollbackToSavePoint(const db_save_point& sp) {
+  inject(db_fault_op::rollback_to_save_point);
+  if (connection_)
+    connection_->RollbackToSavePoint(sp);
+}
+
+mstatus_t DBConnectionFaults::SetupConnection() {
+  if (connection_) {
+    // ошибки прошлой транзакции не переносятся на новую
+    error_.Reset();
+    status_ = STATUS_DEFAULT;
+  }
+  if (!inject(db_fault_op::setup_connection))
+    return status_;
+  connection_->SetReadOnly(is_read_only_);
+  forward(connection_->SetupConnection());
+  is_connected_ = connection_->IsOpen();
+  return status_;
+}
+
+void DBConnectionFaults::CloseConnection() {
+  inject(db_fault_op::close_connection);
+  if (connection_) {
+    connection_->CloseConnection();
+    is_connected_ = connection_->IsOpen();
+  }
+}
+
+mstatus_t DBConnectionFaults::IsTableExists(db_table t, bool* is_exists) {
+  if (!inject(db_fault_op::is_table_exists))
+    return status_;
+  return forward(connection_->IsTableExists(t, is_exists));
+}
+
+mstatus_t DBConnectionFaults::GetTableFormat(db_table t,
+                                             db_table_create_setup* fields) {
+  if (!inject(db_fault_op::get_table_format))
+    return status_;
+  return forward(connection_->GetTableFormat(t, fields));
+}
+
+mstatus_t DBConnectionFaults::CheckTableFormat(
+    const db_table_create_setup& fields) {
+  if (!inject(db_fault_op::check_table_format))
+    return status_;
+  return forward(connection_->CheckTableFormat(fields));
+}
+
+mstatus_t DBConnectionFaults::UpdateTable(
+    const db_table_create_setup& fields) {
+  if (!inject(db_fault_op::update_table))
+    return status_;
+  return forward(connection_->UpdateTable(fields));
+}
+
+mstatus_t DBConnectionFaults::CreateTable(
+    const db_table_create_setup& fields) {
+  if (!inject(db_fault_op::create_table))
+    return status_;
+  return forward(connection_->CreateTable(fields));
+}
+
+mstatus_t DBConnectionFaults::DropTable(const db_table_drop_setup& drop) {
+  if (!inject(db_fault_op::drop_table))
+    return status_;
+  return forward(connection_->DropTable(drop));
+}
+
+mstatus_t DBConnectionFaults::InsertRows(
+    const db_query_insert_setup& insert_data,
+    id_container* id_vec) {
+  if (!inject(db_fault_op::insert_rows))
+    return status_;
+  return forward(connection_->InsertRows(insert_data, id_vec));
+}
+
+mstatus_t DBConnectionFaults::DeleteRows(
+    const db_query_delete_setup& delete_data) {
+  if (!inject(db_fault_op::delete_rows))
+    return status_;
+  return forward(connection_->DeleteRows(delete_data));
+}
+
+mstatus_t DBConnectionFaults::SelectRows(
+    const db_query_select_setup& select_data,
+    db_query_select_result* result_data) {
+  if (!inject(db_fault_op::select_rows))
+    return status_;
+  return forward(connection_->SelectRows(select_data, result_data));
+}
+
+mstatus_t DBConnectionFaults::UpdateRows(
+    const db_query_update_setup& update_data) {
+  if (!inject(db_fault_op::update_rows))
+    return status_;
+  return forward(connection_->UpdateRows(update_data));
+}
+
+const db_fault_stats& DBConnectionFaults::GetStats() const {
+  return state_->stats;
+}
+
+bool DBConnectionFaults::inject(db_fault_op op) {
+  if (!connection_)
+    return false;
+  const db_fault_rule& rule = state_->config.Rule(op);
+  state_->stats.operations++;
+  // случайные величины разыгрываются всегда в одном порядке,
+  //   независимо от результата предыдущих
+  double latency_u = uniform();
+  double tail_u = uniform();
+  double error_u = uniform();
+  double us = 0.0;
+  switch (rule.dist) {
+    case db_latency_dist::fixed:
+      us = rule.base.count();
+      break;
+    case db_latency_dist::uniform:
+      us = rule.base.count() + latency_u * rule.spread.count();
+      break;
+    case db_latency_dist::exponential:
+      us = rule.base.count() - std::log1p(-latency_u) * rule.spread.count();
+      break;
+    case db_latency_dist::none:
+    default:
+      break;
+  }
+  if (tail_u < rule.tail_probability)
+    us += rule.tail_latency.count();
+  if (us >= 1.0) {
+    auto latency = std::chrono::microseconds(static_cast<int64_t>(us));
+    state_->stats.latency_us += latency.count();
+    std::this_thread::sleep_for(latency);
+  }
+  if (error_u < rule.error_probability) {
+    state_->stats.errors++;
+    merror_t error = rule.error;
+    if (error == 0)
+      error = (op == db_fault_op::setup_connection) ? ERROR_DB_CONNECTION
+                                                    : ERROR_DB_OPERATION;
+    error_.SetError(error, "Внесённая ошибка операции "
+                               + std::to_string(static_cast<uint32_t>(op)));
+    status_ = STATUS_HAVE_ERROR;
+    return false;
+  }
+  return true;
+}
+
+mstatus_t DBConnectionFaults::forward(mstatus_t st) {
+  if (merror_t error = connection_->GetError()) {
+    // код и текст ошибки оборачиваемого подключения сохраняются
+    error_.SetError(error, "Ошибка оборачиваемого подключения "
+                               + db_client_to_string(parameters_.supplier)
+                               + ": " + connection_->GetErrorMessage());
+  }
+  return status_ = st;
+}
+
+double DBConnectionFaults::uniform() {
+  // старшие 53 бита - мантисса double
+  return (rng_() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+std::stringstream DBConnectionFaults::setupTableExistsString(db_table) {
+  // строки запросов собирает оборачиваемое подключение
+  return std::stringstream();
+}
+
+std::stringstream DBConnectionFaults::setupGetColumnsInfoString(db_table) {
+  return std::stringstream();
+}
+
+std::string DBConnectionFaults::db_variable_to_string(const db_variable&) {
+  return "";
+}
+}  // namespace asp_db
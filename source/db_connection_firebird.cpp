@@ -133,7 +133,7 @@ void DBConnectionFireBird::RollbackToSavePoint(const db_save_point& sp) {
 mstatus_t DBConnectionFireBird::SetupConnection() {
   if (!isDryRun()) {
     try {
-      firebird_work.InitConnection();
+      firebird_work.InitConnection(is_read_only_);
     } catch (const std::exception& e) {
       error_.SetError(ERROR_DB_CONNECTION,
                       "Подключение к БД: exception. Запрос:\n"
@@ -159,13 +159,12 @@ void DBConnectionFireBird::CloseConnection() {
   firebird_work.ReleaseConnection();
   is_connected_ = false;
   error_.Reset();
-  if (IS_DEBUG_MODE)
-    Logging::Append(io_loglvl::debug_logs,
-                    "Закрытие соединения c БД " + parameters_.name);
+  DB_LOG_DEBUG("Закрытие соединения c БД ", parameters_.name);
   if (isDryRun()) {
     status_ = STATUS_OK;
     passToLogger(io_loglvl::info_logs, FIREBIRD_DRYRUN_LOGGER,
                  "dry_run commit and disconect");
+    flushDryRun();
   }
 }
 
@@ -287,43 +286,29 @@ std::stringstream DBConnectionFireBird::setupGetForeignKeys(db_table t) {
 
 std::stringstream DBConnectionFireBird::setupInsertString(
     const db_query_insert_setup& fields) {
-  if (fields.values_vec.empty()) {
-    error_.SetError(ERROR_DB_VARIABLE, "Нет данных для INSERT операции");
+  std::string fnames;
+  auto cols = setupInsertColumns(fields, &fnames);
+  if (cols.empty())
     return std::stringstream();
-  }
-  if (fields.values_vec[0].empty()) {
-    error_.SetError(ERROR_DB_VARIABLE, "INSERT операция для пустых строк");
-    return std::stringstream();
-  }
-  std::string fnames =
-      "INSERT INTO " + tables_->GetTableName(fields.table) + " (";
-  std::vector<std::string> vals;
-  // set fields
-  auto& row_values = fields.values_vec[0];
-  for (auto& x : row_values)
-    fnames += std::string(fields.fields[x.first].fname) + ", ";
-  fnames.replace(fnames.size() - 2, fnames.size() - 1, ")");
-
-  for (const auto& row : fields.values_vec) {
-    std::string value = " (";
-    for (const auto& x : row) {
-      if (x.first >= 0 && (x.first < fields.fields.size())) {
-        addVariableToString(&value, fields.fields[x.first], x.second);
+  const db_insert_batch& batch = fields.batch;
+  std::string values;
+  // буфер значения ячейки, чтобы не выделять строку на каждую ячейку
+  std::string cell;
+  for (size_t row = 0; row < batch.RowsSize(); ++row) {
+    values += row ? ", (" : " (";
+    for (size_t col : cols) {
+      if (batch.IsNull(row, col)) {
+        values += "DEFAULT, ";
       } else {
-        Logging::Append(io_loglvl::debug_logs,
-                        "Ошибка индекса операции INSERT.\n"
-                        "\tДля таблицы "
-                            + tables_->GetTableName(fields.table));
+        cell.assign(batch.Value(row, col));
+        addVariableToString(&values, fields.fields[batch.ColumnIndex(col)],
+                            cell);
       }
     }
-    value.replace(value.size() - 2, value.size(), "),");
-    vals.emplace_back(value);
+    values.replace(values.size() - 2, 2, ")");
   }
-  vals.back().replace(vals.back().size() - 1, vals.back().size(), " ");
   std::stringstream sstr;
-  sstr << fnames << " VALUES ";
-  for (const auto& x : vals)
-    sstr << x;
+  sstr << fnames << " VALUES" << values;
   sstr << ";";
   return sstr;
 }
@@ -545,27 +530,31 @@ DBConnectionFireBird::_firebird_work::~_firebird_work() {
 
 bool DBConnectionFireBird::_firebird_work::InitConnection(bool read_only) {
   try {
-    if (!read_only) {
-      dpb = utl->getXpbBuilder(fb_status.get(), IXpbBuilder::DPB, NULL, 0);
-      att = prov->attachDatabase(fb_status.get(), parameters.name.c_str(), 0,
-                                 NULL);
-    } else {
-      dpb = utl->getXpbBuilder(fb_status.get(), IXpbBuilder::TPB, NULL, 0);
-      dpb->insertTag(fb_status.get(), isc_tpb_read_committed);
-      dpb->insertTag(fb_status.get(), isc_tpb_no_rec_version);
-      dpb->insertTag(fb_status.get(), isc_tpb_wait);
-      dpb->insertTag(fb_status.get(), isc_tpb_read);
-      att = prov->attachDatabase(fb_status.get(), parameters.name.c_str(),
-                                 dpb->getBufferLength(fb_status.get()),
-                                 dpb->getBuffer(fb_status.get()));
-    }
+    dpb = utl->getXpbBuilder(fb_status.get(), IXpbBuilder::DPB, NULL, 0);
     // вероятно здесь стандартное 'sysdba' и 'masterkey'
     dpb->insertString(fb_status.get(), isc_dpb_user_name,
                       parameters.username.c_str());
     dpb->insertString(fb_status.get(), isc_dpb_password,
                       parameters.password.c_str());
-    // TODO: что-то мне не нравится этот кусок
-    tra = att->startTransaction(fb_status.get(), 0, NULL);
+    att = prov->attachDatabase(fb_status.get(), parameters.name.c_str(),
+                               dpb->getBufferLength(fb_status.get()),
+                               dpb->getBuffer(fb_status.get()));
+    if (!read_only) {
+      // TODO: что-то мне не нравится этот кусок
+      tra = att->startTransaction(fb_status.get(), 0, NULL);
+    } else {
+      // транзакция только на чтение не блокирует пишущие транзакции
+      IXpbBuilder* tpb =
+          utl->getXpbBuilder(fb_status.get(), IXpbBuilder::TPB, NULL, 0);
+      tpb->insertTag(fb_status.get(), isc_tpb_read_committed);
+      tpb->insertTag(fb_status.get(), isc_tpb_rec_version);
+      tpb->insertTag(fb_status.get(), isc_tpb_nowait);
+      tpb->insertTag(fb_status.get(), isc_tpb_read);
+      tra = att->startTransaction(fb_status.get(),
+                                  tpb->getBufferLength(fb_status.get()),
+                                  tpb->getBuffer(fb_status.get()));
+      tpb->dispose();
+    }
   } catch (const FbException& e) {
     status_ = STATUS_HAVE_ERROR;
     if (utl != nullptr) {
@@ -9,12 +9,20 @@
  */
 #include "asp_db/db_connection_manager.h"
 
+#include "asp_db/db_change_listener_memory.h"
+#include "asp_db/db_connection_faults.h"
+#include "asp_db/db_connection_memory.h"
+
 #if defined(WITH_POSTGRESQL)
+#include "asp_db/db_change_listener_postgre.h"
 #include "asp_db/db_connection_postgre.h"
 #endif  // WITH_POSTGRESQL
 #if defined(WITH_FIREBIRD)
 #include "asp_db/db_connection_firebird.h"
 #endif  // WITH_FIREBIRD
+#if defined(WITH_SQLITE)
+#include "asp_db/db_connection_sqlite.h"
+#endif  // WITH_SQLITE
 
 #include <ctime>
 
@@ -37,6 +45,14 @@ logging_cfg firebird_logging_cfg(FIREBIRD_DRYRUN_LOGGER,
                                  DEFAULT_FLUSH_RATE,
                                  false);
 #endif  // WITH_FIREBIRD
+#if defined(WITH_SQLITE)
+logging_cfg sqlite_logging_cfg(SQLITE_DRYRUN_LOGGER,
+                               io_loglvl::info_logs,
+                               SQLITE_DRYRUN_LOGFILE,
+                               DEFAULT_MAXLEN_LOGFILE,
+                               DEFAULT_FLUSH_RATE,
+                               false);
+#endif  // WITH_SQLITE
 
 // db_parameters::db_parameters()
 //   : supplier(db_client::NOONE) {}
@@ -52,15 +68,25 @@ mstatus_t Transaction::ExecuteQueries() {
   if (status_ == STATUS_DEFAULT) {
     for (auto it_query = queries_.begin(); it_query != queries_.end();
          it_query++) {
+      DBTrace::Span span(db_trace_category::query,
+                         DBTrace::IsEnabled() ? (*it_query)->GetInfo() : "");
+      DBMetrics::Timer timer((*it_query)->MetricStage());
       status_ = (*it_query)->Execute();
+      timer.Finish(is_status_ok(status_));
+      span.Finish();
       // если статус после выполнения не удовлетворителен -
       //   откатим все изменения, залогируем ошибку
       if (!is_status_ok(status_)) {
         (*it_query)->LogDBConnectionError();
+        DBMetrics::Timer rollback(db_metric_stage::rollback);
         auto ri = std::make_reverse_iterator(it_query);
         for (; ri != queries_.rend(); ++ri) {
-          if ((*ri)->IsPerformed())
+          if ((*ri)->IsPerformed()) {
+            DBTrace::Span rollback_span(
+                db_trace_category::rollback,
+                DBTrace::IsEnabled() ? (*ri)->GetInfo() : "");
             (*ri)->unExecute();
+          }
         }
         break;
       }
@@ -145,19 +171,24 @@ mstatus_t DBConnectionManager::ResetConnectionParameters(
 }
 
 bool DBConnectionManager::IsTableExists(db_table dt) {
+  DBMetrics::Scope metrics(db_metric_op::is_table_exists, dt);
   bool exists = false;
   exec_wrap<db_table, bool,
             void (DBConnectionManager::*)(Transaction*, db_table, bool*)>(
-      dt, &exists, &DBConnectionManager::isTableExist, nullptr);
+      dt, &exists, &DBConnectionManager::isTableExist, nullptr, true);
   return exists;
 }
 
 mstatus_t DBConnectionManager::CreateTable(db_table dt) {
+  DBMetrics::Scope metrics(db_metric_op::create_table, dt);
   db_save_point sp("create_table");
-  return exec_wrap<db_table, void,
-                   void (DBConnectionManager::*)(Transaction*, db_table,
-                                                 void*)>(
+  auto st = exec_wrap<db_table, void,
+                      void (DBConnectionManager::*)(Transaction*, db_table,
+                                                    void*)>(
       dt, nullptr, &DBConnectionManager::createTable, &sp);
+  // выборки из ещё не созданной таблицы тоже могли попасть в кэш
+  InvalidateQueryCache(dt);
+  return st;
 }
 
 mstatus_t DBConnectionManager::DeleteAllRows(db_table table) {
@@ -166,6 +197,7 @@ mstatus_t DBConnectionManager::DeleteAllRows(db_table table) {
 }
 
 bool DBConnectionManager::CheckTableFormat(db_table dt) {
+  DBMetrics::Scope metrics(db_metric_op::get_table_format, dt);
   db_table_create_setup cs_db(dt);
   mstatus_t result =
       exec_wrap<db_table, db_table_create_setup,
@@ -182,6 +214,7 @@ bool DBConnectionManager::CheckTableFormat(db_table dt) {
 }
 
 mstatus_t DBConnectionManager::UpdateTableFormat(db_table dt) {
+  DBMetrics::Scope metrics(db_metric_op::update_table_format, dt);
   db_table_create_setup cs_db(dt);
   mstatus_t result =
       exec_wrap<db_table, db_table_create_setup,
@@ -197,13 +230,147 @@ mstatus_t DBConnectionManager::UpdateTableFormat(db_table dt) {
   return result;
 }
 
+void DBConnectionManager::EnableQueryCache(
+    const db_query_cache_parameters& parameters) {
+  auto cache = std::make_shared<DBQueryCache>(parameters);
+  std::lock_guard<std::mutex> lock(query_cache_lock_);
+  query_cache_ = std::move(cache);
+}
+
+void DBConnectionManager::DisableQueryCache() {
+  std::shared_ptr<DBQueryCache> cache;
+  {
+    std::lock_guard<std::mutex> lock(query_cache_lock_);
+    cache.swap(query_cache_);
+  }
+}
+
+void DBConnectionManager::EnableGroupCommit(
+    const db_group_commit_parameters& parameters) {
+  group_commit_ = std::make_unique<DBGroupCommit>(parameters);
+}
+
+void DBConnectionManager::DisableGroupCommit() {
+  group_commit_ = nullptr;
+}
+
+const DBGroupCommit* DBConnectionManager::GetGroupCommit() const {
+  return group_commit_.get();
+}
+
+void DBConnectionManager::EnableWriteBehind(
+    const db_write_behind_parameters& parameters) {
+  // строки прежней очереди дописываются с её параметрами
+  write_behind_ = nullptr;
+  write_behind_ = std::make_unique<DBWriteBehind>(parameters);
+}
+
+void DBConnectionManager::DisableWriteBehind() {
+  write_behind_ = nullptr;
+}
+
+void DBConnectionManager::FlushWriteBehind() {
+  if (write_behind_)
+    write_behind_->Flush();
+}
+
+const DBWriteBehind* DBConnectionManager::GetWriteBehind() const {
+  return write_behind_.get();
+}
+
+void DBConnectionManager::InvalidateQueryCache(db_table table) {
+  if (auto cache = queryCache())
+    cache->InvalidateTable(table);
+}
+
+std::shared_ptr<DBQueryCache> DBConnectionManager::queryCache() const {
+  std::lock_guard<std::mutex> lock(query_cache_lock_);
+  return query_cache_;
+}
+
+mstatus_t DBConnectionManager::StartChangeListener(
+    const std::vector<db_table>& tables) {
+  StopChangeListener();
+  // слушатель запускается до публикации, подписки других потоков
+  //   получают уже работающий слушатель
+  auto listener = DBConnectionCreator::getInstance().initChangeListener(
+      tables_, parameters_);
+  if (!listener) {
+    error_.SetError(ERROR_DB_CONNECTION,
+                    "Уведомления об изменении таблиц не поддерживаются для "
+                    "БД: "
+                        + parameters_.GetInfo());
+    return STATUS_NOT;
+  }
+  for (const auto table : tables) {
+    listener->Subscribe(table, [this](const db_table_change& change) {
+      InvalidateQueryCache(change.table);
+    });
+  }
+  mstatus_t st = listener->Start(tables);
+  if (!is_status_ok(st)) {
+    listener->LogError();
+    return st;
+  }
+  std::shared_ptr<DBChangeListener> prev;
+  {
+    std::lock_guard<std::mutex> lock(change_listener_lock_);
+    prev = std::move(change_listener_);
+    change_listener_ = std::move(listener);
+  }
+  // слушатель одновременного вызова StartChangeListener
+  if (prev)
+    prev->Stop();
+  return st;
+}
+
+std::string DBConnectionManager::GetMetricsPrometheus() const {
+  return DBMetrics::Snapshot().ToPrometheus(tables_);
+}
+
+void DBConnectionManager::StopChangeListener() {
+  std::shared_ptr<DBChangeListener> listener;
+  {
+    std::lock_guard<std::mutex> lock(change_listener_lock_);
+    listener = std::move(change_listener_);
+  }
+  // остановка ждёт поток слушателя, обработчики которого могут
+  //   отписываться, поэтому без блокировки
+  if (listener)
+    listener->Stop();
+}
+
+size_t DBConnectionManager::SubscribeTableChanges(
+    db_table table,
+    db_change_callback callback) {
+  std::lock_guard<std::mutex> lock(change_listener_lock_);
+  return (change_listener_)
+             ? change_listener_->Subscribe(table, std::move(callback))
+             : 0;
+}
+
+void DBConnectionManager::UnsubscribeTableChanges(size_t id) {
+  std::shared_ptr<DBChangeListener> listener;
+  {
+    std::lock_guard<std::mutex> lock(change_listener_lock_);
+    listener = change_listener_;
+  }
+  // отписка ждёт исполняемый обработчик, который может обращаться
+  //   к менеджеру, поэтому без блокировки
+  if (listener)
+    listener->Unsubscribe(id);
+}
+
 mstatus_t DBConnectionManager::deleteRowsImp(
     const std::shared_ptr<db_query_delete_setup>& dds) {
+  DBMetrics::Scope metrics(db_metric_op::delete_rows, dds->table);
   db_save_point sp("delete_rows");
-  return exec_wrap<const db_query_delete_setup&, void,
-                   void (DBConnectionManager::*)(
-                       Transaction*, const db_query_delete_setup&, void*)>(
+  auto st = exec_wrap<const db_query_delete_setup&, void,
+                      void (DBConnectionManager::*)(
+                          Transaction*, const db_query_delete_setup&, void*)>(
       *dds, nullptr, &DBConnectionManager::deleteRows, &sp);
+  InvalidateQueryCache(dds->table);
+  return st;
 }
 
 DBConnectionManager::DBConnectionManager(const IDBTables* tables)
@@ -316,10 +483,26 @@ DBConnectionManager::DBConnectionCreator::initDBConnection(
                                                        &db_logger_);
 #endif  // WITH_FIREBIRD
       break;
+    case db_client::MEMORY:
+      connect = std::make_unique<DBConnectionMemory>(tables, parameters,
+                                                     &db_logger_);
+      break;
+    case db_client::SQLITE:
+#if defined(WITH_SQLITE)
+      if (!db_logger_.IsRegistered(sqlite_logging_cfg))
+        db_logger_.Register(sqlite_logging_cfg);
+      connect = std::make_unique<DBConnectionSQLite>(tables, parameters,
+                                                     &db_logger_);
+#endif  // WITH_SQLITE
+      break;
     // TODO: можно тут ошибку установить
     default:
       break;
   }
+  if (connect && parameters.faults)
+    connect = std::make_unique<DBConnectionFaults>(
+        std::move(connect), *parameters.faults, tables, parameters,
+        &db_logger_);
   return connect;
 }
 
@@ -329,9 +512,28 @@ DBConnectionManager::DBConnectionCreator::cloneConnection(
   try {
     return (orig) ? orig->CloneConnection() : nullptr;
   } catch (std::exception& e) {
-    Logging::Append(io_loglvl::err_logs, "Ошибка копирования соединения бд:\n"
-                                             + std::string(e.what()));
+    DB_LOG_ERR("Ошибка копирования соединения бд:\n", e.what());
   }
   return nullptr;
 }
+
+std::unique_ptr<DBChangeListener>
+DBConnectionManager::DBConnectionCreator::initChangeListener(
+    const IDBTables* tables,
+    const db_parameters& parameters) const {
+  std::unique_ptr<DBChangeListener> listener = nullptr;
+  switch (parameters.supplier) {
+    case db_client::POSTGRESQL:
+#if defined(WITH_POSTGRESQL)
+      listener = std::make_unique<DBChangeListenerPostgre>(tables, parameters);
+#endif  // WITH_POSTGRESQL
+      break;
+    case db_client::MEMORY:
+      listener = std::make_unique<DBChangeListenerMemory>(tables, parameters);
+      break;
+    default:
+      break;
+  }
+  return listener;
+}
 }  // namespace asp_db
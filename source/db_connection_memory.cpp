@@ -0,0 +1,718 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_connection_memory.h"
+
+#include "asp_db/db_queries_setup.h"
+#include "asp_db/db_queries_setup_select.h"
+#include "asp_db/db_tables.h"
+#include "asp_db/db_where_evaluator.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace asp_db {
+namespace memory_impl {
+typedef db_query_basesetup::field_index field_index;
+typedef db_query_basesetup::row_values row_values;
+constexpr field_index field_index_end = db_query_basesetup::field_index_end;
+
+/**
+ * \brief Уникальный индекс таблицы: первичный ключ или
+ *   уникальный комплекс
+ * */
+struct unique_index {
+  /** \brief Индексы столбцов ключа */
+  std::vector<field_index> columns;
+  /** \brief Ключи строк: ключ -> идентификатор строки */
+  std::unordered_map<std::string, uint64_t> keys;
+
+ public:
+  /**
+   * \brief Собрать ключ строки
+   * \return false, если одно из значений ключа NULL - такие строки
+   *   не конфликтуют между собой
+   * */
+  bool Key(const row_values& row, std::string* key) const {
+    key->clear();
+    for (auto col : columns) {
+      auto it = row.find(col);
+      if (it == row.end())
+        return false;
+      *key += std::to_string(it->second.size());
+      *key += ':';
+      *key += it->second;
+    }
+    return true;
+  }
+};
+
+/**
+ * \brief Таблица в памяти
+ * */
+struct memory_table {
+  /** \brief Формат таблицы */
+  db_table_create_setup format;
+  /** \brief Строки по идентификаторам, в порядке добавления */
+  std::map<uint64_t, row_values> rows;
+  /** \brief Уникальные индексы */
+  std::vector<unique_index> uniques;
+  /** \brief Следующий идентификатор строки */
+  uint64_t next_rowid = 1;
+  /** \brief Следующее значение автоинкремента */
+  int64_t next_serial = 1;
+  /** \brief Столбец автоинкремента */
+  field_index serial = field_index_end;
+
+ public:
+  explicit memory_table(const db_table_create_setup& _format)
+      : format(_format) {
+    const auto& fields = format.fields;
+    for (size_t i = 0; i < fields.size(); ++i)
+      if (fields[i].type == db_variable_type::type_autoinc)
+        serial = i;
+    addUnique(format.pk_string.fnames);
+    for (const auto& uc : format.unique_constrains)
+      addUnique(uc);
+  }
+  /**
+   * \brief Индекс столбца по имени
+   * */
+  field_index Column(const std::string& fname) const {
+    const auto& fields = format.fields;
+    for (size_t i = 0; i < fields.size(); ++i)
+      if (fname == fields[i].fname)
+        return i;
+    return field_index_end;
+  }
+  /**
+   * \brief Найти строку, конфликтующую с `row` по уникальным
+   *   индексам, исключая строку `except`
+   * \return Идентификатор строки или 0
+   * */
+  uint64_t Conflict(const row_values& row, uint64_t except) const {
+    std::string key;
+    for (const auto& u : uniques) {
+      if (!u.Key(row, &key))
+        continue;
+      auto it = u.keys.find(key);
+      if (it != u.keys.end() && it->second != except)
+        return it->second;
+    }
+    return 0;
+  }
+  void Insert(uint64_t rowid, row_values row) {
+    std::string key;
+    for (auto& u : uniques)
+      if (u.Key(row, &key))
+        u.keys[key] = rowid;
+    rows.emplace(rowid, std::move(row));
+  }
+  row_values Erase(uint64_t rowid) {
+    row_values row;
+    auto it = rows.find(rowid);
+    if (it != rows.end()) {
+      std::string key;
+      for (auto& u : uniques)
+        if (u.Key(it->second, &key))
+          u.keys.erase(key);
+      row = std::move(it->second);
+      rows.erase(it);
+    }
+    return row;
+  }
+
+ private:
+  void addUnique(const std::vector<std::string>& fnames) {
+    unique_index u;
+    for (const auto& fname : fnames) {
+      auto col = Column(trim_str(fname));
+      if (col == field_index_end)
+        return;
+      u.columns.push_back(col);
+    }
+    if (!u.columns.empty())
+      uniques.push_back(std::move(u));
+  }
+};
+
+/**
+ * \brief Хранилище таблиц одной БД
+ * */
+struct memory_storage {
+  mutable std::shared_mutex mutex;
+  std::map<db_table, std::shared_ptr<memory_table>> tables;
+
+  /** \brief Наблюдатели зафиксированных изменений, под `watchers_lock` */
+  std::mutex watchers_lock;
+  std::map<size_t, db_change_callback> watchers;
+  size_t next_watcher = 1;
+};
+
+/**
+ * \brief Запись журнала отката
+ * */
+struct undo_record {
+  enum class kind {
+    /// строка добавлена - удалить
+    row_inserted = 0,
+    /// строка удалена или изменена - вернуть `row`
+    row_changed,
+    /// таблица создана, удалена или изменена - вернуть `prev`
+    table_changed
+  };
+
+  kind k;
+  db_table table;
+  uint64_t rowid = 0;
+  row_values row;
+  std::shared_ptr<memory_table> prev;
+};
+
+/**
+ * \brief Точка сохранения транзакции
+ * */
+struct undo_savepoint {
+  std::string name;
+  /** \brief Отметка журнала отката */
+  size_t mark;
+  /** \brief Количество изменений транзакции */
+  size_t changes;
+};
+
+/**
+ * \brief Журнал отката транзакции подключения
+ * */
+struct undo_log {
+  std::vector<undo_record> records;
+  std::vector<undo_savepoint> savepoints;
+  /**
+   * \brief Изменения таблиц транзакции, передаются наблюдателям
+   *   хранилища при фиксации
+   * */
+  std::vector<db_table_change> changes;
+};
+
+/**
+ * \brief Получить хранилище БД по имени
+ * */
+std::shared_ptr<memory_storage> get_storage(const std::string& name) {
+  static std::mutex registry_lock;
+  static std::map<std::string, std::weak_ptr<memory_storage>> registry;
+  std::lock_guard<std::mutex> lock(registry_lock);
+  auto& weak = registry[name];
+  auto storage = weak.lock();
+  if (!storage) {
+    storage = std::make_shared<memory_storage>();
+    weak = storage;
+  }
+  return storage;
+}
+
+/**
+ * \brief Сопоставить индексы полей коллекции сетапа `fields`
+ *   индексам столбцов таблицы
+ * \return false, если поля нет в таблице
+ * */
+bool map_columns(const db_fields_collection& fields,
+                 const memory_table& table,
+                 std::vector<field_index>* map) {
+  map->resize(fields.size());
+  const auto& tfields = table.format.fields;
+  bool ok = true;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (i < tfields.size() && !strcmp(fields[i].fname, tfields[i].fname)) {
+      (*map)[i] = i;
+    } else {
+      (*map)[i] = table.Column(fields[i].fname);
+      ok &= (*map)[i] != field_index_end;
+    }
+  }
+  return ok;
+}
+}  // namespace memory_impl
+
+using namespace memory_impl;
+
+DBConnectionMemory::DBConnectionMemory(const IDBTables* tables,
+                                       const db_parameters& parameters,
+                                       PrivateLogging* logger)
+    : DBConnection(tables, parameters, logger),
+      storage_(get_storage(parameters.name)),
+      undo_(new undo_log()) {}
+
+DBConnectionMemory::DBConnectionMemory(const DBConnectionMemory& r)
+    : DBConnection(r), storage_(r.storage_), undo_(new undo_log()) {
+  is_connected_ = false;
+}
+
+DBConnectionMemory::~DBConnectionMemory() {
+  CloseConnection();
+}
+
+std::shared_ptr<DBConnection> DBConnectionMemory::CloneConnection() {
+  return std::shared_ptr<DBConnectionMemory>(new DBConnectionMemory(*this));
+}
+
+mstatus_t DBConnectionMemory::AddSavePoint(const db_save_point& sp) {
+  if (!checkConnected())
+    return status_;
+  undo_->savepoints.push_back(
+      {sp.name, undo_->records.size(), undo_->changes.size()});
+  return status_ = STATUS_OK;
+}
+
+void DBConnectionMemory::RollbackToSavePoint(const db_save_point& sp) {
+  if (!checkConnected())
+    return;
+  auto& sps = undo_->savepoints;
+  auto it = std::find_if(sps.rbegin(), sps.rend(),
+                         [&sp](const auto& p) { return p.name == sp.name; });
+  if (it == sps.rend()) {
+    setError(ERROR_DB_SAVE_POINT,
+             "Точка сохранения '" + sp.name + "' не найдена");
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock(storage_->mutex);
+  rollbackTo(it->mark);
+  undo_->changes.resize(it->changes);
+  // сама точка сохранения остаётся, как в SQL
+  sps.erase(it.base(), sps.end());
+}
+
+mstatus_t DBConnectionMemory::SetupConnection() {
+  undo_->records.clear();
+  undo_->savepoints.clear();
+  undo_->changes.clear();
+  is_connected_ = true;
+  error_.Reset();
+  DB_LOG_DEBUG("Подключение к БД в памяти ", parameters_.name);
+  return status_ = STATUS_OK;
+}
+
+void DBConnectionMemory::CloseConnection() {
+  if (is_connected_) {
+    // фиксация транзакции - журнал отката больше не нужен
+    undo_->records.clear();
+    undo_->savepoints.clear();
+    is_connected_ = false;
+    error_.Reset();
+    notifyChanges();
+  }
+}
+
+mstatus_t DBConnectionMemory::IsTableExists(db_table t, bool* is_exists) {
+  if (!checkConnected())
+    return status_;
+  std::shared_lock<std::shared_mutex> lock(storage_->mutex);
+  *is_exists = findTable(t) != nullptr;
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::GetTableFormat(db_table t,
+                                             db_table_create_setup* fields) {
+  if (!checkConnected())
+    return status_;
+  std::shared_lock<std::shared_mutex> lock(storage_->mutex);
+  auto table = findTable(t);
+  if (table == nullptr)
+    return setError(ERROR_DB_TABLE_EXISTS,
+                    "Таблица не существует: " + tables_->GetTableName(t));
+  fields->table = t;
+  fields->fields = table->format.fields;
+  fields->pk_string = table->format.pk_string;
+  fields->unique_constrains = table->format.unique_constrains;
+  fields->ref_strings = table->format.ref_strings;
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::CheckTableFormat(
+    const db_table_create_setup& fields) {
+  if (!checkConnected())
+    return status_;
+  std::shared_lock<std::shared_mutex> lock(storage_->mutex);
+  auto table = findTable(fields.table);
+  if (table == nullptr)
+    return setError(ERROR_DB_TABLE_EXISTS, "Таблица не существует: "
+                                               + tables_->GetTableName(
+                                                   fields.table));
+  auto cmp = table->format.Compare(fields);
+  bool same = std::all_of(cmp.begin(), cmp.end(),
+                          [](const auto& c) { return c.second; });
+  if (!same)
+    return setError(ERROR_DB_OPERATION, "Формат таблицы не совпадает: "
+                                            + tables_->GetTableName(
+                                                fields.table));
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::UpdateTable(
+    const db_table_create_setup& fields) {
+  if (!checkConnected())
+    return status_;
+  std::unique_lock<std::shared_mutex> lock(storage_->mutex);
+  auto it = storage_->tables.find(fields.table);
+  if (it == storage_->tables.end())
+    return setError(ERROR_DB_TABLE_EXISTS, "Таблица не существует: "
+                                               + tables_->GetTableName(
+                                                   fields.table));
+  // добавляются только новые столбцы в конец таблицы, индексы
+  //   столбцов существующих строк не меняются
+  const auto& old_fields = it->second->format.fields;
+  bool prefix = old_fields.size() <= fields.fields.size();
+  for (size_t i = 0; prefix && i < old_fields.size(); ++i)
+    prefix = !strcmp(old_fields[i].fname, fields.fields[i].fname)
+             && old_fields[i].type == fields.fields[i].type;
+  if (!prefix)
+    return setError(ERROR_DB_COL_EXISTS,
+                    "Изменение существующих столбцов таблицы не "
+                    "поддерживается: "
+                        + tables_->GetTableName(fields.table));
+  auto updated = std::make_shared<memory_table>(fields);
+  updated->next_rowid = it->second->next_rowid;
+  updated->next_serial = it->second->next_serial;
+  for (const auto& row : it->second->rows)
+    updated->Insert(row.first, row.second);
+  undo_->records.push_back(
+      {undo_record::kind::table_changed, fields.table, 0, {}, it->second});
+  it->second = std::move(updated);
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::CreateTable(
+    const db_table_create_setup& fields) {
+  if (!checkConnected())
+    return status_;
+  std::unique_lock<std::shared_mutex> lock(storage_->mutex);
+  if (findTable(fields.table) != nullptr)
+    return setError(ERROR_DB_TABLE_EXISTS, "Таблица уже существует: "
+                                               + tables_->GetTableName(
+                                                   fields.table));
+  storage_->tables.emplace(fields.table,
+                           std::make_shared<memory_table>(fields));
+  undo_->records.push_back(
+      {undo_record::kind::table_changed, fields.table, 0, {}, nullptr});
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::DropTable(const db_table_drop_setup& drop) {
+  if (!checkConnected())
+    return status_;
+  std::unique_lock<std::shared_mutex> lock(storage_->mutex);
+  auto it = storage_->tables.find(drop.table);
+  if (it != storage_->tables.end()) {
+    undo_->records.push_back(
+        {undo_record::kind::table_changed, drop.table, 0, {}, it->second});
+    storage_->tables.erase(it);
+  }
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::InsertRows(
+    const db_query_insert_setup& insert_data,
+    id_container* id_vec) {
+  if (!checkConnected())
+    return status_;
+  const db_insert_batch& batch = insert_data.batch;
+  if (batch.Empty())
+    return setError(ERROR_DB_VARIABLE, "Нет данных для INSERT операции");
+  std::unique_lock<std::shared_mutex> lock(storage_->mutex);
+  auto table = findTable(insert_data.table);
+  if (table == nullptr)
+    return setError(ERROR_DB_TABLE_EXISTS,
+                    "Таблица не существует: "
+                        + tables_->GetTableName(insert_data.table));
+  std::vector<field_index> map;
+  if (!map_columns(insert_data.fields, *table, &map))
+    return setError(ERROR_DB_VARIABLE,
+                    "Поле сетапа INSERT не найдено в таблице "
+                        + tables_->GetTableName(insert_data.table));
+  const auto& tfields = table->format.fields;
+  size_t mark = undo_->records.size();
+  std::vector<int> ids;
+  ids.reserve(batch.RowsSize());
+  for (size_t r = 0; r < batch.RowsSize(); ++r) {
+    row_values row;
+    for (size_t col = 0; col < batch.ColumnsSize(); ++col) {
+      if (!batch.IsNull(r, col)) {
+        auto v = batch.Value(r, col);
+        row.emplace(map[batch.ColumnIndex(col)], std::string(v));
+      }
+    }
+    // значения по умолчанию и ограничения NOT NULL
+    for (size_t i = 0; i < tfields.size(); ++i) {
+      if (row.find(i) != row.end())
+        continue;
+      if (i == table->serial) {
+        row.emplace(i, std::to_string(table->next_serial++));
+      } else if (tfields[i].flags.has_default) {
+        row.emplace(i, tfields[i].default_str);
+      } else if (!tfields[i].flags.can_be_null) {
+        rollbackTo(mark);
+        return setError(ERROR_DB_VARIABLE,
+                        "NULL значение для NOT NULL столбца "
+                            + std::string(tfields[i].fname));
+      }
+    }
+    if (table->serial != field_index_end) {
+      int64_t serial = 0;
+      const auto& sv = row[table->serial];
+      std::from_chars(sv.data(), sv.data() + sv.size(), serial);
+      table->next_serial = std::max(table->next_serial, serial + 1);
+    }
+    uint64_t rowid = table->next_rowid++;
+    if (uint64_t conflict = table->Conflict(row, 0)) {
+      if (insert_data.on_exists == insert_on_exists_act::do_nothing)
+        continue;
+      if (insert_data.on_exists != insert_on_exists_act::do_update) {
+        rollbackTo(mark);
+        return setError(ERROR_DB_SQL_QUERY,
+                        "Нарушение уникальности строки таблицы "
+                            + tables_->GetTableName(insert_data.table));
+      }
+      // обновить существующую строку значениями новой
+      row_values updated = table->rows[conflict];
+      for (auto& cell : row)
+        if (cell.first != table->serial)
+          updated[cell.first] = std::move(cell.second);
+      if (table->Conflict(updated, conflict)) {
+        rollbackTo(mark);
+        return setError(ERROR_DB_SQL_QUERY,
+                        "Нарушение уникальности строки таблицы "
+                            + tables_->GetTableName(insert_data.table));
+      }
+      undo_->records.push_back({undo_record::kind::row_changed,
+                                insert_data.table, conflict,
+                                table->Erase(conflict), nullptr});
+      rowid = conflict;
+      row = std::move(updated);
+    } else {
+      undo_->records.push_back({undo_record::kind::row_inserted,
+                                insert_data.table, rowid, {}, nullptr});
+    }
+    if (table->serial != field_index_end) {
+      int id = 0;
+      const auto& sv = row[table->serial];
+      std::from_chars(sv.data(), sv.data() + sv.size(), id);
+      ids.push_back(id);
+    }
+    table->Insert(rowid, std::move(row));
+  }
+  if (id_vec)
+    id_vec->id_vec.insert(id_vec->id_vec.end(), ids.begin(), ids.end());
+  undo_->changes.push_back({insert_data.table, "INSERT"});
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::DeleteRows(
+    const db_query_delete_setup& delete_data) {
+  if (!checkConnected())
+    return status_;
+  std::unique_lock<std::shared_mutex> lock(storage_->mutex);
+  auto table = findTable(delete_data.table);
+  if (table == nullptr)
+    return setError(ERROR_DB_TABLE_EXISTS,
+                    "Таблица не существует: "
+                        + tables_->GetTableName(delete_data.table));
+  DBWhereEvaluator where(table->format.fields, delete_data.GetWhereTree());
+  if (!where.IsValid())
+    return setError(ERROR_DB_OPERATION,
+                    "Невычислимое дерево условий where для таблицы "
+                        + tables_->GetTableName(delete_data.table));
+  std::vector<uint64_t> erased;
+  for (const auto& row : table->rows)
+    if (where(row.second))
+      erased.push_back(row.first);
+  for (auto rowid : erased)
+    undo_->records.push_back({undo_record::kind::row_changed,
+                              delete_data.table, rowid, table->Erase(rowid),
+                              nullptr});
+  undo_->changes.push_back({delete_data.table, "DELETE"});
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::SelectRows(
+    const db_query_select_setup& select_data,
+    db_query_select_result* result_data) {
+  result_data->values_vec.clear();
+  if (!checkConnected())
+    return status_;
+  std::shared_lock<std::shared_mutex> lock(storage_->mutex);
+  auto table = findTable(select_data.table);
+  if (table == nullptr)
+    return setError(ERROR_DB_TABLE_EXISTS,
+                    "Таблица не существует: "
+                        + tables_->GetTableName(select_data.table));
+  DBWhereEvaluator where(table->format.fields, select_data.GetWhereTree());
+  if (!where.IsValid())
+    return setError(ERROR_DB_OPERATION,
+                    "Невычислимое дерево условий where для таблицы "
+                        + tables_->GetTableName(select_data.table));
+  std::vector<field_index> map;
+  map_columns(select_data.fields, *table, &map);
+  bool identity = true;
+  for (size_t i = 0; i < map.size() && identity; ++i)
+    identity = map[i] == i;
+  for (const auto& row : table->rows) {
+    if (!where(row.second))
+      continue;
+    if (identity) {
+      result_data->values_vec.push_back(row.second);
+    } else {
+      row_values rval;
+      for (size_t i = 0; i < map.size(); ++i) {
+        auto it = row.second.find(map[i]);
+        if (it != row.second.end())
+          rval.emplace(i, it->second);
+      }
+      result_data->values_vec.push_back(std::move(rval));
+    }
+  }
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionMemory::UpdateRows(
+    const db_query_update_setup& update_data) {
+  if (!checkConnected())
+    return status_;
+  std::unique_lock<std::shared_mutex> lock(storage_->mutex);
+  auto table = findTable(update_data.table);
+  if (table == nullptr)
+    return setError(ERROR_DB_TABLE_EXISTS,
+                    "Таблица не существует: "
+                        + tables_->GetTableName(update_data.table));
+  DBWhereEvaluator where(table->format.fields, update_data.GetWhereTree());
+  if (!where.IsValid())
+    return setError(ERROR_DB_OPERATION,
+                    "Невычислимое дерево условий where для таблицы "
+                        + tables_->GetTableName(update_data.table));
+  std::vector<field_index> map;
+  if (!map_columns(update_data.fields, *table, &map))
+    return setError(ERROR_DB_VARIABLE,
+                    "Поле сетапа UPDATE не найдено в таблице "
+                        + tables_->GetTableName(update_data.table));
+  std::vector<uint64_t> matched;
+  for (const auto& row : table->rows)
+    if (where(row.second))
+      matched.push_back(row.first);
+  size_t mark = undo_->records.size();
+  for (auto rowid : matched) {
+    row_values updated = table->rows[rowid];
+    for (const auto& cell : update_data.values)
+      updated[map[cell.first]] = cell.second;
+    if (table->Conflict(updated, rowid)) {
+      rollbackTo(mark);
+      return setError(ERROR_DB_SQL_QUERY,
+                      "Нарушение уникальности строки таблицы "
+                          + tables_->GetTableName(update_data.table));
+    }
+    undo_->records.push_back({undo_record::kind::row_changed,
+                              update_data.table, rowid, table->Erase(rowid),
+                              nullptr});
+    table->Insert(rowid, std::move(updated));
+  }
+  undo_->changes.push_back({update_data.table, "UPDATE"});
+  return status_ = STATUS_OK;
+}
+
+size_t DBConnectionMemory::RowsCount(db_table t) const {
+  std::shared_lock<std::shared_mutex> lock(storage_->mutex);
+  auto table = findTable(t);
+  return (table) ? table->rows.size() : 0;
+}
+
+size_t DBConnectionMemory::AddChangeWatcher(db_change_callback watcher) {
+  std::lock_guard<std::mutex> lock(storage_->watchers_lock);
+  size_t id = storage_->next_watcher++;
+  storage_->watchers.emplace(id, std::move(watcher));
+  return id;
+}
+
+void DBConnectionMemory::RemoveChangeWatcher(size_t id) {
+  std::lock_guard<std::mutex> lock(storage_->watchers_lock);
+  storage_->watchers.erase(id);
+}
+
+bool DBConnectionMemory::checkConnected() {
+  if (!is_connected_) {
+    error_.SetError(ERROR_PAIR_DEFAULT(ERROR_DB_CONNECTION));
+    status_ = STATUS_NOT;
+  }
+  return is_connected_;
+}
+
+mstatus_t DBConnectionMemory::setError(merror_t error,
+                                       const std::string& msg) {
+  error_.SetError(error, msg);
+  return status_ = STATUS_HAVE_ERROR;
+}
+
+memory_table* DBConnectionMemory::findTable(db_table t) const {
+  auto it = storage_->tables.find(t);
+  return (it != storage_->tables.end()) ? it->second.get() : nullptr;
+}
+
+void DBConnectionMemory::rollbackTo(size_t mark) {
+  auto& records = undo_->records;
+  while (records.size() > mark) {
+    auto& rec = records.back();
+    if (rec.k == undo_record::kind::table_changed) {
+      if (rec.prev)
+        storage_->tables[rec.table] = std::move(rec.prev);
+      else
+        storage_->tables.erase(rec.table);
+    } else if (auto table = findTable(rec.table)) {
+      table->Erase(rec.rowid);
+      if (rec.k == undo_record::kind::row_changed)
+        table->Insert(rec.rowid, std::move(rec.row));
+    }
+    records.pop_back();
+  }
+}
+
+void DBConnectionMemory::notifyChanges() {
+  if (undo_->changes.empty())
+    return;
+  // как NOTIFY postgres: одинаковые уведомления транзакции
+  //   схлопываются
+  std::vector<db_table_change> changes;
+  for (auto& change : undo_->changes) {
+    bool dup = std::any_of(changes.begin(), changes.end(),
+                           [&change](const db_table_change& c) {
+                             return c.table == change.table
+                                    && c.operation == change.operation;
+                           });
+    if (!dup)
+      changes.push_back(std::move(change));
+  }
+  undo_->changes.clear();
+  // вызов под блокировкой не даёт удалить наблюдателя во время вызова
+  std::lock_guard<std::mutex> lock(storage_->watchers_lock);
+  for (const auto& watcher : storage_->watchers)
+    for (const auto& change : changes)
+      watcher.second(change);
+}
+
+std::stringstream DBConnectionMemory::setupTableExistsString(db_table) {
+  return std::stringstream();
+}
+
+std::stringstream DBConnectionMemory::setupGetColumnsInfoString(db_table) {
+  return std::stringstream();
+}
+
+std::string DBConnectionMemory::db_variable_to_string(const db_variable& dv) {
+  return dv.fname;
+}
+}  // namespace asp_db
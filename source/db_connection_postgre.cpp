@@ -10,18 +10,23 @@
 #include "asp_db/db_connection_postgre.h"
 
 #include "asp_db/db_append_functor.h"
+#include "asp_db/db_change_listener.h"
 #include "asp_db/db_connection_manager.h"
 #include "asp_db/db_queries_setup.h"
 #include "asp_db/db_query.h"
 #include "asp_db/db_tables.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <iterator>
 #include <map>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <vector>
 
 #include <assert.h>
+#include <ctype.h>
 
 namespace asp_db {
 #define types_pair(x, y) \
@@ -149,6 +154,118 @@ db_reference_act GetReferenceAct(char postgre_symbol) {
   }
   return act;
 }
+/**
+ * \brief Фоновое снятие планов медленных запросов
+ *
+ * Планы снимаются одним потоком на собственном подключении, чтобы
+ *   не занимать подключение и транзакцию вызывающего. Очередь на
+ *   один запрос: пока план предыдущего не снят, или с последнего
+ *   запроса прошло меньше `interval`, новые запросы отбрасываются.
+ * */
+class slow_query_explainer {
+ public:
+  static slow_query_explainer& Instance() {
+    static slow_query_explainer explainer;
+    return explainer;
+  }
+
+  ~slow_query_explainer() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    if (worker_.joinable())
+      worker_.join();
+  }
+
+  /**
+   * \brief Поставить запрос `query` в очередь на снятие плана
+   * \return false если запрос отброшен
+   * */
+  bool Submit(const std::string& connect_str,
+              const std::string& query,
+              std::chrono::milliseconds interval) {
+    if (!is_explainable(query))
+      return false;
+    auto now = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (stop_ || pending_ || (was_submitted_ && now - last_ < interval))
+        return false;
+      pending_ = true;
+      was_submitted_ = true;
+      last_ = now;
+      connect_str_ = connect_str;
+      query_ = query;
+      if (!worker_.joinable())
+        worker_ = std::thread(&slow_query_explainer::run, this);
+    }
+    cv_.notify_one();
+    return true;
+  }
+
+ private:
+  slow_query_explainer() = default;
+
+  /**
+   * \brief EXPLAIN применим только к DML запросам
+   * */
+  static bool is_explainable(const std::string& query) {
+    size_t start = query.find_first_not_of(" \t\r\n(");
+    if (start == std::string::npos)
+      return false;
+    std::string word;
+    for (size_t i = start; i < query.size() && isalpha(query[i]); ++i)
+      word += static_cast<char>(toupper(query[i]));
+    return word == "SELECT" || word == "INSERT" || word == "UPDATE" ||
+           word == "DELETE" || word == "WITH";
+  }
+
+  void run() {
+    std::unique_ptr<pqxx::connection> connection;
+    std::string connection_str;
+    std::unique_lock<std::mutex> lock(lock_);
+    while (true) {
+      cv_.wait(lock, [this]() { return stop_ || pending_; });
+      if (stop_)
+        break;
+      std::string connect_str = connect_str_;
+      std::string query = query_;
+      lock.unlock();
+      try {
+        if (!connection || connection_str != connect_str) {
+          connection.reset(new pqxx::connection(connect_str));
+          connection_str = connect_str;
+        }
+        pqxx::nontransaction work(*connection);
+        pqxx::result plan =
+            work.exec("EXPLAIN (ANALYZE false, FORMAT JSON) " + query);
+        if (plan.size())
+          DB_LOG_WARN("План медленного запроса:\n", query, "\n",
+                      plan[0][0].c_str());
+      } catch (const std::exception& e) {
+        // например, таблица создана в ещё не завершённой транзакции
+        connection.reset();
+        DB_LOG_DEBUG("Не удалось получить план медленного запроса:\n", query,
+                     "\nexception what: ", e.what());
+      }
+      lock.lock();
+      pending_ = false;
+    }
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::thread worker_;
+  std::chrono::steady_clock::time_point last_;
+  std::string connect_str_;
+  std::string query_;
+  bool pending_ = false;
+  bool was_submitted_ = false;
+  bool stop_ = false;
+};
 }  // namespace postgresql_impl
 
 DBConnectionPostgre::DBConnectionPostgre(const IDBTables* tables,
@@ -211,12 +328,12 @@ mstatus_t DBConnectionPostgre::SetupConnection() {
         if (pqxx_work.IsAvailable()) {
           status_ = STATUS_OK;
           is_connected_ = true;
-          // отметим начало транзакции
+          // отметим начало транзакции, чтение выполняется
+          //   без явной транзакции
           // todo: вероятно в отдельную функцию вынести
-          pqxx_work.GetTransaction()->exec("begin;");
-          if (IS_DEBUG_MODE)
-            Logging::Append(io_loglvl::debug_logs,
-                            "Подключение к БД " + parameters_.name);
+          if (!is_read_only_)
+            pqxx_work.GetTransaction()->exec("begin;");
+          DB_LOG_DEBUG("Подключение к БД ", parameters_.name);
         } else {
           error_.SetError(
               ERROR_DB_CONNECTION,
@@ -239,8 +356,11 @@ mstatus_t DBConnectionPostgre::SetupConnection() {
     status_ = STATUS_OK;
     passToLogger(io_loglvl::info_logs, POSTGRE_DRYRUN_LOGGER,
                  "dry_run connect:" + connect_str);
-    passToLogger(io_loglvl::info_logs, POSTGRE_DRYRUN_LOGGER,
-                 "dry_run transaction begin");
+    if (!is_read_only_) {
+      passToLogger(io_loglvl::info_logs, POSTGRE_DRYRUN_LOGGER,
+                   "dry_run transaction begin");
+      journalTransaction("begin;", true);
+    }
   }
   return status_;
 }
@@ -248,7 +368,7 @@ mstatus_t DBConnectionPostgre::SetupConnection() {
 void DBConnectionPostgre::CloseConnection() {
   if (pqxx_work.pconnect_) {
     // если собирали транзакцию - закрыть
-    if (pqxx_work.IsAvailable())
+    if (pqxx_work.IsAvailable() && !is_read_only_)
       pqxx_work.GetTransaction()->exec("commit;");
       // fuuuuuuuuu
   #if defined(OS_WINDOWS)
@@ -259,14 +379,14 @@ void DBConnectionPostgre::CloseConnection() {
     pqxx_work.ReleaseConnection();
     is_connected_ = false;
     error_.Reset();
-    if (IS_DEBUG_MODE)
-      Logging::Append(io_loglvl::debug_logs,
-                      "Закрытие соединения c БД " + parameters_.name);
+    DB_LOG_DEBUG("Закрытие соединения c БД ", parameters_.name);
   }
   if (isDryRun()) {
     status_ = STATUS_OK;
     passToLogger(io_loglvl::info_logs, POSTGRE_DRYRUN_LOGGER,
                  "dry_run commit and disconect");
+    journalTransaction("commit;", false);
+    flushDryRun();
   }
 }
 
@@ -401,11 +521,10 @@ mstatus_t DBConnectionPostgre::GetTableFormat(db_table t,
                           tmp.empty() ? '!' : tmp[0]);
                     } else {
                       error = ERROR_GENERAL_T;
-                      Logging::Append(
-                          "foreign key constrain error: act delete");
+                      DB_LOG_ERR("foreign key constrain error: act delete");
                     }
                   } else {
-                    Logging::Append("foreign key constrain error: act update");
+                    DB_LOG_ERR("foreign key constrain error: act update");
                     error = ERROR_GENERAL_T;
                   }
                   fk_map.emplace(trim_str(name[0]), ud);
@@ -553,6 +672,7 @@ mstatus_t DBConnectionPostgre::SelectRows(
       void (DBConnectionPostgre::*)(const std::stringstream&, pqxx::result*)>(
       select_data, &result, &DBConnectionPostgre::setupSelectString,
       &DBConnectionPostgre::execSelect);
+  DBMetrics::Timer decode(db_metric_stage::result_decode);
   for (pqxx::const_result_iterator::reference row : result) {
     db_query_basesetup::row_values rval;
     db_query_basesetup::field_index ind = 0;
@@ -577,15 +697,34 @@ mstatus_t DBConnectionPostgre::UpdateRows(
       &DBConnectionPostgre::execUpdate);
 }
 
+void DBConnectionPostgre::logSlowQuery(const std::string& query,
+                                       std::chrono::microseconds elapsed,
+                                       uint64_t rows,
+                                       db_table table) {
+  DB_LOG_WARN("Медленный запрос: ", elapsed.count(), " мкс, строк: ", rows,
+              ", таблица: ",
+              (table != UNDEFINED_TABLE) ? tables_->GetTableName(table) : "-",
+              "\n\tЗапрос БД: ", query);
+  if (parameters_.slow_query_explain)
+    postgresql_impl::slow_query_explainer::Instance().Submit(
+        setupConnectionString(), query,
+        parameters_.slow_query_explain_interval);
+}
+
 std::string DBConnectionPostgre::setupConnectionString() {
+  return ConnectionString(parameters_);
+}
+
+std::string DBConnectionPostgre::ConnectionString(
+    const db_parameters& parameters) {
   std::stringstream connect_ss;
-  connect_ss << "dbname = " << parameters_.name << " ";
-  connect_ss << "user = " << parameters_.username << " ";
+  connect_ss << "dbname = " << parameters.name << " ";
+  connect_ss << "user = " << parameters.username << " ";
 #ifdef _DEBUG
-  connect_ss << "password = " << parameters_.password << " ";
+  connect_ss << "password = " << parameters.password << " ";
 #endif  // _DEBUG
-  connect_ss << "hostaddr = " << parameters_.host << " ";
-  connect_ss << "port = " << parameters_.port;
+  connect_ss << "hostaddr = " << parameters.host << " ";
+  connect_ss << "port = " << parameters.port;
   return connect_ss.str();
 }
 
@@ -639,45 +778,56 @@ std::stringstream DBConnectionPostgre::setupGetForeignKeys(db_table t) {
   return sstr;
 }
 
+std::stringstream DBConnectionPostgre::setupCreateTableString(
+    const db_table_create_setup& fields) {
+  std::stringstream sstr = DBConnection::setupCreateTableString(fields);
+  if (fields.notify_on_change && !error_.GetErrorCode())
+    sstr << NotifyTriggerString(tables_->GetTableName(fields.table));
+  return sstr;
+}
+
+std::string DBConnectionPostgre::NotifyTriggerString(
+    const std::string& table_name) {
+  std::stringstream sstr;
+  // одна функция триггера на все таблицы, имя канала собирается
+  //   из имени таблицы так же как в db_change_channel
+  sstr << " CREATE OR REPLACE FUNCTION asp_db_notify_change() "
+       << "RETURNS trigger AS $$ BEGIN "
+       << "PERFORM pg_notify('" << db_change_channel("") << "' || "
+       << "TG_TABLE_NAME, TG_OP); RETURN NULL; END; $$ LANGUAGE plpgsql;";
+  sstr << " DROP TRIGGER IF EXISTS " << table_name << "_notify_change ON "
+       << table_name << ";";
+  sstr << " CREATE TRIGGER " << table_name << "_notify_change "
+       << "AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON " << table_name
+       << " FOR EACH STATEMENT EXECUTE PROCEDURE asp_db_notify_change();";
+  return sstr.str();
+}
+
 std::stringstream DBConnectionPostgre::setupInsertString(
     const db_query_insert_setup& fields) {
-  if (fields.values_vec.empty()) {
-    error_.SetError(ERROR_DB_VARIABLE, "Нет данных для INSERT операции");
+  std::string fnames;
+  auto cols = setupInsertColumns(fields, &fnames);
+  if (cols.empty())
     return std::stringstream();
-  }
-  if (fields.values_vec[0].empty()) {
-    error_.SetError(ERROR_DB_VARIABLE, "INSERT операция для пустых строк");
-    return std::stringstream();
-  }
-  std::string fnames =
-      "INSERT INTO " + tables_->GetTableName(fields.table) + " (";
-  std::vector<std::string> vals;
-  // set fields
-  auto& row_values = fields.values_vec[0];
-  for (auto& x : row_values)
-    fnames += std::string(fields.fields[x.first].fname) + ", ";
-  fnames.replace(fnames.size() - 2, fnames.size() - 1, ")");
-
-  for (const auto& row : fields.values_vec) {
-    std::string value = " (";
-    for (const auto& x : row) {
-      if (x.first >= 0 && (x.first < fields.fields.size())) {
-        addVariableToString(&value, fields.fields[x.first], x.second);
+  const db_insert_batch& batch = fields.batch;
+  std::string values;
+  // буфер значения ячейки, чтобы не выделять строку на каждую ячейку
+  std::string cell;
+  for (size_t row = 0; row < batch.RowsSize(); ++row) {
+    values += row ? ", (" : " (";
+    for (size_t col : cols) {
+      if (batch.IsNull(row, col)) {
+        values += "DEFAULT, ";
       } else {
-        Logging::Append(io_loglvl::debug_logs,
-                        "Ошибка индекса операции INSERT.\n"
-                        "\tДля таблицы "
-                            + tables_->GetTableName(fields.table));
+        cell.assign(batch.Value(row, col));
+        addVariableToString(&values, fields.fields[batch.ColumnIndex(col)],
+                            cell);
       }
     }
-    value.replace(value.size() - 2, value.size(), "),");
-    vals.emplace_back(value);
+    values.replace(values.size() - 2, 2, ")");
   }
-  vals.back().replace(vals.back().size() - 1, vals.back().size(), " ");
   std::stringstream sstr;
-  sstr << fnames << " VALUES ";
-  for (const auto& x : vals)
-    sstr << x;
+  sstr << fnames << " VALUES" << values;
   sstr << getOnExistActForInsert(fields.on_exists);
   sstr << "RETURNING " << tables_->GetIdColumnName(fields.table) << ";";
   return sstr;
@@ -753,10 +903,7 @@ void DBConnectionPostgre::execIsTableExists(const std::stringstream& sstr,
     if (!trres.empty()) {
       std::string ex = trres.begin()[0].as<std::string>();
       *is_exists = (ex == "t") ? true : false;
-      if (IS_DEBUG_MODE)
-        Logging::Append(io_loglvl::debug_logs,
-                        "Ответ на запрос БД:" + sstr.str() + "\t'"
-                            + trres.begin()[0].as<std::string>() + "'\n");
+      DB_LOG_DEBUG("Ответ на запрос БД:", sstr.str(), "\t'", ex, "'\n");
     }
   }
 }
@@ -784,15 +931,13 @@ void DBConnectionPostgre::execGetColumnInfo(
           }
         }
       }
-      if (IS_DEBUG_MODE) {
+      if constexpr (db_log_enabled(io_loglvl::debug_logs)) {
         std::string cols = std::accumulate(
             columns_info->begin(), columns_info->end(), std::string(),
             [](const std::string& r, const db_field_info& n) {
               return r + n.name;
             });
-        Logging::Append(
-            io_loglvl::debug_logs,
-            "Ответ на запрос БД:" + sstr.str() + "\t'" + cols + "'\n");
+        DB_LOG_DEBUG("Ответ на запрос БД:", sstr.str(), "\t'", cols, "'\n");
       }
     }
   }
@@ -0,0 +1,952 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_connection_sqlite.h"
+
+#include "asp_db/db_append_functor.h"
+#include "asp_db/db_queries_setup.h"
+#include "asp_db/db_queries_setup_select.h"
+#include "asp_db/db_tables.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+namespace asp_db {
+namespace sqlite_impl {
+/**
+ * \brief Открытый дескриптор базы SQLite с кэшем подготовленных
+ *   запросов
+ * */
+class sqlite_handle {
+ public:
+  explicit sqlite_handle(sqlite3* db) : db(db) {}
+  ~sqlite_handle() {
+    clear();
+    sqlite3_close(db);
+  }
+  sqlite_handle(const sqlite_handle&) = delete;
+  sqlite_handle& operator=(const sqlite_handle&) = delete;
+
+  /**
+   * \brief Получить подготовленный запрос, сброшенный и без
+   *   привязанных параметров
+   * */
+  sqlite3_stmt* Prepare(const std::string& sql) {
+    auto it = stmts_.find(sql);
+    if (it != stmts_.end()) {
+      sqlite3_reset(it->second);
+      sqlite3_clear_bindings(it->second);
+      return it->second;
+    }
+    // запросы с разным текстом(например where с разным числом
+    //   условий) не должны копиться бесконечно
+    if (stmts_.size() >= max_statements)
+      clear();
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db, sql.c_str(), static_cast<int>(sql.size()),
+                           SQLITE_PREPARE_PERSISTENT, &stmt, nullptr)
+        != SQLITE_OK)
+      return nullptr;
+    stmts_.emplace(sql, stmt);
+    return stmt;
+  }
+
+ public:
+  sqlite3* db;
+
+ private:
+  void clear() {
+    for (auto& stmt : stmts_)
+      sqlite3_finalize(stmt.second);
+    stmts_.clear();
+  }
+
+ private:
+  static constexpr size_t max_statements = 64;
+  std::unordered_map<std::string, sqlite3_stmt*> stmts_;
+};
+
+/**
+ * \brief Пул открытых дескрипторов одной базы
+ * */
+class handle_pool {
+ public:
+  /**
+   * \brief Взять свободный дескриптор или открыть новый
+   * \param path Путь к файлу базы
+   * \param err Указатель на строку ошибки открытия
+   * */
+  std::unique_ptr<sqlite_handle> Acquire(const std::string& path,
+                                         std::string* err) {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (!idle_.empty()) {
+        auto handle = std::move(idle_.back());
+        idle_.pop_back();
+        return handle;
+      }
+    }
+    sqlite3* db = nullptr;
+    int rc = sqlite3_open_v2(
+        path.c_str(), &db,
+        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
+        nullptr);
+    if (rc != SQLITE_OK) {
+      *err = (db) ? sqlite3_errmsg(db) : sqlite3_errstr(rc);
+      sqlite3_close(db);
+      return nullptr;
+    }
+    auto handle = std::make_unique<sqlite_handle>(db);
+    // ожидание блокировки записи другими подключениями
+    sqlite3_busy_timeout(db, busy_timeout_ms);
+    char* msg = nullptr;
+    if (sqlite3_exec(db,
+                     "PRAGMA journal_mode = WAL; "
+                     "PRAGMA synchronous = NORMAL; "
+                     "PRAGMA foreign_keys = ON;",
+                     nullptr, nullptr, &msg)
+        != SQLITE_OK) {
+      *err = (msg) ? msg : "PRAGMA error";
+      sqlite3_free(msg);
+      return nullptr;
+    }
+    return handle;
+  }
+  /**
+   * \brief Вернуть дескриптор в пул, незакрытая транзакция
+   *   откатывается
+   * */
+  void Release(std::unique_ptr<sqlite_handle> handle) {
+    if (!sqlite3_get_autocommit(handle->db))
+      sqlite3_exec(handle->db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    std::lock_guard<std::mutex> lock(lock_);
+    if (idle_.size() < max_idle)
+      idle_.push_back(std::move(handle));
+  }
+
+ private:
+  static constexpr size_t max_idle = 8;
+  static constexpr int busy_timeout_ms = 5000;
+  std::mutex lock_;
+  std::vector<std::unique_ptr<sqlite_handle>> idle_;
+};
+
+/**
+ * \brief Сбросить подготовленный запрос при выходе из области
+ *   видимости, чтобы он не держал блокировку чтения
+ * */
+struct stmt_guard {
+  explicit stmt_guard(sqlite3_stmt* stmt) : stmt(stmt) {}
+  ~stmt_guard() {
+    if (stmt)
+      sqlite3_reset(stmt);
+  }
+  sqlite3_stmt* stmt;
+};
+
+/**
+ * \brief Разобрать логическое значение: t/f, true/false, 1/0
+ * \return -1, если строка не логическое значение
+ * */
+int parse_bool(std::string_view v) {
+  std::string s(v);
+  std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+  if (s == "t" || s == "true" || s == "1" || s == "y" || s == "yes")
+    return 1;
+  if (s == "f" || s == "false" || s == "0" || s == "n" || s == "no")
+    return 0;
+  return -1;
+}
+
+/**
+ * \brief Действие внешнего ключа по строке PRAGMA foreign_key_list
+ * */
+db_reference_act reference_act(const std::string& act) {
+  if (act == "CASCADE")
+    return db_reference_act::ref_act_cascade;
+  if (act == "SET NULL")
+    return db_reference_act::ref_act_set_null;
+  if (act == "RESTRICT")
+    return db_reference_act::ref_act_restrict;
+  return db_reference_act::ref_act_not;
+}
+
+/**
+ * \brief Сохранить имя столбца, не найденного в коллекции полей,
+ *   db_variable хранит только указатель на имя
+ * */
+const char* intern_name(const std::string& name) {
+  static std::mutex names_lock;
+  static std::set<std::string> names;
+  std::lock_guard<std::mutex> lock(names_lock);
+  return names.insert(name).first->c_str();
+}
+}  // namespace sqlite_impl
+
+using namespace sqlite_impl;
+
+DBConnectionSQLite::DBConnectionSQLite(const IDBTables* tables,
+                                       const db_parameters& parameters,
+                                       PrivateLogging* logger)
+    : DBConnection(tables, parameters, logger),
+      pool_(std::make_shared<handle_pool>()) {}
+
+DBConnectionSQLite::DBConnectionSQLite(const DBConnectionSQLite& r)
+    : DBConnection(r), pool_(r.pool_) {
+  is_connected_ = false;
+}
+
+DBConnectionSQLite::~DBConnectionSQLite() {
+  CloseConnection();
+}
+
+std::shared_ptr<DBConnection> DBConnectionSQLite::CloneConnection() {
+  return std::shared_ptr<DBConnectionSQLite>(new DBConnectionSQLite(*this));
+}
+
+mstatus_t DBConnectionSQLite::AddSavePoint(const db_save_point& sp) {
+  return execSql(setupAddSavePointString(sp).str());
+}
+
+void DBConnectionSQLite::RollbackToSavePoint(const db_save_point& sp) {
+  execSql(setupRollbackToSavePoint(sp).str());
+}
+
+mstatus_t DBConnectionSQLite::SetupConnection() {
+  // ошибки прошлой транзакции не должны блокировать новую
+  error_.Reset();
+  if (isDryRun()) {
+    status_ = STATUS_OK;
+    passToLogger(io_loglvl::info_logs, SQLITE_DRYRUN_LOGGER,
+                 "dry_run connect: " + parameters_.name);
+    if (!is_read_only_) {
+      passToLogger(io_loglvl::info_logs, SQLITE_DRYRUN_LOGGER,
+                   "dry_run transaction begin");
+      journalTransaction("BEGIN;", true);
+    }
+    return status_;
+  }
+  if (!handle_) {
+    std::string err;
+    handle_ = pool_->Acquire(parameters_.name, &err);
+    if (!handle_) {
+      error_.SetError(ERROR_DB_CONNECTION, "Подключение к БД SQLite '"
+                                               + parameters_.name
+                                               + "': " + err);
+      return status_ = STATUS_HAVE_ERROR;
+    }
+  }
+  is_connected_ = true;
+  status_ = STATUS_OK;
+  // отметим начало транзакции, чтение выполняется в режиме autocommit
+  if (is_read_only_ || is_status_ok(execSql("BEGIN;")))
+    DB_LOG_DEBUG("Подключение к БД SQLite ", parameters_.name);
+  return status_;
+}
+
+void DBConnectionSQLite::CloseConnection() {
+  if (handle_) {
+    bool committed = true;
+    if (!sqlite3_get_autocommit(handle_->db)) {
+      if (sqlite3_exec(handle_->db, "COMMIT;", nullptr, nullptr, nullptr)
+          != SQLITE_OK) {
+        committed = false;
+        setSqliteError(ERROR_DB_OPERATION, "COMMIT;");
+      }
+    }
+    // незафиксированная транзакция откатывается пулом
+    pool_->Release(std::move(handle_));
+    is_connected_ = false;
+    if (committed)
+      error_.Reset();
+    DB_LOG_DEBUG("Закрытие соединения c БД SQLite ", parameters_.name);
+  }
+  if (isDryRun()) {
+    status_ = STATUS_OK;
+    passToLogger(io_loglvl::info_logs, SQLITE_DRYRUN_LOGGER,
+                 "dry_run commit and disconect");
+    journalTransaction("COMMIT;", false);
+    flushDryRun();
+  }
+}
+
+mstatus_t DBConnectionSQLite::IsTableExists(db_table t, bool* is_exists) {
+  std::vector<std::vector<std::string>> rows;
+  if (is_status_ok(queryRows(setupTableExistsString(t).str(), &rows))
+      && !isDryRun())
+    *is_exists = !rows.empty() && rows[0][0] != "0";
+  return status_;
+}
+
+mstatus_t DBConnectionSQLite::GetTableFormat(db_table t,
+                                             db_table_create_setup* fields) {
+  std::string table_name = tables_->GetTableName(t);
+  std::vector<std::vector<std::string>> columns;
+  // cid, name, type, notnull, dflt_value, pk
+  if (!is_status_ok(queryRows(setupGetColumnsInfoString(t).str(), &columns)))
+    return status_;
+  if (isDryRun())
+    return status_;
+  if (columns.empty())
+    return setSqliteError(ERROR_DB_TABLE_EXISTS,
+                          "Таблица не существует: " + table_name);
+  fields->table = t;
+  fields->fields.clear();
+  fields->pk_string.fnames.clear();
+  fields->unique_constrains.clear();
+  const db_fields_collection* known = tables_->GetFieldsCollection(t);
+  std::map<int, std::string> pk;
+  for (const auto& col : columns) {
+    const db_variable* var = nullptr;
+    if (known) {
+      auto it = std::find_if(
+          known->begin(), known->end(),
+          [&col](const db_variable& v) { return col[1] == v.fname; });
+      if (it != known->end())
+        var = &*it;
+    }
+    // тип поля коллекции, если его класс хранения совпадает
+    //   с объявленным в базе
+    if (var && StorageClass(*var) == col[2]) {
+      fields->fields.push_back(*var);
+    } else {
+      db_variable_type type = db_variable_type::type_text;
+      if (col[2] == "INTEGER")
+        type = db_variable_type::type_long;
+      else if (col[2] == "REAL")
+        type = db_variable_type::type_real;
+      else if (col[2] == "BLOB")
+        type = db_variable_type::type_blob;
+      fields->fields.push_back(db_variable(
+          (var) ? var->fid : UNDEFINED_COLUMN,
+          (var) ? var->fname : intern_name(col[1]), type,
+          db_variable::db_variable_flags()));
+    }
+    auto& field = fields->fields.back();
+    field.flags.can_be_null = col[3] == "0";
+    field.flags.is_primary_key = col[5] != "0";
+    field.flags.has_default = !col[4].empty();
+    field.default_str = col[4];
+    if (field.flags.is_primary_key)
+      pk.emplace(std::atoi(col[5].c_str()), col[1]);
+  }
+  for (const auto& p : pk)
+    fields->pk_string.fnames.push_back(p.second);
+  // уникальные комплексы: seq, name, unique, origin, partial
+  std::vector<std::vector<std::string>> indexes;
+  if (!is_status_ok(
+          queryRows("PRAGMA index_list(" + table_name + ");", &indexes)))
+    return status_;
+  for (const auto& index : indexes) {
+    if (index.size() < 4 || index[3] != "u")
+      continue;
+    std::vector<std::vector<std::string>> info;
+    if (!is_status_ok(
+            queryRows("PRAGMA index_info(" + index[1] + ");", &info)))
+      return status_;
+    db_table_create_setup::unique_constrain uc;
+    for (const auto& i : info)
+      uc.push_back(i[2]);
+    fields->unique_constrains.push_back(uc);
+  }
+  // внешние ключи: id, seq, table, from, to, on_update, on_delete
+  std::vector<std::vector<std::string>> fkeys;
+  if (!is_status_ok(
+          queryRows("PRAGMA foreign_key_list(" + table_name + ");", &fkeys)))
+    return status_;
+  if (!fields->ref_strings)
+    fields->ref_strings = std::make_shared<db_ref_collection>();
+  fields->ref_strings->clear();
+  for (const auto& fk : fkeys)
+    fields->ref_strings->push_back(db_reference(
+        fk[3], tables_->StrToTableCode(fk[2]), fk[4], true,
+        reference_act(fk[6]), reference_act(fk[5])));
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionSQLite::CheckTableFormat(
+    const db_table_create_setup& fields) {
+  db_table_create_setup exists(fields.table);
+  if (!is_status_ok(GetTableFormat(fields.table, &exists)) || isDryRun())
+    return status_;
+  for (const auto& field : fields.fields) {
+    auto it = std::find_if(
+        exists.fields.begin(), exists.fields.end(),
+        [&field](const db_variable& v) {
+          return !strcmp(field.fname, v.fname);
+        });
+    if (it == exists.fields.end()
+        || StorageClass(*it) != StorageClass(field))
+      return setSqliteError(ERROR_DB_COL_EXISTS,
+                            "Формат столбца '" + std::string(field.fname)
+                                + "' таблицы "
+                                + tables_->GetTableName(fields.table)
+                                + " не совпадает");
+  }
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionSQLite::UpdateTable(
+    const db_table_create_setup& fields) {
+  db_table_create_setup exists(fields.table);
+  if (!is_status_ok(GetTableFormat(fields.table, &exists)) || isDryRun())
+    return status_;
+  // SQLite умеет только добавлять столбцы
+  for (const auto& field : fields.fields) {
+    bool found = std::any_of(
+        exists.fields.begin(), exists.fields.end(),
+        [&field](const db_variable& v) {
+          return !strcmp(field.fname, v.fname);
+        });
+    if (!found && !is_status_ok(execSql(
+                      setupAddColumnString({fields.table, field}).str())))
+      break;
+  }
+  return status_;
+}
+
+mstatus_t DBConnectionSQLite::CreateTable(
+    const db_table_create_setup& fields) {
+  std::string sql = setupCreateTableString(fields).str();
+  if (sql.empty())
+    return status_ = STATUS_HAVE_ERROR;
+  return execSql(sql);
+}
+
+mstatus_t DBConnectionSQLite::DropTable(const db_table_drop_setup& drop) {
+  // действия RESTRICT|CASCADE SQLite не поддерживает
+  return execSql("DROP TABLE " + tables_->GetTableName(drop.table) + ";");
+}
+
+mstatus_t DBConnectionSQLite::InsertRows(
+    const db_query_insert_setup& insert_data,
+    id_container* id_vec) {
+  std::string fnames;
+  auto cols = setupInsertColumns(insert_data, &fnames);
+  if (cols.empty())
+    return status_ = STATUS_HAVE_ERROR;
+  std::string sql = setupInsert(insert_data, cols);
+  if (dryRun(sql) || !checkConnected())
+    return status_;
+  const db_insert_batch& batch = insert_data.batch;
+  std::vector<bind_value> binds;
+  std::vector<size_t> row_cols;
+  binds.reserve(cols.size());
+  for (size_t row = 0; row < batch.RowsSize(); ++row) {
+    binds.clear();
+    row_cols.clear();
+    for (auto col : cols) {
+      if (batch.IsNull(row, col))
+        continue;
+      const db_variable& var = insert_data.fields[batch.ColumnIndex(col)];
+      binds.push_back(
+          {var.type, var.flags.is_array, batch.Value(row, col)});
+      row_cols.push_back(col);
+    }
+    // строки с отсутствующими значениями - своим запросом, чтобы
+    //   для этих столбцов сработали значения по умолчанию
+    const std::string& row_sql = (row_cols.size() == cols.size())
+                                     ? sql
+                                     : setupInsert(insert_data, row_cols);
+    sqlite3_stmt* stmt = prepare(row_sql);
+    if (stmt == nullptr || !bindValues(stmt, binds))
+      return status_;
+    sqlite3_int64 last_rowid = sqlite3_last_insert_rowid(handle_->db);
+    if (!is_status_ok(stepDone(stmt, row_sql)))
+      return status_;
+    // строка, пропущенная INSERT OR IGNORE или обновлённая по
+    //   ON CONFLICT DO UPDATE, новый id не получает
+    if (id_vec && sqlite3_changes(handle_->db) > 0
+        && sqlite3_last_insert_rowid(handle_->db) != last_rowid)
+      id_vec->id_vec.push_back(
+          static_cast<int>(sqlite3_last_insert_rowid(handle_->db)));
+  }
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionSQLite::DeleteRows(
+    const db_query_delete_setup& delete_data) {
+  std::vector<where_value> values;
+  std::string sql = "DELETE FROM " + tables_->GetTableName(delete_data.table);
+  std::string where;
+  if (!setupWhere(delete_data, &where, &values))
+    return status_ = STATUS_HAVE_ERROR;
+  if (!where.empty())
+    sql += " WHERE " + where;
+  sql += ";";
+  if (dryRun(sql) || !checkConnected())
+    return status_;
+  std::vector<bind_value> binds;
+  for (const auto& v : values)
+    binds.push_back({v.first, false, v.second});
+  sqlite3_stmt* stmt = prepare(sql);
+  if (stmt == nullptr || !bindValues(stmt, binds))
+    return status_;
+  return stepDone(stmt, sql);
+}
+
+mstatus_t DBConnectionSQLite::SelectRows(
+    const db_query_select_setup& select_data,
+    db_query_select_result* result_data) {
+  result_data->values_vec.clear();
+  std::vector<where_value> values;
+  std::string sql = "SELECT * FROM " + tables_->GetTableName(select_data.table);
+  std::string where;
+  if (!setupWhere(select_data, &where, &values))
+    return status_ = STATUS_HAVE_ERROR;
+  if (!where.empty())
+    sql += " WHERE " + where;
+  sql += ";";
+  if (dryRun(sql) || !checkConnected())
+    return status_;
+  std::vector<bind_value> binds;
+  for (const auto& v : values)
+    binds.push_back({v.first, false, v.second});
+  sqlite3_stmt* stmt = prepare(sql);
+  if (stmt == nullptr || !bindValues(stmt, binds))
+    return status_;
+  stmt_guard guard(stmt);
+  // столбцы результата по индексам полей сетапа
+  const auto& fields = select_data.fields;
+  int count = sqlite3_column_count(stmt);
+  std::vector<size_t> map(count, db_query_basesetup::field_index_end);
+  for (int i = 0; i < count; ++i) {
+    const char* name = sqlite3_column_name(stmt, i);
+    for (size_t j = 0; name && j < fields.size(); ++j)
+      if (!strcmp(name, fields[j].fname))
+        map[i] = j;
+  }
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    db_query_basesetup::row_values rval;
+    for (int i = 0; i < count; ++i) {
+      if (map[i] == db_query_basesetup::field_index_end
+          || sqlite3_column_type(stmt, i) == SQLITE_NULL)
+        continue;
+      const char* text =
+          reinterpret_cast<const char*>(sqlite3_column_text(stmt, i));
+      std::string value(text, sqlite3_column_bytes(stmt, i));
+      // логические значения в формате postgres
+      if (fields[map[i]].type == db_variable_type::type_bool)
+        value = (parse_bool(value) == 1) ? "t" : "f";
+      rval.emplace(map[i], std::move(value));
+    }
+    result_data->values_vec.push_back(std::move(rval));
+  }
+  if (rc != SQLITE_DONE)
+    return setSqliteError(ERROR_DB_SQL_QUERY, sql);
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionSQLite::UpdateRows(
+    const db_query_update_setup& update_data) {
+  if (update_data.values.empty())
+    return status_ = STATUS_OK;
+  std::vector<bind_value> binds;
+  std::string sql =
+      "UPDATE " + tables_->GetTableName(update_data.table) + " SET ";
+  for (const auto& x : update_data.values) {
+    const db_variable& var = update_data.fields[x.first];
+    sql += std::string(var.fname) + " = ?, ";
+    binds.push_back({var.type, var.flags.is_array, x.second});
+  }
+  sql.resize(sql.size() - 2);
+  std::vector<where_value> values;
+  std::string where;
+  if (!setupWhere(update_data, &where, &values))
+    return status_ = STATUS_HAVE_ERROR;
+  if (!where.empty())
+    sql += " WHERE " + where;
+  sql += ";";
+  if (dryRun(sql) || !checkConnected())
+    return status_;
+  for (const auto& v : values)
+    binds.push_back({v.first, false, v.second});
+  sqlite3_stmt* stmt = prepare(sql);
+  if (stmt == nullptr || !bindValues(stmt, binds))
+    return status_;
+  return stepDone(stmt, sql);
+}
+
+std::string DBConnectionSQLite::StorageClass(const db_variable& var) {
+  // массивы хранятся текстом в формате postgres `{a,b}`
+  if (var.flags.is_array && var.type != db_variable_type::type_char_array)
+    return "TEXT";
+  switch (var.type) {
+    case db_variable_type::type_autoinc:
+    case db_variable_type::type_bool:
+    case db_variable_type::type_short:
+    case db_variable_type::type_int:
+    case db_variable_type::type_long:
+      return "INTEGER";
+    case db_variable_type::type_real:
+      return "REAL";
+    case db_variable_type::type_blob:
+      return "BLOB";
+    case db_variable_type::type_uuid:
+    case db_variable_type::type_date:
+    case db_variable_type::type_time:
+    case db_variable_type::type_char_array:
+    case db_variable_type::type_text:
+      return "TEXT";
+    case db_variable_type::type_empty:
+    default:
+      return "";
+  }
+}
+
+bool DBConnectionSQLite::dryRun(const std::string& sql) {
+  if (!isDryRun())
+    return false;
+  status_ = STATUS_OK;
+  passToLogger(io_loglvl::info_logs, SQLITE_DRYRUN_LOGGER, "dry_run: " + sql);
+  journalStatement(sql);
+  return true;
+}
+
+bool DBConnectionSQLite::checkConnected() {
+  if (!handle_ || !is_connected_) {
+    error_.SetError(ERROR_PAIR_DEFAULT(ERROR_DB_CONNECTION));
+    status_ = STATUS_NOT;
+    return false;
+  }
+  return true;
+}
+
+mstatus_t DBConnectionSQLite::execSql(const std::string& sql) {
+  if (dryRun(sql) || !checkConnected())
+    return status_;
+  sqlite3_stmt* stmt = prepare(sql);
+  return (stmt) ? stepDone(stmt, sql) : status_;
+}
+
+sqlite3_stmt* DBConnectionSQLite::prepare(const std::string& sql) {
+  sqlite3_stmt* stmt = handle_->Prepare(sql);
+  if (stmt == nullptr)
+    setSqliteError(ERROR_DB_SQL_QUERY, sql);
+  return stmt;
+}
+
+bool DBConnectionSQLite::bindValues(sqlite3_stmt* stmt,
+                                    const std::vector<bind_value>& binds,
+                                    int first) {
+  for (size_t i = 0; i < binds.size(); ++i) {
+    int pos = first + static_cast<int>(i);
+    std::string_view v = binds[i].value;
+    int rc = SQLITE_OK;
+    bool bound = false;
+    if (binds[i].is_array
+        && binds[i].type != db_variable_type::type_char_array) {
+      // упакованный вектор -> `{a,b}`
+      std::vector<std::string> vec;
+      vector_wrapper n(vec);
+      db_variable::TranslateToVector(std::string(v), AppendOp(n));
+      std::string arr = "{";
+      for (size_t j = 0; j < vec.size(); ++j)
+        arr += (j ? "," : "") + vec[j];
+      arr += "}";
+      rc = sqlite3_bind_text(stmt, pos, arr.data(),
+                             static_cast<int>(arr.size()), SQLITE_TRANSIENT);
+      bound = true;
+    } else {
+      switch (binds[i].type) {
+        case db_variable_type::type_autoinc:
+        case db_variable_type::type_short:
+        case db_variable_type::type_int:
+        case db_variable_type::type_long: {
+          int64_t x = 0;
+          auto res = std::from_chars(v.data(), v.data() + v.size(), x);
+          if (res.ec == std::errc() && res.ptr == v.data() + v.size()) {
+            rc = sqlite3_bind_int64(stmt, pos, x);
+            bound = true;
+          }
+        } break;
+        case db_variable_type::type_bool: {
+          int b = parse_bool(v);
+          if (b >= 0) {
+            rc = sqlite3_bind_int(stmt, pos, b);
+            bound = true;
+          }
+        } break;
+        case db_variable_type::type_real: {
+          std::string s(v);
+          char* end = nullptr;
+          double d = std::strtod(s.c_str(), &end);
+          if (!s.empty() && end == s.c_str() + s.size()) {
+            rc = sqlite3_bind_double(stmt, pos, d);
+            bound = true;
+          }
+        } break;
+        case db_variable_type::type_blob:
+          rc = sqlite3_bind_blob(stmt, pos, v.data(),
+                                 static_cast<int>(v.size()), SQLITE_STATIC);
+          bound = true;
+          break;
+        default:
+          break;
+      }
+    }
+    // текст и значения, не разобранные по типу поля
+    if (!bound)
+      rc = sqlite3_bind_text(stmt, pos, v.data(), static_cast<int>(v.size()),
+                             SQLITE_STATIC);
+    if (rc != SQLITE_OK) {
+      setSqliteError(ERROR_DB_VARIABLE, sqlite3_sql(stmt));
+      return false;
+    }
+  }
+  return true;
+}
+
+mstatus_t DBConnectionSQLite::stepDone(sqlite3_stmt* stmt,
+                                       const std::string& sql) {
+  stmt_guard guard(stmt);
+  int rc = sqlite3_step(stmt);
+  if (rc != SQLITE_DONE && rc != SQLITE_ROW)
+    return setSqliteError(ERROR_DB_SQL_QUERY, sql);
+  return status_ = STATUS_OK;
+}
+
+mstatus_t DBConnectionSQLite::setSqliteError(merror_t error,
+                                             const std::string& sql) {
+  std::string msg = (handle_) ? sqlite3_errmsg(handle_->db) : "";
+  error_.SetError(error, "SQLite: " + msg + "\n Query: " + sql);
+  return status_ = STATUS_HAVE_ERROR;
+}
+
+mstatus_t DBConnectionSQLite::queryRows(
+    const std::string& sql,
+    std::vector<std::vector<std::string>>* rows) {
+  if (dryRun(sql) || !checkConnected())
+    return status_;
+  sqlite3_stmt* stmt = prepare(sql);
+  if (stmt == nullptr)
+    return status_;
+  stmt_guard guard(stmt);
+  int count = sqlite3_column_count(stmt);
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    rows->emplace_back(count);
+    for (int i = 0; i < count; ++i) {
+      const unsigned char* text = sqlite3_column_text(stmt, i);
+      if (text)
+        rows->back()[i] = reinterpret_cast<const char*>(text);
+    }
+  }
+  if (rc != SQLITE_DONE)
+    return setSqliteError(ERROR_DB_SQL_QUERY, sql);
+  return status_ = STATUS_OK;
+}
+
+bool DBConnectionSQLite::setupWhere(const db_query_select_setup& fields,
+                                    std::string* sql,
+                                    std::vector<where_value>* values) {
+  const auto& clause = fields.GetWhereTree();
+  auto root = (clause) ? clause->GetRoot() : nullptr;
+  return (root) ? whereNodeString(root.get(), false, sql, values) : true;
+}
+
+bool DBConnectionSQLite::whereNodeString(
+    const expression_node<where_node_data>* node,
+    bool braced,
+    std::string* sql,
+    std::vector<where_value>* values) {
+  if (node == nullptr)
+    return true;
+  const auto& data = node->field_data;
+  if (data.IsValue()) {
+    *sql += "?";
+    auto p = data.GetTablePair();
+    values->emplace_back(p.first, std::move(p.second));
+  } else if (data.IsOperator()) {
+    auto op = data.GetOperatorWrapper().op;
+    if (braced)
+      *sql += "(";
+    if (!whereNodeString(node->GetLeft().get(), true, sql, values))
+      return false;
+    *sql += data.GetString();
+    auto right = node->GetRight();
+    if (op == db_operator_t::op_is && right) {
+      // IS [NOT] NULL|TRUE|FALSE - не параметр
+      *sql += right->field_data.GetTablePair().second;
+    } else {
+      // границы BETWEEN `x AND y` скобками не обрамляются
+      if (!whereNodeString(right.get(), op != db_operator_t::op_between, sql,
+                           values))
+        return false;
+    }
+    if (braced)
+      *sql += ")";
+  } else if (data.IsFieldName() || data.IsRawData()) {
+    *sql += data.GetString();
+  } else {
+    error_.SetError(ERROR_DB_QUERY_SETUP,
+                    "Не обрабатываемый тип данных для where_node_data");
+    return false;
+  }
+  return true;
+}
+
+std::string DBConnectionSQLite::setupInsert(const db_query_insert_setup& fields,
+                                            const std::vector<size_t>& cols) {
+  std::string sql = (fields.on_exists == insert_on_exists_act::do_nothing)
+                        ? "INSERT OR IGNORE INTO "
+                        : "INSERT INTO ";
+  sql += tables_->GetTableName(fields.table);
+  if (cols.empty())
+    return sql + " DEFAULT VALUES;";
+  std::string params;
+  std::vector<std::string> names;
+  sql += " (";
+  for (size_t k = 0; k < cols.size(); ++k) {
+    names.push_back(fields.fields[fields.batch.ColumnIndex(cols[k])].fname);
+    sql += (k) ? ", " : "";
+    sql += names.back();
+    params += (k) ? ", ?" : "?";
+  }
+  sql += ") VALUES (" + params + ")";
+  if (fields.on_exists == insert_on_exists_act::do_update)
+    sql += setupUpsert(fields.table, names);
+  return sql + ";";
+}
+
+std::string DBConnectionSQLite::setupUpsert(
+    db_table t,
+    const std::vector<std::string>& names) {
+  // INSERT OR REPLACE удалил бы строку целиком: не переданные столбцы
+  //   получили бы значения по умолчанию, а строка - новый rowid.
+  //   Обновляются только переданные столбцы строки, совпавшей по
+  //   первичному ключу или уникальному комплексу из переданных столбцов
+  auto has = [&names](const std::string& name) {
+    return std::find(names.begin(), names.end(), trim_str(name))
+           != names.end();
+  };
+  auto covered = [&has](const std::vector<std::string>& key) {
+    return !key.empty() && std::all_of(key.begin(), key.end(), has);
+  };
+  const db_table_create_setup& setup = tables_->CreateSetupByCode(t);
+  const std::vector<std::string>* target = nullptr;
+  if (covered(setup.pk_string.fnames)) {
+    target = &setup.pk_string.fnames;
+  } else {
+    for (const auto& uc : setup.unique_constrains) {
+      if (covered(uc)) {
+        target = &uc;
+        break;
+      }
+    }
+  }
+  // без подходящего ограничения конфликт невозможно разрешить
+  //   обновлением, он останется ошибкой вставки
+  if (target == nullptr)
+    return "";
+  std::string sql = " ON CONFLICT(";
+  for (size_t i = 0; i < target->size(); ++i)
+    sql += (i ? ", " : "") + trim_str((*target)[i]);
+  sql += ") DO ";
+  std::string set;
+  for (const auto& name : names) {
+    bool in_target = std::any_of(
+        target->begin(), target->end(),
+        [&name](const std::string& k) { return trim_str(k) == name; });
+    if (!in_target)
+      set += (set.empty() ? "" : ", ") + name + " = excluded." + name;
+  }
+  return sql + ((set.empty()) ? "NOTHING" : "UPDATE SET " + set);
+}
+
+std::stringstream DBConnectionSQLite::setupTableExistsString(db_table t) {
+  std::stringstream sstr;
+  sstr << "SELECT count(*) FROM sqlite_master WHERE type = 'table' AND name = '"
+       << tables_->GetTableName(t) << "';";
+  return sstr;
+}
+
+std::stringstream DBConnectionSQLite::setupGetColumnsInfoString(db_table t) {
+  std::stringstream sstr;
+  sstr << "PRAGMA table_info(" << tables_->GetTableName(t) << ");";
+  return sstr;
+}
+
+std::stringstream DBConnectionSQLite::setupCreateTableString(
+    const db_table_create_setup& fields) {
+  std::vector<std::string> parts;
+  std::string serial;
+  for (const auto& field : fields.fields) {
+    parts.push_back(db_variable_to_string(field));
+    if (error_.GetErrorCode())
+      return std::stringstream();
+    if (field.type == db_variable_type::type_autoinc)
+      serial = field.fname;
+  }
+  for (const auto& uc : fields.unique_constrains) {
+    std::string str = "UNIQUE(";
+    for (size_t i = 0; i < uc.size(); ++i)
+      str += (i ? ", " : "") + uc[i];
+    parts.push_back(str + ")");
+  }
+  if (fields.ref_strings) {
+    for (const auto& ref : *fields.ref_strings) {
+      parts.push_back(db_reference_to_string(ref));
+      if (error_.GetErrorCode())
+        return std::stringstream();
+    }
+  }
+  const auto& pk = fields.pk_string.fnames;
+  if (serial.empty()) {
+    parts.push_back(db_primarykey_to_string(fields.pk_string));
+  } else if (!(pk.size() == 1 && trim_str(pk[0]) == serial) && !pk.empty()) {
+    // первичный ключ - поле автоинкремента, остальной сложный
+    //   ключ остаётся уникальным комплексом
+    std::string str = "UNIQUE(";
+    for (size_t i = 0; i < pk.size(); ++i)
+      str += (i ? ", " : "") + pk[i];
+    parts.push_back(str + ")");
+  }
+  std::stringstream sstr;
+  sstr << "CREATE TABLE " << tables_->GetTableName(fields.table) << " (";
+  for (size_t i = 0; i < parts.size(); ++i)
+    sstr << (i ? ", " : "") << parts[i];
+  sstr << ");";
+  return sstr;
+}
+
+std::string DBConnectionSQLite::db_variable_to_string(const db_variable& dv) {
+  std::stringstream ss;
+  merror_t ew = dv.CheckYourself();
+  if (!ew) {
+    std::string storage = StorageClass(dv);
+    if (storage.empty()) {
+      error_.SetError(ERROR_DB_VARIABLE,
+                      "Тип переменной не задан для данной имплементации БД");
+      return "";
+    }
+    ss << dv.fname << " " << storage;
+    if (dv.type == db_variable_type::type_autoinc) {
+      ss << " PRIMARY KEY AUTOINCREMENT";
+    } else {
+      if (!dv.flags.can_be_null)
+        ss << " NOT NULL";
+      if (dv.flags.has_default)
+        ss << " DEFAULT " << dv.default_str;
+    }
+  } else {
+    error_.SetError(ew, "Проверка параметров поля таблицы завершилось ошибкой");
+  }
+  return ss.str();
+}
+}  // namespace asp_db
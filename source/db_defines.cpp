@@ -31,6 +31,12 @@ std::string db_client_to_string(db_client client) {
     case db_client::FIREBIRD:
       name = "firebird";
       break;
+    case db_client::MEMORY:
+      name = "memory";
+      break;
+    case db_client::SQLITE:
+      name = "sqlite";
+      break;
     default:
       throw DBException("Неизвестный клиент БД");
   }
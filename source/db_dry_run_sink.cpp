@@ -0,0 +1,195 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_dry_run_sink.h"
+
+#include "asp_db/db_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace asp_db {
+namespace {
+/** \brief Период записи неполного пакета */
+constexpr std::chrono::milliseconds flush_interval(10);
+}  // namespace
+
+std::shared_ptr<DBDryRunSink> DBDryRunSink::Open(const std::string& path,
+                                                 size_t max_pending) {
+  static std::mutex lock;
+  static std::map<std::string, std::weak_ptr<DBDryRunSink>> sinks;
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = sinks.find(path);
+  if (it != sinks.end()) {
+    if (auto sink = it->second.lock())
+      return sink;
+  }
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  if (!file) {
+    DB_LOG_ERR("Не удалось открыть файл dry_run запросов: ", path);
+    return nullptr;
+  }
+  auto sink = std::make_shared<DBDryRunSink>(file, max_pending);
+  sinks[path] = sink;
+  return sink;
+}
+
+DBDryRunSink::DBDryRunSink(std::FILE* file, size_t max_pending)
+    : file_(file),
+      max_pending_(std::max<size_t>(max_pending, 1)),
+      head_(new node),
+      tail_(head_.load(std::memory_order_relaxed)) {
+  // пакеты уже собраны, буфер stdio только добавит копирование
+  if (file_)
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+  worker_ = std::thread(&DBDryRunSink::run, this);
+}
+
+DBDryRunSink::~DBDryRunSink() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stop_.store(true);
+  }
+  wake_cv_.notify_one();
+  if (worker_.joinable())
+    worker_.join();
+  delete tail_;
+  if (file_)
+    std::fclose(file_);
+}
+
+void DBDryRunSink::Append(std::string msg) {
+  const size_t size = msg.size() + 1;
+  const size_t before = reserve(size);
+  node* n = new node;
+  n->msg = std::move(msg);
+  push(n);
+  if (before < batch_size && before + size >= batch_size) {
+    // набрался пакет - будить поток записи до истечения периода
+    { std::lock_guard<std::mutex> guard(lock_); }
+    wake_cv_.notify_one();
+  }
+}
+
+void DBDryRunSink::Flush() {
+  // место сообщений освобождается после записи: пустая очередь
+  //   значит, что сообщения вызывающего уже записаны
+  if (pending_.load(std::memory_order_acquire) == 0)
+    return;
+  // сравнение общих счётчиков не годится: сообщения других потоков
+  //   могут быть записаны раньше сообщений вызывающего
+  auto barrier = std::make_shared<flush_barrier>();
+  node* n = new node;
+  n->barrier = barrier;
+  push(n);
+  std::unique_lock<std::mutex> guard(lock_);
+  flush_requested_.store(true);
+  wake_cv_.notify_one();
+  done_cv_.wait(guard, [this, &barrier]() {
+    return barrier->reached.load() || stop_.load();
+  });
+}
+
+uint64_t DBDryRunSink::Written() const {
+  return written_.load(std::memory_order_relaxed);
+}
+
+uint64_t DBDryRunSink::Writes() const {
+  return writes_.load(std::memory_order_relaxed);
+}
+
+size_t DBDryRunSink::reserve(size_t size) {
+  size_t pending = pending_.load(std::memory_order_relaxed);
+  while (true) {
+    // сообщение больше max_pending пишется через пустую очередь
+    if (pending != 0 && pending + size > max_pending_ && !stop_.load()) {
+      // очередь переполнена - ждём записи пакета
+      std::unique_lock<std::mutex> guard(lock_);
+      wake_cv_.notify_one();
+      done_cv_.wait(guard, [this, size]() {
+        size_t p = pending_.load();
+        return p == 0 || p + size <= max_pending_ || stop_.load();
+      });
+      pending = pending_.load(std::memory_order_relaxed);
+      continue;
+    }
+    // проверка и занятие места одним шагом, иначе одновременные
+    //   продюсеры превысили бы max_pending
+    if (pending_.compare_exchange_weak(pending, pending + size,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed))
+      return pending;
+  }
+}
+
+void DBDryRunSink::push(node* n) {
+  node* prev = head_.exchange(n, std::memory_order_acq_rel);
+  prev->next.store(n, std::memory_order_release);
+}
+
+void DBDryRunSink::run() {
+  std::string batch;
+  batch.reserve(2 * batch_size);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(lock_);
+      wake_cv_.wait_for(guard, flush_interval, [this]() {
+        return stop_.load() || flush_requested_.load() ||
+               pending_.load() >= batch_size;
+      });
+      flush_requested_.store(false);
+    }
+    const bool stop = stop_.load();
+    drain(&batch);
+    write(&batch);
+    // при остановке дописываем всё, что успели добавить
+    if (stop && !tail_->next.load(std::memory_order_acquire))
+      break;
+  }
+}
+
+void DBDryRunSink::drain(std::string* batch) {
+  node* next = tail_->next.load(std::memory_order_acquire);
+  while (next) {
+    if (next->barrier) {
+      // сообщения перед меткой записываются до её снятия
+      write(batch);
+      next->barrier->reached.store(true);
+      next->barrier.reset();
+      { std::lock_guard<std::mutex> guard(lock_); }
+      done_cv_.notify_all();
+    } else {
+      batch->append(next->msg);
+      batch->push_back('\n');
+      // узел становится заглушкой, его сообщение больше не нужно
+      std::string().swap(next->msg);
+    }
+    delete tail_;
+    tail_ = next;
+    if (batch->size() >= batch_size)
+      write(batch);
+    next = tail_->next.load(std::memory_order_acquire);
+  }
+}
+
+void DBDryRunSink::write(std::string* batch) {
+  if (batch->empty())
+    return;
+  if (file_ && std::fwrite(batch->data(), 1, batch->size(), file_)
+                   != batch->size())
+    DB_LOG_ERR("Ошибка записи файла dry_run запросов");
+  written_.fetch_add(batch->size(), std::memory_order_relaxed);
+  writes_.fetch_add(1, std::memory_order_relaxed);
+  pending_.fetch_sub(batch->size());
+  batch->clear();
+  { std::lock_guard<std::mutex> guard(lock_); }
+  done_cv_.notify_all();
+}
+}  // namespace asp_db
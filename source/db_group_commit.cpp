@@ -0,0 +1,40 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_group_commit.h"
+
+#include <algorithm>
+
+namespace asp_db {
+namespace {
+db_group_commit_parameters normalize(db_group_commit_parameters parameters) {
+  parameters.max_rows = std::max<size_t>(parameters.max_rows, 1);
+  return parameters;
+}
+}  // namespace
+
+DBGroupCommit::DBGroupCommit(const db_group_commit_parameters& parameters)
+    : parameters_(normalize(parameters)) {}
+
+uint64_t DBGroupCommit::Groups() const {
+  return groups_.load(std::memory_order_relaxed);
+}
+
+uint64_t DBGroupCommit::Rows() const {
+  return rows_.load(std::memory_order_relaxed);
+}
+
+void DBGroupCommit::close(db_table table, group* g) {
+  g->closed = true;
+  auto it = open_.find(table);
+  if (it != open_.end() && it->second.get() == g)
+    open_.erase(it);
+  g->cv.notify_all();
+}
+}  // namespace asp_db
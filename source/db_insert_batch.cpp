@@ -0,0 +1,89 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_insert_batch.h"
+
+#include <assert.h>
+
+namespace asp_db {
+bool db_insert_batch::SetColumns(const std::vector<field_index>& columns) {
+  if (rows_ || cell_)
+    return false;
+  columns_.clear();
+  columns_.resize(columns.size());
+  for (size_t i = 0; i < columns.size(); ++i)
+    columns_[i].index = columns[i];
+  has_columns_ = true;
+  if (reserved_)
+    Reserve(reserved_);
+  return true;
+}
+
+void db_insert_batch::Reserve(size_t rows) {
+  reserved_ = rows;
+  for (auto& c : columns_) {
+    c.ends.reserve(rows);
+    c.nulls.reserve((rows + 63) / 64);
+  }
+}
+
+void db_insert_batch::Append(std::string_view value) {
+  append(value, false);
+}
+
+void db_insert_batch::AppendNull() {
+  append(std::string_view(), true);
+}
+
+void db_insert_batch::CommitRow() {
+  while (cell_ < columns_.size())
+    AppendNull();
+  cell_ = 0;
+  if (++rows_ == 1 && reserved_ > 1) {
+    // оценить размер арен по первой строке
+    for (auto& c : columns_)
+      c.arena.reserve(c.arena.size() * reserved_);
+  }
+}
+
+void db_insert_batch::Clear() {
+  for (auto& c : columns_) {
+    c.arena.clear();
+    c.ends.clear();
+    c.nulls.clear();
+    c.null_count = 0;
+  }
+  rows_ = 0;
+  cell_ = 0;
+}
+
+db_insert_batch::row_values db_insert_batch::Row(size_t row) const {
+  row_values values;
+  for (size_t col = 0; col < columns_.size(); ++col)
+    if (!IsNull(row, col))
+      values.emplace(columns_[col].index, std::string(Value(row, col)));
+  return values;
+}
+
+void db_insert_batch::append(std::string_view value, bool is_null) {
+  assert(cell_ < columns_.size() && "db_insert_batch: row overflow");
+  if (cell_ >= columns_.size())
+    return;
+  column& c = columns_[cell_++];
+  if ((rows_ & 63) == 0)
+    c.nulls.push_back(0);
+  if (is_null) {
+    c.nulls.back() |= uint64_t(1) << (rows_ & 63);
+    ++c.null_count;
+  } else {
+    c.arena.append(value.data(), value.size());
+  }
+  c.ends.push_back(c.arena.size());
+}
+}  // namespace asp_db
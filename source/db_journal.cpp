@@ -0,0 +1,158 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_journal.h"
+
+#include "asp_db/db_log.h"
+
+#include <cstring>
+#include <map>
+
+namespace asp_db {
+namespace {
+const char journal_magic[] = "ASPDBJ01";
+constexpr size_t journal_magic_size = sizeof(journal_magic) - 1;
+/** \brief Ограничение длины запроса при чтении повреждённого журнала */
+constexpr uint64_t max_sql_size = 256 * 1024 * 1024;
+
+/**
+ * \brief Дописать `value` в формате varint(LEB128)
+ * \return Количество байт
+ * */
+size_t put_varint(uint64_t value, unsigned char* out) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = static_cast<unsigned char>(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = static_cast<unsigned char>(value);
+  return n;
+}
+}  // namespace
+
+/* DBJournalWriter */
+std::shared_ptr<DBJournalWriter> DBJournalWriter::Open(
+    const std::string& path) {
+  static std::mutex lock;
+  static std::map<std::string, std::weak_ptr<DBJournalWriter>> journals;
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = journals.find(path);
+  if (it != journals.end()) {
+    if (auto journal = it->second.lock())
+      return journal;
+  }
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    DB_LOG_ERR("Не удалось открыть файл журнала запросов: ", path);
+    return nullptr;
+  }
+  auto journal = std::make_shared<DBJournalWriter>(file);
+  journals[path] = journal;
+  return journal;
+}
+
+DBJournalWriter::DBJournalWriter(std::FILE* file)
+    : file_(file), start_(std::chrono::steady_clock::now()) {
+  if (file_)
+    std::fwrite(journal_magic, 1, journal_magic_size, file_);
+}
+
+DBJournalWriter::~DBJournalWriter() {
+  if (file_)
+    std::fclose(file_);
+}
+
+uint32_t DBJournalWriter::NextConnectionId() {
+  return connections_.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void DBJournalWriter::Append(uint32_t connection_id, const std::string& sql) {
+  unsigned char head[30];
+  std::lock_guard<std::mutex> guard(lock_);
+  // время берётся под блокировкой, чтобы приращения не были отрицательными
+  uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start_)
+                        .count();
+  size_t n = put_varint(now_us - last_us_, head);
+  n += put_varint(connection_id, head + n);
+  n += put_varint(sql.size(), head + n);
+  last_us_ = now_us;
+  if (file_) {
+    std::fwrite(head, 1, n, file_);
+    std::fwrite(sql.data(), 1, sql.size(), file_);
+  }
+}
+
+void DBJournalWriter::Flush() {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (file_ && std::fflush(file_))
+    DB_LOG_ERR("Ошибка записи журнала запросов");
+}
+
+/* DBJournalReader */
+DBJournalReader::DBJournalReader(const std::string& path)
+    : file_(std::fopen(path.c_str(), "rb")) {
+  char magic[journal_magic_size];
+  is_open_ = file_ &&
+             std::fread(magic, 1, journal_magic_size, file_) ==
+                 journal_magic_size &&
+             !memcmp(magic, journal_magic, journal_magic_size);
+}
+
+DBJournalReader::~DBJournalReader() {
+  if (file_)
+    std::fclose(file_);
+}
+
+bool DBJournalReader::IsOpen() const {
+  return is_open_;
+}
+
+bool DBJournalReader::Next(db_journal_record* record) {
+  if (!is_open_ || is_corrupted_)
+    return false;
+  int c = std::fgetc(file_);
+  if (c == EOF)
+    return false;
+  std::ungetc(c, file_);
+  uint64_t delta = 0, connection_id = 0, size = 0;
+  if (!readVarint(&delta) || !readVarint(&connection_id) ||
+      !readVarint(&size) || connection_id > UINT32_MAX ||
+      size > max_sql_size) {
+    is_corrupted_ = true;
+    return false;
+  }
+  record->sql.resize(size);
+  if (size && std::fread(&record->sql[0], 1, size, file_) != size) {
+    is_corrupted_ = true;
+    return false;
+  }
+  time_us_ += delta;
+  record->time_us = time_us_;
+  record->connection_id = static_cast<uint32_t>(connection_id);
+  return true;
+}
+
+bool DBJournalReader::IsCorrupted() const {
+  return is_corrupted_;
+}
+
+bool DBJournalReader::readVarint(uint64_t* value) {
+  *value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    int c = std::fgetc(file_);
+    if (c == EOF)
+      return false;
+    *value |= uint64_t(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+  }
+  return false;
+}
+}  // namespace asp_db
@@ -0,0 +1,407 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_metrics.h"
+
+#include "asp_db/db_tables.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace asp_db {
+namespace {
+/**
+ * \brief Гистограмма этапа в потоке-владельце
+ * */
+struct thread_histogram {
+  std::array<std::atomic<uint64_t>, db_metric_histogram::buckets_count>
+      buckets{};
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> sum_ns{0};
+  std::atomic<uint64_t> max_ns{0};
+  std::atomic<uint64_t> errors{0};
+};
+
+/**
+ * \brief Гистограммы одного потока
+ * */
+struct thread_shard {
+  /**
+   * \brief Мьютекс на изменение набора ключей, записи значений
+   *   в существующие гистограммы идут без него
+   * */
+  std::mutex lock;
+  std::unordered_map<uint64_t, std::unique_ptr<thread_histogram>> values;
+};
+
+/**
+ * \brief Реестр гистограмм всех потоков
+ * */
+struct metrics_registry {
+  std::atomic<bool> enabled{false};
+  /**
+   * \brief Мьютекс на набор потоков, снятие снимка и обнуление
+   * */
+  std::mutex lock;
+  std::vector<std::shared_ptr<thread_shard>> shards;
+  /**
+   * \brief Суммы гистограмм завершившихся потоков
+   * */
+  thread_shard retired;
+};
+
+metrics_registry& registry() {
+  static metrics_registry r;
+  return r;
+}
+
+/**
+ * \brief Операция и таблица замеров текущего потока
+ * */
+thread_local db_metric_op current_op = db_metric_op::none;
+thread_local db_table current_table = UNDEFINED_TABLE;
+
+/**
+ * \brief Добавить значения гистограммы `from` к `to`
+ * */
+void merge_histogram(thread_histogram* to, const thread_histogram& from) {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  for (size_t i = 0; i < from.buckets.size(); ++i)
+    to->buckets[i].fetch_add(from.buckets[i].load(relaxed), relaxed);
+  to->count.fetch_add(from.count.load(relaxed), relaxed);
+  to->sum_ns.fetch_add(from.sum_ns.load(relaxed), relaxed);
+  uint64_t max_ns = from.max_ns.load(relaxed);
+  if (to->max_ns.load(relaxed) < max_ns)
+    to->max_ns.store(max_ns, relaxed);
+  to->errors.fetch_add(from.errors.load(relaxed), relaxed);
+}
+
+/**
+ * \brief Гистограммы текущего потока, при завершении потока
+ *   суммируются в metrics_registry::retired и удаляются из реестра
+ * */
+struct local_shard_holder {
+  std::shared_ptr<thread_shard> shard;
+
+ public:
+  local_shard_holder() : shard(std::make_shared<thread_shard>()) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    r.shards.push_back(shard);
+  }
+  ~local_shard_holder() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    for (const auto& v : shard->values) {
+      auto& h = r.retired.values[v.first];
+      if (!h)
+        h = std::make_unique<thread_histogram>();
+      merge_histogram(h.get(), *v.second);
+    }
+    r.shards.erase(std::find(r.shards.begin(), r.shards.end(), shard));
+  }
+};
+
+thread_shard& local_shard() {
+  thread_local local_shard_holder holder;
+  return *holder.shard;
+}
+
+uint64_t pack_key(const db_metric_key& key) {
+  return (uint64_t(key.op) << 40) | (uint64_t(key.stage) << 32) | key.table;
+}
+
+db_metric_key unpack_key(uint64_t key) {
+  return db_metric_key{db_metric_op((key >> 40) & 0xff),
+                       db_metric_stage((key >> 32) & 0xff),
+                       db_table(key & 0xffffffff)};
+}
+
+inline int highest_bit(uint64_t w) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(w);
+#else
+  int i = 0;
+  for (; w >>= 1;)
+    ++i;
+  return i;
+#endif  // __GNUC__
+}
+
+/**
+ * \brief Границы корзин вывода Prometheus, секунды
+ * */
+const std::array<double, 15> prometheus_bounds = {
+    1e-6, 5e-6, 1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3,
+    1e-2, 5e-2, 0.1,  0.5,  1.0,  5.0,  10.0};
+}  // namespace
+
+const char* db_metric_op_to_string(db_metric_op op) {
+  switch (op) {
+    case db_metric_op::none:
+      return "none";
+    case db_metric_op::is_table_exists:
+      return "is_table_exists";
+    case db_metric_op::create_table:
+      return "create_table";
+    case db_metric_op::get_table_format:
+      return "get_table_format";
+    case db_metric_op::update_table_format:
+      return "update_table_format";
+    case db_metric_op::insert_rows:
+      return "insert_rows";
+    case db_metric_op::select_rows:
+      return "select_rows";
+    case db_metric_op::delete_rows:
+      return "delete_rows";
+    case db_metric_op::count:
+    default:
+      return "unknown";
+  }
+}
+
+const char* db_metric_stage_to_string(db_metric_stage stage) {
+  switch (stage) {
+    case db_metric_stage::total:
+      return "total";
+    case db_metric_stage::clone_connection:
+      return "clone_connection";
+    case db_metric_stage::connect:
+      return "connect";
+    case db_metric_stage::save_point:
+      return "save_point";
+    case db_metric_stage::execute:
+      return "execute";
+    case db_metric_stage::close_connection:
+      return "close_connection";
+    case db_metric_stage::rollback:
+      return "rollback";
+    case db_metric_stage::statement_build:
+      return "statement_build";
+    case db_metric_stage::server_exec:
+      return "server_exec";
+    case db_metric_stage::result_decode:
+      return "result_decode";
+    case db_metric_stage::set_select_data:
+      return "set_select_data";
+    case db_metric_stage::count:
+    default:
+      return "unknown";
+  }
+}
+
+/* db_metric_key */
+bool db_metric_key::operator<(const db_metric_key& r) const {
+  return pack_key(*this) < pack_key(r);
+}
+
+/* db_metric_histogram */
+size_t db_metric_histogram::BucketIndex(uint64_t ns) {
+  if (ns < 16)
+    return ns;
+  // номер старшего бита и 4 следующих за ним бита
+  int e = highest_bit(ns);
+  if (e > 47)
+    return buckets_count - 1;
+  return (e - 3) * 16 + ((ns >> (e - 4)) & 15);
+}
+
+uint64_t db_metric_histogram::BucketUpperBound(size_t index) {
+  if (index < 16)
+    return index;
+  int e = int(index / 16) + 3;
+  uint64_t lower = (16 + index % 16) << (e - 4);
+  return lower + (uint64_t(1) << (e - 4)) - 1;
+}
+
+uint64_t db_metric_histogram::Percentile(double q) const {
+  if (count == 0 || buckets.empty())
+    return 0;
+  uint64_t rank = static_cast<uint64_t>(q * count + 0.5);
+  rank = std::clamp<uint64_t>(rank, 1, count);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return std::min(BucketUpperBound(i), max_ns);
+  }
+  return max_ns;
+}
+
+/* db_metrics_snapshot */
+std::string db_metrics_snapshot::ToPrometheus(const IDBTables* tables) const {
+  std::stringstream ss;
+  ss << "# HELP asp_db_stage_duration_seconds Duration of database "
+        "operation stages\n"
+     << "# TYPE asp_db_stage_duration_seconds histogram\n";
+  auto labels = [tables](const db_metric_key& key) {
+    std::string table = (tables && key.table != UNDEFINED_TABLE)
+                            ? tables->GetTableName(key.table)
+                            : std::to_string(key.table);
+    return std::string("op=\"") + db_metric_op_to_string(key.op)
+           + "\",stage=\"" + db_metric_stage_to_string(key.stage)
+           + "\",table=\"" + table + "\"";
+  };
+  for (const auto& v : values) {
+    const auto& h = v.second;
+    std::string l = labels(v.first);
+    // корзины HdrHistogram сворачиваются в фиксированные границы
+    size_t i = 0;
+    uint64_t cumulative = 0;
+    for (double bound : prometheus_bounds) {
+      uint64_t bound_ns = static_cast<uint64_t>(bound * 1e9);
+      for (; i < h.buckets.size()
+             && db_metric_histogram::BucketUpperBound(i) <= bound_ns;
+           ++i)
+        cumulative += h.buckets[i];
+      ss << "asp_db_stage_duration_seconds_bucket{" << l << ",le=\"" << bound
+         << "\"} " << cumulative << "\n";
+    }
+    ss << "asp_db_stage_duration_seconds_bucket{" << l << ",le=\"+Inf\"} "
+       << h.count << "\n"
+       << "asp_db_stage_duration_seconds_sum{" << l << "} "
+       << h.sum_ns * 1e-9 << "\n"
+       << "asp_db_stage_duration_seconds_count{" << l << "} " << h.count
+       << "\n";
+  }
+  ss << "# HELP asp_db_stage_errors_total Database operation stages "
+        "finished with error\n"
+     << "# TYPE asp_db_stage_errors_total counter\n";
+  for (const auto& v : values)
+    ss << "asp_db_stage_errors_total{" << labels(v.first) << "} "
+       << v.second.errors << "\n";
+  return ss.str();
+}
+
+/* DBMetrics::Scope */
+DBMetrics::Scope::Scope(db_metric_op op, db_table table)
+    : prev_op_(current_op), prev_table_(current_table) {
+  current_op = op;
+  current_table = table;
+}
+
+DBMetrics::Scope::~Scope() {
+  current_op = prev_op_;
+  current_table = prev_table_;
+}
+
+/* DBMetrics::Timer */
+DBMetrics::Timer::Timer(db_metric_stage stage)
+    : stage_(stage), active_(IsEnabled()) {
+  if (active_)
+    start_ = std::chrono::steady_clock::now();
+}
+
+DBMetrics::Timer::~Timer() {
+  Finish();
+}
+
+void DBMetrics::Timer::Finish(bool ok) {
+  if (!active_)
+    return;
+  active_ = false;
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_)
+                .count();
+  Record(stage_, static_cast<uint64_t>(ns), ok);
+}
+
+/* DBMetrics */
+void DBMetrics::SetEnabled(bool enabled) {
+  registry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool DBMetrics::IsEnabled() {
+  return registry().enabled.load(std::memory_order_relaxed);
+}
+
+void DBMetrics::Record(db_metric_stage stage, uint64_t ns, bool ok) {
+  Record(db_metric_key{current_op, stage, current_table}, ns, ok);
+}
+
+void DBMetrics::Record(const db_metric_key& key, uint64_t ns, bool ok) {
+  if (!IsEnabled())
+    return;
+  thread_shard& shard = local_shard();
+  uint64_t k = pack_key(key);
+  // набор ключей меняет только поток-владелец, поэтому поиск
+  //   без блокировки
+  auto it = shard.values.find(k);
+  if (it == shard.values.end()) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    it = shard.values.emplace(k, std::make_unique<thread_histogram>()).first;
+  }
+  thread_histogram& h = *it->second;
+  constexpr auto relaxed = std::memory_order_relaxed;
+  h.buckets[db_metric_histogram::BucketIndex(ns)].fetch_add(1, relaxed);
+  h.count.fetch_add(1, relaxed);
+  h.sum_ns.fetch_add(ns, relaxed);
+  if (h.max_ns.load(relaxed) < ns)
+    h.max_ns.store(ns, relaxed);
+  if (!ok)
+    h.errors.fetch_add(1, relaxed);
+}
+
+db_metrics_snapshot DBMetrics::Snapshot() {
+  // под мьютексом реестра: завершающийся поток не переносит свои
+  //   гистограммы в retired посреди снятия снимка
+  auto& r = registry();
+  std::lock_guard<std::mutex> registry_lock(r.lock);
+  constexpr auto relaxed = std::memory_order_relaxed;
+  db_metrics_snapshot snapshot;
+  auto add_shard = [&snapshot](thread_shard& shard) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    for (const auto& v : shard.values) {
+      auto& h = snapshot.values[unpack_key(v.first)];
+      if (h.buckets.empty())
+        h.buckets.resize(db_metric_histogram::buckets_count);
+      const thread_histogram& th = *v.second;
+      for (size_t i = 0; i < h.buckets.size(); ++i)
+        h.buckets[i] += th.buckets[i].load(relaxed);
+      h.count += th.count.load(relaxed);
+      h.sum_ns += th.sum_ns.load(relaxed);
+      h.max_ns = std::max(h.max_ns, th.max_ns.load(relaxed));
+      h.errors += th.errors.load(relaxed);
+    }
+  };
+  for (const auto& shard : r.shards)
+    add_shard(*shard);
+  add_shard(r.retired);
+  return snapshot;
+}
+
+size_t DBMetrics::ThreadsCount() {
+  std::lock_guard<std::mutex> lock(registry().lock);
+  return registry().shards.size();
+}
+
+void DBMetrics::Reset() {
+  auto& r = registry();
+  std::lock_guard<std::mutex> registry_lock(r.lock);
+  constexpr auto relaxed = std::memory_order_relaxed;
+  std::vector<thread_shard*> shards{&r.retired};
+  for (const auto& shard : r.shards)
+    shards.push_back(shard.get());
+  for (auto* shard : shards) {
+    std::lock_guard<std::mutex> lock(shard->lock);
+    for (const auto& v : shard->values) {
+      thread_histogram& h = *v.second;
+      for (auto& b : h.buckets)
+        b.store(0, relaxed);
+      h.count.store(0, relaxed);
+      h.sum_ns.store(0, relaxed);
+      h.max_ns.store(0, relaxed);
+      h.errors.store(0, relaxed);
+    }
+  }
+}
+}  // namespace asp_db
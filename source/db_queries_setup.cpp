@@ -10,6 +10,7 @@
 #include "asp_db/db_queries_setup.h"
 
 #include "asp_db/db_connection_manager.h"
+#include "asp_db/db_table_schema.h"
 #include "asp_db/db_tables.h"
 
 #include "asp_utils/Logging.h"
@@ -142,6 +143,10 @@ db_query_basesetup::db_query_basesetup(db_table table,
 
 db_query_basesetup::field_index db_query_basesetup::IndexByFieldId(
     db_variable_id fid) {
+  if (fields_index) {
+    size_t i = fields_index->IndexOf(fid);
+    return (i < fields.size()) ? i : db_query_basesetup::field_index_end;
+  }
   field_index i = 0;
   for (auto const& x : fields) {
     if (x.fid == fid)
@@ -159,23 +164,25 @@ db_query_insert_setup::db_query_insert_setup(
 
 std::shared_ptr<DBWhereClause<where_node_data>>
 db_query_insert_setup::InitInsertTree() {
-  if (values_vec.empty())
+  if (batch.Empty())
     return nullptr;
   std::shared_ptr<DBWhereClause<where_node_data>> clause = nullptr;
   std::vector<std::shared_ptr<expression_node<where_node_data>>> source;
-  source.reserve(values_vec[0].size());
-  const auto& row = values_vec[0];
-  for (const auto& x : row) {
+  source.reserve(batch.ColumnsSize());
+  for (size_t col = 0; col < batch.ColumnsSize(); ++col) {
     // инициализировать все 3х элементные поддеревья типа
     //             EQ
     //            /  \       -->   `$fname EQ $value`
     //        fname  value
     // и записать их в контейнер
-    auto i = x.first;
+    auto i = batch.ColumnIndex(col);
+    if (batch.IsNull(0, col))
+      continue;
     if (i != db_query_basesetup::field_index_end && i < fields.size()) {
       auto& f = fields[i];
       auto node = where_node_creator<db_operator_t::op_eq>::create(
-          std::string(f.fname), where_table_pair(f.type, x.second));
+          std::string(f.fname),
+          where_table_pair(f.type, std::string(batch.Value(0, col))));
       if (node.get())
         source.push_back(node);
     }
@@ -34,21 +34,29 @@ mstatus_t DBQuery::Execute() {
       status_ = exec();
       is_performed_ = true;
     } else {
-      if (IS_DEBUG_MODE)
-        Logging::Append("not default status of query '" + q_info() + "'");
+      DB_LOG_DEBUG("not default status of query '", q_info(), "'");
     }
   } else {
     status_ = STATUS_HAVE_ERROR;
-    Logging::Append(ERROR_DB_QUERY_SETUP, "Execute setup connection query");
+    DB_LOG_ERROR(ERROR_DB_QUERY_SETUP, "Execute setup connection query");
   }
   return status_;
 }
 
 void DBQuery::unExecute() {}
 
+std::string DBQuery::GetInfo() {
+  return q_info();
+}
+
+db_metric_stage DBQuery::MetricStage() const {
+  return db_metric_stage::execute;
+}
+
 /* DBQuerySetupConnection */
-DBQuerySetupConnection::DBQuerySetupConnection(DBConnection* db_ptr)
-    : DBQuery(db_ptr) {}
+DBQuerySetupConnection::DBQuerySetupConnection(DBConnection* db_ptr,
+                                               bool read_only)
+    : DBQuery(db_ptr), read_only_(read_only) {}
 
 void DBQuerySetupConnection::unExecute() {
   if (db_ptr_)
@@ -56,11 +64,16 @@ void DBQuerySetupConnection::unExecute() {
 }
 
 mstatus_t DBQuerySetupConnection::exec() {
+  db_ptr_->SetReadOnly(read_only_);
   return db_ptr_->SetupConnection();
 }
 
+db_metric_stage DBQuerySetupConnection::MetricStage() const {
+  return db_metric_stage::connect;
+}
+
 std::string DBQuerySetupConnection::q_info() {
-  return "SetupConnection";
+  return read_only_ ? "SetupConnection(read only)" : "SetupConnection";
 }
 
 /* DBQueryCloseConnection */
@@ -73,7 +86,7 @@ mstatus_t DBQueryCloseConnection::Execute() {
     status_ = STATUS_OK;
   } else {
     status_ = STATUS_HAVE_ERROR;
-    Logging::Append(ERROR_DB_QUERY_SETUP, "Execute close connection query");
+    DB_LOG_ERROR(ERROR_DB_QUERY_SETUP, "Execute close connection query");
   }
   return status_;
 }
@@ -83,6 +96,10 @@ mstatus_t DBQueryCloseConnection::exec() {
   return STATUS_NOT;
 }
 
+db_metric_stage DBQueryCloseConnection::MetricStage() const {
+  return db_metric_stage::close_connection;
+}
+
 std::string DBQueryCloseConnection::q_info() {
   return "CloseConnection";
 }
@@ -100,6 +117,10 @@ mstatus_t DBQueryAddSavePoint::exec() {
   return db_ptr_->AddSavePoint(save_point);
 }
 
+db_metric_stage DBQueryAddSavePoint::MetricStage() const {
+  return db_metric_stage::save_point;
+}
+
 std::string DBQueryAddSavePoint::q_info() {
   return "AddSavePoint";
 }
@@ -0,0 +1,127 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_query_cache.h"
+
+namespace asp_db {
+DBQueryCache::DBQueryCache(const db_query_cache_parameters& parameters)
+    : parameters_(parameters) {}
+
+std::string DBQueryCache::MakeKey(const db_query_select_setup& setup) {
+  std::string key = std::to_string(setup.table) + "|";
+  if (setup.IsActToAll()) {
+    key += "*";
+  } else {
+    auto where = setup.GetWhereString();
+    key += where.has_value() ? where.value() : std::string();
+  }
+  // проекция - все поля таблицы из коллекции сетапа
+  key += "|";
+  for (const auto& field : setup.fields) {
+    key += field.fname;
+    key += ",";
+  }
+  return key;
+}
+
+bool DBQueryCache::Get(const db_query_select_setup& setup,
+                       db_query_select_result* result) {
+  std::string key = MakeKey(setup);
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = index_.find(key);
+  if (it == index_.end())
+    return false;
+  if (it->second->expire < clock::now()) {
+    erase(it->second);
+    return false;
+  }
+  // переместить запись в начало списка
+  entries_.splice(entries_.begin(), entries_, it->second);
+  result->values_vec = it->second->rows;
+  return true;
+}
+
+uint64_t DBQueryCache::Generation(db_table table) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = generations_.find(table);
+  return (it != generations_.end()) ? it->second : 0;
+}
+
+void DBQueryCache::Put(const db_query_select_setup& setup,
+                       const db_query_select_result& result,
+                       uint64_t generation) {
+  std::string key = MakeKey(setup);
+  size_t size = key.size() + sizeof(cache_entry) + rowsSize(result.values_vec);
+  std::lock_guard<std::mutex> lock(lock_);
+  auto gen = generations_.find(setup.table);
+  if (gen != generations_.end() && gen->second != generation)
+    return;
+  if (auto it = index_.find(key); it != index_.end())
+    erase(it->second);
+  if (size > parameters_.memory_budget)
+    return;
+  evict(size);
+  entries_.push_front(cache_entry{key, setup.table, result.values_vec, size,
+                                  clock::now() + parameters_.ttl});
+  index_.emplace(std::move(key), entries_.begin());
+  memory_usage_ += size;
+}
+
+void DBQueryCache::InvalidateTable(db_table table) {
+  std::lock_guard<std::mutex> lock(lock_);
+  ++generations_[table];
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto next = std::next(it);
+    if (it->table == table)
+      erase(it);
+    it = next;
+  }
+}
+
+void DBQueryCache::Clear() {
+  std::lock_guard<std::mutex> lock(lock_);
+  index_.clear();
+  entries_.clear();
+  memory_usage_ = 0;
+}
+
+size_t DBQueryCache::Size() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return entries_.size();
+}
+
+size_t DBQueryCache::MemoryUsage() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return memory_usage_;
+}
+
+size_t DBQueryCache::rowsSize(const rows_container& rows) {
+  // примерная оценка: узлы std::map и буферы строк
+  size_t size = rows.capacity() * sizeof(db_query_basesetup::row_values);
+  for (const auto& row : rows) {
+    size += row.size() * (sizeof(db_query_basesetup::row_values::value_type) +
+                          4 * sizeof(void*));
+    for (const auto& value : row)
+      size += value.second.capacity();
+  }
+  return size;
+}
+
+void DBQueryCache::erase(lru_list::iterator it) {
+  memory_usage_ -= it->size;
+  index_.erase(it->key);
+  entries_.erase(it);
+}
+
+void DBQueryCache::evict(size_t required) {
+  while (!entries_.empty() &&
+         memory_usage_ + required > parameters_.memory_budget)
+    erase(std::prev(entries_.end()));
+}
+}  // namespace asp_db
@@ -0,0 +1,285 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_query_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+#include <ctype.h>
+
+namespace asp_db {
+namespace {
+bool is_ident(char c) {
+  return isalnum(static_cast<unsigned char>(c)) || c == '_'
+         || static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool ends_with(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size()
+         && !str.compare(str.size() - suffix.size(), suffix.size(), suffix);
+}
+
+/**
+ * \brief Добавить параметр `?`, список `?, ?` свернуть в `?`
+ * */
+void append_param(std::string* out) {
+  if (ends_with(*out, "?, "))
+    out->resize(out->size() - 2);
+  else if (ends_with(*out, "?,"))
+    out->resize(out->size() - 1);
+  else
+    *out += '?';
+}
+
+/**
+ * \brief Свернуть только что закрытую группу `(...)`, если она
+ *   повторяет предыдущую: `(?), (?)` -> `(?)`
+ * */
+void collapse_group(std::string* out) {
+  int depth = 0;
+  size_t start = out->size();
+  while (start > 0) {
+    char c = (*out)[--start];
+    if (c == ')')
+      ++depth;
+    else if (c == '(' && --depth == 0)
+      break;
+  }
+  if (depth != 0)
+    return;
+  std::string group = out->substr(start);
+  std::string prefix = out->substr(0, start);
+  if (ends_with(prefix, group + ", "))
+    out->resize(start - 2);
+  else if (ends_with(prefix, group + ","))
+    out->resize(start - 1);
+}
+
+uint64_t stat_key(const db_query_stat& s, db_query_stats_order order) {
+  switch (order) {
+    case db_query_stats_order::mean_time:
+      return s.MeanNs();
+    case db_query_stats_order::max_time:
+      return s.max_ns;
+    case db_query_stats_order::calls:
+      return s.calls;
+    case db_query_stats_order::rows:
+      return s.rows;
+    case db_query_stats_order::bytes:
+      return s.bytes;
+    case db_query_stats_order::total_time:
+    default:
+      return s.total_ns;
+  }
+}
+}  // namespace
+
+std::string db_query_normalize(const std::string& sql) {
+  std::string out;
+  out.reserve(sql.size());
+  bool space = false;
+  for (size_t i = 0; i < sql.size();) {
+    char c = sql[i];
+    if (isspace(static_cast<unsigned char>(c))) {
+      space = true;
+      ++i;
+      continue;
+    }
+    if (space && !out.empty())
+      out += ' ';
+    space = false;
+    if (c == '\'') {
+      // строка, `''` внутри - экранированная кавычка
+      for (++i; i < sql.size(); ++i) {
+        if (sql[i] == '\'') {
+          if (i + 1 < sql.size() && sql[i + 1] == '\'')
+            ++i;
+          else
+            break;
+        }
+      }
+      ++i;
+      append_param(&out);
+    } else if (c == '"') {
+      // идентификатор в кавычках копируется как есть
+      size_t end = sql.find('"', i + 1);
+      end = (end == std::string::npos) ? sql.size() : end + 1;
+      out.append(sql, i, end - i);
+      i = end;
+    } else if (isdigit(static_cast<unsigned char>(c))
+               && (out.empty() || !is_ident(out.back()))) {
+      while (i < sql.size()
+             && (isdigit(static_cast<unsigned char>(sql[i])) || sql[i] == '.'))
+        ++i;
+      if (i < sql.size() && (sql[i] == 'e' || sql[i] == 'E')) {
+        size_t j = i + 1;
+        if (j < sql.size() && (sql[j] == '+' || sql[j] == '-'))
+          ++j;
+        if (j < sql.size() && isdigit(static_cast<unsigned char>(sql[j]))) {
+          for (i = j; i < sql.size()
+                      && isdigit(static_cast<unsigned char>(sql[i]));)
+            ++i;
+        }
+      }
+      append_param(&out);
+    } else {
+      out += c;
+      ++i;
+      if (c == ')')
+        collapse_group(&out);
+    }
+  }
+  return out;
+}
+
+uint64_t db_query_fingerprint(const std::string& normalized) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : normalized) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/* db_query_stat */
+uint64_t db_query_stat::MeanNs() const {
+  return (calls) ? total_ns / calls : 0;
+}
+
+/* DBQueryStats::Statement */
+DBQueryStats::Statement::Statement(DBQueryStats& stats)
+    : stats_(stats), active_(stats.IsEnabled()) {
+  if (active_)
+    start_ = std::chrono::steady_clock::now();
+}
+
+bool DBQueryStats::Statement::IsActive() const {
+  return active_;
+}
+
+void DBQueryStats::Statement::Finish(const std::string& sql,
+                                     uint64_t rows,
+                                     uint64_t bytes) {
+  if (!active_)
+    return;
+  active_ = false;
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_)
+                .count();
+  stats_.Record(sql, static_cast<uint64_t>(ns), rows, bytes + sql.size());
+}
+
+/* DBQueryStats */
+DBQueryStats::DBQueryStats(size_t capacity)
+    : shard_capacity_(std::max<size_t>(1, (capacity + shards_count - 1)
+                                              / shards_count)) {}
+
+DBQueryStats& DBQueryStats::Global() {
+  static DBQueryStats stats;
+  return stats;
+}
+
+void DBQueryStats::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool DBQueryStats::IsEnabled() const {
+  return enabled_.load(std::memory_order_relaxed);
+}
+
+void DBQueryStats::Record(const std::string& sql,
+                          uint64_t ns,
+                          uint64_t rows,
+                          uint64_t bytes) {
+  std::string query = db_query_normalize(sql);
+  uint64_t fingerprint = db_query_fingerprint(query);
+  shard& s = shards_[fingerprint % shards_count];
+  std::lock_guard<std::mutex> lock(s.lock);
+  auto it = s.values.find(fingerprint);
+  if (it == s.values.end()) {
+    if (s.values.size() >= shard_capacity_) {
+      // как в pg_stat_statements: вытесняется редкий запрос
+      auto victim = std::min_element(
+          s.values.begin(), s.values.end(), [](const auto& a, const auto& b) {
+            return a.second.calls < b.second.calls;
+          });
+      s.values.erase(victim);
+      evicted_.fetch_add(1, std::memory_order_relaxed);
+    }
+    it = s.values.emplace(fingerprint, db_query_stat()).first;
+    it->second.fingerprint = fingerprint;
+    it->second.query = std::move(query);
+    it->second.min_ns = ns;
+  }
+  db_query_stat& stat = it->second;
+  stat.calls++;
+  stat.total_ns += ns;
+  stat.min_ns = std::min(stat.min_ns, ns);
+  stat.max_ns = std::max(stat.max_ns, ns);
+  stat.rows += rows;
+  stat.bytes += bytes;
+}
+
+std::vector<db_query_stat> DBQueryStats::Top(
+    size_t n,
+    db_query_stats_order order) const {
+  std::vector<db_query_stat> all;
+  for (const auto& s : shards_) {
+    std::lock_guard<std::mutex> lock(s.lock);
+    for (const auto& v : s.values)
+      all.push_back(v.second);
+  }
+  n = std::min(n, all.size());
+  std::partial_sort(all.begin(), all.begin() + n, all.end(),
+                    [order](const db_query_stat& a, const db_query_stat& b) {
+                      return stat_key(a, order) > stat_key(b, order);
+                    });
+  all.resize(n);
+  return all;
+}
+
+std::string DBQueryStats::Report(size_t n, db_query_stats_order order) const {
+  std::string report =
+      "     calls   total_ms    mean_ms     max_ms       rows      bytes  "
+      "query\n";
+  char line[128];
+  for (const auto& s : Top(n, order)) {
+    snprintf(line, sizeof(line), "%10llu %10.3f %10.3f %10.3f %10llu %10llu  ",
+             static_cast<unsigned long long>(s.calls), s.total_ns * 1e-6,
+             s.MeanNs() * 1e-6, s.max_ns * 1e-6,
+             static_cast<unsigned long long>(s.rows),
+             static_cast<unsigned long long>(s.bytes));
+    report += line + s.query + "\n";
+  }
+  return report;
+}
+
+size_t DBQueryStats::Size() const {
+  size_t size = 0;
+  for (const auto& s : shards_) {
+    std::lock_guard<std::mutex> lock(s.lock);
+    size += s.values.size();
+  }
+  return size;
+}
+
+uint64_t DBQueryStats::Evicted() const {
+  return evicted_.load(std::memory_order_relaxed);
+}
+
+void DBQueryStats::Reset() {
+  for (auto& s : shards_) {
+    std::lock_guard<std::mutex> lock(s.lock);
+    s.values.clear();
+  }
+  evicted_.store(0, std::memory_order_relaxed);
+}
+}  // namespace asp_db
@@ -0,0 +1,341 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_trace.h"
+
+#include "asp_utils/Logging.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace asp_db {
+namespace {
+constexpr size_t name_words = (db_trace_event::name_size + 1) / 8;
+static_assert(name_words * 8 == db_trace_event::name_size + 1,
+              "имя интервала упаковывается в целые слова");
+
+/**
+ * \brief Ячейка кольцевого буфера
+ *
+ * Поля атомарны, чтобы чтение из другого потока не было гонкой
+ *   данных, согласованность ячейки проверяет счётчик версии:
+ *   нечётный - ячейка записывается, `2 * n + 2` - записан
+ *   интервал с номером `n`
+ * */
+struct trace_slot {
+  std::atomic<uint64_t> seq{0};
+  std::atomic<uint64_t> start_ns{0};
+  std::atomic<uint64_t> duration_ns{0};
+  std::atomic<uint32_t> category{0};
+  /** \brief Идентификатор потока, записавшего интервал */
+  std::atomic<uint32_t> tid{0};
+  std::array<std::atomic<uint64_t>, name_words> name{};
+};
+
+/**
+ * \brief Кольцевой буфер потока, пишет только поток-владелец
+ *
+ * Буфер завершившегося потока возвращается в пул реестра после
+ *   снятия его интервалов(Collect) или их сброса(Reset) и достаётся
+ *   следующему новому потоку
+ * */
+struct thread_ring {
+  /** \brief Идентификатор потока-владельца */
+  uint32_t tid = 0;
+  /** \brief Поток-владелец завершился, изменяется под мьютексом
+   *   реестра */
+  bool retired = false;
+  /** \brief Количество записанных интервалов */
+  std::atomic<uint64_t> head{0};
+  std::array<trace_slot, DBTrace::ring_capacity> slots;
+};
+
+/**
+ * \brief Реестр буферов всех потоков
+ * */
+struct trace_registry {
+  std::atomic<bool> enabled{false};
+  /** \brief Начало отсчёта времени, нс часов steady_clock */
+  std::atomic<uint64_t> origin_ns{0};
+  /** \brief Интервалы, начатые раньше, отброшены Reset */
+  std::atomic<uint64_t> reset_ns{0};
+  std::mutex lock;
+  /** \brief Все выделенные буферы */
+  std::vector<std::unique_ptr<thread_ring>> rings;
+  /** \brief Буферы завершившихся потоков, интервалы которых уже
+   *   сняты или сброшены */
+  std::vector<thread_ring*> free_rings;
+  /** \brief Последний выданный идентификатор потока */
+  uint32_t last_tid = 0;
+};
+
+trace_registry& registry() {
+  static trace_registry r;
+  return r;
+}
+
+/**
+ * \brief Вернуть в пул буферы завершившихся потоков
+ * */
+void release_rings(trace_registry* r,
+                   const std::vector<thread_ring*>& retired) {
+  std::lock_guard<std::mutex> lock(r->lock);
+  for (auto* ring : retired) {
+    ring->retired = false;
+    r->free_rings.push_back(ring);
+  }
+}
+
+/**
+ * \brief Буфер текущего потока, при завершении потока
+ *   помечается завершённым
+ * */
+struct local_ring_holder {
+  thread_ring* ring;
+
+ public:
+  local_ring_holder() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    if (r.free_rings.empty()) {
+      r.rings.push_back(std::make_unique<thread_ring>());
+      ring = r.rings.back().get();
+    } else {
+      ring = r.free_rings.back();
+      r.free_rings.pop_back();
+    }
+    ring->tid = ++r.last_tid;
+  }
+  ~local_ring_holder() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    ring->retired = true;
+  }
+};
+
+thread_ring& local_ring() {
+  thread_local local_ring_holder holder;
+  return *holder.ring;
+}
+
+uint64_t clock_ns(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             t.time_since_epoch())
+      .count();
+}
+
+void copy_name(char* dst, const char* src) {
+  size_t len = src ? strnlen(src, db_trace_event::name_size) : 0;
+  if (len)
+    memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+/**
+ * \brief Экранировать строку для JSON
+ * */
+std::string json_escape(const std::string& str) {
+  std::string out;
+  out.reserve(str.size());
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+}  // namespace
+
+const char* db_trace_category_to_string(db_trace_category category) {
+  switch (category) {
+    case db_trace_category::manager:
+      return "manager";
+    case db_trace_category::query:
+      return "query";
+    case db_trace_category::rollback:
+      return "rollback";
+    default:
+      return "unknown";
+  }
+}
+
+/* DBTrace::Span */
+DBTrace::Span::Span(db_trace_category category, const char* name)
+    : category_(category), active_(IsEnabled()) {
+  if (active_) {
+    copy_name(name_, name);
+    start_ = std::chrono::steady_clock::now();
+  }
+}
+
+DBTrace::Span::Span(db_trace_category category, const std::string& name)
+    : Span(category, name.c_str()) {}
+
+DBTrace::Span::~Span() {
+  Finish();
+}
+
+void DBTrace::Span::Finish() {
+  if (!active_)
+    return;
+  active_ = false;
+  Record(category_, name_, start_, std::chrono::steady_clock::now());
+}
+
+/* DBTrace */
+void DBTrace::SetEnabled(bool enabled) {
+  auto& r = registry();
+  if (enabled && !r.enabled.load(std::memory_order_relaxed))
+    r.origin_ns.store(clock_ns(std::chrono::steady_clock::now()),
+                      std::memory_order_relaxed);
+  r.enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool DBTrace::IsEnabled() {
+  return registry().enabled.load(std::memory_order_relaxed);
+}
+
+void DBTrace::Record(db_trace_category category,
+                     const char* name,
+                     std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point finish) {
+  uint64_t words[name_words] = {0};
+  copy_name(reinterpret_cast<char*>(words), name);
+  thread_ring& ring = local_ring();
+  uint64_t n = ring.head.load(std::memory_order_relaxed);
+  trace_slot& slot = ring.slots[n % ring_capacity];
+  slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.start_ns.store(clock_ns(start), std::memory_order_relaxed);
+  slot.duration_ns.store(clock_ns(finish) - clock_ns(start),
+                         std::memory_order_relaxed);
+  slot.category.store(uint32_t(category), std::memory_order_relaxed);
+  slot.tid.store(ring.tid, std::memory_order_relaxed);
+  for (size_t i = 0; i < name_words; ++i)
+    slot.name[i].store(words[i], std::memory_order_relaxed);
+  slot.seq.store(2 * n + 2, std::memory_order_release);
+  ring.head.store(n + 1, std::memory_order_release);
+}
+
+std::vector<db_trace_event> DBTrace::Collect() {
+  auto& r = registry();
+  // буферы не удаляются до завершения программы, а завершённые
+  //   до снятия больше не изменяются и после снятия идут в пул
+  std::vector<const thread_ring*> rings;
+  std::vector<thread_ring*> retired;
+  {
+    std::lock_guard<std::mutex> lock(r.lock);
+    for (const auto& ring : r.rings) {
+      if (ring->retired)
+        retired.push_back(ring.get());
+      rings.push_back(ring.get());
+    }
+  }
+  const uint64_t origin = r.origin_ns.load(std::memory_order_relaxed);
+  const uint64_t cutoff =
+      std::max(origin, r.reset_ns.load(std::memory_order_relaxed));
+  std::vector<db_trace_event> events;
+  for (const auto& ring : rings) {
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t n = (head > ring_capacity) ? head - ring_capacity : 0;
+    for (; n < head; ++n) {
+      const trace_slot& slot = ring->slots[n % ring_capacity];
+      uint64_t seq = slot.seq.load(std::memory_order_acquire);
+      if (seq != 2 * n + 2)
+        continue;
+      uint64_t words[name_words];
+      uint64_t start = slot.start_ns.load(std::memory_order_relaxed);
+      uint64_t duration = slot.duration_ns.load(std::memory_order_relaxed);
+      uint32_t category = slot.category.load(std::memory_order_relaxed);
+      uint32_t tid = slot.tid.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < name_words; ++i)
+        words[i] = slot.name[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // ячейку перезаписали во время чтения
+      if (slot.seq.load(std::memory_order_relaxed) != seq || start < cutoff)
+        continue;
+      db_trace_event event;
+      event.name = reinterpret_cast<const char*>(words);
+      event.category = static_cast<db_trace_category>(category);
+      event.start_ns = start - origin;
+      event.duration_ns = duration;
+      event.tid = tid;
+      events.push_back(std::move(event));
+    }
+  }
+  std::sort(events.begin(), events.end(),
+            [](const db_trace_event& a, const db_trace_event& b) {
+              return a.start_ns < b.start_ns;
+            });
+  release_rings(&r, retired);
+  return events;
+}
+
+std::string DBTrace::ToChromeJson() {
+  std::string json = "{\"traceEvents\":[";
+  char buf[128];
+  bool first = true;
+  for (const auto& e : Collect()) {
+    json += first ? "\n" : ",\n";
+    first = false;
+    json += "{\"name\":\"" + json_escape(e.name) + "\",\"cat\":\"" +
+            db_trace_category_to_string(e.category) + "\",\"ph\":\"X\"";
+    // время в микросекундах с дробной частью
+    snprintf(buf, sizeof(buf),
+             ",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+             e.start_ns * 1e-3, e.duration_ns * 1e-3, e.tid);
+    json += buf;
+  }
+  return json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+mstatus_t DBTrace::WriteChromeJson(const std::string& path) {
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  if (out)
+    out << ToChromeJson();
+  if (!out) {
+    Logging::Append(io_loglvl::err_logs,
+                    "Не удалось записать трассировку в файл: " + path);
+    return STATUS_HAVE_ERROR;
+  }
+  return STATUS_OK;
+}
+
+size_t DBTrace::RingsCount() {
+  std::lock_guard<std::mutex> lock(registry().lock);
+  return registry().rings.size();
+}
+
+void DBTrace::Reset() {
+  auto& r = registry();
+  r.reset_ns.store(clock_ns(std::chrono::steady_clock::now()),
+                   std::memory_order_relaxed);
+  std::vector<thread_ring*> retired;
+  {
+    std::lock_guard<std::mutex> lock(r.lock);
+    for (const auto& ring : r.rings)
+      if (ring->retired)
+        retired.push_back(ring.get());
+  }
+  release_rings(&r, retired);
+}
+}  // namespace asp_db
@@ -0,0 +1,297 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_where_evaluator.h"
+
+#include "asp_utils/Logging.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+
+namespace asp_db {
+namespace {
+/**
+ * \brief Разобрать целое число, вся строка должна быть числом
+ * */
+bool parse_integer(const std::string& str, int64_t* out) {
+  const char* end = str.data() + str.size();
+  auto res = std::from_chars(str.data(), end, *out);
+  return res.ec == std::errc() && res.ptr == end;
+}
+/**
+ * \brief Разобрать число с плавающей точкой
+ * */
+bool parse_real(const std::string& str, double* out) {
+  if (str.empty())
+    return false;
+  char* end = nullptr;
+  *out = std::strtod(str.c_str(), &end);
+  return end == str.c_str() + str.size();
+}
+/**
+ * \brief Разобрать логическое значение в формате postgres: t/f,
+ *   true/false, 1/0
+ * */
+bool parse_bool(const std::string& str, int64_t* out) {
+  std::string s = str;
+  std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+  if (s == "t" || s == "true" || s == "1" || s == "y" || s == "yes") {
+    *out = 1;
+  } else if (s == "f" || s == "false" || s == "0" || s == "n" || s == "no") {
+    *out = 0;
+  } else {
+    return false;
+  }
+  return true;
+}
+/**
+ * \brief Сравнить строки дат, '/' и '-' равнозначны
+ * */
+int compare_dates(const std::string& l, const std::string& r) {
+  size_t n = std::min(l.size(), r.size());
+  for (size_t i = 0; i < n; ++i) {
+    char lc = (l[i] == '/') ? '-' : l[i];
+    char rc = (r[i] == '/') ? '-' : r[i];
+    if (lc != rc)
+      return (lc < rc) ? -1 : 1;
+  }
+  return (l.size() == r.size()) ? 0 : ((l.size() < r.size()) ? -1 : 1);
+}
+template <class T>
+int three_way(const T& l, const T& r) {
+  return (l < r) ? -1 : ((r < l) ? 1 : 0);
+}
+}  // namespace
+
+DBWhereEvaluator::DBWhereEvaluator(
+    const db_fields_collection& fields,
+    const std::shared_ptr<DBWhereClause<where_node_data>>& clause)
+    : BaseObject(STATUS_DEFAULT) {
+  try {
+    auto root = (clause) ? clause->GetRoot() : nullptr;
+    if (root)
+      compile(fields, root.get());
+    status_ = STATUS_OK;
+  } catch (const std::exception& e) {
+    nodes_.clear();
+    error_.SetError(ERROR_DB_OPERATION,
+                    "Ошибка компиляции дерева where условий: "
+                        + std::string(e.what()));
+    status_ = STATUS_HAVE_ERROR;
+  }
+}
+
+std::vector<DBWhereEvaluator::row_values> DBWhereEvaluator::Filter(
+    const std::vector<row_values>& rows) const {
+  std::vector<row_values> result;
+  for (const auto& row : rows)
+    if (Evaluate(row) == db_tribool::tb_true)
+      result.push_back(row);
+  return result;
+}
+
+bool DBWhereEvaluator::LikeMatch(const std::string& str,
+                                 const std::string& pattern) {
+  // жадный поиск с возвратом к последнему `%`
+  size_t s = 0, p = 0;
+  size_t star_p = std::string::npos, star_s = 0;
+  while (s < str.size()) {
+    if (p < pattern.size() && (pattern[p] == '_' || pattern[p] == str[s])) {
+      ++s;
+      ++p;
+    } else if (p < pattern.size() && pattern[p] == '%') {
+      star_p = p++;
+      star_s = s;
+    } else if (star_p != std::string::npos) {
+      p = star_p + 1;
+      s = ++star_s;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '%')
+    ++p;
+  return p == pattern.size();
+}
+
+int DBWhereEvaluator::compile(const db_fields_collection& fields,
+                              const expression_node<where_node_data>* node) {
+  if (node == nullptr || !node->field_data.IsOperator())
+    throw db_variable_exception("Узел дерева условий не является оператором");
+  compiled_node cn;
+  cn.op = node->field_data.GetOperatorWrapper();
+  int index = static_cast<int>(nodes_.size());
+  nodes_.emplace_back();
+  if (cn.op.op == db_operator_t::op_and || cn.op.op == db_operator_t::op_or) {
+    cn.left = compile(fields, node->GetLeft().get());
+    cn.right = compile(fields, node->GetRight().get());
+    nodes_[index] = cn;
+    return index;
+  }
+  if (cn.op.op == db_operator_t::op_empty)
+    throw db_variable_exception("Пустой оператор дерева условий");
+  // лист сравнения: слева имя поля, справа значение
+  auto fnode = node->GetLeft();
+  auto vnode = node->GetRight();
+  if (!fnode || !fnode->field_data.IsFieldName() || !vnode)
+    throw db_variable_exception("Невычислимый узел дерева условий");
+  std::string fname = fnode->field_data.GetTablePair().second;
+  auto field = std::find_if(
+      fields.begin(), fields.end(),
+      [&fname](const db_variable& v) { return fname == v.fname; });
+  if (field == fields.end())
+    throw db_variable_exception("Поле '" + fname
+                                + "' не найдено в коллекции полей таблицы");
+  cn.field = std::distance(fields.begin(), field);
+  switch (field->type) {
+    case db_variable_type::type_autoinc:
+    case db_variable_type::type_short:
+    case db_variable_type::type_int:
+    case db_variable_type::type_long:
+      cn.kind = value_kind::vk_integer;
+      break;
+    case db_variable_type::type_real:
+      cn.kind = value_kind::vk_real;
+      break;
+    case db_variable_type::type_bool:
+      cn.kind = value_kind::vk_bool;
+      break;
+    case db_variable_type::type_date:
+      cn.kind = value_kind::vk_date;
+      break;
+    default:
+      cn.kind = value_kind::vk_text;
+      break;
+  }
+  if (cn.op.op == db_operator_t::op_between) {
+    if (!vnode->GetLeft() || !vnode->GetRight())
+      throw db_variable_exception("Не заданы границы оператора BETWEEN");
+    cn.lo = parseValue(cn.kind,
+                       vnode->GetLeft()->field_data.GetTablePair().second);
+    cn.hi = parseValue(cn.kind,
+                       vnode->GetRight()->field_data.GetTablePair().second);
+  } else if (cn.op.op == db_operator_t::op_is) {
+    // IS [NOT] NULL|TRUE|FALSE - значение хранится строкой
+    cn.lo.s = trim_str(vnode->field_data.GetTablePair().second);
+    std::transform(cn.lo.s.begin(), cn.lo.s.end(), cn.lo.s.begin(),
+                   ::toupper);
+  } else if (cn.op.op == db_operator_t::op_like) {
+    cn.kind = value_kind::vk_text;
+    cn.lo.s = vnode->field_data.GetTablePair().second;
+  } else {
+    if (!vnode->field_data.IsValue())
+      throw db_variable_exception("Невычислимое значение дерева условий");
+    cn.lo = parseValue(cn.kind, vnode->field_data.GetTablePair().second);
+  }
+  nodes_[index] = cn;
+  return index;
+}
+
+DBWhereEvaluator::compiled_value DBWhereEvaluator::parseValue(
+    value_kind kind,
+    const std::string& str) {
+  compiled_value cv;
+  bool ok = true;
+  switch (kind) {
+    case value_kind::vk_integer:
+      ok = parse_integer(str, &cv.i);
+      break;
+    case value_kind::vk_real:
+      ok = parse_real(str, &cv.d);
+      break;
+    case value_kind::vk_bool:
+      ok = parse_bool(str, &cv.i);
+      break;
+    case value_kind::vk_date:
+    case value_kind::vk_text:
+      cv.s = str;
+      break;
+  }
+  if (!ok)
+    throw db_variable_exception("Ошибка разбора значения условия: " + str);
+  return cv;
+}
+
+int DBWhereEvaluator::compare(value_kind kind,
+                              const std::string& value,
+                              const compiled_value& cv) {
+  switch (kind) {
+    case value_kind::vk_integer: {
+      int64_t i;
+      return parse_integer(value, &i) ? three_way(i, cv.i) : compare_failed;
+    }
+    case value_kind::vk_real: {
+      double d;
+      return parse_real(value, &d) ? three_way(d, cv.d) : compare_failed;
+    }
+    case value_kind::vk_bool: {
+      int64_t b;
+      return parse_bool(value, &b) ? three_way(b, cv.i) : compare_failed;
+    }
+    case value_kind::vk_date:
+      return compare_dates(value, cv.s);
+    case value_kind::vk_text:
+      return value.compare(cv.s) < 0 ? -1 : (value == cv.s ? 0 : 1);
+  }
+  return compare_failed;
+}
+
+db_tribool DBWhereEvaluator::evalLeaf(const compiled_node& node,
+                                      const std::string* value) const {
+  auto tb = [](bool b) {
+    return b ? db_tribool::tb_true : db_tribool::tb_false;
+  };
+  if (node.op.op == db_operator_t::op_is) {
+    const std::string& what = node.lo.s;
+    bool inverse = what.rfind("NOT ", 0) == 0;
+    std::string target = inverse ? trim_str(what.substr(4)) : what;
+    bool result = false;
+    if (target == "NULL") {
+      result = value == nullptr;
+    } else if (target == "TRUE" || target == "FALSE") {
+      int64_t b;
+      result = value && parse_bool(*value, &b) && (b == (target == "TRUE"));
+    } else if (target == "UNKNOWN") {
+      result = value == nullptr;
+    }
+    return tb(result != inverse);
+  }
+  if (value == nullptr)
+    return db_tribool::tb_unknown;
+  if (node.op.op == db_operator_t::op_like)
+    return tb(LikeMatch(*value, node.lo.s) != node.op.inverse);
+  int c = compare(node.kind, *value, node.lo);
+  if (c == compare_failed)
+    return db_tribool::tb_unknown;
+  switch (node.op.op) {
+    case db_operator_t::op_eq:
+      return tb(c == 0);
+    case db_operator_t::op_ne:
+      return tb(c != 0);
+    case db_operator_t::op_lt:
+      return tb(c < 0);
+    case db_operator_t::op_le:
+      return tb(c <= 0);
+    case db_operator_t::op_gt:
+      return tb(c > 0);
+    case db_operator_t::op_ge:
+      return tb(c >= 0);
+    case db_operator_t::op_between: {
+      int h = compare(node.kind, *value, node.hi);
+      if (h == compare_failed)
+        return db_tribool::tb_unknown;
+      return tb((c >= 0 && h <= 0) != node.op.inverse);
+    }
+    default:
+      break;
+  }
+  return db_tribool::tb_unknown;
+}
+}  // namespace asp_db
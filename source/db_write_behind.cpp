@@ -0,0 +1,186 @@
+/**
+ * asp_therm - implementation of real gas equations of state
+ *
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_db/db_write_behind.h"
+
+#include "asp_db/db_log.h"
+
+#include <algorithm>
+
+namespace asp_db {
+namespace {
+db_write_behind_parameters normalize(db_write_behind_parameters parameters) {
+  parameters.batch_rows = std::max<size_t>(parameters.batch_rows, 1);
+  parameters.max_pending =
+      std::max(parameters.max_pending, parameters.batch_rows);
+  return parameters;
+}
+}  // namespace
+
+DBWriteBehind::DBWriteBehind(const db_write_behind_parameters& parameters)
+    : parameters_(normalize(parameters)) {
+  lists_.emplace_back(new queue_list);
+  queues_.store(lists_.back().get(), std::memory_order_release);
+  worker_ = std::thread(&DBWriteBehind::run, this);
+}
+
+DBWriteBehind::~DBWriteBehind() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stop_.store(true);
+  }
+  wake_cv_.notify_one();
+  done_cv_.notify_all();
+  if (worker_.joinable())
+    worker_.join();
+}
+
+void DBWriteBehind::Flush() {
+  // сравнение общих счётчиков не годится: строки других потоков
+  //   могут быть записаны раньше строк вызывающего
+  const queue_list* list = queues_.load(std::memory_order_acquire);
+  if (list->queues.empty())
+    return;
+  auto barrier = std::make_shared<flush_barrier>();
+  barrier->remaining.store(list->queues.size());
+  for (auto* queue : list->queues)
+    queue->pushBarrier(barrier);
+  std::unique_lock<std::mutex> guard(lock_);
+  flush_requested_.store(true);
+  wake_cv_.notify_one();
+  done_cv_.wait(guard, [this, &barrier]() {
+    return barrier->remaining.load() == 0 || stop_.load();
+  });
+}
+
+uint64_t DBWriteBehind::Enqueued() const {
+  return enqueued_.load(std::memory_order_relaxed);
+}
+
+uint64_t DBWriteBehind::Completed() const {
+  return completed_.load(std::memory_order_relaxed);
+}
+
+uint64_t DBWriteBehind::Failed() const {
+  return failed_.load(std::memory_order_relaxed);
+}
+
+uint64_t DBWriteBehind::Batches() const {
+  return batches_.load(std::memory_order_relaxed);
+}
+
+DBWriteBehind::table_queue* DBWriteBehind::findQueue(db_table table) const {
+  const queue_list* list = queues_.load(std::memory_order_acquire);
+  for (auto* queue : list->queues) {
+    if (queue->table == table)
+      return queue;
+  }
+  return nullptr;
+}
+
+DBWriteBehind::table_queue* DBWriteBehind::addQueue(
+    std::unique_ptr<table_queue> queue) {
+  std::lock_guard<std::mutex> guard(queues_lock_);
+  if (auto* exists = findQueue(queue->table))
+    return exists;
+  // старые списки могут читать продюсеры, освобождаются с объектом
+  std::unique_ptr<queue_list> list(new queue_list(*lists_.back()));
+  list->queues.push_back(queue.get());
+  owned_queues_.push_back(std::move(queue));
+  lists_.push_back(std::move(list));
+  queues_.store(lists_.back().get(), std::memory_order_release);
+  return owned_queues_.back().get();
+}
+
+void DBWriteBehind::reserve() {
+  size_t pending = pending_.load(std::memory_order_relaxed);
+  while (true) {
+    if (pending >= parameters_.max_pending && !stop_.load()) {
+      // очереди переполнены - ждём записи пакета
+      std::unique_lock<std::mutex> guard(lock_);
+      wake_cv_.notify_one();
+      done_cv_.wait(guard, [this]() {
+        return pending_.load() < parameters_.max_pending || stop_.load();
+      });
+      pending = pending_.load(std::memory_order_relaxed);
+      continue;
+    }
+    // проверка и занятие места одним шагом, иначе одновременные
+    //   продюсеры превысили бы max_pending; при остановке строки
+    //   дописываются без ограничения
+    if (pending_.compare_exchange_weak(pending, pending + 1,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed))
+      return;
+  }
+}
+
+void DBWriteBehind::pushed(table_queue* queue) {
+  enqueued_.fetch_add(1, std::memory_order_release);
+  if (queue->size.fetch_add(1) + 1 == parameters_.batch_rows) {
+    // набрался пакет - будить поток записи до истечения периода
+    { std::lock_guard<std::mutex> guard(lock_); }
+    wake_cv_.notify_one();
+  }
+}
+
+void DBWriteBehind::run() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(lock_);
+      wake_cv_.wait_for(guard, parameters_.flush_interval, [this]() {
+        if (stop_.load() || flush_requested_.load())
+          return true;
+        for (auto* queue : queues_.load()->queues) {
+          if (queue->size.load() >= parameters_.batch_rows)
+            return true;
+        }
+        return false;
+      });
+      flush_requested_.store(false);
+    }
+    const bool stop = stop_.load();
+    flushQueues();
+    // при остановке дописываем всё, что успели добавить
+    if (stop && pending_.load() == 0)
+      break;
+  }
+}
+
+void DBWriteBehind::flushQueues() {
+  bool flushed = true;
+  while (flushed) {
+    flushed = false;
+    for (auto* queue : queues_.load(std::memory_order_acquire)->queues) {
+      db_write_behind_batch batch;
+      if (!queue->flush(parameters_.batch_rows, &batch))
+        continue;
+      flushed = true;
+      if (batch.rows == 0) {
+        // снята метка Flush
+        { std::lock_guard<std::mutex> guard(lock_); }
+        done_cv_.notify_all();
+        continue;
+      }
+      batches_.fetch_add(1, std::memory_order_relaxed);
+      if (!is_status_ok(batch.status)) {
+        failed_.fetch_add(batch.rows, std::memory_order_relaxed);
+        DB_LOG_ERR("Ошибка отложенного добавления ", batch.rows,
+                   " строк таблицы ", batch.table);
+      }
+      if (parameters_.on_batch)
+        parameters_.on_batch(batch);
+      pending_.fetch_sub(batch.rows);
+      completed_.fetch_add(batch.rows, std::memory_order_release);
+      { std::lock_guard<std::mutex> guard(lock_); }
+      done_cv_.notify_all();
+    }
+  }
+}
+}  // namespace asp_db
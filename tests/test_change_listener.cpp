@@ -0,0 +1,178 @@
+#include "asp_db/db_change_listener.h"
+#include "asp_db/db_connection_manager.h"
+#include "test_fixtures.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+/**
+ * \brief Операции, полученные подписчиком из потока слушателя
+ * */
+class ChangeLog {
+ public:
+  void Add(const db_table_change& change) {
+    std::lock_guard<std::mutex> lock(lock_);
+    ops_.push_back(change.operation);
+    cv_.notify_all();
+  }
+  /**
+   * \brief Дождаться `n` операций
+   * */
+  bool Wait(size_t n) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return cv_.wait_for(lock, std::chrono::seconds(5),
+                        [this, n]() { return ops_.size() >= n; });
+  }
+  std::vector<std::string> Ops() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return ops_;
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::vector<std::string> ops_;
+};
+
+/**
+ * \brief Слушатель без подключения к БД, события передаются вручную
+ * */
+class FakeChangeListener : public DBChangeListener {
+ public:
+  FakeChangeListener() : DBChangeListener(nullptr) {}
+
+  mstatus_t Start(const std::vector<db_table>&) override { return STATUS_OK; }
+  void Stop() override {}
+
+  void Notify(db_table table, const std::string& op) {
+    dispatch(db_table_change{table, op});
+  }
+};
+}  // namespace
+
+TEST(DBChangeListener, Channel) {
+  EXPECT_EQ(db_change_channel("book"), "asp_db_book");
+}
+
+TEST(DBChangeListener, DispatchByTable) {
+  FakeChangeListener listener;
+  std::vector<std::string> book_ops;
+  int author_calls = 0;
+  size_t book_id =
+      listener.Subscribe(table_book, [&book_ops](const db_table_change& c) {
+        book_ops.push_back(c.operation);
+      });
+  listener.Subscribe(table_author, [&author_calls](const db_table_change&) {
+    ++author_calls;
+  });
+
+  listener.Notify(table_book, "INSERT");
+  listener.Notify(table_book, "DELETE");
+  listener.Notify(table_translation, "UPDATE");
+  ASSERT_EQ(book_ops.size(), 2u);
+  EXPECT_EQ(book_ops[1], "DELETE");
+  EXPECT_EQ(author_calls, 0);
+
+  listener.Unsubscribe(book_id);
+  listener.Notify(table_book, "INSERT");
+  listener.Notify(table_author, "INSERT");
+  EXPECT_EQ(book_ops.size(), 2u);
+  EXPECT_EQ(author_calls, 1);
+}
+
+TEST(DBChangeListener, UnsubscribeWaitsForCallback) {
+  FakeChangeListener listener;
+  std::atomic<bool> started{false}, finished{false};
+  size_t id = listener.Subscribe(
+      table_book, [&started, &finished](const db_table_change&) {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        finished = true;
+      });
+  std::thread notifier(
+      [&listener]() { listener.Notify(table_book, "INSERT"); });
+  while (!started)
+    std::this_thread::yield();
+  listener.Unsubscribe(id);
+  EXPECT_TRUE(finished);
+  notifier.join();
+
+  // отписка из обработчика в потоке слушателя не ждёт сама себя
+  int calls = 0;
+  size_t self_id = 0;
+  self_id = listener.Subscribe(
+      table_book, [&listener, &self_id, &calls](const db_table_change&) {
+        ++calls;
+        listener.Unsubscribe(self_id);
+      });
+  std::thread self([&listener]() {
+    listener.Notify(table_book, "INSERT");
+    listener.Notify(table_book, "DELETE");
+  });
+  self.join();
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(DBChangeListener, MemorySubscribeLifecycle) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(
+      dbm.ResetConnectionParameters(test_memory_parameters("listener_life"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  // слушатель не запущен - подписки нет
+  EXPECT_EQ(dbm.SubscribeTableChanges(table_book, nullptr), 0u);
+
+  ASSERT_TRUE(is_status_ok(dbm.StartChangeListener({table_book})));
+  ChangeLog first, second;
+  size_t first_id = dbm.SubscribeTableChanges(
+      table_book, [&first](const db_table_change& c) { first.Add(c); });
+  dbm.SubscribeTableChanges(
+      table_book, [&second](const db_table_change& c) { second.Add(c); });
+  ASSERT_NE(first_id, 0u);
+
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(test_book("Hobbit"))));
+  ASSERT_TRUE(first.Wait(1));
+  ASSERT_TRUE(second.Wait(1));
+  EXPECT_EQ(first.Ops(), std::vector<std::string>{"INSERT"});
+
+  // отписанный обработчик не вызывается, второй получает событие
+  dbm.UnsubscribeTableChanges(first_id);
+  ASSERT_TRUE(is_status_ok(dbm.DeleteAllRows(table_book)));
+  ASSERT_TRUE(second.Wait(2));
+  EXPECT_EQ(second.Ops().back(), "DELETE");
+  EXPECT_EQ(first.Ops().size(), 1u);
+
+  dbm.StopChangeListener();
+  EXPECT_EQ(dbm.SubscribeTableChanges(table_book, nullptr), 0u);
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(test_book("Dune"))));
+  EXPECT_EQ(second.Ops().size(), 2u);
+}
+
+TEST(DBChangeListener, MemoryInvalidatesCacheOfOtherManager) {
+  DBConnectionManager reader(&test_ldb), writer(&test_ldb);
+  auto p = test_memory_parameters("listener_cache");
+  ASSERT_TRUE(is_status_aval(reader.ResetConnectionParameters(p)));
+  ASSERT_TRUE(is_status_aval(writer.ResetConnectionParameters(p)));
+  ASSERT_TRUE(is_status_ok(writer.CreateTable(table_book)));
+  reader.EnableQueryCache(db_query_cache_parameters{});
+  ASSERT_TRUE(is_status_ok(reader.StartChangeListener({table_book})));
+  ChangeLog log;
+  reader.SubscribeTableChanges(
+      table_book, [&log](const db_table_change& c) { log.Add(c); });
+
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(reader.SelectAllRows(table_book, &r)));
+  EXPECT_TRUE(r.empty());
+  // запись другого менеджера в обход кэша читателя
+  ASSERT_TRUE(is_status_ok(writer.SaveSingleRow(test_book("Solaris"))));
+  ASSERT_TRUE(log.Wait(1));
+  ASSERT_TRUE(is_status_ok(reader.SelectAllRows(table_book, &r)));
+  EXPECT_EQ(r.size(), 1u);
+}
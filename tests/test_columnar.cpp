@@ -0,0 +1,171 @@
+#include "asp_db/db_columnar.h"
+#include "asp_db/db_where.h"
+#include "asp_db/db_where_evaluator.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <random>
+
+namespace {
+LibraryDBTables columnar_ldb;
+const IDBTables* columnar_tables = &columnar_ldb;
+
+/**
+ * \brief Коллекция полей со всеми числовыми типами
+ * */
+const db_fields_collection numeric_fields = {
+    db_variable(1,
+                "id",
+                db_variable_type::type_autoinc,
+                db_variable::db_variable_flags({{"is_primary_key", true}})),
+    db_variable(2,
+                "counter",
+                db_variable_type::type_long,
+                db_variable::db_variable_flags({{"can_be_null", true}})),
+    db_variable(3,
+                "value",
+                db_variable_type::type_real,
+                db_variable::db_variable_flags({{"can_be_null", true}})),
+    db_variable(4,
+                "name",
+                db_variable_type::type_text,
+                db_variable::db_variable_flags({{"can_be_null", true}})),
+};
+
+/**
+ * \brief Случайные строки таблицы книг, год издания иногда NULL
+ * */
+std::vector<db_query_basesetup::row_values> random_books(size_t count) {
+  const auto& fields = *columnar_tables->GetFieldsCollection(table_book);
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> year(1800, 2020);
+  std::uniform_int_distribution<int> lang(0, 3);
+  std::vector<db_query_basesetup::row_values> rows(count);
+  for (size_t r = 0; r < count; ++r) {
+    for (size_t i = 0; i < fields.size(); ++i) {
+      if (fields[i].fid == BOOK_ID)
+        rows[r].emplace(i, std::to_string(r + 1));
+      else if (fields[i].fid == BOOK_TITLE)
+        rows[r].emplace(i, "title" + std::to_string(r));
+      else if (fields[i].fid == BOOK_PUB_YEAR && r % 7)
+        rows[r].emplace(i, std::to_string(year(gen)));
+      else if (fields[i].fid == BOOK_LANG)
+        rows[r].emplace(i, std::to_string(lang(gen)));
+    }
+  }
+  return rows;
+}
+
+/**
+ * \brief Сравнить колоночную выборку с построчным вычислением
+ * */
+void expect_same(DBColumnarView& view,
+                 const std::vector<db_query_basesetup::row_values>& rows,
+                 const wns::node_ptr& node) {
+  auto clause = std::make_shared<DBWhereClause<where_node_data>>(node);
+  DBWhereEvaluator evaluator(*columnar_tables->GetFieldsCollection(table_book),
+                             clause);
+  ASSERT_TRUE(evaluator.IsValid());
+  db_selection selection;
+  ASSERT_TRUE(is_status_ok(view.Select(clause, &selection)));
+  ASSERT_EQ(selection.Size(), rows.size());
+  for (size_t r = 0; r < rows.size(); ++r)
+    ASSERT_EQ(selection.Test(r), evaluator(rows[r])) << "row " << r;
+}
+}  // namespace
+
+TEST(DBColumnarView, Selection) {
+  db_selection s(130);
+  EXPECT_EQ(s.Count(), 0u);
+  s.Set(0);
+  s.Set(64);
+  s.Set(129);
+  EXPECT_EQ(s.Count(), 3u);
+  EXPECT_EQ(s.Indexes(), (std::vector<size_t>{0, 64, 129}));
+  s.Invert();
+  EXPECT_EQ(s.Count(), 127u);
+
+  db_selection all(130, true);
+  EXPECT_EQ(all.Count(), 130u);
+  all &= s;
+  EXPECT_EQ(all.Count(), 127u);
+  all |= db_selection(130, true);
+  EXPECT_EQ(all.Count(), 130u);
+}
+
+TEST(DBColumnarView, SelectRange) {
+  std::vector<db_query_basesetup::row_values> rows;
+  for (int i = 0; i < 200; ++i) {
+    db_query_basesetup::row_values row{{0, std::to_string(i)},
+                                       {3, "n" + std::to_string(i)}};
+    if (i % 10)
+      row.emplace(1, std::to_string(int64_t(i) * 10000000000));
+    row.emplace(2, std::to_string(i * 0.5));
+    rows.push_back(row);
+  }
+  DBColumnarView view(numeric_fields, rows);
+  ASSERT_TRUE(is_status_ok(view.GetStatus()));
+  EXPECT_EQ(view.RowsCount(), 200u);
+  EXPECT_EQ(view.GetColumn(3), nullptr);
+  ASSERT_NE(view.GetColumn(1), nullptr);
+  EXPECT_EQ(view.GetColumn(1)->valid.Count(), 180u);
+
+  db_selection s;
+  ASSERT_TRUE(
+      is_status_ok(view.SelectRange(0, int64_t(10), int64_t(74), &s)));
+  EXPECT_EQ(s.Count(), 65u);
+  // NULL значения не выбираются
+  ASSERT_TRUE(is_status_ok(
+      view.SelectRange(1, int64_t(0), int64_t(500000000000), &s)));
+  EXPECT_EQ(s.Count(), 45u);
+  ASSERT_TRUE(is_status_ok(view.SelectRange(2, 10.0, 20.0, &s)));
+  EXPECT_EQ(s.Count(), 21u);
+  // дробные границы для целочисленного столбца
+  ASSERT_TRUE(is_status_ok(view.SelectRange(0, 0.5, 2.5, &s)));
+  EXPECT_EQ(s.Indexes(), (std::vector<size_t>{1, 2}));
+  EXPECT_FALSE(is_status_ok(view.SelectRange(3, 0.0, 1.0, &s)));
+
+  DBColumnarView bad(numeric_fields, {{{0, "abc"}}});
+  EXPECT_FALSE(is_status_ok(bad.GetStatus()));
+}
+
+TEST(DBColumnarView, WhereTree) {
+  auto rows = random_books(1000);
+  DBColumnarView view(*columnar_tables->GetFieldsCollection(table_book), rows);
+  ASSERT_TRUE(is_status_ok(view.GetStatus()));
+  WhereTreeConstructor<table_book> c(&columnar_ldb);
+
+  expect_same(view, rows, c.Eq(BOOK_LANG, 2));
+  expect_same(view, rows, c.Ne(BOOK_LANG, 2));
+  expect_same(view, rows, c.Lt(BOOK_PUB_YEAR, 1900));
+  expect_same(view, rows, c.Ge(BOOK_PUB_YEAR, 2000));
+  expect_same(view, rows, c.Between(BOOK_PUB_YEAR, 1950, 1960));
+  expect_same(view, rows, c.Between(BOOK_PUB_YEAR, 1950, 1960, true));
+  expect_same(view, rows, c.Is(BOOK_PUB_YEAR, "NULL"));
+  expect_same(view, rows,
+              c.Or(c.And(c.Gt(BOOK_PUB_YEAR, 1990), c.Eq(BOOK_LANG, 1)),
+                   c.Le(BOOK_ID, 10)));
+
+  db_selection s;
+  EXPECT_FALSE(is_status_ok(view.Select(
+      std::make_shared<DBWhereClause<where_node_data>>(
+          c.Eq(BOOK_TITLE, "title1")),
+      &s)));
+  ASSERT_TRUE(is_status_ok(view.Select(nullptr, &s)));
+  EXPECT_EQ(s.Count(), rows.size());
+}
+
+TEST(DBColumnarView, OwnsFields) {
+  auto rows = random_books(100);
+  std::unique_ptr<DBColumnarView> view;
+  {
+    // коллекция полей удаляется раньше представления
+    auto fields = *columnar_tables->GetFieldsCollection(table_book);
+    view.reset(new DBColumnarView(fields, rows));
+  }
+  ASSERT_TRUE(is_status_ok(view->GetStatus()));
+  WhereTreeConstructor<table_book> c(&columnar_ldb);
+  expect_same(*view, rows, c.Ge(BOOK_PUB_YEAR, 2000));
+}
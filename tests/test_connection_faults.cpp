@@ -0,0 +1,114 @@
+#include "asp_db/db_connection_faults.h"
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_connection_memory.h"
+#include "test_fixtures.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * \brief Результаты `n` операций SetupConnection копий подключения
+ * */
+std::vector<bool> faults_pattern(uint64_t seed, int n) {
+  db_fault_config config;
+  config.seed = seed;
+  config.Rule(db_fault_op::setup_connection).error_probability = 0.5;
+  auto p = test_memory_parameters("faults_pattern");
+  DBConnectionFaults conn(
+      std::make_shared<DBConnectionMemory>(&test_ldb, p), config,
+      &test_ldb, p);
+  std::vector<bool> res;
+  for (int i = 0; i < n; ++i) {
+    auto c = conn.CloneConnection();
+    res.push_back(is_status_ok(c->SetupConnection()));
+    c->CloseConnection();
+  }
+  return res;
+}
+}  // namespace
+
+TEST(DBConnectionFaults, ManagerErrors) {
+  // хранилище в памяти общее для подключений с одним именем БД
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(
+      test_memory_parameters("faults_manager"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+
+  auto config = std::make_shared<db_fault_config>();
+  config->Rule(db_fault_op::insert_rows).error_probability = 1.0;
+  DBConnectionManager faulty(&test_ldb);
+  ASSERT_TRUE(is_status_aval(faulty.ResetConnectionParameters(
+      test_memory_parameters("faults_manager", config))));
+  id_container ids;
+  EXPECT_FALSE(is_status_ok(faulty.SaveVectorOfRows(test_books(), &ids)));
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(faulty.SelectAllRows(table_book, &r)));
+  EXPECT_TRUE(r.empty());
+
+  EXPECT_TRUE(is_status_ok(dbm.SaveVectorOfRows(test_books(), &ids)));
+  ASSERT_TRUE(is_status_ok(faulty.SelectAllRows(table_book, &r)));
+  EXPECT_EQ(r.size(), test_books().size());
+}
+
+TEST(DBConnectionFaults, SeededPattern) {
+  auto a = faults_pattern(42, 32);
+  EXPECT_EQ(a, faults_pattern(42, 32));
+  EXPECT_NE(a, faults_pattern(43, 32));
+  // при вероятности 0.5 есть и ошибки, и успешные подключения
+  EXPECT_NE(std::count(a.begin(), a.end(), true), 0);
+  EXPECT_NE(std::count(a.begin(), a.end(), false), 0);
+}
+
+TEST(DBConnectionFaults, Latency) {
+  db_fault_config config;
+  db_fault_rule rule;
+  rule.dist = db_latency_dist::fixed;
+  rule.base = std::chrono::microseconds(200);
+  config.SetAll(rule);
+  config.Rule(db_fault_op::select_rows).tail_probability = 1.0;
+  config.Rule(db_fault_op::select_rows).tail_latency =
+      std::chrono::microseconds(1000);
+  auto p = test_memory_parameters("faults_latency");
+  DBConnectionFaults conn(
+      std::make_shared<DBConnectionMemory>(&test_ldb, p), config,
+      &test_ldb, p);
+  ASSERT_TRUE(is_status_ok(conn.SetupConnection()));
+  EXPECT_TRUE(conn.IsOpen());
+  db_query_select_result result(
+      *db_query_select_setup::Init(&test_ldb, table_book, true));
+  // таблицы нет, но задержка вносится до выполнения
+  conn.SelectRows(*db_query_select_setup::Init(&test_ldb, table_book, true),
+                  &result);
+  conn.CloseConnection();
+  EXPECT_FALSE(conn.IsOpen());
+  EXPECT_EQ(conn.GetStats().operations, 3u);
+  EXPECT_EQ(conn.GetStats().errors, 0u);
+  EXPECT_EQ(conn.GetStats().latency_us, 200u * 3 + 1000u);
+}
+
+TEST(DBConnectionFaults, ForwardsWrappedError) {
+  auto p = test_memory_parameters("faults_forward");
+  auto memory = std::make_shared<DBConnectionMemory>(&test_ldb, p);
+  DBConnectionFaults conn(memory, db_fault_config(), &test_ldb, p);
+  ASSERT_TRUE(is_status_ok(conn.SetupConnection()));
+  db_query_select_result result(
+      *db_query_select_setup::Init(&test_ldb, table_book, true));
+  // таблицы нет: код и текст ошибки берутся из оборачиваемого подключения
+  EXPECT_FALSE(is_status_ok(conn.SelectRows(
+      *db_query_select_setup::Init(&test_ldb, table_book, true), &result)));
+  EXPECT_EQ(conn.GetError(), memory->GetError());
+  EXPECT_FALSE(memory->GetErrorMessage().empty());
+  EXPECT_NE(conn.GetErrorMessage().find(memory->GetErrorMessage()),
+            std::string::npos);
+  conn.CloseConnection();
+
+  // ошибка прошлой транзакции сбрасывается новым подключением
+  ASSERT_TRUE(is_status_ok(conn.SetupConnection()));
+  EXPECT_EQ(conn.GetError(), ERROR_SUCCESS_T);
+  EXPECT_TRUE(conn.GetErrorMessage().empty());
+  conn.CloseConnection();
+}
@@ -0,0 +1,87 @@
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_connection_memory.h"
+#include "asp_db/db_where.h"
+#include "test_fixtures.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+TEST(DBConnectionMemory, ManagerRoundTrip) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(
+      dbm.ResetConnectionParameters(test_memory_parameters("memory_manager"))));
+  EXPECT_FALSE(dbm.IsTableExists(table_book));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  EXPECT_TRUE(dbm.IsTableExists(table_book));
+
+  id_container ids;
+  ASSERT_TRUE(is_status_ok(dbm.SaveVectorOfRows(test_books(), &ids)));
+  EXPECT_EQ(ids.id_vec, (std::vector<int>{1, 2, 3}));
+  int id = -1;
+  book single;
+  book_construct(single, -1, lang_ita, "Divina Commedia", 1320,
+                 book::f_full & ~book::f_id);
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(single, &id)));
+  EXPECT_EQ(id, 4);
+
+  WhereTreeConstructor<table_book> c(&test_ldb);
+  WhereTree<table_book> wt(c);
+  wt.Init(c.And(c.Gt(BOOK_PUB_YEAR, 1950), c.Eq(BOOK_LANG, int(lang_eng))));
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectRows(wt, &r)));
+  ASSERT_EQ(r.size(), 1u);
+  EXPECT_EQ(r[0].title, "Dune");
+  EXPECT_EQ(r[0].id, 2);
+
+  WhereTree<table_book> del(c);
+  del.Init(c.Lt(BOOK_PUB_YEAR, 1940));
+  ASSERT_TRUE(is_status_ok(dbm.DeleteRows(del)));
+  r.clear();
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[0].title, "Dune");
+  EXPECT_EQ(r[1].title, "Solaris");
+}
+
+TEST(DBConnectionMemory, UniqueAndSavePoints) {
+  const IDBTables* tables = &test_ldb;
+  const auto& book_setup = tables->CreateSetupByCode(table_book);
+  DBConnectionMemory conn(tables, test_memory_parameters("memory_unique"));
+  // операции без открытого подключения не выполняются
+  EXPECT_EQ(conn.CreateTable(book_setup), STATUS_NOT);
+  ASSERT_TRUE(is_status_ok(conn.SetupConnection()));
+  ASSERT_TRUE(is_status_ok(conn.CreateTable(book_setup)));
+
+  db_save_point sp("memory_sp");
+  ASSERT_TRUE(is_status_ok(conn.AddSavePoint(sp)));
+  auto setup = test_ldb.InitInsertSetup<book>(test_books());
+  ASSERT_TRUE(is_status_ok(conn.InsertRows(*setup, nullptr)));
+  EXPECT_EQ(conn.RowsCount(table_book), 3u);
+
+  // уникальный комплекс (title, pub_year): вся операция отменяется
+  auto dup = test_ldb.InitInsertSetup<book>(test_books());
+  EXPECT_EQ(conn.InsertRows(*dup, nullptr), STATUS_HAVE_ERROR);
+  EXPECT_EQ(conn.RowsCount(table_book), 3u);
+  dup->SetOnExistAct(insert_on_exists_act::do_nothing);
+  id_container ids;
+  EXPECT_TRUE(is_status_ok(conn.InsertRows(*dup, &ids)));
+  EXPECT_TRUE(ids.id_vec.empty());
+  EXPECT_EQ(conn.RowsCount(table_book), 3u);
+
+  // копия подключения работает с тем же хранилищем
+  auto clone = conn.CloneConnection();
+  ASSERT_TRUE(is_status_ok(clone->SetupConnection()));
+  db_query_select_result result(
+      *db_query_select_setup::Init(&test_ldb, table_book, true));
+  ASSERT_TRUE(is_status_ok(clone->SelectRows(
+      *db_query_select_setup::Init(&test_ldb, table_book, true), &result)));
+  EXPECT_EQ(result.values_vec.size(), 3u);
+  clone->CloseConnection();
+
+  conn.RollbackToSavePoint(sp);
+  EXPECT_EQ(conn.RowsCount(table_book), 0u);
+  conn.CloseConnection();
+  EXPECT_EQ(conn.RowsCount(table_book), 0u);
+}
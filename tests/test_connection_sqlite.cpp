@@ -0,0 +1,208 @@
+#if defined(WITH_SQLITE)
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_connection_sqlite.h"
+#include "asp_db/db_journal.h"
+#include "asp_db/db_where.h"
+#include "test_fixtures.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+size_t sqlite_rows(DBConnection* conn) {
+  db_query_select_result result(
+      *db_query_select_setup::Init(&test_ldb, table_book, true));
+  if (!is_status_ok(conn->SelectRows(
+          *db_query_select_setup::Init(&test_ldb, table_book, true),
+          &result)))
+    return size_t(-1);
+  return result.values_vec.size();
+}
+}  // namespace
+
+TEST(DBConnectionSQLite, ManagerRoundTrip) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(
+      test_sqlite_parameters("sqlite_manager.db"))));
+  EXPECT_FALSE(dbm.IsTableExists(table_book));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  EXPECT_TRUE(dbm.IsTableExists(table_book));
+
+  id_container ids;
+  ASSERT_TRUE(is_status_ok(dbm.SaveVectorOfRows(test_books(), &ids)));
+  EXPECT_EQ(ids.id_vec, (std::vector<int>{1, 2, 3}));
+  int id = -1;
+  book single;
+  book_construct(single, -1, lang_ita, "Divina Commedia", 1320,
+                 book::f_full & ~book::f_id);
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(single, &id)));
+  EXPECT_EQ(id, 4);
+
+  WhereTreeConstructor<table_book> c(&test_ldb);
+  WhereTree<table_book> wt(c);
+  wt.Init(c.And(c.Gt(BOOK_PUB_YEAR, 1950), c.Eq(BOOK_LANG, int(lang_eng))));
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectRows(wt, &r)));
+  ASSERT_EQ(r.size(), 1u);
+  EXPECT_EQ(r[0].title, "Dune");
+  EXPECT_EQ(r[0].id, 2);
+
+  WhereTree<table_book> del(c);
+  del.Init(c.Lt(BOOK_PUB_YEAR, 1940));
+  ASSERT_TRUE(is_status_ok(dbm.DeleteRows(del)));
+  r.clear();
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[0].title, "Dune");
+  EXPECT_EQ(r[1].title, "Solaris");
+}
+
+TEST(DBConnectionSQLite, UniqueAndSavePoints) {
+  const IDBTables* tables = &test_ldb;
+  const auto& book_setup = tables->CreateSetupByCode(table_book);
+  DBConnectionSQLite conn(tables, test_sqlite_parameters("sqlite_unique.db"));
+  // операции без открытого подключения не выполняются
+  EXPECT_EQ(conn.CreateTable(book_setup), STATUS_NOT);
+  ASSERT_TRUE(is_status_ok(conn.SetupConnection()));
+  ASSERT_TRUE(is_status_ok(conn.CreateTable(book_setup)));
+
+  db_table_create_setup format(table_book);
+  ASSERT_TRUE(is_status_ok(conn.GetTableFormat(table_book, &format)));
+  ASSERT_EQ(format.fields.size(), book_setup.fields.size());
+  EXPECT_TRUE(is_status_ok(conn.CheckTableFormat(book_setup)));
+  ASSERT_EQ(format.unique_constrains.size(), 1u);
+
+  db_save_point sp("sqlite_sp");
+  ASSERT_TRUE(is_status_ok(conn.AddSavePoint(sp)));
+  auto setup = test_ldb.InitInsertSetup<book>(test_books());
+  ASSERT_TRUE(is_status_ok(conn.InsertRows(*setup, nullptr)));
+  EXPECT_EQ(sqlite_rows(&conn), 3u);
+
+  // уникальный комплекс (title, pub_year)
+  auto dup = test_ldb.InitInsertSetup<book>(test_books());
+  EXPECT_EQ(conn.InsertRows(*dup, nullptr), STATUS_HAVE_ERROR);
+  dup->SetOnExistAct(insert_on_exists_act::do_nothing);
+  id_container ids;
+  EXPECT_TRUE(is_status_ok(conn.InsertRows(*dup, &ids)));
+  EXPECT_TRUE(ids.id_vec.empty());
+  EXPECT_EQ(sqlite_rows(&conn), 3u);
+
+  conn.RollbackToSavePoint(sp);
+  EXPECT_EQ(sqlite_rows(&conn), 0u);
+  conn.CloseConnection();
+}
+
+TEST(DBConnectionSQLite, UpsertKeepsUnsuppliedColumns) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(
+      test_sqlite_parameters("sqlite_upsert.db"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  ASSERT_TRUE(is_status_ok(dbm.SaveVectorOfRows(test_books())));
+
+  // строка совпадает с "Dune" по уникальному комплексу (title, pub_year),
+  //   id не передаётся
+  book dune;
+  book_construct(dune, -1, lang_rus, "Dune", 1965,
+                 book::f_full & ~book::f_id);
+  ASSERT_TRUE(is_status_ok(dbm.SaveNotExistsRows(
+      std::vector<book>{dune}, nullptr, insert_on_exists_act::do_update)));
+
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  ASSERT_EQ(r.size(), 3u);
+  auto it = std::find_if(r.begin(), r.end(),
+                         [](const book& b) { return b.title == "Dune"; });
+  ASSERT_NE(it, r.end());
+  EXPECT_EQ(it->lang, lang_rus);
+  // INSERT OR REPLACE выдал бы строке новый id
+  EXPECT_EQ(it->id, 2);
+}
+
+TEST(DBConnectionSQLite, DryRunFile) {
+  db_parameters p = test_sqlite_parameters("sqlite_dry_run.db");
+  p.is_dry_run = true;
+  p.dry_run_file = "sqlite_dry_run.sql";
+  {
+    DBConnectionManager dbm(&test_ldb);
+    ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(p)));
+    ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+    // CloseConnection дожидается записи запросов транзакции
+    std::ifstream in(p.dry_run_file);
+    std::stringstream sql;
+    sql << in.rdbuf();
+    EXPECT_NE(sql.str().find("dry_run: CREATE TABLE"), std::string::npos);
+    EXPECT_NE(sql.str().find("dry_run commit and disconect\n"),
+              std::string::npos);
+  }
+  std::remove(p.dry_run_file.c_str());
+}
+
+TEST(DBConnectionSQLite, DryRunJournal) {
+  db_parameters p = test_sqlite_parameters("sqlite_dry_run.db");
+  p.is_dry_run = true;
+  p.dry_run_journal = "sqlite_dry_run.journal";
+  {
+    DBConnectionManager dbm(&test_ldb);
+    ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(p)));
+    ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+    ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  }
+  DBJournalReader reader(p.dry_run_journal);
+  ASSERT_TRUE(reader.IsOpen());
+  std::vector<db_journal_record> records;
+  db_journal_record record;
+  while (reader.Next(&record))
+    records.push_back(record);
+  // проверка подключения и две транзакции на разных копиях подключения,
+  //   каждая транзакция завершена
+  ASSERT_EQ(records.size(), 10u);
+  std::map<uint32_t, std::vector<std::string>> sessions;
+  for (const auto& r : records)
+    sessions[r.connection_id].push_back(r.sql);
+  ASSERT_EQ(sessions.size(), 3u);
+  for (const auto& s : sessions) {
+    EXPECT_EQ(s.second.front(), "BEGIN;");
+    EXPECT_EQ(s.second.back(), "COMMIT;");
+  }
+  EXPECT_NE(records[records.size() - 2].sql.find("CREATE TABLE"),
+            std::string::npos);
+  std::remove(p.dry_run_journal.c_str());
+}
+
+TEST(DBConnectionSQLite, ReadOnlyWithoutTransaction) {
+  db_parameters p = test_sqlite_parameters("sqlite_dry_run.db");
+  p.is_dry_run = true;
+  p.dry_run_journal = "sqlite_read_only.journal";
+  {
+    DBConnectionManager dbm(&test_ldb);
+    ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(p)));
+    dbm.IsTableExists(table_book);
+    std::vector<book> r;
+    dbm.SelectAllRows(table_book, &r);
+  }
+  DBJournalReader reader(p.dry_run_journal);
+  ASSERT_TRUE(reader.IsOpen());
+  std::map<uint32_t, std::vector<std::string>> sessions;
+  db_journal_record record;
+  while (reader.Next(&record))
+    sessions[record.connection_id].push_back(record.sql);
+  // чтение - один запрос без BEGIN/COMMIT и точек сохранения
+  size_t reads = 0;
+  for (const auto& s : sessions) {
+    if (s.second.front() == "BEGIN;")
+      continue;
+    ASSERT_EQ(s.second.size(), 1u);
+    EXPECT_NE(s.second[0].find("SELECT"), std::string::npos);
+    ++reads;
+  }
+  EXPECT_EQ(reads, 2u);
+  std::remove(p.dry_run_journal.c_str());
+}
+#endif  // WITH_SQLITE
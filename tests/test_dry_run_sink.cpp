@@ -0,0 +1,100 @@
+#include "asp_db/db_dry_run_sink.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asp_db;
+
+namespace {
+std::vector<std::string> read_lines(const std::string& path) {
+  std::vector<std::string> lines;
+  std::ifstream in(path);
+  for (std::string line; std::getline(in, line);)
+    lines.push_back(line);
+  return lines;
+}
+}  // namespace
+
+TEST(DBDryRunSink, ThreadsAndFlush) {
+  const std::string path = "dry_run_sink_threads.sql";
+  auto sink = DBDryRunSink::Open(path);
+  ASSERT_NE(sink, nullptr);
+  // копии подключений получают общий сток
+  EXPECT_EQ(DBDryRunSink::Open(path), sink);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&sink, t]() {
+      for (int i = 0; i < 1000; ++i)
+        sink->Append("INSERT INTO t" + std::to_string(t) + " VALUES (" +
+                     std::to_string(i) + ");");
+    });
+  for (auto& t : threads)
+    t.join();
+  sink->Flush();
+
+  auto lines = read_lines(path);
+  ASSERT_EQ(lines.size(), 4000u);
+  // порядок сообщений одного потока сохраняется
+  std::vector<int> next(4, 0);
+  for (const auto& line : lines) {
+    int t = line[13] - '0';
+    ASSERT_GE(t, 0);
+    ASSERT_LT(t, 4);
+    EXPECT_EQ(line, "INSERT INTO t" + std::to_string(t) + " VALUES (" +
+                        std::to_string(next[t]++) + ");");
+  }
+  // запись пакетами, а не по строке
+  EXPECT_LT(sink->Writes(), 4000u);
+  sink.reset();
+  std::remove(path.c_str());
+}
+
+TEST(DBDryRunSink, Bounded) {
+  const std::string path = "dry_run_sink_bounded.sql";
+  auto sink = DBDryRunSink::Open(path, 256);
+  ASSERT_NE(sink, nullptr);
+  const std::string msg(100, 'x');
+  for (int i = 0; i < 500; ++i)
+    sink->Append(msg);
+  sink->Flush();
+  EXPECT_EQ(sink->Written(), 500u * (msg.size() + 1));
+  sink.reset();
+  EXPECT_EQ(read_lines(path).size(), 500u);
+  std::remove(path.c_str());
+}
+
+TEST(DBDryRunSink, FlushPerCaller) {
+  const std::string path = "dry_run_sink_flush.sql";
+  auto sink = DBDryRunSink::Open(path, 4096);
+  ASSERT_NE(sink, nullptr);
+  std::vector<std::thread> threads;
+  std::vector<int> flushed(4, 0);
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&sink, &flushed, &path, t]() {
+      std::string last;
+      for (int i = 0; i < 500; ++i) {
+        last = "t" + std::to_string(t) + " " + std::to_string(i);
+        sink->Append(last);
+      }
+      // после Flush в файле все сообщения потока, сколько бы ни
+      //   добавили другие потоки
+      sink->Flush();
+      auto lines = read_lines(path);
+      flushed[t] = std::count(lines.begin(), lines.end(), last);
+    });
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(flushed, std::vector<int>(4, 1));
+  sink.reset();
+  std::remove(path.c_str());
+}
+
+TEST(DBDryRunSink, OpenError) {
+  EXPECT_EQ(DBDryRunSink::Open("no_such_dir/dry_run.sql"), nullptr);
+}
@@ -0,0 +1,85 @@
+/**
+ * asp_db - db api of the project 'asp_therm'
+ * ===================================================================
+ * * test_fixtures *
+ *   Общие для тестов таблицы примера библиотеки, параметры
+ * подключений и наборы книг
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef TESTS__TEST_FIXTURES_H
+#define TESTS__TEST_FIXTURES_H
+
+#include "asp_db/db_connection.h"
+#include "library_structs.h"
+#include "library_tables.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** \brief Таблицы примера библиотеки */
+inline LibraryDBTables test_ldb;
+
+/**
+ * \brief Параметры подключения к БД в памяти
+ * \param name Имя БД, подключения с одним именем делят хранилище
+ * \param faults Конфигурация внесения ошибок, nullptr - без обёртки
+ * */
+inline db_parameters test_memory_parameters(
+    const std::string& name,
+    std::shared_ptr<db_fault_config> faults = nullptr) {
+  db_parameters p;
+  p.supplier = db_client::MEMORY;
+  p.name = name;
+  p.is_dry_run = false;
+  p.faults = faults;
+  return p;
+}
+
+/**
+ * \brief Параметры подключения к файлу SQLite `name`, файл базы и
+ *   журналы WAL прошлого запуска удаляются
+ * */
+inline db_parameters test_sqlite_parameters(const std::string& name) {
+  db_parameters p;
+  p.supplier = db_client::SQLITE;
+  p.name = name;
+  p.is_dry_run = false;
+  for (const char* suffix : {"", "-wal", "-shm"})
+    std::remove((name + suffix).c_str());
+  return p;
+}
+
+/**
+ * \brief Книга без id, все остальные поля заданы
+ * */
+inline book test_book(const std::string& title,
+                      int year = 1900,
+                      language_t lang = lang_eng) {
+  book b;
+  book_construct(b, -1, lang, title, year, book::f_full & ~book::f_id);
+  return b;
+}
+
+/**
+ * \brief Книга "Book <i>" с годом издания 1900 + i
+ * */
+inline book test_numbered_book(int i) {
+  return test_book("Book " + std::to_string(i), 1900 + i);
+}
+
+/**
+ * \brief Книги Hobbit, Dune, Solaris без id
+ * */
+inline std::vector<book> test_books() {
+  return {test_book("Hobbit", 1937), test_book("Dune", 1965),
+          test_book("Solaris", 1961, lang_rus)};
+}
+
+#endif  // !TESTS__TEST_FIXTURES_H
@@ -0,0 +1,90 @@
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_group_commit.h"
+#include "test_fixtures.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(DBGroupCommit, MergesConcurrentRows) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(
+      dbm.ResetConnectionParameters(test_memory_parameters("group_merge"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  db_group_commit_parameters gp;
+  gp.window = std::chrono::milliseconds(50);
+  gp.max_rows = 8;
+  dbm.EnableGroupCommit(gp);
+
+  const int threads_count = 16;
+  std::vector<int> ids(threads_count, -1);
+  std::vector<mstatus_t> statuses(threads_count, STATUS_DEFAULT);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_count; ++i)
+    threads.emplace_back([&dbm, &ids, &statuses, i]() {
+      statuses[i] = dbm.SaveSingleRow(test_numbered_book(i), &ids[i]);
+    });
+  for (auto& t : threads)
+    t.join();
+
+  for (int i = 0; i < threads_count; ++i)
+    EXPECT_TRUE(is_status_ok(statuses[i])) << i;
+  // каждый поток получил свой id
+  std::vector<int> sorted(ids);
+  std::sort(sorted.begin(), sorted.end());
+  EXPECT_TRUE(std::adjacent_find(sorted.begin(), sorted.end()) ==
+              sorted.end());
+  EXPECT_GT(sorted.front(), 0);
+
+  const DBGroupCommit* gc = dbm.GetGroupCommit();
+  ASSERT_NE(gc, nullptr);
+  EXPECT_EQ(gc->Rows(), uint64_t(threads_count));
+  EXPECT_LT(gc->Groups(), uint64_t(threads_count));
+
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  ASSERT_EQ(r.size(), size_t(threads_count));
+  for (const auto& b : r) {
+    int i = b.first_pub_year - 1900;
+    ASSERT_GE(i, 0);
+    ASSERT_LT(i, threads_count);
+    EXPECT_EQ(b.id, ids[i]);
+    EXPECT_EQ(b.title, "Book " + std::to_string(i));
+  }
+}
+
+TEST(DBGroupCommit, FailedRowDoesNotFailGroup) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(
+      dbm.ResetConnectionParameters(test_memory_parameters("group_failed"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(test_numbered_book(0))));
+  db_group_commit_parameters gp;
+  gp.window = std::chrono::milliseconds(200);
+  gp.max_rows = 3;
+  dbm.EnableGroupCommit(gp);
+
+  // строка 0 уже добавлена - нарушение уникальности
+  std::vector<int> ids(3, -1);
+  std::vector<mstatus_t> statuses(3, STATUS_DEFAULT);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i)
+    threads.emplace_back([&dbm, &ids, &statuses, i]() {
+      statuses[i] = dbm.SaveSingleRow(test_numbered_book(i), &ids[i]);
+    });
+  for (auto& t : threads)
+    t.join();
+
+  EXPECT_FALSE(is_status_ok(statuses[0]));
+  EXPECT_TRUE(is_status_ok(statuses[1]));
+  EXPECT_TRUE(is_status_ok(statuses[2]));
+  EXPECT_GT(ids[1], 0);
+  EXPECT_GT(ids[2], 0);
+  EXPECT_NE(ids[1], ids[2]);
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  EXPECT_EQ(r.size(), 3u);
+}
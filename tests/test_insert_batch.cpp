@@ -0,0 +1,76 @@
+#include "asp_db/db_insert_batch.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+LibraryDBTables batch_ldb;
+}  // namespace
+
+TEST(DBInsertBatch, AppendRows) {
+  db_insert_batch batch;
+  EXPECT_FALSE(batch.HasColumns());
+  ASSERT_TRUE(batch.SetColumns({0, 2, 3}));
+  batch.Reserve(100);
+  for (size_t i = 0; i < 100; ++i) {
+    batch.Append(std::to_string(i));
+    // у нечётных строк значение второго столбца отсутствует
+    if (i % 2)
+      batch.AppendNull();
+    else
+      batch.Append("'title_" + std::to_string(i) + "'");
+    batch.CommitRow();
+  }
+  ASSERT_EQ(batch.RowsSize(), 100u);
+  ASSERT_EQ(batch.ColumnsSize(), 3u);
+  EXPECT_FALSE(batch.SetColumns({1}));
+  EXPECT_EQ(batch.ColumnIndex(1), 2u);
+  EXPECT_EQ(batch.Value(70, 0), "70");
+  EXPECT_EQ(batch.Value(70, 1), "'title_70'");
+  EXPECT_TRUE(batch.IsNull(71, 1));
+  EXPECT_FALSE(batch.IsNull(71, 0));
+  // незаполненный столбец строки отмечен отсутствующим
+  EXPECT_TRUE(batch.AllNull(2));
+  EXPECT_FALSE(batch.AllNull(1));
+
+  auto row = batch.Row(65);
+  EXPECT_EQ(row.size(), 1u);
+  EXPECT_EQ(row.at(0), "65");
+
+  batch.Clear();
+  EXPECT_TRUE(batch.Empty());
+  EXPECT_EQ(batch.ColumnsSize(), 3u);
+  batch.Append("1");
+  batch.CommitRow();
+  EXPECT_EQ(batch.RowsSize(), 1u);
+  EXPECT_EQ(batch.Value(0, 0), "1");
+  EXPECT_TRUE(batch.IsNull(0, 1));
+}
+
+TEST(DBInsertBatch, InsertSetup) {
+  std::vector<book> books(3);
+  book_construct(books[0], 4, lang_eng, "Hobbit", 1937, book::f_full);
+  book_construct(books[1], -1, lang_eng, "Dune", 1965, book::f_full);
+  book_construct(books[2], 6, lang_rus, "Solaris", 1961, book::f_full);
+  auto setup = batch_ldb.InitInsertSetup<book>(books);
+  ASSERT_NE(setup, nullptr);
+  const auto& batch = setup->batch;
+  ASSERT_EQ(batch.RowsSize(), 3u);
+  ASSERT_EQ(batch.ColumnsSize(), 4u);
+  // id второй строки не задан и подставляется значением по умолчанию
+  size_t id_col = 0;
+  while (batch.ColumnIndex(id_col) != setup->IndexByFieldId(BOOK_ID))
+    ++id_col;
+  EXPECT_EQ(batch.Value(0, id_col), "4");
+  EXPECT_TRUE(batch.IsNull(1, id_col));
+  EXPECT_EQ(batch.Value(2, id_col), "6");
+
+  auto tree = setup->InitInsertTree();
+  ASSERT_NE(tree, nullptr);
+  auto ws = tree->GetString();
+  EXPECT_NE(ws.find("Hobbit"), std::string::npos);
+  EXPECT_EQ(ws.find("Dune"), std::string::npos);
+}
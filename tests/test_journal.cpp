@@ -0,0 +1,108 @@
+#include "asp_db/db_journal.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asp_db;
+
+TEST(DBJournal, RoundTrip) {
+  const std::string path = "journal_round_trip.bin";
+  {
+    auto journal = DBJournalWriter::Open(path);
+    ASSERT_NE(journal, nullptr);
+    EXPECT_EQ(DBJournalWriter::Open(path), journal);
+    uint32_t first = journal->NextConnectionId();
+    uint32_t second = journal->NextConnectionId();
+    EXPECT_NE(first, second);
+    journal->Append(first, "begin;");
+    journal->Append(second, "begin;");
+    journal->Append(first, std::string(300, 'x'));
+    journal->Append(first, "");
+    journal->Append(second, "commit;");
+    journal->Flush();
+  }
+  DBJournalReader reader(path);
+  ASSERT_TRUE(reader.IsOpen());
+  std::vector<db_journal_record> records;
+  db_journal_record record;
+  while (reader.Next(&record))
+    records.push_back(record);
+  EXPECT_FALSE(reader.IsCorrupted());
+  ASSERT_EQ(records.size(), 5u);
+  EXPECT_EQ(records[0].sql, "begin;");
+  EXPECT_EQ(records[2].sql, std::string(300, 'x'));
+  EXPECT_EQ(records[3].sql, "");
+  EXPECT_EQ(records[4].sql, "commit;");
+  EXPECT_EQ(records[0].connection_id, records[2].connection_id);
+  EXPECT_EQ(records[1].connection_id, records[4].connection_id);
+  for (size_t i = 1; i < records.size(); ++i)
+    EXPECT_GE(records[i].time_us, records[i - 1].time_us);
+  std::remove(path.c_str());
+}
+
+TEST(DBJournal, Threads) {
+  const std::string path = "journal_threads.bin";
+  {
+    auto journal = DBJournalWriter::Open(path);
+    ASSERT_NE(journal, nullptr);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&journal]() {
+        uint32_t id = journal->NextConnectionId();
+        for (int i = 0; i < 500; ++i)
+          journal->Append(id, "SELECT " + std::to_string(i) + ";");
+      });
+    for (auto& t : threads)
+      t.join();
+  }
+  DBJournalReader reader(path);
+  std::vector<int> next(5, 0);
+  db_journal_record record;
+  size_t count = 0;
+  while (reader.Next(&record)) {
+    ASSERT_GE(record.connection_id, 1u);
+    ASSERT_LE(record.connection_id, 4u);
+    EXPECT_EQ(record.sql, "SELECT " +
+                              std::to_string(next[record.connection_id]++) +
+                              ";");
+    ++count;
+  }
+  EXPECT_EQ(count, 2000u);
+  std::remove(path.c_str());
+}
+
+TEST(DBJournal, Corrupted) {
+  const std::string path = "journal_corrupted.bin";
+  {
+    auto journal = DBJournalWriter::Open(path);
+    ASSERT_NE(journal, nullptr);
+    journal->Append(1, "SELECT 1;");
+    journal->Append(1, "SELECT 2;");
+  }
+  // обрезать последнюю запись
+  std::string data;
+  {
+    std::ifstream in(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size() - 3);
+  }
+  DBJournalReader reader(path);
+  db_journal_record record;
+  EXPECT_TRUE(reader.Next(&record));
+  EXPECT_EQ(record.sql, "SELECT 1;");
+  EXPECT_FALSE(reader.Next(&record));
+  EXPECT_TRUE(reader.IsCorrupted());
+  std::remove(path.c_str());
+
+  DBJournalReader missing("no_such_journal.bin");
+  EXPECT_FALSE(missing.IsOpen());
+  EXPECT_FALSE(missing.Next(&record));
+}
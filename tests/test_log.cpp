@@ -0,0 +1,36 @@
+#include "asp_db/db_log.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace asp_db;
+
+namespace {
+int evaluated = 0;
+
+std::string counted(const std::string& str) {
+  ++evaluated;
+  return str;
+}
+}  // namespace
+
+TEST(DBLog, Format) {
+  EXPECT_EQ(db_log_format("Медленный запрос: ", 1500, " мкс, строк: ", 2u),
+            "Медленный запрос: 1500 мкс, строк: 2");
+  EXPECT_EQ(db_log_format(std::string("a"), 'b', "c"), "abc");
+}
+
+TEST(DBLog, CompileTimeLevel) {
+  EXPECT_TRUE(db_log_enabled(io_loglvl::err_logs));
+  EXPECT_FALSE(db_log_enabled(io_loglvl::no_log));
+  EXPECT_EQ(db_log_enabled(io_loglvl::debug_logs),
+            ASP_DB_LOG_LEVEL >= ASP_DB_LOG_LEVEL_DEBUG);
+
+  evaluated = 0;
+  DB_LOG_ERR("error: ", counted("evaluated"));
+  EXPECT_EQ(evaluated, 1);
+  // части отключенного сообщения не вычисляются
+  DB_LOG_DEBUG("debug: ", counted("not evaluated"));
+  EXPECT_EQ(evaluated, db_log_enabled(io_loglvl::debug_logs) ? 2 : 1);
+}
@@ -0,0 +1,140 @@
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_metrics.h"
+#include "library_structs.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+LibraryDBTables metrics_ldb;
+
+const db_metric_histogram* find_metric(const db_metrics_snapshot& s,
+                                       db_metric_op op,
+                                       db_metric_stage stage,
+                                       db_table table) {
+  auto it = s.values.find(db_metric_key{op, stage, table});
+  return (it != s.values.end()) ? &it->second : nullptr;
+}
+}  // namespace
+
+TEST(DBMetrics, Buckets) {
+  for (uint64_t v : {0ull, 15ull, 16ull, 31ull, 1000ull, 123456789ull}) {
+    size_t i = db_metric_histogram::BucketIndex(v);
+    EXPECT_LE(v, db_metric_histogram::BucketUpperBound(i));
+    if (i > 0) {
+      EXPECT_GT(v, db_metric_histogram::BucketUpperBound(i - 1));
+    }
+  }
+  // относительная погрешность корзины не больше 1/16
+  size_t i = db_metric_histogram::BucketIndex(1000000);
+  EXPECT_LE(db_metric_histogram::BucketUpperBound(i), 1000000 + 1000000 / 16);
+  EXPECT_EQ(db_metric_histogram::BucketIndex(~0ull),
+            db_metric_histogram::buckets_count - 1);
+
+  db_metric_histogram h;
+  h.buckets.resize(db_metric_histogram::buckets_count);
+  for (uint64_t v = 1; v <= 100; ++v) {
+    h.buckets[db_metric_histogram::BucketIndex(v * 1000)]++;
+    h.count++;
+    h.max_ns = v * 1000;
+  }
+  EXPECT_NEAR(double(h.Percentile(0.5)), 50000.0, 50000.0 / 16);
+  EXPECT_NEAR(double(h.Percentile(0.99)), 99000.0, 99000.0 / 16);
+  EXPECT_EQ(h.Percentile(1.0), 100000u);
+}
+
+TEST(DBMetrics, ThreadsAndReset) {
+  DBMetrics::SetEnabled(true);
+  DBMetrics::Reset();
+  const db_metric_key key{db_metric_op::none, db_metric_stage::execute, 7};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&key]() {
+      for (int i = 0; i < 1000; ++i)
+        DBMetrics::Record(key, 100 + i, i % 10 != 0);
+    });
+  for (auto& t : threads)
+    t.join();
+  auto s = DBMetrics::Snapshot();
+  const auto* h =
+      find_metric(s, db_metric_op::none, db_metric_stage::execute, 7);
+  ASSERT_NE(h, nullptr);
+  EXPECT_EQ(h->count, 4000u);
+  EXPECT_EQ(h->errors, 400u);
+  EXPECT_EQ(h->max_ns, 1099u);
+
+  // гистограммы завершившихся потоков перенесены в общие
+  size_t threads_count = DBMetrics::ThreadsCount();
+  for (int t = 0; t < 4; ++t)
+    std::thread([&key]() { DBMetrics::Record(key, 10); }).join();
+  EXPECT_LE(DBMetrics::ThreadsCount(), threads_count);
+  s = DBMetrics::Snapshot();
+  h = find_metric(s, db_metric_op::none, db_metric_stage::execute, 7);
+  ASSERT_NE(h, nullptr);
+  EXPECT_EQ(h->count, 4004u);
+
+  DBMetrics::Reset();
+  s = DBMetrics::Snapshot();
+  h = find_metric(s, db_metric_op::none, db_metric_stage::execute, 7);
+  ASSERT_NE(h, nullptr);
+  EXPECT_EQ(h->count, 0u);
+  DBMetrics::SetEnabled(false);
+}
+
+TEST(DBMetrics, ManagerStages) {
+  DBMetrics::SetEnabled(true);
+  DBMetrics::Reset();
+  db_parameters p;
+  p.supplier = db_client::MEMORY;
+  p.name = "metrics_manager";
+  p.is_dry_run = false;
+  DBConnectionManager dbm(&metrics_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(p)));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  std::vector<book> books(1);
+  book_construct(books[0], -1, lang_eng, "Dune", 1965,
+                 book::f_full & ~book::f_id);
+  ASSERT_TRUE(is_status_ok(dbm.SaveVectorOfRows(books)));
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  // повторная вставка нарушает уникальный комплекс
+  EXPECT_FALSE(is_status_ok(dbm.SaveVectorOfRows(books)));
+  DBMetrics::SetEnabled(false);
+
+  auto s = DBMetrics::Snapshot();
+  for (auto stage : {db_metric_stage::total, db_metric_stage::clone_connection,
+                     db_metric_stage::connect, db_metric_stage::execute,
+                     db_metric_stage::close_connection}) {
+    const auto* h =
+        find_metric(s, db_metric_op::select_rows, stage, table_book);
+    ASSERT_NE(h, nullptr) << db_metric_stage_to_string(stage);
+    EXPECT_EQ(h->count, 1u);
+  }
+  const auto* data = find_metric(s, db_metric_op::select_rows,
+                                 db_metric_stage::set_select_data, table_book);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(data->count, 1u);
+  const auto* insert = find_metric(s, db_metric_op::insert_rows,
+                                   db_metric_stage::total, table_book);
+  ASSERT_NE(insert, nullptr);
+  EXPECT_EQ(insert->count, 2u);
+  EXPECT_EQ(insert->errors, 1u);
+  const auto* rollback = find_metric(s, db_metric_op::insert_rows,
+                                     db_metric_stage::rollback, table_book);
+  ASSERT_NE(rollback, nullptr);
+  EXPECT_EQ(rollback->count, 1u);
+
+  std::string text = dbm.GetMetricsPrometheus();
+  EXPECT_NE(text.find("# TYPE asp_db_stage_duration_seconds histogram"),
+            std::string::npos);
+  EXPECT_NE(text.find("asp_db_stage_duration_seconds_count{op=\"insert_rows\","
+                      "stage=\"total\",table=\"book\"} 2"),
+            std::string::npos);
+  EXPECT_NE(text.find("asp_db_stage_errors_total{op=\"insert_rows\","
+                      "stage=\"total\",table=\"book\"} 1"),
+            std::string::npos);
+}
@@ -0,0 +1,126 @@
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_mirror_table.h"
+#include "test_fixtures.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+/**
+ * \brief Дождаться выполнения `done`, обновление по уведомлению
+ *   выполняется в потоке слушателя
+ * */
+bool wait_for(const std::function<bool()>& done) {
+  auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > until)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+}  // namespace
+
+TEST(DBMirrorTable, LoadAndRefreshById) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(
+      dbm.ResetConnectionParameters(test_memory_parameters("mirror_by_id"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  ASSERT_TRUE(is_status_ok(dbm.SaveVectorOfRows(std::vector<book>{
+      test_book("Hobbit", 1937), test_book("Dune", 1965)})));
+
+  DBMirrorTable<table_book, book, int> mirror(
+      &dbm, &test_ldb, [](const book& b) { return b.id; });
+  mirror.SetWatermark(BOOK_ID, [](const book& b) { return int64_t(b.id); });
+  // первый Refresh - полная загрузка
+  ASSERT_TRUE(is_status_ok(mirror.Refresh()));
+  EXPECT_EQ(mirror.Size(), 2u);
+  ASSERT_TRUE(mirror.GetWatermark().has_value());
+  EXPECT_EQ(*mirror.GetWatermark(), 2);
+  auto dune = mirror.Find(2);
+  ASSERT_TRUE(dune.has_value());
+  EXPECT_EQ(dune->title, "Dune");
+  EXPECT_FALSE(mirror.Find(3).has_value());
+
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(test_book("Solaris", 1961))));
+  ASSERT_TRUE(is_status_ok(mirror.Refresh()));
+  EXPECT_EQ(mirror.Size(), 3u);
+  EXPECT_EQ(*mirror.GetWatermark(), 3);
+  ASSERT_TRUE(mirror.Find(3).has_value());
+  EXPECT_EQ(mirror.Find(3)->title, "Solaris");
+}
+
+TEST(DBMirrorTable, TextWatermark) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(
+      dbm.ResetConnectionParameters(test_memory_parameters("mirror_by_text"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  // заголовки в формате времени ISO 8601 вместо столбца updated_at
+  ASSERT_TRUE(is_status_ok(
+      dbm.SaveSingleRow(test_book("2021-01-01 10:00:00", 2021))));
+
+  DBMirrorTable<table_book, book, int, std::string> mirror(
+      &dbm, &test_ldb, [](const book& b) { return b.id; });
+  mirror.SetWatermark(
+      BOOK_TITLE, [](const book& b) { return b.title; }, true);
+  ASSERT_TRUE(is_status_ok(mirror.Load()));
+  EXPECT_EQ(mirror.GetWatermark(), std::string("2021-01-01 10:00:00"));
+
+  ASSERT_TRUE(is_status_ok(
+      dbm.SaveSingleRow(test_book("2021-01-02 09:00:00", 2021))));
+  ASSERT_TRUE(is_status_ok(mirror.Refresh()));
+  EXPECT_EQ(mirror.Size(), 2u);
+  EXPECT_EQ(mirror.GetWatermark(), std::string("2021-01-02 09:00:00"));
+  size_t rows = 0;
+  mirror.ForEach([&rows](const book&) { ++rows; });
+  EXPECT_EQ(rows, 2u);
+}
+
+TEST(DBMirrorTable, SubscribeChanges) {
+  auto p = test_memory_parameters("mirror_changes");
+  DBConnectionManager reader(&test_ldb), writer(&test_ldb);
+  ASSERT_TRUE(is_status_aval(reader.ResetConnectionParameters(p)));
+  ASSERT_TRUE(is_status_aval(writer.ResetConnectionParameters(p)));
+  ASSERT_TRUE(is_status_ok(writer.CreateTable(table_book)));
+  ASSERT_TRUE(is_status_ok(writer.SaveVectorOfRows(std::vector<book>{
+      test_book("Hobbit", 1937), test_book("Dune", 1965)})));
+  ASSERT_TRUE(is_status_ok(reader.StartChangeListener({table_book})));
+
+  // по числу вызовов функции водяного знака видно, какие строки
+  //   прочитаны: новые при Refresh или все при Load
+  std::atomic<size_t> wm_calls{0};
+  DBMirrorTable<table_book, book, int> mirror(
+      &reader, &test_ldb, [](const book& b) { return b.id; });
+  mirror.SetWatermark(BOOK_ID, [&wm_calls](const book& b) {
+    ++wm_calls;
+    return int64_t(b.id);
+  });
+  ASSERT_TRUE(is_status_ok(mirror.Load()));
+  ASSERT_TRUE(mirror.SubscribeChanges());
+  EXPECT_EQ(wm_calls, 2u);
+
+  // INSERT догружается инкрементально
+  ASSERT_TRUE(is_status_ok(writer.SaveSingleRow(test_book("Solaris", 1961))));
+  ASSERT_TRUE(wait_for([&mirror]() { return mirror.Size() == 3; }));
+  EXPECT_EQ(wm_calls, 3u);
+  EXPECT_EQ(*mirror.GetWatermark(), 3);
+
+  // DELETE не виден по водяному знаку - полная перезагрузка
+  WhereTreeConstructor<table_book> c(&test_ldb);
+  WhereTree<table_book> wt(c);
+  wt.Init(c.Eq(BOOK_ID, 1));
+  ASSERT_TRUE(is_status_ok(writer.DeleteRows(wt)));
+  ASSERT_TRUE(wait_for([&mirror]() { return mirror.Size() == 2; }));
+  EXPECT_EQ(wm_calls, 5u);
+  EXPECT_FALSE(mirror.Find(1).has_value());
+  EXPECT_TRUE(mirror.Find(3).has_value());
+
+  mirror.UnsubscribeChanges();
+  reader.StopChangeListener();
+}
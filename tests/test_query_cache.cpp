@@ -0,0 +1,161 @@
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_queries_setup_select.h"
+#include "asp_db/db_query_cache.h"
+#include "asp_db/db_where.h"
+#include "library_structs.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+namespace {
+LibraryDBTables cache_ldb;
+
+/**
+ * \brief Заполнить результат выборки `n` строками
+ * */
+void fill_result(db_query_select_result* result, int n) {
+  for (int i = 0; i < n; ++i) {
+    db_query_basesetup::row_values row;
+    row.emplace(0, std::to_string(i));
+    row.emplace(1, "title_" + std::to_string(i));
+    result->values_vec.emplace_back(row);
+  }
+}
+}  // namespace
+
+TEST(DBQueryCache, KeyIncludesWhere) {
+  WhereTreeConstructor<table_book> c(&cache_ldb);
+  WhereTree<table_book> wt1(c);
+  wt1.Init(c.Eq(BOOK_TITLE, "Hobbit"));
+  WhereTree<table_book> wt2(c);
+  wt2.Init(c.Eq(BOOK_TITLE, "Dune"));
+  auto s1 = db_query_select_setup::Init(wt1);
+  auto s2 = db_query_select_setup::Init(wt2);
+  auto s_all = db_query_select_setup::Init(&cache_ldb, table_book, true);
+
+  EXPECT_NE(DBQueryCache::MakeKey(*s1), DBQueryCache::MakeKey(*s2));
+  EXPECT_NE(DBQueryCache::MakeKey(*s1), DBQueryCache::MakeKey(*s_all));
+  EXPECT_EQ(DBQueryCache::MakeKey(*s1),
+            DBQueryCache::MakeKey(*db_query_select_setup::Init(wt1)));
+}
+
+TEST(DBQueryCache, PutGetInvalidate) {
+  DBQueryCache cache(db_query_cache_parameters{});
+  auto books = db_query_select_setup::Init(&cache_ldb, table_book, true);
+  auto authors = db_query_select_setup::Init(&cache_ldb, table_author, true);
+  db_query_select_result r(*books);
+  fill_result(&r, 3);
+
+  db_query_select_result out(*books);
+  EXPECT_FALSE(cache.Get(*books, &out));
+  cache.Put(*books, r, 0);
+  cache.Put(*authors, r, 0);
+  ASSERT_TRUE(cache.Get(*books, &out));
+  EXPECT_EQ(out.values_vec.size(), 3u);
+  EXPECT_EQ(out.values_vec[2].at(1), "title_2");
+  EXPECT_GT(cache.MemoryUsage(), 0u);
+
+  cache.InvalidateTable(table_book);
+  EXPECT_FALSE(cache.Get(*books, &out));
+  EXPECT_EQ(cache.Size(), 1u);
+  cache.Clear();
+  EXPECT_EQ(cache.Size(), 0u);
+  EXPECT_EQ(cache.MemoryUsage(), 0u);
+}
+
+TEST(DBQueryCache, LRUEviction) {
+  WhereTreeConstructor<table_book> c(&cache_ldb);
+  auto all = db_query_select_setup::Init(&cache_ldb, table_book, true);
+  db_query_select_result r(*all);
+  fill_result(&r, 16);
+  db_query_cache_parameters p;
+  DBQueryCache probe(p);
+  probe.Put(*all, r, 0);
+  // бюджет на две записи
+  p.memory_budget = probe.MemoryUsage() * 2 + 64;
+  DBQueryCache cache(p);
+
+  std::vector<std::shared_ptr<db_query_select_setup>> setups;
+  for (int i = 0; i < 3; ++i) {
+    WhereTree<table_book> wt(c);
+    wt.Init(c.Eq(BOOK_PUB_YEAR, 1900 + i));
+    setups.push_back(db_query_select_setup::Init(wt));
+  }
+  db_query_select_result out(*all);
+  cache.Put(*setups[0], r, 0);
+  cache.Put(*setups[1], r, 0);
+  // обращение к первой записи делает давно используемой вторую
+  EXPECT_TRUE(cache.Get(*setups[0], &out));
+  cache.Put(*setups[2], r, 0);
+  EXPECT_EQ(cache.Size(), 2u);
+  EXPECT_TRUE(cache.Get(*setups[0], &out));
+  EXPECT_FALSE(cache.Get(*setups[1], &out));
+  EXPECT_TRUE(cache.Get(*setups[2], &out));
+  EXPECT_LE(cache.MemoryUsage(), p.memory_budget);
+}
+
+TEST(DBQueryCache, TTLExpire) {
+  db_query_cache_parameters p;
+  p.ttl = std::chrono::milliseconds(10);
+  DBQueryCache cache(p);
+  auto all = db_query_select_setup::Init(&cache_ldb, table_book, true);
+  db_query_select_result r(*all);
+  fill_result(&r, 1);
+  cache.Put(*all, r, 0);
+  db_query_select_result out(*all);
+  EXPECT_TRUE(cache.Get(*all, &out));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(cache.Get(*all, &out));
+  EXPECT_EQ(cache.Size(), 0u);
+}
+
+TEST(DBQueryCache, RejectsPutAfterInvalidate) {
+  DBQueryCache cache(db_query_cache_parameters{});
+  auto all = db_query_select_setup::Init(&cache_ldb, table_book, true);
+  db_query_select_result r(*all);
+  fill_result(&r, 2);
+  // выборка началась до изменения таблицы, а закончилась после
+  const uint64_t generation = cache.Generation(table_book);
+  cache.InvalidateTable(table_book);
+  cache.Put(*all, r, generation);
+  db_query_select_result out(*all);
+  EXPECT_FALSE(cache.Get(*all, &out));
+  EXPECT_EQ(cache.Size(), 0u);
+
+  cache.Put(*all, r, cache.Generation(table_book));
+  EXPECT_TRUE(cache.Get(*all, &out));
+}
+
+TEST(DBQueryCache, ManagerWriteInvalidatesSelect) {
+  db_parameters p;
+  p.supplier = db_client::MEMORY;
+  p.name = "query_cache_manager";
+  p.is_dry_run = false;
+  DBConnectionManager dbm(&cache_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(p)));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  dbm.EnableQueryCache(db_query_cache_parameters{});
+
+  book b;
+  book_construct(b, -1, lang_eng, "Hobbit", 1937, book::f_full & ~book::f_id);
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(b)));
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  EXPECT_EQ(r.size(), 1u);
+
+  // добавление через менеджер инвалидирует закэшированную выборку
+  book_construct(b, -1, lang_eng, "Dune", 1965, book::f_full & ~book::f_id);
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(b)));
+  r.clear();
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  EXPECT_EQ(r.size(), 2u);
+
+  ASSERT_TRUE(is_status_ok(dbm.DeleteAllRows(table_book)));
+  r.clear();
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  EXPECT_TRUE(r.empty());
+  dbm.DisableQueryCache();
+}
@@ -0,0 +1,104 @@
+#include "asp_db/db_query_stats.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asp_db;
+
+TEST(DBQueryStats, Normalize) {
+  EXPECT_EQ(db_query_normalize("SELECT * FROM book WHERE (pub_year > 1950) "
+                               "AND (title = 'Dune');"),
+            "SELECT * FROM book WHERE (pub_year > ?) AND (title = ?);");
+  // экранированная кавычка, числа в идентификаторах и вещественные
+  EXPECT_EQ(db_query_normalize("UPDATE t1 SET a = 'it''s',\n  b = -1.5e-3;"),
+            "UPDATE t1 SET a = ?, b = -?;");
+  EXPECT_EQ(db_query_normalize("SELECT \"col 1\" FROM t WHERE x IN (1, 2,3)"),
+            "SELECT \"col 1\" FROM t WHERE x IN (?)");
+  // INSERT с разным числом строк - один текст
+  std::string one = db_query_normalize(
+      "INSERT INTO book (title, pub_year, lang) VALUES ('Dune', 1965, 1) "
+      "RETURNING id;");
+  std::string three = db_query_normalize(
+      "INSERT INTO book (title, pub_year, lang) VALUES ('Dune', 1965, 1), "
+      "('Hobbit', 1937, 1),('Solaris', 1961, 0) RETURNING id;");
+  EXPECT_EQ(one, "INSERT INTO book (title, pub_year, lang) VALUES (?) "
+                 "RETURNING id;");
+  EXPECT_EQ(one, three);
+  EXPECT_EQ(db_query_fingerprint(one), db_query_fingerprint(three));
+  // строки с NULL отличаются по форме
+  EXPECT_EQ(db_query_normalize("VALUES ('a', NULL), ('b', NULL), ('c', 2)"),
+            "VALUES (?, NULL), (?)");
+}
+
+TEST(DBQueryStats, RecordAndTop) {
+  DBQueryStats stats;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&stats, t]() {
+      for (int i = 0; i < 100; ++i) {
+        stats.Record("SELECT * FROM book WHERE id = " + std::to_string(i), 1000,
+                     1, 10);
+        if (t == 0)
+          stats.Record("DELETE FROM book WHERE id = " + std::to_string(i),
+                       100000 + i, 0, 0);
+      }
+    });
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(stats.Size(), 2u);
+
+  auto top = stats.Top(1);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].query, "DELETE FROM book WHERE id = ?");
+  EXPECT_EQ(top[0].calls, 100u);
+  EXPECT_EQ(top[0].min_ns, 100000u);
+  EXPECT_EQ(top[0].max_ns, 100099u);
+
+  top = stats.Top(5, db_query_stats_order::calls);
+  ASSERT_EQ(top.size(), 2u);
+  EXPECT_EQ(top[0].query, "SELECT * FROM book WHERE id = ?");
+  EXPECT_EQ(top[0].calls, 400u);
+  EXPECT_EQ(top[0].rows, 400u);
+  EXPECT_EQ(top[0].bytes, 4000u);
+  EXPECT_NE(stats.Report(2).find("DELETE FROM book WHERE id = ?"),
+            std::string::npos);
+
+  stats.Reset();
+  EXPECT_EQ(stats.Size(), 0u);
+}
+
+TEST(DBQueryStats, Bounded) {
+  DBQueryStats stats(64);
+  // частый запрос не вытесняется редкими
+  for (int i = 0; i < 10; ++i)
+    stats.Record("SELECT 1 FROM hot", 10, 0, 0);
+  for (int i = 0; i < 500; ++i)
+    stats.Record("SELECT 1 FROM t" + std::to_string(i), 10, 0, 0);
+  EXPECT_LE(stats.Size(), 64u);
+  EXPECT_GE(stats.Evicted(), 500u - 64u);
+  auto top = stats.Top(1, db_query_stats_order::calls);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].query, "SELECT ? FROM hot");
+  EXPECT_EQ(top[0].calls, 10u);
+}
+
+TEST(DBQueryStats, Statement) {
+  DBQueryStats stats;
+  {
+    DBQueryStats::Statement st(stats);
+    EXPECT_FALSE(st.IsActive());
+    st.Finish("SELECT 1", 0, 0);
+  }
+  EXPECT_EQ(stats.Size(), 0u);
+  stats.SetEnabled(true);
+  DBQueryStats::Statement st(stats);
+  EXPECT_TRUE(st.IsActive());
+  st.Finish("SELECT 1", 2, 5);
+  auto top = stats.Top(1);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].rows, 2u);
+  EXPECT_EQ(top[0].bytes, 5u + 8u);
+}
@@ -0,0 +1,94 @@
+#include "asp_db/db_queries_setup_select.h"
+#include "asp_db/db_table_descriptor.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+LibraryDBTables descriptor_ldb;
+const IDBTables* descriptor_tables = &descriptor_ldb;
+}  // namespace
+
+TEST(DBTableDescriptor, InsertValues) {
+  book hobbit;
+  book_construct(hobbit, -1, lang_eng, "Hobbit", 1937,
+                 book::f_full & ~book::f_id);
+  auto setup = descriptor_ldb.InitInsertSetup<book>({hobbit});
+  ASSERT_NE(setup, nullptr);
+  ASSERT_EQ(setup->RowsSize(), 1u);
+  const auto row = setup->batch.Row(0);
+  // id не инициализирован и не добавляется
+  EXPECT_EQ(row.size(), 3u);
+  EXPECT_EQ(row.count(setup->IndexByFieldId(BOOK_ID)), 0u);
+  EXPECT_EQ(row.at(setup->IndexByFieldId(BOOK_TITLE)), "Hobbit");
+  EXPECT_EQ(row.at(setup->IndexByFieldId(BOOK_PUB_YEAR)), "1937");
+
+  hobbit.initialized = book::f_title;
+  setup = descriptor_ldb.InitInsertSetup<book>({hobbit});
+  EXPECT_EQ(setup->batch.Row(0).size(), 1u);
+}
+
+TEST(DBTableDescriptor, MoveInsertValues) {
+  std::vector<book> books(2);
+  book_construct(books[0], -1, lang_eng, "Hobbit", 1937,
+                 book::f_full & ~book::f_id);
+  book_construct(books[1], -1, lang_eng, "Dune", 1965,
+                 book::f_full & ~book::f_id);
+  // диапазон lvalue - строки копируются
+  auto setup = descriptor_ldb.InitInsertSetup<book>(books.cbegin(),
+                                                    books.cend());
+  ASSERT_NE(setup, nullptr);
+  ASSERT_EQ(setup->RowsSize(), 2u);
+  EXPECT_EQ(books[0].title, "Hobbit");
+  // rvalue - строки перемещаются в сетап
+  setup = descriptor_ldb.InitInsertSetup<book>(std::move(books));
+  ASSERT_NE(setup, nullptr);
+  ASSERT_EQ(setup->RowsSize(), 2u);
+  const auto row = setup->batch.Row(1);
+  EXPECT_EQ(row.size(), 3u);
+  EXPECT_EQ(row.at(setup->IndexByFieldId(BOOK_TITLE)), "Dune");
+  EXPECT_EQ(row.at(setup->IndexByFieldId(BOOK_PUB_YEAR)), "1965");
+  EXPECT_EQ(row.at(setup->IndexByFieldId(BOOK_LANG)),
+            std::to_string(lang_eng));
+}
+
+TEST(DBTableDescriptor, SelectData) {
+  book dune;
+  book_construct(dune, 12, lang_eng, "Dune", 1965, book::f_full);
+  translation tr;
+  tr.id = 3;
+  tr.book_p.first = 12;
+  tr.lang = lang_rus;
+  tr.translated_name = "Дюна";
+  tr.translators = "Бирюков";
+  tr.initialized = translation::f_full;
+
+  auto book_setup = descriptor_ldb.InitInsertSetup<book>({dune});
+  auto books = db_query_select_setup::Init(&descriptor_ldb, table_book, true);
+  db_query_select_result book_result(*books);
+  book_result.values_vec.push_back(book_setup->batch.Row(0));
+  std::vector<book> out_books;
+  descriptor_tables->SetSelectData(&book_result, &out_books);
+  ASSERT_EQ(out_books.size(), 1u);
+  EXPECT_EQ(out_books[0].id, 12);
+  EXPECT_EQ(out_books[0].title, "Dune");
+  EXPECT_EQ(out_books[0].first_pub_year, 1965);
+  EXPECT_EQ(out_books[0].lang, lang_eng);
+
+  auto tr_setup = descriptor_ldb.InitInsertSetup<translation>({tr});
+  auto trs = db_query_select_setup::Init(&descriptor_ldb, table_translation,
+                                         true);
+  db_query_select_result tr_result(*trs);
+  tr_result.values_vec.push_back(tr_setup->batch.Row(0));
+  std::vector<translation> out_trs;
+  descriptor_tables->SetSelectData(&tr_result, &out_trs);
+  ASSERT_EQ(out_trs.size(), 1u);
+  EXPECT_EQ(out_trs[0].book_p.first, 12);
+  EXPECT_EQ(out_trs[0].lang, lang_rus);
+  EXPECT_EQ(out_trs[0].translated_name, "Дюна");
+  EXPECT_EQ(out_trs[0].translators, "Бирюков");
+}
@@ -0,0 +1,59 @@
+#include "asp_db/db_queries_setup_select.h"
+#include "asp_db/db_table_schema.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+
+namespace {
+LibraryDBTables schema_ldb;
+
+constexpr db_table_schema test_schema({
+    {0x0101, "id", db_variable_type::type_autoinc,
+     ff_primary_key | ff_not_null},
+    {0x0102, "name", db_variable_type::type_text},
+    {0x0203, "value", db_variable_type::type_real, ff_can_be_negative},
+});
+static_assert(test_schema.Size() == 3);
+static_assert(test_schema.IndexOf(0x0203) == 2);
+static_assert(test_schema.IndexOf(0x0303) == db_fields_index::npos);
+}  // namespace
+
+TEST(DBTableSchema, Index) {
+  auto index = test_schema.Index();
+  EXPECT_EQ(index.IndexOf(0x0101), 0u);
+  EXPECT_EQ(index.IndexOf(0x0102), 1u);
+  EXPECT_EQ(index.IndexOf(0x0104), db_fields_index::npos);
+
+  auto fields = test_schema.MakeCollection();
+  ASSERT_EQ(fields.size(), 3u);
+  EXPECT_STREQ(fields[1].fname, "name");
+  EXPECT_TRUE(fields[0].flags.is_primary_key);
+  EXPECT_FALSE(fields[0].flags.can_be_null);
+  EXPECT_TRUE(fields[1].flags.can_be_null);
+  EXPECT_TRUE(fields[2].flags.can_be_negative);
+
+  db_field_schema duplicated[] = {{1, "a", db_variable_type::type_int},
+                                  {1, "b", db_variable_type::type_int}};
+  EXPECT_THROW(db_table_schema<2>{duplicated}, std::logic_error);
+}
+
+TEST(DBTableSchema, TablesAdapter) {
+  const IDBTables* tables = &schema_ldb;
+  const auto& fields = *tables->GetFieldsCollection(table_author);
+  const db_fields_index* index = tables->GetFieldsIndex(table_author);
+  ASSERT_NE(index, nullptr);
+  for (size_t i = 0; i < fields.size(); ++i)
+    EXPECT_EQ(index->IndexOf(fields[i].fid), i);
+  EXPECT_EQ(schema_ldb.GetFieldById<table_author>(AUTHOR_BOOKS).fname,
+            std::string(TABLE_FIELD_NAME(AUTHOR_BOOKS)));
+  EXPECT_THROW(schema_ldb.GetFieldById<table_author>(BOOK_ID),
+               idbtables_exception<table_author>);
+
+  auto setup = db_query_select_setup::Init(&schema_ldb, table_book, true);
+  EXPECT_EQ(setup->fields_index, tables->GetFieldsIndex(table_book));
+  EXPECT_EQ(setup->IndexByFieldId(BOOK_PUB_YEAR), 2u);
+  EXPECT_EQ(setup->IndexByFieldId(AUTHOR_NAME),
+            db_query_basesetup::field_index_end);
+}
@@ -0,0 +1,148 @@
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_trace.h"
+#include "library_structs.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+LibraryDBTables trace_ldb;
+
+size_t count_events(const std::vector<db_trace_event>& events,
+                    db_trace_category category,
+                    const std::string& name) {
+  return std::count_if(events.begin(), events.end(),
+                       [&](const db_trace_event& e) {
+                         return e.category == category && e.name == name;
+                       });
+}
+}  // namespace
+
+TEST(DBTrace, Disabled) {
+  DBTrace::SetEnabled(false);
+  DBTrace::Reset();
+  {
+    DBTrace::Span span(db_trace_category::manager, "Disabled");
+  }
+  EXPECT_TRUE(DBTrace::Collect().empty());
+}
+
+TEST(DBTrace, RingAndThreads) {
+  DBTrace::SetEnabled(true);
+  DBTrace::Reset();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t)
+    threads.emplace_back([]() {
+      for (size_t i = 0; i < DBTrace::ring_capacity + 100; ++i)
+        DBTrace::Span span(db_trace_category::query,
+                           "a very long span name that does not fit");
+    });
+  for (auto& t : threads)
+    t.join();
+  DBTrace::SetEnabled(false);
+
+  auto events = DBTrace::Collect();
+  // в буфере потока остаются последние ring_capacity интервалов
+  EXPECT_EQ(events.size(), 3 * DBTrace::ring_capacity);
+  std::set<uint32_t> tids;
+  for (const auto& e : events)
+    tids.insert(e.tid);
+  EXPECT_EQ(tids.size(), 3u);
+  EXPECT_EQ(events[0].name.size(), db_trace_event::name_size);
+  EXPECT_TRUE(std::is_sorted(
+      events.begin(), events.end(),
+      [](const db_trace_event& a, const db_trace_event& b) {
+        return a.start_ns < b.start_ns;
+      }));
+  DBTrace::Reset();
+  EXPECT_TRUE(DBTrace::Collect().empty());
+}
+
+TEST(DBTrace, RingsReused) {
+  DBTrace::SetEnabled(true);
+  DBTrace::Reset();
+  // снятый буфер завершившегося потока достаётся следующему
+  std::thread([]() {
+    DBTrace::Span span(db_trace_category::query, "first");
+  }).join();
+  DBTrace::Collect();
+  size_t rings_count = DBTrace::RingsCount();
+  for (int t = 0; t < 4; ++t) {
+    std::thread([]() {
+      DBTrace::Span span(db_trace_category::query, "next");
+    }).join();
+    EXPECT_EQ(DBTrace::Collect().size(), t + 2u);
+  }
+  DBTrace::SetEnabled(false);
+  EXPECT_EQ(DBTrace::RingsCount(), rings_count);
+
+  // интервалы прошлых владельцев буфера сохраняются со своими tid
+  auto events = DBTrace::Collect();
+  EXPECT_EQ(count_events(events, db_trace_category::query, "first"), 1u);
+  EXPECT_EQ(count_events(events, db_trace_category::query, "next"), 4u);
+  std::set<uint32_t> tids;
+  for (const auto& e : events)
+    tids.insert(e.tid);
+  EXPECT_EQ(tids.size(), 5u);
+  DBTrace::Reset();
+}
+
+TEST(DBTrace, Transaction) {
+  db_parameters p;
+  p.supplier = db_client::MEMORY;
+  p.name = "trace_manager";
+  p.is_dry_run = false;
+  DBConnectionManager dbm(&trace_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(p)));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+
+  DBTrace::SetEnabled(true);
+  DBTrace::Reset();
+  std::vector<book> books(1);
+  book_construct(books[0], -1, lang_eng, "Dune", 1965,
+                 book::f_full & ~book::f_id);
+  ASSERT_TRUE(is_status_ok(dbm.SaveVectorOfRows(books)));
+  // повторная вставка нарушает уникальный комплекс - откат
+  EXPECT_FALSE(is_status_ok(dbm.SaveVectorOfRows(books)));
+  DBTrace::SetEnabled(false);
+
+  auto events = DBTrace::Collect();
+  EXPECT_EQ(count_events(events, db_trace_category::manager, "Transaction"),
+            2u);
+  EXPECT_EQ(
+      count_events(events, db_trace_category::manager, "CloneConnection"), 2u);
+  EXPECT_EQ(
+      count_events(events, db_trace_category::query, "SetupConnection"), 2u);
+  EXPECT_EQ(count_events(events, db_trace_category::query, "InsertRows"), 2u);
+  EXPECT_EQ(
+      count_events(events, db_trace_category::query, "CloseConnection"), 1u);
+  EXPECT_EQ(
+      count_events(events, db_trace_category::rollback, "SetupConnection"),
+      1u);
+
+  // запросы транзакции вложены в интервал менеджера
+  auto transaction = std::find_if(
+      events.begin(), events.end(),
+      [](const db_trace_event& e) { return e.name == "Transaction"; });
+  auto insert = std::find_if(
+      events.begin(), events.end(),
+      [](const db_trace_event& e) { return e.name == "InsertRows"; });
+  ASSERT_NE(transaction, events.end());
+  ASSERT_NE(insert, events.end());
+  EXPECT_LE(transaction->start_ns, insert->start_ns);
+  EXPECT_GE(transaction->start_ns + transaction->duration_ns,
+            insert->start_ns + insert->duration_ns);
+
+  std::string json = DBTrace::ToChromeJson();
+  EXPECT_EQ(json.find("{\"traceEvents\":["), 0u);
+  EXPECT_NE(json.find("{\"name\":\"InsertRows\",\"cat\":\"query\","
+                      "\"ph\":\"X\",\"ts\":"),
+            std::string::npos);
+  DBTrace::Reset();
+}
@@ -0,0 +1,107 @@
+#include "asp_db/db_queries_setup.h"
+#include "asp_db/db_where.h"
+#include "asp_db/db_where_evaluator.h"
+#include "library_tables.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+LibraryDBTables eval_ldb;
+const IDBTables* eval_tables = &eval_ldb;
+
+/**
+ * \brief Собрать строку книги в формате результата выборки
+ * */
+db_query_basesetup::row_values book_row(int id,
+                                        const std::string& title,
+                                        int year,
+                                        int lang) {
+  const auto& fields = *eval_tables->GetFieldsCollection(table_book);
+  db_query_basesetup::row_values row;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (fields[i].fid == BOOK_ID)
+      row.emplace(i, std::to_string(id));
+    else if (fields[i].fid == BOOK_TITLE)
+      row.emplace(i, title);
+    else if (fields[i].fid == BOOK_PUB_YEAR && year)
+      row.emplace(i, std::to_string(year));
+    else if (fields[i].fid == BOOK_LANG)
+      row.emplace(i, std::to_string(lang));
+  }
+  return row;
+}
+
+DBWhereEvaluator make_evaluator(const wns::node_ptr& node) {
+  auto clause = std::make_shared<DBWhereClause<where_node_data>>(node);
+  return DBWhereEvaluator(*eval_tables->GetFieldsCollection(table_book),
+                          clause);
+}
+}  // namespace
+
+TEST(DBWhereEvaluator, Compare) {
+  WhereTreeConstructor<table_book> c(&eval_ldb);
+  auto hobbit = book_row(1, "Hobbit", 1937, lang_eng);
+  auto dune = book_row(2, "Dune", 1965, lang_eng);
+
+  auto eq = make_evaluator(c.Eq(BOOK_TITLE, "Hobbit"));
+  ASSERT_TRUE(eq.IsValid());
+  EXPECT_TRUE(eq(hobbit));
+  EXPECT_FALSE(eq(dune));
+
+  EXPECT_TRUE(make_evaluator(c.Ne(BOOK_TITLE, "Hobbit"))(dune));
+  EXPECT_TRUE(make_evaluator(c.Gt(BOOK_PUB_YEAR, 1950))(dune));
+  EXPECT_FALSE(make_evaluator(c.Gt(BOOK_PUB_YEAR, 1950))(hobbit));
+  EXPECT_TRUE(make_evaluator(c.Le(BOOK_PUB_YEAR, 1937))(hobbit));
+  EXPECT_TRUE(make_evaluator(c.Lt(BOOK_ID, 2))(hobbit));
+  EXPECT_TRUE(make_evaluator(c.Ge(BOOK_ID, 2))(dune));
+  // числовое, а не строковое сравнение
+  EXPECT_TRUE(make_evaluator(c.Lt(BOOK_PUB_YEAR, 10000))(dune));
+}
+
+TEST(DBWhereEvaluator, LikeBetween) {
+  WhereTreeConstructor<table_book> c(&eval_ldb);
+  auto hobbit = book_row(1, "Hobbit", 1937, lang_eng);
+
+  EXPECT_TRUE(make_evaluator(c.Like(BOOK_TITLE, "Hob%"))(hobbit));
+  EXPECT_TRUE(make_evaluator(c.Like(BOOK_TITLE, "%bb_t"))(hobbit));
+  EXPECT_FALSE(make_evaluator(c.Like(BOOK_TITLE, "%x%"))(hobbit));
+  EXPECT_TRUE(make_evaluator(c.Between(BOOK_PUB_YEAR, 1900, 1937))(hobbit));
+  EXPECT_FALSE(make_evaluator(c.Between(BOOK_PUB_YEAR, 1938, 2000))(hobbit));
+
+  EXPECT_TRUE(DBWhereEvaluator::LikeMatch("abc", "%"));
+  EXPECT_TRUE(DBWhereEvaluator::LikeMatch("", "%"));
+  EXPECT_FALSE(DBWhereEvaluator::LikeMatch("abc", "ab"));
+  EXPECT_TRUE(DBWhereEvaluator::LikeMatch("aXbXc", "a%b%c"));
+}
+
+TEST(DBWhereEvaluator, AndOrNull) {
+  WhereTreeConstructor<table_book> c(&eval_ldb);
+  auto hobbit = book_row(1, "Hobbit", 1937, lang_eng);
+  auto no_year = book_row(3, "Unknown", 0, lang_rus);
+
+  auto and_node = c.And(c.Eq(BOOK_TITLE, "Hobbit"), c.Gt(BOOK_PUB_YEAR, 1900));
+  EXPECT_TRUE(make_evaluator(and_node)(hobbit));
+  auto or_node = c.Or(c.Eq(BOOK_TITLE, "Dune"), c.Eq(BOOK_ID, 1));
+  EXPECT_TRUE(make_evaluator(or_node)(hobbit));
+  EXPECT_FALSE(make_evaluator(or_node)(no_year));
+
+  // сравнение с NULL
+  auto gt = make_evaluator(c.Gt(BOOK_PUB_YEAR, 1900));
+  EXPECT_EQ(gt.Evaluate(no_year), db_tribool::tb_unknown);
+  auto or_null = make_evaluator(
+      c.Or(c.Gt(BOOK_PUB_YEAR, 1900), c.Eq(BOOK_TITLE, "Unknown")));
+  EXPECT_EQ(or_null.Evaluate(no_year), db_tribool::tb_true);
+  EXPECT_TRUE(make_evaluator(c.Is(BOOK_PUB_YEAR, "NULL"))(no_year));
+  EXPECT_FALSE(make_evaluator(c.Is(BOOK_PUB_YEAR, "NULL"))(hobbit));
+  EXPECT_TRUE(make_evaluator(c.Is(BOOK_PUB_YEAR, "NOT NULL"))(hobbit));
+}
+
+TEST(DBWhereEvaluator, Invalid) {
+  WhereTreeConstructor<table_book> c(&eval_ldb);
+  auto raw = make_evaluator(c.RawData("book_title = 'Hobbit'"));
+  EXPECT_FALSE(raw.IsValid());
+  EXPECT_EQ(raw.Evaluate(book_row(1, "Hobbit", 1937, lang_eng)),
+            db_tribool::tb_unknown);
+  auto bad_value = make_evaluator(c.Eq(BOOK_PUB_YEAR, "nineteen"));
+  EXPECT_FALSE(bad_value.IsValid());
+}
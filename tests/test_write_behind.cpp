@@ -0,0 +1,153 @@
+#include "asp_db/db_connection_manager.h"
+#include "asp_db/db_write_behind.h"
+#include "test_fixtures.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(DBWriteBehind, Disabled) {
+  DBConnectionManager dbm(&test_ldb);
+  EXPECT_EQ(dbm.EnqueueSave(test_numbered_book(0)), STATUS_NOT);
+  EXPECT_EQ(dbm.GetWriteBehind(), nullptr);
+}
+
+TEST(DBWriteBehind, BatchesRowsOfThreads) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(
+      test_memory_parameters("write_behind_batches"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+
+  std::mutex lock;
+  std::vector<db_write_behind_batch> batches;
+  db_write_behind_parameters wp;
+  wp.batch_rows = 32;
+  wp.max_pending = 64;
+  wp.flush_interval = std::chrono::milliseconds(5);
+  wp.on_batch = [&lock, &batches](const db_write_behind_batch& batch) {
+    std::lock_guard<std::mutex> guard(lock);
+    batches.push_back(batch);
+  };
+  dbm.EnableWriteBehind(wp);
+
+  const int threads_count = 4, rows_count = 250;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threads_count; ++t)
+    threads.emplace_back([&dbm, t]() {
+      for (int i = 0; i < rows_count; ++i)
+        ASSERT_EQ(dbm.EnqueueSave(test_numbered_book(t * rows_count + i)),
+                  STATUS_OK);
+    });
+  for (auto& t : threads)
+    t.join();
+  dbm.FlushWriteBehind();
+
+  const DBWriteBehind* wb = dbm.GetWriteBehind();
+  ASSERT_NE(wb, nullptr);
+  const uint64_t total = threads_count * rows_count;
+  EXPECT_EQ(wb->Enqueued(), total);
+  EXPECT_EQ(wb->Completed(), total);
+  EXPECT_EQ(wb->Failed(), 0u);
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t rows = 0;
+    for (const auto& b : batches) {
+      EXPECT_TRUE(is_status_ok(b.status));
+      EXPECT_EQ(b.table, table_book);
+      EXPECT_LE(b.rows, wp.batch_rows);
+      EXPECT_EQ(b.ids.size(), b.rows);
+      rows += b.rows;
+    }
+    EXPECT_EQ(rows, total);
+    EXPECT_EQ(batches.size(), wb->Batches());
+    EXPECT_LT(batches.size(), total);
+  }
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  EXPECT_EQ(r.size(), total);
+}
+
+TEST(DBWriteBehind, ReportsFailedBatch) {
+  DBConnectionManager dbm(&test_ldb);
+  ASSERT_TRUE(is_status_aval(dbm.ResetConnectionParameters(
+      test_memory_parameters("write_behind_failed"))));
+  ASSERT_TRUE(is_status_ok(dbm.CreateTable(table_book)));
+  ASSERT_TRUE(is_status_ok(dbm.SaveSingleRow(test_numbered_book(1))));
+
+  std::vector<mstatus_t> statuses;
+  db_write_behind_parameters wp;
+  wp.flush_interval = std::chrono::seconds(10);
+  wp.on_batch = [&statuses](const db_write_behind_batch& batch) {
+    statuses.push_back(batch.status);
+  };
+  dbm.EnableWriteBehind(wp);
+  // строка уже добавлена - нарушение уникальности
+  ASSERT_EQ(dbm.EnqueueSave(test_numbered_book(1)), STATUS_OK);
+  dbm.FlushWriteBehind();
+  ASSERT_EQ(statuses.size(), 1u);
+  EXPECT_FALSE(is_status_ok(statuses[0]));
+  EXPECT_EQ(dbm.GetWriteBehind()->Failed(), 1u);
+
+  // отключение дописывает оставшиеся строки
+  ASSERT_EQ(dbm.EnqueueSave(test_numbered_book(2)), STATUS_OK);
+  dbm.DisableWriteBehind();
+  ASSERT_EQ(statuses.size(), 2u);
+  EXPECT_TRUE(is_status_ok(statuses[1]));
+  std::vector<book> r;
+  ASSERT_TRUE(is_status_ok(dbm.SelectAllRows(table_book, &r)));
+  EXPECT_EQ(r.size(), 2u);
+}
+
+TEST(DBWriteBehind, FlushWaitsForOwnRowsOnly) {
+  db_write_behind_parameters wp;
+  wp.flush_interval = std::chrono::seconds(10);
+  DBWriteBehind wb(wp);
+
+  std::mutex lock;
+  std::condition_variable cv;
+  bool release_b = false, b_enqueued = false;
+  std::atomic<bool> gate{false}, x_written{false};
+  // пока пишется первая очередь, поток B добавляет строку таблицы Y
+  auto first = [&](std::vector<int>&&, id_container*) {
+    if (gate.load()) {
+      std::unique_lock<std::mutex> guard(lock);
+      release_b = true;
+      cv.notify_all();
+      cv.wait(guard, [&b_enqueued]() { return b_enqueued; });
+    }
+    return STATUS_OK;
+  };
+  auto y_commit = [](std::vector<int>&&, id_container*) { return STATUS_OK; };
+  auto x_commit = [&x_written](std::vector<int>&&, id_container*) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    x_written = true;
+    return STATUS_OK;
+  };
+  // порядок очередей потока записи: first, Y, X
+  wb.Enqueue(table_author, 0, first);
+  wb.Enqueue(table_translation, 0, y_commit);
+  wb.Flush();
+  gate = true;
+
+  std::thread b([&]() {
+    std::unique_lock<std::mutex> guard(lock);
+    cv.wait(guard, [&release_b]() { return release_b; });
+    wb.Enqueue(table_translation, 1, y_commit);
+    b_enqueued = true;
+    cv.notify_all();
+  });
+  // поток A: строка таблицы X, запись строки Y потока B не должна
+  //   засчитываться за неё
+  wb.Enqueue(table_author, 1, first);
+  wb.Enqueue(table_book, 1, x_commit);
+  wb.Flush();
+  EXPECT_TRUE(x_written.load());
+  b.join();
+  wb.Flush();
+  EXPECT_EQ(wb.Completed(), wb.Enqueued());
+}
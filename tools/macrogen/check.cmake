@@ -0,0 +1,53 @@
+# Проверка актуальности закоммиченных файлов, сгенерированных
+#   asp_db-macrogen, запускается из ctest(см. asp_db_macrogen_check
+#   в macrogen.cmake):
+#
+# cmake -DCARGO=<cargo> -DMANIFEST=<Cargo.toml> -DTOOL_DIR=<каталог сборки>
+#   -DHEADER=<заголовок> -DCLASS=<класс> [-DINCLUDE=<заголовок>]
+#   -DOUTPUT=<закоммиченные файлы без расширения> -DWORK_DIR=<каталог>
+#   [-DUPDATE=ON] -P check.cmake
+#
+# С UPDATE=ON сгенерированные файлы копируются в OUTPUT.
+foreach(var CARGO MANIFEST TOOL_DIR HEADER CLASS OUTPUT WORK_DIR)
+  if(NOT ${var})
+    message(FATAL_ERROR "check.cmake: ${var} required")
+  endif()
+endforeach()
+
+execute_process(
+  COMMAND ${CARGO} build --release --quiet
+    --manifest-path ${MANIFEST} --target-dir ${TOOL_DIR}
+  RESULT_VARIABLE res)
+if(NOT res EQUAL 0)
+  message(FATAL_ERROR "asp_db-macrogen build failed: ${res}")
+endif()
+
+get_filename_component(name ${OUTPUT} NAME)
+get_filename_component(output_dir ${OUTPUT} DIRECTORY)
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(args --input ${HEADER} --class ${CLASS} --output ${WORK_DIR}/${name})
+if(INCLUDE)
+  list(APPEND args --include ${INCLUDE})
+endif()
+execute_process(
+  COMMAND ${TOOL_DIR}/release/asp_db-macrogen${CMAKE_EXECUTABLE_SUFFIX}
+    ${args}
+  RESULT_VARIABLE res)
+if(NOT res EQUAL 0)
+  message(FATAL_ERROR "asp_db-macrogen failed: ${res}")
+endif()
+
+foreach(ext .h .cpp)
+  if(UPDATE)
+    file(COPY ${WORK_DIR}/${name}${ext} DESTINATION ${output_dir})
+    continue()
+  endif()
+  execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files
+      ${WORK_DIR}/${name}${ext} ${OUTPUT}${ext}
+    RESULT_VARIABLE res)
+  if(NOT res EQUAL 0)
+    message(FATAL_ERROR "${OUTPUT}${ext} is out of date with ${HEADER}, "
+      "regenerate it: cmake -DUPDATE=ON ... -P ${CMAKE_CURRENT_LIST_FILE}")
+  endif()
+endforeach()
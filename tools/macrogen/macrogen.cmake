@@ -0,0 +1,93 @@
+# Генерация реализации IDBTables по структурам, размеченным макросами
+#   asp_db/db_meta.h
+#
+# asp_db_macrogen(<out_var>
+#   HEADER <заголовок со структурами>
+#   CLASS <имя класса, наследника IDBTables>
+#   NAME <имя сгенерированных файлов без расширения>
+#   [INCLUDE <заголовок, подключаемый в сгенерированном .cpp>])
+#
+# Генератор собирается cargo при первой генерации, результат -
+#   ${CMAKE_CURRENT_BINARY_DIR}/<NAME>.h и <NAME>.cpp, путь к .cpp
+#   записывается в <out_var>. Каталог ${CMAKE_CURRENT_BINARY_DIR}
+#   следует добавить в пути подключаемых файлов цели.
+#
+# asp_db_macrogen_check(<test_name>
+#   HEADER <заголовок со структурами>
+#   CLASS <имя класса, наследника IDBTables>
+#   OUTPUT <путь к закоммиченным сгенерированным файлам без расширения>
+#   [INCLUDE <заголовок, подключаемый в сгенерированном .cpp>])
+#
+# Добавляет тесты ctest: <test_name>-unit - тесты самого генератора,
+#   <test_name>-up-to-date - генерация во временный каталог и сравнение
+#   с <OUTPUT>.h, <OUTPUT>.cpp. Обновить закоммиченные файлы:
+#   cmake -DUPDATE=ON <аргументы теста> -P check.cmake
+set(ASP_DB_MACROGEN_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+find_program(CARGO_EXECUTABLE cargo)
+
+function(asp_db_macrogen out_var)
+  cmake_parse_arguments(MG "" "HEADER;CLASS;NAME;INCLUDE" "" ${ARGN})
+  if(NOT MG_HEADER OR NOT MG_CLASS OR NOT MG_NAME)
+    message(FATAL_ERROR "asp_db_macrogen: HEADER, CLASS and NAME required")
+  endif()
+  if(NOT CARGO_EXECUTABLE)
+    message(FATAL_ERROR "asp_db_macrogen: `cargo` not found, "
+      "see https://www.rust-lang.org/tools/install")
+  endif()
+
+  set(tool_dir ${CMAKE_CURRENT_BINARY_DIR}/macrogen)
+  set(tool ${tool_dir}/release/asp_db-macrogen${CMAKE_EXECUTABLE_SUFFIX})
+  file(GLOB tool_sources ${ASP_DB_MACROGEN_DIR}/src/*.rs)
+  add_custom_command(
+    OUTPUT ${tool}
+    COMMAND ${CARGO_EXECUTABLE} build --release --quiet
+      --manifest-path ${ASP_DB_MACROGEN_DIR}/Cargo.toml
+      --target-dir ${tool_dir}
+    DEPENDS ${ASP_DB_MACROGEN_DIR}/Cargo.toml ${tool_sources}
+    COMMENT "Build asp_db-macrogen")
+
+  set(out_base ${CMAKE_CURRENT_BINARY_DIR}/${MG_NAME})
+  set(args --input ${MG_HEADER} --class ${MG_CLASS} --output ${out_base})
+  if(MG_INCLUDE)
+    list(APPEND args --include ${MG_INCLUDE})
+  endif()
+  add_custom_command(
+    OUTPUT ${out_base}.h ${out_base}.cpp
+    COMMAND ${tool} ${args}
+    DEPENDS ${tool} ${MG_HEADER}
+    COMMENT "Generate ${MG_NAME} from ${MG_HEADER}")
+  set(${out_var} ${out_base}.cpp PARENT_SCOPE)
+endfunction()
+
+function(asp_db_macrogen_check test_name)
+  cmake_parse_arguments(MG "" "HEADER;CLASS;OUTPUT;INCLUDE" "" ${ARGN})
+  if(NOT MG_HEADER OR NOT MG_CLASS OR NOT MG_OUTPUT)
+    message(FATAL_ERROR
+      "asp_db_macrogen_check: HEADER, CLASS and OUTPUT required")
+  endif()
+  if(NOT CARGO_EXECUTABLE)
+    message(FATAL_ERROR "asp_db_macrogen_check: `cargo` not found, "
+      "see https://www.rust-lang.org/tools/install")
+  endif()
+
+  set(tool_dir ${CMAKE_CURRENT_BINARY_DIR}/macrogen)
+  add_test(NAME ${test_name}-unit
+    COMMAND ${CARGO_EXECUTABLE} test --quiet
+      --manifest-path ${ASP_DB_MACROGEN_DIR}/Cargo.toml
+      --target-dir ${tool_dir})
+  add_test(NAME ${test_name}-up-to-date
+    COMMAND ${CMAKE_COMMAND}
+      -DCARGO=${CARGO_EXECUTABLE}
+      -DMANIFEST=${ASP_DB_MACROGEN_DIR}/Cargo.toml
+      -DTOOL_DIR=${tool_dir}
+      -DHEADER=${MG_HEADER}
+      -DCLASS=${MG_CLASS}
+      -DINCLUDE=${MG_INCLUDE}
+      -DOUTPUT=${MG_OUTPUT}
+      -DWORK_DIR=${CMAKE_CURRENT_BINARY_DIR}/${test_name}
+      -P ${ASP_DB_MACROGEN_DIR}/check.cmake)
+  # оба теста собирают генератор в одном каталоге
+  set_tests_properties(${test_name}-unit ${test_name}-up-to-date
+    PROPERTIES RESOURCE_LOCK ${tool_dir})
+endfunction()
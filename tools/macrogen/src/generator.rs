@@ -0,0 +1,801 @@
+//! Генерация реализации IDBTables по разобранным структурам таблиц
+//!
+//! Для каждой структуры генерируется:
+//!   - схема таблицы времени компиляции `db_table_schema`, коллекция
+//!     полей и индекс полей;
+//!   - сетап создания таблицы с уникальными комплексами и внешними
+//!     ключами;
+//!   - дескриптор `db_table_descriptor` с функциями записи и чтения полей
+//!     структуры без промежуточных строк: целые числа разбираются
+//!     `std::from_chars` и записываются `std::to_chars` в буфер на стеке,
+//!     строковые поля копируются без преобразований;
+//!   - специализации шаблонов IDBTables для структуры.
+
+use crate::parser::{Field, Table};
+use std::fmt::Write;
+
+/// Параметры генерации
+pub struct Options {
+    /// Имя генерируемого класса, наследника IDBTables
+    pub class: String,
+    /// Имя файлов результата без расширения
+    pub basename: String,
+    /// Заголовок со структурами, как его подключать в сгенерированном
+    pub structs_include: String,
+    /// Заголовок, подключаемый в сгенерированном .cpp, по умолчанию
+    ///   сгенерированный заголовок
+    pub cpp_include: Option<String>,
+    /// Имя исходного файла для комментария
+    pub source_name: String,
+}
+
+/// Способ преобразования значения поля
+#[derive(Debug, PartialEq)]
+enum Conv {
+    Int,
+    Real,
+    Bool,
+    Text,
+    /// контейнер строк - `TranslateFromVector`/`string2Container`
+    StrVec,
+    /// функции `str_functions`
+    Custom(String, String),
+}
+
+/// Столбец таблицы, полностью определённый по полю структуры
+#[derive(Debug)]
+struct Column<'a> {
+    field: &'a Field,
+    id: String,
+    db_type: &'static str,
+    flags: Vec<&'static str>,
+    len: Option<String>,
+    conv: Conv,
+}
+
+const DB_TYPES: [(&str, &str); 12] = [
+    ("autoinc", "type_autoinc"),
+    ("uuid", "type_uuid"),
+    ("bool", "type_bool"),
+    ("short", "type_short"),
+    ("int", "type_int"),
+    ("long", "type_long"),
+    ("real", "type_real"),
+    ("date", "type_date"),
+    ("time", "type_time"),
+    ("char_array", "type_char_array"),
+    ("text", "type_text"),
+    ("blob", "type_blob"),
+];
+
+/// Тип столбца по типу поля в C++
+fn infer_type(ctype: &str) -> Option<&'static str> {
+    let t = match ctype {
+        "size_t" | "incremental" => "type_autoinc",
+        "short" | "int16_t" => "type_short",
+        "int" | "int32_t" => "type_int",
+        "long" | "long long" | "int64_t" | "bigint" | "ssize_t" => "type_long",
+        "float" | "double" => "type_real",
+        "bool" => "type_bool",
+        "std::string" | "string" | "text" => "type_text",
+        _ if container_elem(ctype).is_some() => "type_text",
+        _ => return None,
+    };
+    Some(t)
+}
+
+fn is_string(ctype: &str) -> bool {
+    matches!(ctype, "std::string" | "string" | "text")
+}
+
+/// Тип элемента для `std::vector<T>` и `container<T>`
+fn container_elem(ctype: &str) -> Option<&str> {
+    for prefix in ["std::vector<", "vector<", "container<"] {
+        if let Some(rest) = ctype.strip_prefix(prefix) {
+            return rest.strip_suffix('>').map(str::trim);
+        }
+    }
+    None
+}
+
+fn upper(s: &str) -> String {
+    s.to_ascii_uppercase()
+}
+
+fn gen_err<T>(table: &Table, line: usize, msg: impl Into<String>) -> Result<T, String> {
+    Err(format!(
+        "line {}: table '{}': {}",
+        line,
+        table.name,
+        msg.into()
+    ))
+}
+
+fn resolve_column<'a>(table: &'a Table, f: &'a Field) -> Result<Column<'a>, String> {
+    let db_type = match &f.db_type {
+        Some(t) => match DB_TYPES.iter().find(|(k, _)| k == t) {
+            Some((_, v)) => *v,
+            None => return gen_err(table, f.line, format!("unknown type({})", t)),
+        },
+        None => match infer_type(&f.ctype) {
+            Some(t) => t,
+            None => {
+                return gen_err(
+                    table,
+                    f.line,
+                    format!("set type(...) for field '{}' of type '{}'", f.name, f.ctype),
+                )
+            }
+        },
+    };
+    let conv = if let Some((to, from)) = &f.str_functions {
+        Conv::Custom(to.clone(), from.clone())
+    } else if let Some(elem) = container_elem(&f.ctype) {
+        if !is_string(elem) || f.fkey.is_some() {
+            return gen_err(
+                table,
+                f.line,
+                format!("set str_functions for container field '{}'", f.name),
+            );
+        }
+        Conv::StrVec
+    } else {
+        match db_type {
+            "type_autoinc" | "type_short" | "type_int" | "type_long" => Conv::Int,
+            "type_real" => Conv::Real,
+            "type_bool" => Conv::Bool,
+            _ if is_string(&f.ctype) && f.fkey.is_none() => Conv::Text,
+            _ => {
+                return gen_err(
+                    table,
+                    f.line,
+                    format!(
+                        "set str_functions for field '{}' of type '{}'",
+                        f.name, f.ctype
+                    ),
+                )
+            }
+        }
+    };
+    let is_pk = table.primary_key.as_deref() == Some(f.name.as_str());
+    let is_ref = f.fkey.is_some() || table.references.iter().any(|r| r.field == f.name);
+    let mut flags = Vec::new();
+    if is_pk {
+        flags.push("ff_primary_key");
+    }
+    if is_ref {
+        flags.push("ff_reference");
+    }
+    if f.not_null || is_pk {
+        flags.push("ff_not_null");
+    }
+    if f.can_be_negative {
+        flags.push("ff_can_be_negative");
+    }
+    if f.array {
+        flags.push("ff_array");
+    }
+    if f.has_default {
+        flags.push("ff_has_default");
+    }
+    let len = match (&f.len, &conv) {
+        (Some(l), _) => Some(l.clone()),
+        (None, Conv::StrVec) => Some("0".into()),
+        _ => None,
+    };
+    Ok(Column {
+        field: f,
+        id: f
+            .id
+            .clone()
+            .unwrap_or_else(|| format!("{}_{}", upper(&table.name), upper(&f.name))),
+        db_type,
+        flags,
+        len,
+        conv,
+    })
+}
+
+/// Таблица с разрешёнными столбцами
+struct Resolved<'a> {
+    table: &'a Table,
+    code: String,
+    columns: Vec<Column<'a>>,
+}
+
+impl<'a> Resolved<'a> {
+    fn column(&self, name: &str) -> Option<&Column<'a>> {
+        self.columns.iter().find(|c| c.field.name == name)
+    }
+    fn col_name(&self, name: &str) -> String {
+        format!("TABLE_FIELD_NAME({})", self.column(name).unwrap().id)
+    }
+}
+
+fn resolve(tables: &[Table]) -> Result<Vec<Resolved<'_>>, String> {
+    if tables.is_empty() {
+        return Err("no ASP_TABLE structs found".into());
+    }
+    let with_codes = tables.iter().filter(|t| t.code.is_some()).count();
+    if with_codes != 0 && with_codes != tables.len() {
+        return Err("table_code must be set for all tables or for none".into());
+    }
+    let mut result = Vec::new();
+    for t in tables {
+        if tables.iter().filter(|x| x.name == t.name).count() > 1 {
+            return gen_err(t, t.line, "duplicated table struct");
+        }
+        if t.fields.is_empty() {
+            return gen_err(t, t.line, "no fields");
+        }
+        let columns = t
+            .fields
+            .iter()
+            .map(|f| resolve_column(t, f))
+            .collect::<Result<Vec<_>, _>>()?;
+        if let Some(pk) = &t.primary_key {
+            if t.field(pk).is_none() {
+                return gen_err(t, t.line, format!("unknown primary_key field '{}'", pk));
+            }
+        }
+        for u in &t.uniques {
+            for name in u {
+                if t.field(name).is_none() {
+                    return gen_err(t, t.line, format!("unknown unique field '{}'", name));
+                }
+            }
+        }
+        for f in t.fields.iter().filter(|f| f.fkey.is_some()) {
+            if !t.references.iter().any(|r| r.field == f.name) {
+                return gen_err(
+                    t,
+                    f.line,
+                    format!("field_fkey '{}' without reference", f.name),
+                );
+            }
+        }
+        for r in &t.references {
+            let f = match t.field(&r.field) {
+                Some(f) => f,
+                None => {
+                    return gen_err(t, r.line, format!("unknown reference field '{}'", r.field))
+                }
+            };
+            if f.fkey.as_deref().map_or(false, |ft| ft != r.table) {
+                return gen_err(t, r.line, format!("'{}' references other table", r.field));
+            }
+            match tables.iter().find(|x| x.name == r.table) {
+                Some(rt) if rt.field(&r.column).is_some() => {}
+                Some(_) => return gen_err(t, r.line, format!("unknown column '{}'", r.column)),
+                None => return gen_err(t, r.line, format!("unknown table '{}'", r.table)),
+            }
+            for act in [&r.on_update, &r.on_delete] {
+                if ref_act(act).is_none() {
+                    return gen_err(t, r.line, format!("unknown reference action '{}'", act));
+                }
+            }
+        }
+        result.push(Resolved {
+            table: t,
+            code: t
+                .code
+                .clone()
+                .unwrap_or_else(|| format!("table_{}", t.name)),
+            columns,
+        });
+    }
+    Ok(result)
+}
+
+fn ref_act(act: &str) -> Option<&'static str> {
+    Some(match act {
+        "NO_ACTION" => "ref_act_not",
+        "SET_NULL" => "ref_act_set_null",
+        "CASCADE" => "ref_act_cascade",
+        "RESTRICT" => "ref_act_restrict",
+        _ => return None,
+    })
+}
+
+fn banner(out: &mut String, name: &str, opts: &Options) {
+    let _ = write!(
+        out,
+        "/**\n\
+         \x20* asp_db - db api of the project 'asp_therm'\n\
+         \x20* ===================================================================\n\
+         \x20* * {} *\n\
+         \x20*   Сгенерировано asp_db-macrogen по '{}', не редактировать\n\
+         \x20* вручную - изменения будут перезаписаны генератором\n\
+         \x20* ===================================================================\n\
+         \x20*/\n",
+        name, opts.source_name
+    );
+}
+
+/// Сгенерировать заголовок: коды таблиц и столбцов, не заданные
+///   разметкой, объявление класса и специализаций
+pub fn header(tables: &[Table], opts: &Options) -> Result<String, String> {
+    let resolved = resolve(tables)?;
+    let guard = format!(
+        "ASP_DB_MACROGEN__{}_H",
+        upper(
+            &opts
+                .basename
+                .replace(|c: char| !c.is_ascii_alphanumeric(), "_")
+        )
+    );
+    let mut out = String::new();
+    banner(&mut out, &opts.basename, opts);
+    let _ = writeln!(out, "#ifndef {}\n#define {}\n", guard, guard);
+    let _ = writeln!(out, "#include \"asp_db/db_tables.h\"");
+    let _ = writeln!(out, "#include \"{}\"\n", opts.structs_include);
+    out.push_str("#include <string>\n#include <vector>\n");
+
+    if tables[0].code.is_none() {
+        out.push_str("\n/* коды таблиц */\n");
+        for (i, r) in resolved.iter().enumerate() {
+            let _ = writeln!(out, "constexpr asp_db::db_table {} = {};", r.code, i + 1);
+        }
+    }
+    for r in &resolved {
+        let generated: Vec<_> = r
+            .columns
+            .iter()
+            .enumerate()
+            .filter(|(_, c)| c.field.id.is_none())
+            .collect();
+        if generated.is_empty() {
+            continue;
+        }
+        let _ = writeln!(out, "\n/* столбцы таблицы {} */", r.table.name);
+        for (i, c) in generated {
+            let _ = writeln!(
+                out,
+                "#define {} (({}) << 16 | 0x{:04x})",
+                c.id,
+                r.code,
+                i + 1
+            );
+            let _ = writeln!(out, "#define {}_NAME \"{}\"", c.id, c.field.name);
+        }
+    }
+
+    let _ = write!(
+        out,
+        "\n/** \\brief Реализация IDBTables для таблиц {} */\n\
+         class {cls} final : public asp_db::IDBTables {{\n \
+         public:\n  \
+         std::string GetTablesNamespace() const override {{ return \"{cls}\"; }}\n  \
+         std::string GetTableName(asp_db::db_table t) const override;\n  \
+         const asp_db::db_fields_collection* GetFieldsCollection(\n      \
+         asp_db::db_table t) const override;\n  \
+         const asp_db::db_fields_index* GetFieldsIndex(\n      \
+         asp_db::db_table t) const override;\n  \
+         asp_db::db_table StrToTableCode(const std::string& tname) const override;\n  \
+         std::string GetIdColumnName(asp_db::db_table dt) const override;\n  \
+         const asp_db::db_table_create_setup& CreateSetupByCode(\n      \
+         asp_db::db_table dt) const override;\n\
+         }};\n\n\
+         namespace asp_db {{\n",
+        opts.source_name,
+        cls = opts.class
+    );
+    for r in &resolved {
+        let t = &r.table.name;
+        let _ = write!(
+            out,
+            "/* {t} */\n\
+             template <>\n\
+             std::string IDBTables::GetTableName<{t}>() const;\n\
+             template <>\n\
+             db_table IDBTables::GetTableCode<{t}>() const;\n\
+             template <>\n\
+             void IDBTables::setInsertValues<{t}>(db_query_insert_setup* src,\n\
+             {pi}const {t}& select_data) const;\n\
+             template <>\n\
+             void IDBTables::moveInsertValues<{t}>(db_query_insert_setup* src,\n\
+             {pm}{t}& insert_data) const;\n\
+             template <>\n\
+             void IDBTables::SetSelectData<{t}>(db_query_select_result* src,\n\
+             {ps}std::vector<{t}>* out_vec) const;\n",
+            t = t,
+            pi = " ".repeat(34 + t.len()),
+            pm = " ".repeat(35 + t.len()),
+            ps = " ".repeat(32 + t.len())
+        );
+    }
+    let _ = writeln!(out, "}}  // namespace asp_db\n\n#endif  // !{}", guard);
+    Ok(out)
+}
+
+/// Выражения записи (`set`), чтения (`get`) и чтения перемещением
+///   (`take`) значения поля
+fn accessors(c: &Column) -> (String, String, Option<String>) {
+    let member = format!(
+        "t.{}{}",
+        c.field.name,
+        if c.field.fkey.is_some() { ".first" } else { "" }
+    );
+    let check = if c.field.fkey.is_some() || c.db_type == "type_autoinc" {
+        format!("{} > 0", member)
+    } else {
+        "true".to_string()
+    };
+    let (set, get) = match &c.conv {
+        Conv::Int => (
+            format!("db_string_to_int(s, &{});", member),
+            format!(
+                "db_int_to_string({}, s);\n        return {};",
+                member, check
+            ),
+        ),
+        Conv::Real => (
+            format!("{} = std::strtod(s.c_str(), nullptr);", member),
+            format!("real2str({}, s);\n        return {};", member, check),
+        ),
+        Conv::Bool => (
+            format!("{} = str2bool(s);", member),
+            format!(
+                "*s = {} ? \"true\" : \"false\";\n        return {};",
+                member, check
+            ),
+        ),
+        Conv::Text => (
+            format!("{} = s;", member),
+            format!("*s = {};\n        return {};", member, check),
+        ),
+        Conv::StrVec => (
+            format!(
+                "{}.clear();\n        IDBTables::string2Container(s, &{});",
+                member, member
+            ),
+            format!(
+                "*s = db_variable::TranslateFromVector({m}.begin(), {m}.end());\n        \
+                 return !{m}.empty();",
+                m = member
+            ),
+        ),
+        Conv::Custom(to, from) => (
+            format!("{}(s, &{});", from, member),
+            format!("*s = {}({});\n        return {};", to, member, check),
+        ),
+    };
+    // строки перемещаются в сетап INSERT без копирования
+    let take = match &c.conv {
+        Conv::Text => Some(format!(
+            "*s = std::move({});\n        return {};",
+            member, check
+        )),
+        _ => None,
+    };
+    (set, get, take)
+}
+
+fn helpers(out: &mut String, resolved: &[Resolved]) {
+    let uses = |conv: fn(&Conv) -> bool| {
+        resolved
+            .iter()
+            .any(|r| r.columns.iter().any(|c| conv(&c.conv)))
+    };
+    // целые числа - db_int_to_string/db_string_to_int дескриптора
+    let real = uses(|c| *c == Conv::Real);
+    let boolean = uses(|c| *c == Conv::Bool);
+    if real || boolean {
+        out.push_str("/* преобразования значений столбцов */\n");
+    }
+    if real {
+        out.push_str(
+            "void real2str(double v, std::string* s) {\n  \
+             char buf[32];\n  \
+             s->assign(buf, std::snprintf(buf, sizeof(buf), \"%.17g\", v));\n\
+             }\n",
+        );
+    }
+    if boolean {
+        out.push_str(
+            "bool str2bool(const std::string& s) {\n  \
+             return s == \"t\" || s == \"true\" || s == \"1\";\n\
+             }\n",
+        );
+    }
+}
+
+/// Сгенерировать реализацию
+pub fn source(tables: &[Table], opts: &Options) -> Result<String, String> {
+    let resolved = resolve(tables)?;
+    let mut out = String::new();
+    banner(&mut out, &format!("{}.cpp", opts.basename), opts);
+    let include = opts
+        .cpp_include
+        .clone()
+        .unwrap_or_else(|| format!("{}.h", opts.basename));
+    let _ = write!(
+        out,
+        "#include \"{}\"\n\
+         #include \"asp_db/db_connection_manager.h\"\n\
+         #include \"asp_db/db_table_descriptor.h\"\n\
+         #include \"asp_db/db_table_schema.h\"\n\n\
+         #include <cstdio>\n\
+         #include <cstdlib>\n\
+         #include <memory>\n\
+         #include <string>\n\n\
+         using namespace asp_db;\n\n\
+         namespace {{\n",
+        include
+    );
+    helpers(&mut out, &resolved);
+
+    for r in &resolved {
+        let t = &r.table.name;
+        let _ = write!(
+            out,
+            "\n/*\n * {}\n */\nconstexpr db_table_schema {}_schema({{\n",
+            t, t
+        );
+        for c in &r.columns {
+            let flags = if c.flags.is_empty() {
+                "ff_none".to_string()
+            } else {
+                c.flags.join(" | ")
+            };
+            let _ = write!(
+                out,
+                "    {{TABLE_FIELD_PAIR({}), db_variable_type::{},\n     {}",
+                c.id, c.db_type, flags
+            );
+            if let Some(len) = &c.len {
+                let _ = write!(out, ", {}", len);
+            }
+            out.push_str("},\n");
+        }
+        let _ = write!(
+            out,
+            "}});\n\
+             const db_fields_collection {t}_fields = {t}_schema.MakeCollection();\n\
+             const db_fields_index {t}_index = {t}_schema.Index();\n\
+             const db_table_create_setup::uniques_container {t}_uniques = {{",
+            t = t
+        );
+        for u in &r.table.uniques {
+            let names: Vec<_> = u.iter().map(|n| r.col_name(n)).collect();
+            let _ = write!(
+                out,
+                "\n    db_table_create_setup::unique_constrain{{\n        {}}},",
+                names.join(",\n        ")
+            );
+        }
+        out.push_str("};\n");
+        if r.table.references.is_empty() {
+            let _ = writeln!(
+                out,
+                "const std::shared_ptr<db_ref_collection> {}_references = nullptr;",
+                t
+            );
+        } else {
+            let _ = write!(
+                out,
+                "const std::shared_ptr<db_ref_collection> {}_references(\n    \
+                 new db_ref_collection{{",
+                t
+            );
+            for (i, rf) in r.table.references.iter().enumerate() {
+                let target = resolved.iter().find(|x| x.table.name == rf.table).unwrap();
+                let _ = write!(
+                    out,
+                    "{}\n        db_reference({},\n                     {},\n                     \
+                     {},\n                     true,\n                     \
+                     db_reference_act::{},\n                     db_reference_act::{})",
+                    if i > 0 { "," } else { "" },
+                    r.col_name(&rf.field),
+                    target.code,
+                    target.col_name(&rf.column),
+                    ref_act(&rf.on_delete).unwrap(),
+                    ref_act(&rf.on_update).unwrap()
+                );
+            }
+            out.push_str("});\n");
+        }
+        let _ = write!(
+            out,
+            "const db_table_create_setup {t}_create_setup({code},\n    \
+             {t}_fields,\n    {t}_uniques,\n    {t}_references);\n\
+             const db_table_descriptor<{t}> {t}_descriptor(\n    {t}_fields,\n    {{",
+            t = t,
+            code = r.code
+        );
+        for (i, c) in r.columns.iter().enumerate() {
+            let (set, get, take) = accessors(c);
+            let flag = match &c.field.flag {
+                Some(f) => format!("{}::{}", t, f),
+                None => "0".into(),
+            };
+            let _ = write!(
+                out,
+                "{}{{{}, {},\n      []({t}& t, const std::string& s) {{\n        {}\n      }},\n      \
+                 [](const {t}& t, std::string* s) {{\n        {}\n      }}",
+                if i > 0 { ",\n     " } else { "" },
+                c.id,
+                flag,
+                set,
+                get,
+                t = t
+            );
+            if let Some(take) = take {
+                let _ = write!(
+                    out,
+                    ",\n      []({t}& t, std::string* s) {{\n        {}\n      }}",
+                    take,
+                    t = t
+                );
+            }
+            out.push('}');
+        }
+        out.push_str("});\n");
+    }
+    out.push_str("}  // namespace\n");
+
+    let cls = &opts.class;
+    let cases = |f: &dyn Fn(&Resolved) -> String| {
+        resolved
+            .iter()
+            .map(|r| format!("    case {}:\n      {}\n", r.code, f(r)))
+            .collect::<String>()
+    };
+    let unknown = "    default:\n      \
+                   throw DBException(ERROR_DB_TABLE_EXISTS, \"Неизвестный код таблицы\");\n";
+    let _ = write!(
+        out,
+        "\nstd::string {cls}::GetTableName(db_table t) const {{\n  switch (t) {{\n{}    \
+         default:\n      break;\n  }}\n  return \"\";\n}}\n",
+        cases(&|r| format!("return \"{}\";", r.table.name)),
+        cls = cls
+    );
+    let _ = write!(
+        out,
+        "const db_fields_collection* {cls}::GetFieldsCollection(db_table t) const {{\n  \
+         switch (t) {{\n{}{}  }}\n}}\n",
+        cases(&|r| format!("return &{}_fields;", r.table.name)),
+        unknown,
+        cls = cls
+    );
+    let _ = write!(
+        out,
+        "const db_fields_index* {cls}::GetFieldsIndex(db_table t) const {{\n  \
+         switch (t) {{\n{}    default:\n      break;\n  }}\n  return nullptr;\n}}\n",
+        cases(&|r| format!("return &{}_index;", r.table.name)),
+        cls = cls
+    );
+    let _ = write!(
+        out,
+        "db_table {cls}::StrToTableCode(const std::string& tname) const {{\n",
+        cls = cls
+    );
+    for r in &resolved {
+        let _ = write!(
+            out,
+            "  if (tname == \"{}\")\n    return {};\n",
+            r.table.name, r.code
+        );
+    }
+    out.push_str("  return UNDEFINED_TABLE;\n}\n");
+    let _ = write!(
+        out,
+        "std::string {cls}::GetIdColumnName(db_table dt) const {{\n  switch (dt) {{\n{}    \
+         default:\n      break;\n  }}\n  return \"\";\n}}\n",
+        resolved
+            .iter()
+            .filter_map(|r| r.table.primary_key.as_ref().map(|pk| format!(
+                "    case {}:\n      return {};\n",
+                r.code,
+                r.col_name(pk)
+            )))
+            .collect::<String>(),
+        cls = cls
+    );
+    let _ = write!(
+        out,
+        "const db_table_create_setup& {cls}::CreateSetupByCode(db_table dt) const {{\n  \
+         switch (dt) {{\n{}{}  }}\n}}\n",
+        cases(&|r| format!("return {}_create_setup;", r.table.name)),
+        unknown,
+        cls = cls
+    );
+
+    out.push_str("\nnamespace asp_db {\n");
+    for r in &resolved {
+        let _ = write!(
+            out,
+            "/* {t} */\n\
+             template <>\n\
+             std::string IDBTables::GetTableName<{t}>() const {{\n  return \"{t}\";\n}}\n\
+             template <>\n\
+             db_table IDBTables::GetTableCode<{t}>() const {{\n  return {code};\n}}\n\
+             template <>\n\
+             void IDBTables::setInsertValues<{t}>(db_query_insert_setup* src,\n\
+             {pi}const {t}& select_data) const {{\n  \
+             {t}_descriptor.SetInsertValues(src, select_data);\n}}\n\
+             template <>\n\
+             void IDBTables::moveInsertValues<{t}>(db_query_insert_setup* src,\n\
+             {pm}{t}& insert_data) const {{\n  \
+             {t}_descriptor.MoveInsertValues(src, insert_data);\n}}\n\
+             template <>\n\
+             void IDBTables::SetSelectData<{t}>(db_query_select_result* src,\n\
+             {ps}std::vector<{t}>* out_vec) const {{\n  \
+             {t}_descriptor.SetSelectData(*src, out_vec);\n}}\n",
+            t = r.table.name,
+            code = r.code,
+            pi = " ".repeat(34 + r.table.name.len()),
+            pm = " ".repeat(35 + r.table.name.len()),
+            ps = " ".repeat(32 + r.table.name.len())
+        );
+    }
+    out.push_str("}  // namespace asp_db\n");
+    Ok(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::parse;
+
+    fn opts() -> Options {
+        Options {
+            class: "TestTables".into(),
+            basename: "test_tables_gen".into(),
+            structs_include: "test_structs.h".into(),
+            cpp_include: None,
+            source_name: "test_structs.h".into(),
+        }
+    }
+
+    #[test]
+    fn generate() {
+        let tables = parse(
+            "struct ASP_TABLE a { field(size_t, id); field(std::vector<std::string>, v);\n\
+             field(double, x, NOT_NULL); primary_key(id) unique_complex(x) };\n\
+             struct ASP_TABLE b { field(int, id, type(autoinc));\n\
+             field_fkey(int, a_p, a); reference(a_p, a(id), CASCADE) };",
+        )
+        .unwrap();
+        let h = header(&tables, &opts()).unwrap();
+        assert!(h.contains("constexpr asp_db::db_table table_a = 1;"));
+        assert!(h.contains("#define A_X ((table_a) << 16 | 0x0003)"));
+        assert!(h.contains("#define B_A_P_NAME \"a_p\""));
+        assert!(h.contains("class TestTables final : public asp_db::IDBTables"));
+
+        let s = source(&tables, &opts()).unwrap();
+        assert!(s.contains("#include \"test_tables_gen.h\""));
+        assert!(s.contains(
+            "{TABLE_FIELD_PAIR(A_ID), db_variable_type::type_autoinc,\n     \
+                            ff_primary_key | ff_not_null}"
+        ));
+        assert!(s.contains("db_variable_type::type_text,\n     ff_none, 0}"));
+        assert!(s.contains("TABLE_FIELD_NAME(B_A_P),\n                     table_a,"));
+        assert!(s.contains(
+            "db_reference_act::ref_act_not,\n                     \
+                            db_reference_act::ref_act_cascade"
+        ));
+        assert!(s.contains("db_string_to_int(s, &t.a_p.first);"));
+        assert!(s.contains("return t.a_p.first > 0;"));
+        assert!(s.contains("void real2str"));
+        assert!(!s.contains("str2bool"));
+    }
+
+    #[test]
+    fn errors() {
+        let check = |src: &str| header(&parse(src).unwrap(), &opts()).unwrap_err();
+        assert!(check("struct ASP_TABLE a { field(my_t, x); };").contains("type(...)"));
+        assert!(
+            check("struct ASP_TABLE a { field(my_t, x, type(text)); };").contains("str_functions")
+        );
+        assert!(
+            check("struct ASP_TABLE a { field(int, x); primary_key(y) };").contains("primary_key")
+        );
+        assert!(check("struct ASP_TABLE a { field_fkey(int, x, b); };").contains("reference"));
+        assert!(check(
+            "struct ASP_TABLE a { table_code(1) field(int, x); };\n\
+             struct ASP_TABLE b { field(int, x); };"
+        )
+        .contains("table_code"));
+    }
+}
@@ -0,0 +1,88 @@
+//! asp_db-macrogen - генератор реализации `asp_db::IDBTables` по
+//!   структурам, размеченным макросами `asp_db/db_meta.h`
+//!
+//! ```text
+//! asp_db-macrogen --input library_structs.h --class LibraryDBTables \
+//!     --output build/library_tables_gen [--include library_tables.h]
+//! ```
+//!
+//! Создаёт `<output>.h` с объявлением класса и специализаций шаблонов
+//!   IDBTables и `<output>.cpp` с их реализацией.
+
+mod generator;
+mod parser;
+
+use std::path::Path;
+use std::process::ExitCode;
+
+const USAGE: &str = "usage: asp_db-macrogen --input <header> --class <name> \
+                     --output <path without extension> [--include <header>] \
+                     [--structs-include <header>]";
+
+fn run(args: &[String]) -> Result<(), String> {
+    let mut input = None;
+    let mut class = None;
+    let mut output = None;
+    let mut include = None;
+    let mut structs_include = None;
+    let mut it = args.iter();
+    while let Some(arg) = it.next() {
+        let slot = match arg.as_str() {
+            "--input" => &mut input,
+            "--class" => &mut class,
+            "--output" => &mut output,
+            "--include" => &mut include,
+            "--structs-include" => &mut structs_include,
+            "-h" | "--help" => {
+                println!("{}", USAGE);
+                return Ok(());
+            }
+            _ => return Err(format!("unknown argument '{}'\n{}", arg, USAGE)),
+        };
+        *slot = Some(it.next().ok_or(format!("no value for '{}'", arg))?.clone());
+    }
+    let (input, class, output) = match (input, class, output) {
+        (Some(i), Some(c), Some(o)) => (i, c, o),
+        _ => return Err(USAGE.into()),
+    };
+
+    let src = std::fs::read_to_string(&input).map_err(|e| format!("{}: {}", input, e))?;
+    let tables = parser::parse(&src).map_err(|e| format!("{}:{}", input, e))?;
+    let file_name = |p: &str| {
+        Path::new(p)
+            .file_name()
+            .map(|n| n.to_string_lossy().into_owned())
+            .unwrap_or_else(|| p.to_string())
+    };
+    let opts = generator::Options {
+        class,
+        basename: file_name(&output),
+        structs_include: structs_include.unwrap_or_else(|| file_name(&input)),
+        cpp_include: include,
+        source_name: file_name(&input),
+    };
+    let header = generator::header(&tables, &opts).map_err(|e| format!("{}:{}", input, e))?;
+    let source = generator::source(&tables, &opts).map_err(|e| format!("{}:{}", input, e))?;
+    // файлы перезаписываются только при изменении, чтобы не пересобирать
+    //   зависящие от заголовка единицы трансляции
+    for (path, text) in [
+        (format!("{}.h", output), header),
+        (format!("{}.cpp", output), source),
+    ] {
+        if std::fs::read_to_string(&path).ok().as_deref() != Some(text.as_str()) {
+            std::fs::write(&path, text).map_err(|e| format!("{}: {}", path, e))?;
+        }
+    }
+    Ok(())
+}
+
+fn main() -> ExitCode {
+    let args: Vec<String> = std::env::args().skip(1).collect();
+    match run(&args) {
+        Ok(()) => ExitCode::SUCCESS,
+        Err(e) => {
+            eprintln!("asp_db-macrogen: {}", e);
+            ExitCode::FAILURE
+        }
+    }
+}
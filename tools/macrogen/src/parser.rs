@@ -0,0 +1,548 @@
+//! Разбор заголовков со структурами, размеченными макросами
+//! `asp_db/db_meta.h`:
+//!
+//! ```cpp
+//! struct ASP_TABLE book {
+//!   table_code(table_book)
+//!   field(row_id, id, type(autoinc), id(BOOK_ID), flag(f_id));
+//!   field(std::string, title, NOT_NULL, id(BOOK_TITLE));
+//!   primary_key(id)
+//!   unique_complex(title)
+//! };
+//! ```
+//!
+//! Разбор не является полноценным разбором C++: из исходника удаляются
+//!   комментарии, в нём ищутся структуры `struct ASP_TABLE <name> {...}`,
+//!   а в теле структуры - вызовы макросов разметки на верхнем уровне
+//!   вложенности. Прочее содержимое структуры (перечисления, методы,
+//!   неразмеченные поля) пропускается.
+
+use std::fmt;
+
+/// Ошибка разбора с номером строки исходника
+#[derive(Debug, PartialEq)]
+pub struct ParseError {
+    pub line: usize,
+    pub msg: String,
+}
+
+impl fmt::Display for ParseError {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        write!(f, "line {}: {}", self.line, self.msg)
+    }
+}
+
+/// Поле структуры - макросы `field` и `field_fkey`
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct Field {
+    pub name: String,
+    /// Тип поля в C++, для `field_fkey` - тип идентификатора
+    pub ctype: String,
+    /// Для `field_fkey` - структура таблицы, на которую ссылается поле
+    pub fkey: Option<String>,
+    /// Тип столбца БД - опция `type(...)`
+    pub db_type: Option<String>,
+    /// Макрос идентификатора столбца - опция `id(...)`
+    pub id: Option<String>,
+    /// Флаг поля `initialized` структуры - опция `flag(...)`
+    pub flag: Option<String>,
+    /// Длина массива - опция `len(...)`
+    pub len: Option<String>,
+    pub not_null: bool,
+    pub array: bool,
+    pub can_be_negative: bool,
+    pub has_default: bool,
+    /// Функции преобразования - макрос `str_functions`
+    pub str_functions: Option<(String, String)>,
+    pub line: usize,
+}
+
+/// Внешний ключ - макрос `reference(field, table(column), upd, del)`
+#[derive(Debug, Clone, PartialEq)]
+pub struct Reference {
+    pub field: String,
+    pub table: String,
+    pub column: String,
+    pub on_update: String,
+    pub on_delete: String,
+    pub line: usize,
+}
+
+/// Размеченная структура таблицы
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct Table {
+    pub name: String,
+    /// Код таблицы - макрос `table_code(...)`
+    pub code: Option<String>,
+    pub fields: Vec<Field>,
+    pub primary_key: Option<String>,
+    pub uniques: Vec<Vec<String>>,
+    pub references: Vec<Reference>,
+    pub line: usize,
+}
+
+impl Table {
+    pub fn field(&self, name: &str) -> Option<&Field> {
+        self.fields.iter().find(|f| f.name == name)
+    }
+}
+
+/// Удалить комментарии, сохранив переводы строк для номеров строк
+fn strip_comments(src: &str) -> String {
+    let b: Vec<char> = src.chars().collect();
+    let mut out = String::with_capacity(src.len());
+    let mut i = 0;
+    while i < b.len() {
+        let c = b[i];
+        if c == '"' || c == '\'' {
+            // строковый или символьный литерал копируется как есть
+            out.push(c);
+            i += 1;
+            while i < b.len() && b[i] != c {
+                if b[i] == '\\' && i + 1 < b.len() {
+                    out.push(b[i]);
+                    i += 1;
+                }
+                out.push(b[i]);
+                i += 1;
+            }
+            if i < b.len() {
+                out.push(b[i]);
+                i += 1;
+            }
+        } else if c == '/' && i + 1 < b.len() && b[i + 1] == '/' {
+            while i < b.len() && b[i] != '\n' {
+                i += 1;
+            }
+        } else if c == '/' && i + 1 < b.len() && b[i + 1] == '*' {
+            i += 2;
+            while i < b.len() && !(b[i] == '*' && i + 1 < b.len() && b[i + 1] == '/') {
+                if b[i] == '\n' {
+                    out.push('\n');
+                }
+                i += 1;
+            }
+            i += 2;
+            out.push(' ');
+        } else {
+            out.push(c);
+            i += 1;
+        }
+    }
+    out
+}
+
+fn is_ident_char(c: char) -> bool {
+    c.is_ascii_alphanumeric() || c == '_'
+}
+
+/// Курсор по исходнику без комментариев
+struct Cursor {
+    s: Vec<char>,
+    pos: usize,
+}
+
+impl Cursor {
+    fn line(&self) -> usize {
+        1 + self.s[..self.pos.min(self.s.len())]
+            .iter()
+            .filter(|&&c| c == '\n')
+            .count()
+    }
+
+    fn err<T>(&self, msg: impl Into<String>) -> Result<T, ParseError> {
+        Err(ParseError {
+            line: self.line(),
+            msg: msg.into(),
+        })
+    }
+
+    fn skip_ws(&mut self) {
+        while self.pos < self.s.len() && self.s[self.pos].is_whitespace() {
+            self.pos += 1;
+        }
+    }
+
+    fn peek(&self) -> Option<char> {
+        self.s.get(self.pos).copied()
+    }
+
+    fn ident(&mut self) -> Option<String> {
+        let start = self.pos;
+        while self.pos < self.s.len() && is_ident_char(self.s[self.pos]) {
+            self.pos += 1;
+        }
+        if start == self.pos {
+            None
+        } else {
+            Some(self.s[start..self.pos].iter().collect())
+        }
+    }
+
+    /// Содержимое скобок, курсор стоит на `(`
+    fn parens(&mut self) -> Result<String, ParseError> {
+        let start = self.pos + 1;
+        let mut depth = 0;
+        while self.pos < self.s.len() {
+            match self.s[self.pos] {
+                '(' => depth += 1,
+                ')' => {
+                    depth -= 1;
+                    if depth == 0 {
+                        self.pos += 1;
+                        return Ok(self.s[start..self.pos - 1].iter().collect());
+                    }
+                }
+                '"' => self.skip_literal(),
+                _ => {}
+            }
+            self.pos += 1;
+        }
+        self.err("unbalanced parentheses")
+    }
+
+    fn skip_literal(&mut self) {
+        let q = self.s[self.pos];
+        self.pos += 1;
+        while self.pos < self.s.len() && self.s[self.pos] != q {
+            if self.s[self.pos] == '\\' {
+                self.pos += 1;
+            }
+            self.pos += 1;
+        }
+    }
+}
+
+/// Разделить аргументы макроса по запятым верхнего уровня скобок,
+///   как это делает препроцессор
+pub fn split_args(args: &str) -> Vec<String> {
+    let mut result = Vec::new();
+    let mut depth = 0;
+    let mut cur = String::new();
+    let mut in_str = false;
+    for c in args.chars() {
+        match c {
+            '"' => in_str = !in_str,
+            '(' if !in_str => depth += 1,
+            ')' if !in_str => depth -= 1,
+            ',' if !in_str && depth == 0 => {
+                result.push(normalize(&cur));
+                cur.clear();
+                continue;
+            }
+            _ => {}
+        }
+        cur.push(c);
+    }
+    if !cur.trim().is_empty() || !result.is_empty() {
+        result.push(normalize(&cur));
+    }
+    result
+}
+
+/// Схлопнуть пробельные символы
+fn normalize(s: &str) -> String {
+    s.split_whitespace().collect::<Vec<_>>().join(" ")
+}
+
+/// Разобрать опцию `name` или `name(value)`
+fn split_option(opt: &str) -> (String, Option<String>) {
+    match opt.find('(') {
+        Some(p) if opt.ends_with(')') => (
+            opt[..p].trim().to_string(),
+            Some(opt[p + 1..opt.len() - 1].trim().to_string()),
+        ),
+        _ => (opt.to_string(), None),
+    }
+}
+
+const MACROS: [&str; 7] = [
+    "field",
+    "field_fkey",
+    "primary_key",
+    "unique_complex",
+    "reference",
+    "table_code",
+    "str_functions",
+];
+
+/// Разобрать все размеченные структуры исходника
+pub fn parse(src: &str) -> Result<Vec<Table>, ParseError> {
+    let mut c = Cursor {
+        s: strip_comments(src).chars().collect(),
+        pos: 0,
+    };
+    let mut tables = Vec::new();
+    while c.pos < c.s.len() {
+        let ch = c.s[c.pos];
+        if ch == '"' || ch == '\'' {
+            c.skip_literal();
+            c.pos += 1;
+            continue;
+        }
+        let boundary = c.pos == 0 || !is_ident_char(c.s[c.pos - 1]);
+        if !boundary || !is_ident_char(ch) {
+            c.pos += 1;
+            continue;
+        }
+        let word = c.ident().unwrap();
+        if word != "struct" {
+            continue;
+        }
+        let save = c.pos;
+        c.skip_ws();
+        if c.ident().as_deref() != Some("ASP_TABLE") {
+            c.pos = save;
+            continue;
+        }
+        c.skip_ws();
+        let line = c.line();
+        let name = match c.ident() {
+            Some(n) => n,
+            None => return c.err("expected table struct name after ASP_TABLE"),
+        };
+        c.skip_ws();
+        if c.peek() != Some('{') {
+            return c.err(format!("expected '{{' after 'struct ASP_TABLE {}'", name));
+        }
+        c.pos += 1;
+        let mut table = parse_body(&mut c)?;
+        table.name = name;
+        table.line = line;
+        tables.push(table);
+    }
+    Ok(tables)
+}
+
+/// Разобрать тело структуры, курсор стоит после `{`
+fn parse_body(c: &mut Cursor) -> Result<Table, ParseError> {
+    let mut table = Table::default();
+    let mut depth = 0;
+    // последний значимый символ: макросы разметки начинают объявление
+    let mut prev = '{';
+    while c.pos < c.s.len() {
+        let ch = c.s[c.pos];
+        match ch {
+            '{' => depth += 1,
+            '}' => {
+                if depth == 0 {
+                    c.pos += 1;
+                    return Ok(table);
+                }
+                depth -= 1;
+            }
+            '"' | '\'' => c.skip_literal(),
+            _ => {}
+        }
+        if depth == 0 && is_ident_char(ch) && !is_ident_char(c.s[c.pos - 1]) {
+            let word = c.ident().unwrap();
+            let after = c.pos;
+            c.skip_ws();
+            if "{};)".contains(prev) && MACROS.contains(&word.as_str()) && c.peek() == Some('(') {
+                let line = c.line();
+                let args = split_args(&c.parens()?);
+                apply_macro(&mut table, &word, args, line)?;
+                prev = ')';
+                continue;
+            }
+            c.pos = after;
+            prev = c.s[after - 1];
+            continue;
+        }
+        if !ch.is_whitespace() {
+            prev = ch;
+        }
+        c.pos += 1;
+    }
+    c.err("unterminated ASP_TABLE struct")
+}
+
+fn perr<T>(line: usize, msg: impl Into<String>) -> Result<T, ParseError> {
+    Err(ParseError {
+        line,
+        msg: msg.into(),
+    })
+}
+
+fn apply_macro(
+    table: &mut Table,
+    name: &str,
+    args: Vec<String>,
+    line: usize,
+) -> Result<(), ParseError> {
+    match name {
+        "field" | "field_fkey" => {
+            let fixed = if name == "field" { 2 } else { 3 };
+            if args.len() < fixed {
+                return perr(
+                    line,
+                    format!("{} expects at least {} arguments", name, fixed),
+                );
+            }
+            let mut f = Field {
+                ctype: args[0].clone(),
+                name: args[1].clone(),
+                line,
+                ..Default::default()
+            };
+            if name == "field_fkey" {
+                f.fkey = Some(args[2].clone());
+            }
+            for opt in &args[fixed..] {
+                apply_option(&mut f, opt, line)?;
+            }
+            if table.field(&f.name).is_some() {
+                return perr(line, format!("duplicated field '{}'", f.name));
+            }
+            table.fields.push(f);
+        }
+        "primary_key" => {
+            if args.len() != 1 || table.primary_key.is_some() {
+                return perr(line, "expected single primary_key(field)");
+            }
+            table.primary_key = Some(args[0].clone());
+        }
+        "unique_complex" => {
+            if args.is_empty() {
+                return perr(line, "unique_complex without fields");
+            }
+            table.uniques.push(args);
+        }
+        "reference" => {
+            // reference(field, table(column)[, on_update[, on_delete]])
+            if args.len() < 2 || args.len() > 4 {
+                return perr(line, "expected reference(field, table(column), upd, del)");
+            }
+            let (rtable, rcol) = split_option(&args[1]);
+            let rcol = match rcol {
+                Some(col) => col,
+                None => return perr(line, "reference target must be 'table(column)'"),
+            };
+            let act = |i: usize| args.get(i).cloned().unwrap_or_else(|| "NO_ACTION".into());
+            table.references.push(Reference {
+                field: args[0].clone(),
+                table: rtable,
+                column: rcol,
+                on_update: act(2),
+                on_delete: act(3),
+                line,
+            });
+        }
+        "table_code" => {
+            if args.len() != 1 || table.code.is_some() {
+                return perr(line, "expected single table_code(code)");
+            }
+            table.code = Some(args[0].clone());
+        }
+        "str_functions" => {
+            if args.len() != 3 {
+                return perr(line, "expected str_functions(field, to_str, from_str)");
+            }
+            match table.fields.iter_mut().find(|f| f.name == args[0]) {
+                Some(f) => f.str_functions = Some((args[1].clone(), args[2].clone())),
+                None => {
+                    return perr(
+                        line,
+                        format!("str_functions for unknown field '{}'", args[0]),
+                    )
+                }
+            }
+        }
+        _ => unreachable!(),
+    }
+    Ok(())
+}
+
+fn apply_option(f: &mut Field, opt: &str, line: usize) -> Result<(), ParseError> {
+    let (name, value) = split_option(opt);
+    match (name.as_str(), value) {
+        ("NOT_NULL", None) => f.not_null = true,
+        ("ARRAY", None) => f.array = true,
+        ("CAN_BE_NEGATIVE", None) => f.can_be_negative = true,
+        ("HAS_DEFAULT", None) => f.has_default = true,
+        ("type", Some(v)) => f.db_type = Some(v),
+        ("id", Some(v)) => f.id = Some(v),
+        ("flag", Some(v)) => f.flag = Some(v),
+        ("len", Some(v)) => f.len = Some(v),
+        _ => {
+            return perr(
+                line,
+                format!("unknown option '{}' of field '{}'", opt, f.name),
+            )
+        }
+    }
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const SRC: &str = r#"
+#define ASP_TABLE
+/* struct ASP_TABLE commented { field(int, x); }; */
+struct ASP_TABLE book {
+  table_code(table_book)
+  enum initialized_flags { f_id = 0x01, f_title = 0x02 };
+  inline bool IsSet(int f) const { return field(f); }
+  /** \brief id */
+  field(row_id, id, type(autoinc), NOT_NULL, id(BOOK_ID), flag(f_id));
+  field(std::string, title, NOT_NULL, id(BOOK_TITLE), flag(f_title));
+  field(std::vector<std::string>, tags, len(0));
+  str_functions(title, title2str, str2title)
+  primary_key(id)
+  unique_complex(title, id)
+  int32_t initialized = 0;
+};
+
+struct ASP_TABLE translation {
+  field(int, id, type(autoinc));
+  field_fkey(row_id, book_p, book, NOT_NULL);
+  reference(book_p, book(id), CASCADE, SET_NULL)
+};
+"#;
+
+    #[test]
+    fn parse_tables() {
+        let tables = parse(SRC).unwrap();
+        assert_eq!(tables.len(), 2);
+        let book = &tables[0];
+        assert_eq!(book.name, "book");
+        assert_eq!(book.code.as_deref(), Some("table_book"));
+        assert_eq!(book.fields.len(), 3);
+        assert_eq!(book.fields[0].db_type.as_deref(), Some("autoinc"));
+        assert_eq!(book.fields[0].id.as_deref(), Some("BOOK_ID"));
+        assert!(book.fields[1].not_null);
+        assert_eq!(book.fields[2].ctype, "std::vector<std::string>");
+        assert_eq!(book.fields[2].len.as_deref(), Some("0"));
+        assert_eq!(
+            book.fields[1].str_functions,
+            Some(("title2str".into(), "str2title".into()))
+        );
+        assert_eq!(book.primary_key.as_deref(), Some("id"));
+        assert_eq!(book.uniques, vec![vec!["title".to_string(), "id".into()]]);
+
+        let tr = &tables[1];
+        assert_eq!(tr.fields[1].fkey.as_deref(), Some("book"));
+        assert_eq!(tr.references[0].table, "book");
+        assert_eq!(tr.references[0].column, "id");
+        assert_eq!(tr.references[0].on_delete, "SET_NULL");
+    }
+
+    #[test]
+    fn parse_errors() {
+        let e = parse("struct ASP_TABLE t {\n field(int, x, WRONG);\n};").unwrap_err();
+        assert_eq!(e.line, 2);
+        assert!(parse("struct ASP_TABLE t { field(int); };").is_err());
+        assert!(parse("struct ASP_TABLE t { field(int, x);").is_err());
+    }
+
+    #[test]
+    fn split() {
+        assert_eq!(
+            split_args("a, f(b, c), \"x,y\""),
+            vec!["a", "f(b, c)", "\"x,y\""]
+        );
+        assert!(split_args("  ").is_empty());
+    }
+}